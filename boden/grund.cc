@@ -28,7 +28,10 @@
 #include "../descriptor/way_desc.h"
 
 #include "../dataobj/freelist.h"
+#include "../dataobj/landmark_table.h"
+#include "../dataobj/road_graph.h"
 #include "../dataobj/loadsave.h"
+#include "../dataobj/route_cache.h"
 #include "../dataobj/translator.h"
 #include "../dataobj/environment.h"
 
@@ -844,6 +847,8 @@ void grund_t::mark_image_dirty()
 	if(imageid!=IMG_EMPTY) {
 		const scr_coord scr_pos = welt->get_viewport()->get_screen_coord(koord3d(pos.get_2d(),get_disp_height()));
 		display_mark_img_dirty( imageid, scr_pos.x, scr_pos.y );
+		const sint16 raster_tile_width = get_tile_raster_width();
+		display_static_layer_mark_dirty( scr_pos.x, scr_pos.y - raster_tile_width, scr_pos.x + raster_tile_width - 1, scr_pos.y + raster_tile_width - 1 );
 	}
 }
 
@@ -1380,6 +1385,21 @@ void grund_t::display_if_visible(sint16 xpos, sint16 ypos, const sint16 raster_t
 }
 
 
+bool grund_t::is_boden_dirty() const
+{
+	if(  get_flag(grund_t::dirty)  ) {
+		return true;
+	}
+	// the ways are drawn with the ground
+	for(  uint8 i = 0;  i < offsets[flags / has_way1];  i++  ) {
+		if(  obj_bei(i)->get_flag(obj_t::dirty)  ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
 slope_t::type grund_t::get_disp_way_slope() const
 {
 	if (is_visible()) {
@@ -1879,6 +1899,9 @@ bool grund_t::weg_erweitern(waytype_t wegtyp, ribi_t::ribi ribi)
 		}
 		calc_image();
 		set_flag(dirty);
+		landmark_table_t::way_changed(pos, wegtyp);
+		road_graph_t::way_changed(weg);
+		route_cache_t::network_changed();
 		return true;
 	}
 	return false;
@@ -2031,6 +2054,10 @@ sint64 grund_t::neuen_weg_bauen(weg_t *weg, ribi_t::ribi ribi, player_t *player,
 
 		// may result in a crossing, but the wegebauer will recalc all images anyway
 		weg->calc_image();
+
+		landmark_table_t::way_changed(pos, weg->get_waytype());
+		road_graph_t::way_changed(weg);
+		route_cache_t::network_changed();
 	}
 	return cost;
 }
@@ -2071,6 +2098,8 @@ sint32 grund_t::weg_entfernen(waytype_t wegtyp, bool ribi_rem)
 		sint32 costs = (weg->get_desc()->get_value() / 2); // Costs for removal are half construction costs.
 		weg->cleanup( NULL );
 		delete weg;
+		landmark_table_t::way_removed();
+		route_cache_t::network_changed();
 
 		// delete the second way ...
 		if(flags&has_way2) {
@@ -543,6 +543,11 @@ public:
 	void display_if_visible(sint16 xpos, sint16 ypos, const sint16 raster_tile_width);
 #endif
 
+	/**
+	 * @returns whether anything drawn by display_boden() changed since the tile was drawn last
+	 */
+	bool is_boden_dirty() const;
+
 	/**
 	 * displays everything that is on a tile - the main display routine for objects on tiles
 	 * @param is_global set to true, if this is called during the whole screen update
@@ -15,6 +15,7 @@
 #include "../../bauer/wegbauer.h"
 #include "../../dataobj/translator.h"
 #include "../../dataobj/ribi.h"
+#include "../../dataobj/road_graph.h"
 #include "../../utils/cbuffer_t.h"
 #include "../../vehicle/simvehicle.h" /* for calc_direction */
 #include "../../obj/wayobj.h"
@@ -301,6 +302,8 @@ void strasse_t::set_overtaking_mode(overtaking_mode_t o, player_t* calling_playe
 	if (is_deletable(calling_player) == NULL)
 	{
 		overtaking_mode = o;
+		// one-way roads restrict the directions of travel
+		road_graph_t::way_changed(this);
 	}
 }
 
@@ -331,6 +334,7 @@ void strasse_t::update_ribi_mask_oneway(ribi_t::ribi mask, ribi_t::ribi allow, p
 	} else {
 		ribi_mask_oneway &= ~allow;
 	}
+	road_graph_t::way_changed(this);
 }
 
 ribi_t::ribi strasse_t::get_ribi() const {
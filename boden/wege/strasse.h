@@ -33,6 +33,12 @@ private:
 	*/
 	uint8 ribi_mask_oneway:4;
 
+	/**
+	* Index of this tile in the road graph of the private car route checker,
+	* or road_graph_t::no_node if it is not a node of the graph
+	*/
+	uint32 road_graph_node = UINT32_MAX_VALUE;
+
 public:
 	static const way_desc_t *default_strasse;
 
@@ -66,6 +72,9 @@ public:
 	ribi_t::ribi get_ribi_mask_oneway() const { return (ribi_t::ribi)ribi_mask_oneway; }
 	ribi_t::ribi get_ribi() const OVERRIDE;
 
+	uint32 get_road_graph_node() const { return road_graph_node; }
+	void set_road_graph_node(uint32 node) { road_graph_node = node; }
+
 	void rotate90() OVERRIDE;
 
 	image_id get_front_image() const OVERRIDE
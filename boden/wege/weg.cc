@@ -4,6 +4,7 @@
  */
 
 #include <stdio.h>
+#include <algorithm>
 #include <tuple>
 
 #include "../../tpl/slist_tpl.h"
@@ -37,6 +38,9 @@
 #include "../../dataobj/environment.h" // TILE_HEIGHT_STEP
 #include "../../dataobj/translator.h"
 #include "../../dataobj/loadsave.h"
+#include "../../dataobj/landmark_table.h"
+#include "../../dataobj/road_graph.h"
+#include "../../dataobj/route_cache.h"
 #include "../../dataobj/environment.h"
 #include "../../descriptor/way_desc.h"
 #include "../../descriptor/tunnel_desc.h"
@@ -54,6 +58,12 @@ static pthread_mutexattr_t mutex_attributes;
 static pthread_rwlockattr_t rwlock_attributes;
 
 pthread_mutex_t weg_t::private_car_route_map::route_map_mtx = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t weg_t::private_car_route_map::table_mtx[16] = {
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER
+};
 #endif
 
 
@@ -349,6 +359,7 @@ void weg_t::init()
 	foreground_image = IMG_EMPTY;
 	public_right_of_way = false;
 	degraded = false;
+	landmark_index = landmark_table_t::no_index;
 	remaining_wear_capacity = 100000000;
 	replacement_way = NULL;
 #ifdef MULTI_THREAD
@@ -358,11 +369,6 @@ void weg_t::init()
 	//int error = pthread_rwlock_init(&private_car_store_route_rwlock, &rwlock_attributes);
 	//assert(error == 0);
 #endif
-	for(uint32 j=0; j<2; j++){
-		for(uint32 i=0; i<5; i++){
-			private_car_routes[j][i].set_route_map_elem(j);
-		}
-	}
 }
 
 
@@ -539,9 +545,7 @@ void weg_t::rdwr(loadsave_t *file)
 			{
 				for (uint32 i = 0; i < route_array_number; i++)
 				{
-					for(uint32 j=0; j<5; j++) {
-						private_car_routes[i][j].rdwr(file);
-					}
+					private_car_routes[i].rdwr(file, this, i);
 				}
 			}
 			else // Loading
@@ -556,28 +560,22 @@ void weg_t::rdwr(loadsave_t *file)
 							for (uint32 j = 0; j < private_car_routes_count; j++) {
 								koord destination;
 								destination.rdwr(file);
+								const uint32 destination_id = private_car_route_map::register_destination(i, destination);
 								if (file->get_extended_revision() < 33) {
 									// Koord3d representation
 									koord3d next_tile;
 									next_tile.rdwr(file);
-									private_car_routes[i][get_map_idx(next_tile)].insert_unique(destination);
+									private_car_routes[i].insert(destination_id, get_map_idx(next_tile));
 								} else {
 									// Integer-neighbour representation
 									uint8 next_tile_neighbour;
 									file->rdwr_byte(next_tile_neighbour);
-									private_car_routes[i][get_map_idx(private_car_t::neighbour_from_int(get_pos(), next_tile_neighbour))].insert_unique(destination);
+									private_car_routes[i].insert(destination_id, get_map_idx(private_car_t::neighbour_from_int(get_pos(), next_tile_neighbour)));
 								}
 							}
 						} else {
 							// Container membership representation
-							for(uint8 j=0; j<5; j++) {
-								private_car_routes[i][j].rdwr(file);
-							}
-
-							if(file->is_version_ex_less(14,39)) {
-								// Correct for nsew->nesw change
-								std::swap(private_car_routes[i][1],private_car_routes[i][2]);
-							}
+							private_car_routes[i].rdwr(file, this, i);
 						}
 					}
 				}
@@ -586,72 +584,105 @@ void weg_t::rdwr(loadsave_t *file)
 	}
 }
 
-void weg_t::private_car_route_map::rdwr(loadsave_t *file){
+/**
+ * Route sets of savegames between 14.37 and 14.42 may be shared between ways
+ * by their index in a global list, and the way owning the set may well be
+ * loaded after the ways referring to it. Such references are kept here until
+ * finish_loading().
+ */
+struct legacy_private_car_route_set_t {
+	weg_t *way;
+	uint32 idx;
+	uint8 map_elem;
+	uint8 dir;
+};
+static vector_tpl<legacy_private_car_route_set_t> legacy_route_sets;
+static vector_tpl<vector_tpl<koord> > legacy_route_maps[2];
+
+void weg_t::private_car_route_map::rdwr(loadsave_t *file, weg_t *way, uint8 map_elem){
 	if(file->is_saving()){
-
-		uint32 count=get_count();
-		//single or null
-		if(count < 2){
-			file->rdwr_long(count);
-			if(count==1){
-				single_koord.rdwr(file);
+		// Each direction is written as a plain list of destinations, which all
+		// versions since 14.37 read as a set of its own.
+		for(uint8 dir = 0; dir < 5; dir++){
+			uint32 count = 0;
+			FOR(vector_tpl<run_t>, const& run, runs){
+				if(run.directions & (1 << dir)){
+					count += run.last - run.first + 1;
+				}
 			}
-			return;
-		}
-		//use negative coords to store index and link mode
-		if(link_mode == link_mode_master){
-			count+=2;
-		}else{
-			count=2;
-		}
-		file->rdwr_long(count);
-		koord idx1,idx2;
-		idx1.x = -2;
-		idx1.y = static_cast<sint16>((idx >> 16) & 0xFFFF);
-		idx1.rdwr(file);
-		idx2.x = -1 - (sint16)link_mode;
-		idx2.y = static_cast<sint16>((idx) & 0xFFFF);
-		idx2.rdwr(file);
-		//save the destination list
-		if(link_mode==link_mode_master){
-			for(uint32 k = 0; k < get_count(); k++){
-				route_maps[route_map_elem][idx].get_by_index(k).rdwr(file);
+			file->rdwr_long(count);
+			FOR(vector_tpl<run_t>, const& run, runs){
+				if(run.directions & (1 << dir)){
+					for(uint32 id = run.first; id <= run.last; id++){
+						koord dest = destinations[map_elem][id];
+						dest.rdwr(file);
+					}
+				}
 			}
 		}
 	}else{
-		uint32 count=0;
-		file->rdwr_long(count);
-		resize(0);
-		if(count == 1){
-			single_koord.rdwr(file);
-			link_mode = link_mode_single;
-		}else if(count >= 2){
-			koord idx1,idx2;
-			idx1.rdwr(file);
-			idx2.rdwr(file);
-			if(idx1.x == -2){
-				//newer file, extract index and link mode
-				idx =  uint32(static_cast<uint16>(idx1.y)) << 16;
-				idx |= uint32(static_cast<uint16>(idx2.y));
-				link_mode = -1 - idx2.x;
-				if(link_mode == link_mode_master){
-					route_maps[route_map_elem].store_at(idx,ordered_vector_tpl<koord,uint32>(count-2));
+		reset_table();
+		for(uint8 j = 0; j < 5; j++){
+			// Correct for nsew->nesw change
+			const uint8 dir = file->is_version_ex_less(14,39) && (j == 1 || j == 2) ? 3 - j : j;
+			uint32 count = 0;
+			file->rdwr_long(count);
+			uint32 k = 0;
+			bool master = false;
+			uint32 master_idx = 0;
+			if(count >= 2){
+				koord idx1, idx2;
+				idx1.rdwr(file);
+				idx2.rdwr(file);
+				k = 2;
+				if(idx1.x == -2){
+					// Shared set: the index and link mode are stored in negative coordinates
+					legacy_private_car_route_set_t set;
+					set.way = way;
+					set.idx = (uint32(static_cast<uint16>(idx1.y)) << 16) | uint32(static_cast<uint16>(idx2.y));
+					set.map_elem = map_elem;
+					set.dir = dir;
+					legacy_route_sets.append(set);
+					// Only the owner of the set stores the destinations, the others refer to it
+					master = -1 - idx2.x == 5;
+					if(master){
+						master_idx = set.idx;
+						legacy_route_maps[map_elem].store_at(master_idx, vector_tpl<koord>(count - 2));
+					}
+				}else{
+					insert(register_destination(map_elem, idx1), dir);
+					insert(register_destination(map_elem, idx2), dir);
 				}
-			}else{
-				//older file, just append destinations
-				resize(count);
-				insert_unique(idx1);
-				insert_unique(idx2);
 			}
-			//for master or old file, read remaining destinations
-			for(uint32 k=2; k<count; k++){
-				koord dest; dest.rdwr(file);
-				insert_unique(dest);
+			for(; k < count; k++){
+				koord dest;
+				dest.rdwr(file);
+				if(master){
+					legacy_route_maps[map_elem][master_idx].append(dest);
+				}else{
+					insert(register_destination(map_elem, dest), dir);
+				}
 			}
 		}
 	}
 }
 
+void weg_t::private_car_route_map::finish_loading(){
+	FOR(vector_tpl<legacy_private_car_route_set_t>, const& set, legacy_route_sets){
+		if(set.idx < legacy_route_maps[set.map_elem].get_count()){
+			FOR(vector_tpl<koord>, const& dest, legacy_route_maps[set.map_elem][set.idx]){
+				set.way->private_car_routes[set.map_elem].insert(register_destination(set.map_elem, dest), set.dir);
+			}
+		}
+	}
+	vector_tpl<legacy_private_car_route_set_t> no_sets;
+	swap(legacy_route_sets, no_sets);
+	for(uint8 i = 0; i < 2; i++){
+		vector_tpl<vector_tpl<koord> > no_maps;
+		swap(legacy_route_maps[i], no_maps);
+	}
+}
+
 void weg_t::info(cbuffer_t & buf) const
 {
 	obj_t::info(buf);
@@ -766,27 +797,25 @@ void weg_t::info(cbuffer_t & buf) const
 			uint32 cities_count = 0;
 			uint32 buildings_count = 0;
 #ifdef DEBUG
-			buf.append(translator::translate("[indices: "));
-			for(uint8 i=0;i<5;i++) {
-				buf.printf("%d ",private_car_routes[private_car_routes_currently_reading_element][i].get_idx());
-			}
-			buf.append("]\n");
+			buf.printf("[runs: %u]\n", private_car_routes[private_car_routes_currently_reading_element].get_runs().get_count());
+			uint32 shown = 0;
 #endif
-			for(uint8 i=0;i<5;i++) {
-				for(uint32 j=0;j<private_car_routes[private_car_routes_currently_reading_element][i].get_count();j++){
-					const koord dest = private_car_routes[private_car_routes_currently_reading_element][i][j];
+			FOR(vector_tpl<private_car_route_map::run_t>, const& run, private_car_routes[private_car_routes_currently_reading_element].get_runs()) {
+				for(uint32 j=run.first; j<=run.last; j++){
+					const koord dest = private_car_route_map::get_destination(private_car_routes_currently_reading_element, j);
 					const grund_t* gr = welt->lookup_kartenboden(dest);
 					const gebaeude_t* building = gr ? gr->get_building() : NULL;
 					if (building)
 					{
 						buildings_count++;
 #ifdef DEBUG
-						if(j < 5){
+						if(shown < 5){
 							buf.append("\n");
 							buf.append(translator::translate(building->get_individual_name()));
-						}else if(j==5){
+						}else if(shown==5){
 							buf.append("\n...");
 						}
+						shown++;
 #endif
 					}
 					else
@@ -1343,6 +1372,10 @@ void weg_t::rotate90()
  */
 void weg_t::count_sign()
 {
+	// signs and signals may restrict the directions of travel
+	road_graph_t::way_changed(this);
+	route_cache_t::network_changed();
+
 	// Either only sign or signal please ...
 	flags &= ~(HAS_SIGN|HAS_SIGNAL|HAS_CROSSING);
 	const grund_t *gr=welt->lookup(get_pos());
@@ -1491,7 +1524,7 @@ void weg_t::calc_image()
 #endif
 
 #ifdef DEBUG_PRIVATE_CAR_ROUTES
-	if (private_car_routes[private_car_routes_currently_reading_element].empty())
+	if (private_car_routes[private_car_routes_currently_reading_element].is_empty())
 	{
 		set_image(IMG_EMPTY);
 		set_after_image(IMG_EMPTY);
@@ -1972,230 +2005,233 @@ signal_t *weg_t::get_signal(ribi_t::ribi direction_of_travel) const
 	else return NULL;
 }
 
-//#define NO_PRIVATE_CAR_DESTINATION_LINKING
-
-vector_tpl<ordered_vector_tpl<koord,uint32> > weg_t::private_car_route_map::route_maps[2];
+vector_tpl<koord> weg_t::private_car_route_map::destinations[2];
+vector_tpl<uint32> weg_t::private_car_route_map::destinations_by_pos[2];
 
-void weg_t::private_car_route_map::clear(){
-	if(link_mode==link_mode_master){
-		route_maps[route_map_elem][idx].clear();
-	}else{
-		link_mode=link_mode_NULL;
-	}
+static inline uint32 destination_pos_key(koord k)
+{
+	return ((uint32)(uint16)k.x << 16) | (uint16)k.y;
 }
 
-void weg_t::private_car_route_map::pre_reset(){
-	if(link_mode==link_mode_master){
-		route_maps[route_map_elem][idx].clear();
+// Interleaves the bits of both coordinates, so that sorting by it keeps neighbouring destinations together.
+static inline uint32 destination_spatial_key(koord k)
+{
+	uint32 key = 0;
+	for(uint8 bit = 0; bit < 16; bit++) {
+		key |= (((uint32)(uint16)k.x >> bit) & 1) << (2 * bit);
+		key |= (((uint32)(uint16)k.y >> bit) & 1) << (2 * bit + 1);
 	}
-	link_mode=link_mode_NULL;
+	return key;
 }
 
-bool weg_t::private_car_route_map::contains(koord elem) const{
-	if(link_mode==link_mode_NULL){
-		return false;
-	}
-	if(link_mode==link_mode_single){
-		bool result= single_koord==elem;
-		return result;
-	}
-	bool result=route_maps[route_map_elem][idx].contains(elem);
-	return result;
+static bool destination_spatial_less(koord a, koord b)
+{
+	return destination_spatial_key(a) < destination_spatial_key(b);
 }
 
-bool weg_t::private_car_route_map::insert_unique(koord elem, private_car_route_map* link_to, uint8 link_dir){
-	if(link_mode==link_mode_NULL){
-		single_koord=elem;
-		link_mode=link_mode_single;
-		return true;
-	}
-	if(link_mode==link_mode_single){
-		if(single_koord==elem){
-			return false;
-		}
-		if(link_to
-				&& link_to->link_mode!=link_mode_NULL
-				&& link_to->link_mode!=link_mode_single
-				&& link_to->contains(single_koord)
-				&& link_to->contains(elem)){
-			link_mode=link_dir;
-			idx=link_to->idx;
-			return true;
-		}
-		route_maps[route_map_elem].append(ordered_vector_tpl<koord,uint32>());
-		uint32 new_idx=route_maps[route_map_elem].get_count()-1;
-		route_maps[route_map_elem][new_idx].insert_unique(single_koord);
-		idx=new_idx;
-		link_mode=link_mode_master;
-	}
-	if(link_mode==link_mode_master){
-		bool result = route_maps[route_map_elem][idx].insert_unique(elem);
-		return result;
-	}
-	if(link_to){
-		if(link_mode==link_dir
-				&& link_to->link_mode!=link_mode_NULL
-				&& link_to->link_mode!=link_mode_single){
-			idx=link_to->idx;
-			return false;
+uint32 weg_t::private_car_route_map::find(uint32 destination_id) const
+{
+	uint32 low = 0;
+	uint32 high = runs.get_count();
+	while(low < high) {
+		const uint32 mid = (low + high) / 2;
+		if(runs[mid].last < destination_id) {
+			low = mid + 1;
 		}
-		route_maps[route_map_elem].append(ordered_vector_tpl<koord,uint32>(route_maps[route_map_elem][idx]));
-		uint32 new_idx=route_maps[route_map_elem].get_count()-1;
-		if(link_to->link_mode==link_mode_single){
-			route_maps[route_map_elem][new_idx].insert_unique(link_to->single_koord);
-		}else if(link_to->link_mode!=link_mode_NULL){
-			route_maps[route_map_elem][new_idx].set_union(route_maps[route_map_elem][link_to->idx]);
+		else {
+			high = mid;
 		}
-		idx=new_idx;
-		link_mode=link_mode_master;
-		bool result = route_maps[route_map_elem][idx].insert_unique(elem);
-		return result;
 	}
-	return false;
+	return low;
 }
 
-koord& weg_t::private_car_route_map::get_by_index(uint32_t i){
-	if(link_mode==link_mode_single){
-		koord& result=single_koord;
-		return result;
-	}
-	koord& result = route_maps[route_map_elem][idx][i];
-	return result;
-}
-
-const koord& weg_t::private_car_route_map::get_by_index(uint32_t i) const {
-	if(link_mode==link_mode_single){
-		const koord& result=single_koord;
-		return result;
+uint8 weg_t::private_car_route_map::get_directions(uint32 destination_id) const
+{
+	const uint32 pos = find(destination_id);
+	if(pos < runs.get_count() && runs[pos].first <= destination_id) {
+		return runs[pos].directions;
 	}
-	const koord& result = route_maps[route_map_elem][idx][i];
-	return result;
-}
-koord& weg_t::private_car_route_map::operator[](uint32 i){
-	return get_by_index(i);
+	return 0;
 }
 
-const koord& weg_t::private_car_route_map::operator[](uint32 i) const {
-	return get_by_index(i);
-}
-
-uint32 weg_t::private_car_route_map::get_count() const {
-	if(link_mode==link_mode_NULL){
-		return 0;
+void weg_t::private_car_route_map::merge_at(uint32 pos)
+{
+	if(pos > 0 && (uint32)runs[pos-1].last + 1 == runs[pos].first && runs[pos-1].directions == runs[pos].directions) {
+		runs[pos-1].last = runs[pos].last;
+		runs.remove_at(pos);
+		pos--;
 	}
-	if(link_mode==link_mode_single){
-		return 1;
+	if(pos + 1 < runs.get_count() && (uint32)runs[pos].last + 1 == runs[pos+1].first && runs[pos].directions == runs[pos+1].directions) {
+		runs[pos].last = runs[pos+1].last;
+		runs.remove_at(pos+1);
 	}
-	const uint32 result = route_maps[route_map_elem][idx].get_count();
-	return result;
 }
 
-bool weg_t::private_car_route_map::is_empty() const {
-	if(link_mode==link_mode_NULL){
-		return true;
+bool weg_t::private_car_route_map::insert(uint32 destination_id, uint8 dir)
+{
+	const uint8 bit = 1 << dir;
+	uint32 pos = find(destination_id);
+	run_t single;
+	single.first = destination_id;
+	single.last = destination_id;
+	single.directions = bit;
+	if(pos < runs.get_count() && runs[pos].first <= destination_id) {
+		run_t run = runs[pos];
+		if(run.directions & bit) {
+			return false;
+		}
+		// Split the run around the destination
+		single.directions = run.directions | bit;
+		if(run.first < destination_id) {
+			run_t before = run;
+			before.last = destination_id - 1;
+			runs[pos] = before;
+			pos++;
+			runs.insert_at(pos, single);
+		}
+		else {
+			runs[pos] = single;
+		}
+		if(destination_id < run.last) {
+			run_t after = run;
+			after.first = destination_id + 1;
+			runs.insert_at(pos + 1, after);
+		}
 	}
-	if(link_mode==link_mode_single){
-		return false;
+	else {
+		runs.insert_at(pos, single);
 	}
-	const bool result = route_maps[route_map_elem][idx].is_empty();
-	return result;
+	merge_at(pos);
+	return true;
 }
 
-bool weg_t::private_car_route_map::remove(koord elem){
-
-	if(link_mode==link_mode_NULL){
-		return false;
-	}
-	if(link_mode==link_mode_single){
-		if(single_koord==elem){
-			link_mode=link_mode_NULL;
-			return true;
-		}
+bool weg_t::private_car_route_map::remove(uint32 destination_id)
+{
+	const uint32 pos = find(destination_id);
+	if(pos >= runs.get_count() || runs[pos].first > destination_id) {
 		return false;
 	}
-	bool result = route_maps[route_map_elem][idx].remove(elem);
-	return result;
-}
-
-void weg_t::private_car_route_map::resize(uint32 new_size){
-	if((link_mode==link_mode_single || link_mode==link_mode_NULL) && new_size<=1){
-		return;
+	const run_t run = runs[pos];
+	runs.remove_at(pos);
+	uint32 insert_pos = pos;
+	if(run.first < destination_id) {
+		run_t before = run;
+		before.last = destination_id - 1;
+		runs.insert_at(insert_pos++, before);
 	}
-	if(link_mode!=link_mode_master){
-		ordered_vector_tpl<koord,uint32> to_append=(link_mode==link_mode_single || link_mode==link_mode_NULL)
-				? ordered_vector_tpl<koord,uint32>() : ordered_vector_tpl<koord,uint32>(route_maps[route_map_elem][idx]);
-		route_maps[route_map_elem].append(to_append);
-		idx=route_maps[route_map_elem].get_count()-1;
-		if(link_mode==link_mode_single){
-			route_maps[route_map_elem][idx].insert_unique(single_koord);
-		}
-		link_mode=link_mode_master;
+	if(destination_id < run.last) {
+		run_t after = run;
+		after.first = destination_id + 1;
+		runs.insert_at(insert_pos, after);
 	}
-	route_maps[route_map_elem][idx].resize(new_size);
+	return true;
 }
 
-void weg_t::private_car_route_map::reset(uint8 map_elem){
-	route_maps[map_elem].clear();
-	route_maps[map_elem].resize(0);
+void weg_t::private_car_route_map::reset_table()
+{
+	vector_tpl<run_t> no_runs;
+	swap(runs, no_runs);
 }
 
-weg_t::private_car_route_map* weg_t::private_car_backtrace_last_route_map=NULL;
-uint8 weg_t::private_car_backtrace_last_idx=0;
+void weg_t::private_car_route_map::reset(uint8 map_elem, const vector_tpl<koord> &new_destinations)
+{
+	vector_tpl<koord> sorted(new_destinations);
+	std::sort(sorted.begin(), sorted.end(), destination_spatial_less);
 
-void weg_t::private_car_backtrace_begin(){
-	private_car_route_map::route_map_lock();
-	private_car_backtrace_last_route_map=NULL;
+	destinations[map_elem].clear();
+	destinations[map_elem].resize(sorted.get_count() + 1);
+	destinations_by_pos[map_elem].clear();
+	destinations_by_pos[map_elem].resize(sorted.get_count());
+	destinations[map_elem].append(koord::invalid);
+	FOR(vector_tpl<koord>, const& dest, sorted) {
+		register_destination(map_elem, dest);
+	}
 }
 
-void weg_t::private_car_backtrace_end(){
-	private_car_route_map::route_map_unlock();
+uint32 weg_t::private_car_route_map::get_destination_id(uint8 map_elem, koord destination)
+{
+	const vector_tpl<koord> &dests = destinations[map_elem];
+	const vector_tpl<uint32> &by_pos = destinations_by_pos[map_elem];
+	const uint32 key = destination_pos_key(destination);
+	uint32 low = 0;
+	uint32 high = by_pos.get_count();
+	while(low < high) {
+		const uint32 mid = (low + high) / 2;
+		const uint32 mid_key = destination_pos_key(dests[by_pos[mid]]);
+		if(mid_key == key) {
+			return by_pos[mid];
+		}
+		if(mid_key < key) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	return 0;
 }
 
-void weg_t::private_car_backtrace_add(koord destination, koord3d next_tile){
-	uint8 writing_elem=get_private_car_routes_currently_writing_element();
-	auto map = private_car_routes[writing_elem];
-	const uint8 map_idx = get_map_idx(next_tile);
-
-	if(!map[map_idx].contains(destination)) {
-#ifdef NO_PRIVATE_CAR_DESTINATION_LINKING
-		for(uint8 i=0;i<5;i++) {
-			if(i != map_idx && map[i].remove(destination)) {
-				break;
-			}
+uint32 weg_t::private_car_route_map::register_destination(uint8 map_elem, koord destination)
+{
+	if(destination == koord::invalid) {
+		return 0;
+	}
+	route_map_lock();
+	vector_tpl<koord> &dests = destinations[map_elem];
+	vector_tpl<uint32> &by_pos = destinations_by_pos[map_elem];
+	if(dests.empty()) {
+		dests.append(koord::invalid);
+	}
+	const uint32 key = destination_pos_key(destination);
+	uint32 low = 0;
+	uint32 high = by_pos.get_count();
+	while(low < high) {
+		const uint32 mid = (low + high) / 2;
+		const uint32 mid_key = destination_pos_key(dests[by_pos[mid]]);
+		if(mid_key == key) {
+			const uint32 id = by_pos[mid];
+			route_map_unlock();
+			return id;
+		}
+		if(mid_key < key) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
 		}
-		map[map_idx].insert_unique(destination);
-#else
-		map[map_idx].insert_unique(destination,private_car_backtrace_last_route_map,private_car_backtrace_last_idx);
-#endif
 	}
+	const uint32 id = dests.get_count();
+	dests.append(destination);
+	by_pos.insert_at(low, id);
+	route_map_unlock();
+	return id;
 }
 
-void weg_t::private_car_backtrace_inc(koord3d next_tile){
-	uint8 writing_elem=get_private_car_routes_currently_writing_element();
-	auto map = private_car_routes[writing_elem];
+void weg_t::private_car_backtrace_add(const uint32 *destination_ids, uint8 count, koord3d next_tile)
+{
+	private_car_route_map &map = private_car_routes[get_private_car_routes_currently_writing_element()];
 	const uint8 map_idx = get_map_idx(next_tile);
-	private_car_backtrace_last_route_map=map+map_idx;
-	private_car_backtrace_last_idx=map_idx;
+	map.table_lock();
+	for(uint8 i = 0; i < count; i++) {
+		if(destination_ids[i]) {
+			map.insert(destination_ids[i], map_idx);
+		}
+	}
+	map.table_unlock();
 }
 
 void weg_t::add_private_car_route(koord destination, koord3d next_tile)
 {
-
-	uint8 writing_elem=get_private_car_routes_currently_writing_element();
-	private_car_route_map::route_map_lock();
-	auto map = private_car_routes[writing_elem];
+	const uint32 destination_id = register_private_car_destination(destination);
+	private_car_route_map &map = private_car_routes[get_private_car_routes_currently_writing_element()];
 	const uint8 map_idx = get_map_idx(next_tile);
 
-	if(!map[map_idx].contains(destination)) {
-		for(uint8 i=0;i<5;i++) {
-			if(i != map_idx && map[i].remove(destination)) {
-				break;
-			}
-		}
-		map[map_idx].insert_unique(destination);
+	map.table_lock();
+	if(map.get_directions(destination_id) != (1 << map_idx)) {
+		map.remove(destination_id);
+		map.insert(destination_id, map_idx);
 	}
-
-	private_car_route_map::route_map_unlock();
+	map.table_unlock();
 
 #ifdef DEBUG_PRIVATE_CAR_ROUTES
 	calc_image();
@@ -2221,12 +2257,9 @@ void weg_t::delete_all_routes_from_here(bool reading_set)
 
 	vector_tpl<koord> destinations_to_delete;
 
-	for(uint8 i=0;i<5;i++) {
-		auto &map = private_car_routes[routes_index][i];
-		if (!map.is_empty()) {
-			for(uint32 j=0; j<map.get_count();j++) {
-				destinations_to_delete.append(map[j]);
-			}
+	FOR(vector_tpl<private_car_route_map::run_t>, const& run, private_car_routes[routes_index].get_runs()) {
+		for(uint32 j=run.first; j<=run.last; j++) {
+			destinations_to_delete.append(private_car_route_map::get_destination(routes_index, j));
 		}
 	}
 		FOR(vector_tpl<koord>, dest, destinations_to_delete)
@@ -2274,13 +2307,10 @@ void weg_t::delete_route_to(koord destination, bool reading_set)
 void weg_t::remove_private_car_route(koord destination, bool reading_set)
 {
 	const uint32 routes_index = reading_set ? private_car_routes_currently_reading_element : get_private_car_routes_currently_writing_element();
-	private_car_route_map::route_map_lock();
-	for(uint8 i=0;i<5;i++) {
-		if(private_car_routes[routes_index][i].remove(destination)) {
-			break;
-		}
-	}
-	private_car_route_map::route_map_unlock();
+	private_car_route_map &map = private_car_routes[routes_index];
+	map.table_lock();
+	map.remove(private_car_route_map::get_destination_id(routes_index, destination));
+	map.table_unlock();
 }
 
 void weg_t::add_travel_time_update(weg_t* w, uint32 actual, uint32 ideal)
@@ -2305,15 +2335,13 @@ void weg_t::clear_travel_time_updates() {
 }
 
 koord3d weg_t::get_next_on_private_car_route_to(koord dest, bool reading_set, uint8 startdir) const {
-#ifdef NO_PRIVATE_CAR_DESTINATION_LINKING
-	startdir=0;
-#endif
-	auto map = private_car_routes[reading_set ? private_car_routes_currently_reading_element : get_private_car_routes_currently_writing_element()];
-	if(map[4].contains(dest)){
+	const uint32 routes_index = reading_set ? private_car_routes_currently_reading_element : get_private_car_routes_currently_writing_element();
+	const uint8 directions = private_car_routes[routes_index].get_directions(private_car_route_map::get_destination_id(routes_index, dest));
+	if(directions & (1 << private_car_route_map::reached_here)){
 		return koord3d::invalid;
 	}
 	for(uint8 i=startdir; i<4+startdir; i++) {
-		if(map[i&3].contains(dest)) {
+		if(directions & (1 << (i&3))) {
 			grund_t* to;
 			if(welt->lookup(get_pos())->get_neighbour(to, waytype_t::road_wt,ribi_t::nesw[i&3])) {
 				return to->get_pos();
@@ -18,7 +18,7 @@
 #include "../../descriptor/way_desc.h"
 #include "../../dataobj/koord3d.h"
 #include "../../tpl/minivec_tpl.h"
-#include "../../tpl/ordered_vector_tpl.h"
+#include "../../tpl/vector_tpl.h"
 #include "../../simskin.h"
 
 #ifdef MULTI_THREAD
@@ -210,6 +210,9 @@ private:
 	// Whether the way is in a degraded state.
 	bool degraded:1;
 
+	// Index of this way in the landmark table of its waytype (see landmark_table_t)
+	uint32 landmark_index;
+
 
 protected:
 
@@ -247,61 +250,88 @@ public:
 	minivec_tpl<gebaeude_t*> connected_buildings;
 
 	/**
-	 * Map of all private car routes from way
+	 * Next hop table of the private car routes passing over this way.
+	 * Destinations are numbered per route set (see register_destination()),
+	 * and each run covers consecutive destination numbers which leave this way
+	 * in the same set of directions: bits 0-3 are the nesw neighbours, bit 4
+	 * marks destinations reached from this way. The numbers are handed out in
+	 * spatial order, so neighbouring destinations, which are reached over the
+	 * same roads, mostly fall into one run.
 	 */
 	class private_car_route_map{
 	public:
-		void set_route_map_elem(uint8 elem){route_map_elem=elem;}
+		enum { reached_here = 4 };
+
+		struct run_t {
+			uint32 first;
+			uint32 last:27;
+			uint32 directions:5;
+		};
+
+		/// Adds the destination as leaving this way in direction dir (0-3 nesw, reached_here).
+		/// @returns false if it was already recorded so.
+		bool insert(uint32 destination_id, uint8 dir);
 
-		private_car_route_map(){link_mode=link_mode_NULL;}
+		/// Removes the destination in all directions.
+		bool remove(uint32 destination_id);
 
-		void clear();
+		/// @returns the direction bits recorded for the destination, 0 if none.
+		uint8 get_directions(uint32 destination_id) const;
 
-		void pre_reset();
+		const vector_tpl<run_t> &get_runs() const { return runs; }
+		bool is_empty() const { return runs.empty(); }
 
-		bool contains(koord elem) const;
-		bool insert_unique(koord elem, private_car_route_map* link_to = NULL, uint8 link_dir=0);
+		/// Clears the table and releases its memory.
+		void reset_table();
 
-		koord& get_by_index(uint32_t i);
-		const koord& get_by_index(uint32_t i) const;
+		/**
+		 * Numbers the destinations of the route set map_elem afresh, in
+		 * spatial order. Destinations not in the list are numbered on demand.
+		 */
+		static void reset(uint8 map_elem, const vector_tpl<koord> &destinations);
 
-		koord& operator [] (uint32 i);
-		const koord& operator [] (uint32 i) const ;
+		/// @returns the number of the destination in the route set map_elem, adding it if needed.
+		static uint32 register_destination(uint8 map_elem, koord destination);
 
-		uint32 get_count() const ;
-		bool is_empty() const ;
+		/**
+		 * @returns the number of the destination in the route set map_elem, 0 if unknown.
+		 * No lock is taken: the numbering of the set currently read only changes
+		 * while the private car route threads are suspended.
+		 */
+		static uint32 get_destination_id(uint8 map_elem, koord destination);
 
-		bool remove(koord elem);
-		void resize(uint32 new_size);
+		static koord get_destination(uint8 map_elem, uint32 destination_id) { return destinations[map_elem][destination_id]; }
 
-		static void reset(uint8 map_elem);
+		/**
+		 * Saves the five direction sets as plain destination lists, or loads any
+		 * of the formats used since 14.37.
+		 */
+		void rdwr(loadsave_t *file, weg_t *way, uint8 map_elem);
 
-		//backwards compatible saving
-		void rdwr(loadsave_t *file);
+		/// Resolves the route sets which older savegames shared between ways.
+		static void finish_loading();
 
 	private:
-		union {
-			uint32 idx;
-			koord single_koord;
-		};
-		uint8 link_mode:3;
-		uint8 route_map_elem:1;
-		enum link_modes {
-			link_mode_NULL=7,
-			link_mode_single=6,
-			link_mode_master=5
-		};
+		vector_tpl<run_t> runs;
 
-		static vector_tpl<ordered_vector_tpl<koord,uint32> > route_maps[2];
-public:
+		/// Joins the run at pos with its neighbours where they line up.
+		void merge_at(uint32 pos);
 
-		inline sint32 get_idx() const {if(link_mode==link_mode_NULL || link_mode==link_mode_single) return -1; return idx;}
+		/// @returns the position of the first run not ending before the destination.
+		uint32 find(uint32 destination_id) const;
 
+		// Per route set: destination coordinates by number (0 is unused),
+		// and the numbers ordered by coordinate for the lookup.
+		static vector_tpl<koord> destinations[2];
+		static vector_tpl<uint32> destinations_by_pos[2];
+
+	public:
 #ifdef MULTI_THREAD
 		static pthread_mutex_t route_map_mtx;
+		static pthread_mutex_t table_mtx[16];
 #endif
 
-
+		/// Guards the numbering of the destinations of the set being written.
 		inline static void route_map_lock() {
 #ifdef MULTI_THREAD
 			int error = pthread_mutex_lock(&route_map_mtx);
@@ -319,26 +349,34 @@ public:
 #endif
 			return;
 		}
-	};
 
+		/// Guards this table while it is written; tables share a small number of locks.
+		inline void table_lock() {
+#ifdef MULTI_THREAD
+			int error = pthread_mutex_lock(&table_mtx[((size_t)this >> 4) & 15]);
+			assert(error == 0);
+			(void)error;
+#endif
+			return;
+		}
 
+		inline void table_unlock() {
+#ifdef MULTI_THREAD
+			int error = pthread_mutex_unlock(&table_mtx[((size_t)this >> 4) & 15]);
+			assert(error == 0);
+			(void)error;
+#endif
+			return;
+		}
+	};
 
-	// Likewise, out of caution, put this here for the same reason.
-	// n_bags must be fairly low as there are 2 maps per way and usually zero elements per way, up to ~150 in high cases and ~1500 in highest cases
-	//typedef ordered_vector_tpl<koord, uint32> private_car_route_map;
-	//typedef std::unordered_map<koord, koord3d> private_car_route_map_2;
-	private_car_route_map private_car_routes[2][5];
-	//private_car_route_map_2 private_car_routes_std[2];
+	private_car_route_map private_car_routes[2];
 	static uint32 private_car_routes_currently_reading_element;
 	static uint32 get_private_car_routes_currently_writing_element() { return private_car_routes_currently_reading_element == 1 ? 0 : 1; }
 
-	static void private_car_backtrace_begin();
-	static void private_car_backtrace_end();
-	void private_car_backtrace_add(koord destination, koord3d next_tile);
-	void private_car_backtrace_inc(koord3d next_tile);
-
-	static private_car_route_map* private_car_backtrace_last_route_map;
-	static uint8 private_car_backtrace_last_idx;
+	/// Records that private car routes to the destinations (see register_private_car_destination()) pass over this way to next_tile, or end here if next_tile is invalid.
+	void private_car_backtrace_add(const uint32 *destination_ids, uint8 count, koord3d next_tile);
+	static uint32 register_private_car_destination(koord destination) { return private_car_route_map::register_destination(get_private_car_routes_currently_writing_element(), destination); }
 
 	void add_private_car_route(koord dest, koord3d next_tile);
 	bool has_private_car_route(koord dest) const;
@@ -428,6 +466,9 @@ public:
 
 	waytype_t get_waytype() const OVERRIDE { return wtyp; }
 
+	uint32 get_landmark_index() const { return landmark_index; }
+	void set_landmark_index(uint32 index) { landmark_index = index; }
+
 	inline bool is_rail_type() const { return wtyp == track_wt || wtyp == maglev_wt || wtyp == tram_wt || wtyp == narrowgauge_wt || wtyp == monorail_wt;  }
 
 	/**
@@ -27,6 +27,10 @@ bool env_t::simple_drawing = false;
 bool env_t::simple_drawing_fast_forward = true;
 sint16 env_t::simple_drawing_normal = 4;
 sint16 env_t::simple_drawing_default = 24;
+uint32 env_t::image_cache_budget = 0;
+bool env_t::image_cache_prewarm = false;
+bool env_t::background_rezoom = true;
+bool env_t::static_layer_cache = false;
 uint8 env_t::follow_convoi_underground = 2;
 
 char env_t::data_dir[PATH_MAX];
@@ -64,6 +68,8 @@ sint32 env_t::server_frames_ahead = 4;
 sint32 env_t::additional_client_frames_behind = 4;
 sint32 env_t::network_frames_per_step = 4;
 uint32 env_t::server_sync_steps_between_checks = 24;
+uint32 env_t::server_frames_before_join = 64;
+bool env_t::network_state_hashes = false;
 bool env_t::pause_server_no_clients = false;
 bool env_t::server_runs_background_tasks_when_paused = false;
 
@@ -133,6 +139,7 @@ sint32 env_t::intercity_road_length;
 plainstring env_t::river_type[10];
 uint8 env_t::river_types;
 sint32 env_t::autosave;
+bool env_t::background_autosave;
 uint32 env_t::fps;
 uint32 env_t::ff_fps;
 sint16 env_t::max_acceleration;
@@ -266,6 +273,7 @@ void env_t::init()
 
 	// autosave every x months (0=off)
 	autosave = 0;
+	background_autosave = false;
 
 	// default: make 25 frames per second (if possible) and 10 for faster fast forward
 	fps = 25;
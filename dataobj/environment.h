@@ -76,6 +76,16 @@ public:
 	/// @see karte_t::interactive()
 	static uint32 server_sync_steps_between_checks;
 
+	/// number of sync_steps the server waits before it saves the game for a joining client,
+	/// so that all clients asking to join meanwhile receive the same game
+	/// @see nwc_join_t::execute()
+	static uint32 server_frames_before_join;
+
+	/// calculate hashes of the state of convoys, stops, factories, cities and track reservations
+	/// after each step, to find out where a network game went out of sync
+	/// @see state_hashes_t
+	static bool network_state_hashes;
+
 	/// when true, restore the windows from a savegame
 	static bool restore_UI;
 
@@ -376,6 +386,18 @@ public:
 	/// always use fast drawing in fast forward
 	static bool simple_drawing_fast_forward;
 
+	/// memory for zoomed and player coloured images in MiB, least recently drawn ones are freed above (0 = no limit)
+	static uint32 image_cache_budget;
+
+	/// zoom and colour the images of the last frame at once when zooming
+	static bool image_cache_prewarm;
+
+	/// zoom the images drawn before by the worker threads after zooming, instead of when they are drawn
+	static bool background_rezoom;
+
+	/// keep the ground and ways of the main view in a cache, and draw them again only where they changed
+	static bool static_layer_cache;
+
 	/// format in which date is shown
 	enum date_fmt {
 		DATE_FMT_SEASON             = 0,
@@ -467,6 +489,9 @@ public:
 	/// do autosave every month?
 	static sint32 autosave;
 
+	/// save autosaves in a copy of the process while the game goes on (not on Windows)? Needed for autosaves of network servers.
+	static bool background_autosave;
+
 
 	/**
 	 * @name Midi/sound options
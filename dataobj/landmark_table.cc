@@ -0,0 +1,362 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include "landmark_table.h"
+
+#include "../simdebug.h"
+#include "../simworld.h"
+#include "../boden/grund.h"
+#include "../boden/wege/weg.h"
+#include "../utils/job_scheduler.h"
+
+
+landmark_table_t::table_t landmark_table_t::tables[landmark_table_t::table_count];
+vector_tpl<landmark_table_t::change_t> landmark_table_t::pending_changes;
+bool landmark_table_t::rebuild_requested = true;
+uint32 landmark_table_t::changes_since_rebuild = 0;
+bool landmark_table_t::building = false;
+
+static job_scheduler_t::job_t build_job(NULL, NULL);
+
+
+sint8 landmark_table_t::get_table_index(waytype_t wt)
+{
+	switch(  wt  ) {
+		case road_wt:        return 0;
+		case track_wt:       return 1;
+		case tram_wt:        return 2;
+		case monorail_wt:    return 3;
+		case maglev_wt:      return 4;
+		case narrowgauge_wt: return 5;
+		default:             return -1;
+	}
+}
+
+
+landmark_table_t::target_t::target_t(const grund_t *gr, waytype_t wt) :
+	distances(NULL),
+	way_count(0)
+{
+	const sint8 t = get_table_index(wt);
+	if(  t < 0  ||  gr == NULL  ||  !tables[t].ready  ) {
+		return;
+	}
+	const weg_t *w = gr->get_weg(wt);
+	const table_t &table = tables[t];
+	if(  w == NULL  ||  w->get_landmark_index() >= table.way_count  ) {
+		return;
+	}
+	distances = table.distances.begin();
+	way_count = table.way_count;
+	const uint16 *d = distances + w->get_landmark_index() * landmark_count;
+	for(  uint8 l = 0;  l < landmark_count;  l++  ) {
+		target_distance[l] = d[l];
+	}
+}
+
+
+uint32 landmark_table_t::target_t::get_lower_bound(const weg_t *w) const
+{
+	if(  distances == NULL  ||  w == NULL  ||  w->get_landmark_index() >= way_count  ) {
+		return 0;
+	}
+	const uint16 *d = distances + w->get_landmark_index() * landmark_count;
+	uint32 bound = 0;
+	for(  uint8 l = 0;  l < landmark_count;  l++  ) {
+		if(  d[l] == unreachable  ||  target_distance[l] == unreachable  ) {
+			continue;
+		}
+		const uint32 difference = d[l] > target_distance[l] ? d[l] - target_distance[l] : target_distance[l] - d[l];
+		bound = max(bound, difference);
+	}
+	return bound;
+}
+
+
+// breadth first search over the copied connections, storing the distances to one landmark
+static void measure_from_landmark(const uint32 *neighbours, uint16 *distances, const uint32 landmark, const uint8 column, vector_tpl<uint32> &queue)
+{
+	const uint8 landmark_count = landmark_table_t::landmark_count;
+	queue.clear();
+	distances[landmark * landmark_count + column] = 0;
+	queue.append(landmark);
+	for(  uint32 head = 0;  head < queue.get_count();  head++  ) {
+		const uint32 i = queue[head];
+		const uint16 next_distance = distances[i * landmark_count + column] + 1;
+		if(  next_distance >= landmark_table_t::unreachable  ) {
+			continue;
+		}
+		for(  uint8 r = 0;  r < 4;  r++  ) {
+			const uint32 n = neighbours[i * 4 + r];
+			if(  n != landmark_table_t::no_index  &&  distances[n * landmark_count + column] == landmark_table_t::unreachable  ) {
+				distances[n * landmark_count + column] = next_distance;
+				queue.append(n);
+			}
+		}
+	}
+}
+
+
+void landmark_table_t::build_table(table_t &table)
+{
+	const uint32 way_count = table.way_count;
+	table.distances.set_count(way_count * landmark_count);
+	uint16 *distances = table.distances.begin();
+	for(  uint32 i = 0;  i < way_count * landmark_count;  i++  ) {
+		distances[i] = unreachable;
+	}
+
+	vector_tpl<uint32> queue(way_count);
+
+	// start far away from an arbitrary way
+	measure_from_landmark(table.neighbours.begin(), distances, 0, 0, queue);
+	uint32 landmark = queue[queue.get_count() - 1];
+	for(  uint32 i = 0;  i < way_count;  i++  ) {
+		distances[i * landmark_count] = unreachable;
+	}
+
+	// each further landmark is the way furthest from all landmarks so far;
+	// ways which none of them reaches come first, so that every network gets one
+	vector_tpl<uint16> nearest(way_count);
+	nearest.set_count(way_count);
+	for(  uint32 i = 0;  i < way_count;  i++  ) {
+		nearest[i] = unreachable;
+	}
+	for(  uint8 l = 0;  l < landmark_count;  l++  ) {
+		measure_from_landmark(table.neighbours.begin(), distances, landmark, l, queue);
+
+		uint16 furthest = 0;
+		for(  uint32 i = 0;  i < way_count;  i++  ) {
+			nearest[i] = min(nearest[i], distances[i * landmark_count + l]);
+			if(  nearest[i] > furthest  ) {
+				furthest = nearest[i];
+				landmark = i;
+			}
+		}
+		if(  furthest == 0  ) {
+			// every way is a landmark
+			break;
+		}
+	}
+}
+
+
+void landmark_table_t::build_task(void *, uint32 task)
+{
+	if(  tables[task].way_count > 0  ) {
+		build_table(tables[task]);
+	}
+}
+
+
+void landmark_table_t::start_rebuild(karte_t *welt)
+{
+	for(  uint8 t = 0;  t < table_count;  t++  ) {
+		tables[t].ready = false;
+		tables[t].way_count = 0;
+		tables[t].distances.clear();
+		tables[t].neighbours.clear();
+	}
+
+	// the crow flies straight enough on small maps
+	const uint32 min_map_size = welt->get_settings().get_route_landmarks_min_map_size();
+	if(  (uint32)max(welt->get_size().x, welt->get_size().y) < min_map_size  ) {
+		return;
+	}
+
+	// number the ways
+	FOR(vector_tpl<weg_t *>, const w, weg_t::get_alle_wege()) {
+		const sint8 t = get_table_index(w->get_waytype());
+		if(  t >= 0  ) {
+			w->set_landmark_index(tables[t].way_count++);
+		}
+	}
+
+	// copy their connections, so that the tables can be built while the game goes on
+	for(  uint8 t = 0;  t < table_count;  t++  ) {
+		tables[t].neighbours.set_count(tables[t].way_count * 4);
+	}
+	FOR(vector_tpl<weg_t *>, const w, weg_t::get_alle_wege()) {
+		const waytype_t wt = w->get_waytype();
+		const sint8 t = get_table_index(wt);
+		if(  t < 0  ) {
+			continue;
+		}
+		const grund_t *gr = welt->lookup(w->get_pos());
+		uint32 *neighbours = tables[t].neighbours.begin() + w->get_landmark_index() * 4;
+		for(  uint8 r = 0;  r < 4;  r++  ) {
+			grund_t *to;
+			const weg_t *next = gr  &&  gr->get_neighbour(to, wt, ribi_t::nesw[r]) ? to->get_weg(wt) : NULL;
+			neighbours[r] = next ? next->get_landmark_index() : no_index;
+		}
+	}
+
+	// without workers, the tables are built at once
+	build_job.function = &build_task;
+	job_scheduler_t::submit(build_job, table_count);
+	building = true;
+}
+
+
+void landmark_table_t::finish_rebuild()
+{
+	if(  building  ) {
+		job_scheduler_t::wait(build_job);
+	}
+	building = false;
+
+	for(  uint8 t = 0;  t < table_count;  t++  ) {
+		table_t &table = tables[t];
+		if(  table.way_count > 0  &&  !table.ready  ) {
+			table.ready = true;
+			vector_tpl<uint32> no_neighbours;
+			swap(table.neighbours, no_neighbours);
+			DBG_MESSAGE("landmark_table_t::finish_rebuild()", "table %i: %u ways", t, table.way_count);
+		}
+	}
+}
+
+
+// @returns the index of this way, after adding it to the table if it is new
+static uint32 get_way_index(vector_tpl<uint16> &distances, uint32 &way_count, weg_t *w)
+{
+	if(  w->get_landmark_index() >= way_count  ) {
+		w->set_landmark_index(way_count++);
+		for(  uint8 l = 0;  l < landmark_table_t::landmark_count;  l++  ) {
+			distances.append(landmark_table_t::unreachable);
+		}
+	}
+	return w->get_landmark_index();
+}
+
+
+void landmark_table_t::apply_pending_changes(karte_t *welt)
+{
+	vector_tpl<grund_t *> queue;
+	FOR(vector_tpl<change_t>, const& change, pending_changes) {
+		const sint8 t = get_table_index(change.wt);
+		grund_t *gr = welt->lookup(change.pos);
+		weg_t *w = gr ? gr->get_weg(change.wt) : NULL;
+		if(  t < 0  ||  !tables[t].ready  ||  w == NULL  ) {
+			continue;
+		}
+		table_t &table = tables[t];
+
+		// the way may now be closer to the landmarks through its neighbours ...
+		const uint32 index = get_way_index(table.distances, table.way_count, w);
+		for(  uint8 r = 0;  r < 4;  r++  ) {
+			grund_t *to;
+			weg_t *next = gr->get_neighbour(to, change.wt, ribi_t::nesw[r]) ? to->get_weg(change.wt) : NULL;
+			if(  next == NULL  ) {
+				continue;
+			}
+			const uint32 n = get_way_index(table.distances, table.way_count, next);
+			uint16 *distances = table.distances.begin();
+			for(  uint8 l = 0;  l < landmark_count;  l++  ) {
+				const uint16 d = distances[n * landmark_count + l];
+				if(  d + 1 < distances[index * landmark_count + l]  ) {
+					distances[index * landmark_count + l] = d + 1;
+				}
+			}
+		}
+
+		// ... and the ways beyond it closer through it
+		queue.clear();
+		queue.append(gr);
+		for(  uint32 head = 0;  head < queue.get_count();  head++  ) {
+			grund_t *from = queue[head];
+			const uint32 i = from->get_weg(change.wt)->get_landmark_index();
+			for(  uint8 r = 0;  r < 4;  r++  ) {
+				grund_t *to;
+				weg_t *next = from->get_neighbour(to, change.wt, ribi_t::nesw[r]) ? to->get_weg(change.wt) : NULL;
+				if(  next == NULL  ) {
+					continue;
+				}
+				const uint32 n = get_way_index(table.distances, table.way_count, next);
+				uint16 *distances = table.distances.begin();
+				bool closer = false;
+				for(  uint8 l = 0;  l < landmark_count;  l++  ) {
+					const uint16 d = distances[i * landmark_count + l];
+					if(  d + 1 < distances[n * landmark_count + l]  ) {
+						distances[n * landmark_count + l] = d + 1;
+						closer = true;
+					}
+				}
+				if(  closer  ) {
+					queue.append(to);
+				}
+			}
+		}
+	}
+	pending_changes.clear();
+}
+
+
+void landmark_table_t::way_changed(koord3d pos, waytype_t wt)
+{
+	if(  get_table_index(wt) < 0  ) {
+		return;
+	}
+	change_t change;
+	change.pos = pos;
+	change.wt = wt;
+	pending_changes.append(change);
+	changes_since_rebuild++;
+}
+
+
+void landmark_table_t::way_removed()
+{
+	changes_since_rebuild++;
+}
+
+
+void landmark_table_t::new_month()
+{
+	if(  changes_since_rebuild > 0  ) {
+		rebuild_requested = true;
+	}
+}
+
+
+void landmark_table_t::step(karte_t *welt)
+{
+	finish_rebuild();
+
+	if(  rebuild_requested  ) {
+		rebuild_requested = false;
+		changes_since_rebuild = 0;
+		pending_changes.clear();
+		start_rebuild(welt);
+		return;
+	}
+
+	if(  !pending_changes.empty()  ) {
+		apply_pending_changes(welt);
+	}
+}
+
+
+void landmark_table_t::rotate90(sint16 y_size)
+{
+	FOR(vector_tpl<change_t>, & change, pending_changes) {
+		change.pos.rotate90(y_size);
+	}
+}
+
+
+void landmark_table_t::clear()
+{
+	finish_rebuild();
+	for(  uint8 t = 0;  t < table_count;  t++  ) {
+		tables[t].ready = false;
+		tables[t].way_count = 0;
+		tables[t].distances.clear();
+		tables[t].neighbours.clear();
+	}
+	pending_changes.clear();
+	rebuild_requested = true;
+	changes_since_rebuild = 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_LANDMARK_TABLE_H
+#define DATAOBJ_LANDMARK_TABLE_H
+
+
+#include "../simtypes.h"
+#include "koord3d.h"
+
+#include "../tpl/vector_tpl.h"
+
+class karte_t;
+class grund_t;
+class weg_t;
+
+
+/**
+ * Landmark distance tables of the way networks, which give the convoy route
+ * search a lower bound of the remaining distance to its target (ALT heuristic).
+ * For a few landmark tiles per waytype, the number of tiles to every way of that
+ * waytype is stored. By the triangle inequality, no route from a way to the target
+ * can be shorter than the difference of their distances to any landmark. Unlike
+ * the distance as the crow flies, this bound follows winding networks.
+ *
+ * The tables are built by the job scheduler from a copy of the network connections
+ * taken at step(), and are used from the next step() on. Ways built in between
+ * are added at step() and shorten the stored distances where needed. Removed ways
+ * leave the stored distances too short, which keeps them a valid lower bound, until
+ * the next full rebuild at the start of a month.
+ *
+ * All changes happen in step(), while no convoy route searches run, and depend
+ * only on the way network, so that all clients of a network game use the same tables.
+ */
+class landmark_table_t
+{
+public:
+	enum { landmark_count = 8 };
+
+	static const uint32 no_index = UINT32_MAX_VALUE;
+
+	// stored for ways which cannot be reached from a landmark, or are too far away
+	static const uint16 unreachable = 0xFFFF;
+
+	/**
+	 * Distances of a search target to the landmarks of its waytype,
+	 * looked up once per route search.
+	 */
+	class target_t
+	{
+		const uint16 *distances;
+		uint32 way_count;
+		uint16 target_distance[landmark_count];
+
+	public:
+		target_t(const grund_t *gr, waytype_t wt);
+
+		/// @returns a lower bound of the number of tiles from way @p w to the target, 0 if not known
+		uint32 get_lower_bound(const weg_t *w) const;
+	};
+
+private:
+	enum { table_count = 6 };
+
+	struct table_t
+	{
+		// landmark_count entries per way, in the order of the way indices
+		vector_tpl<uint16> distances;
+		uint32 way_count;
+		bool ready;
+
+		// the connections of the ways while the table is being built: four entries per way
+		vector_tpl<uint32> neighbours;
+	};
+
+	static table_t tables[table_count];
+
+	struct change_t
+	{
+		koord3d pos;
+		waytype_t wt;
+	};
+
+	// ways built or connected since the last step()
+	static vector_tpl<change_t> pending_changes;
+
+	static bool rebuild_requested;
+	static uint32 changes_since_rebuild;
+
+	static bool building;
+
+	/// @returns the table of this waytype, or -1 if it has none
+	static sint8 get_table_index(waytype_t wt);
+
+	/// Copies the connections of all ways and starts building the tables
+	static void start_rebuild(karte_t *welt);
+
+	/// Waits for the tables being built, if any, and takes them into use
+	static void finish_rebuild();
+
+	/// Computes the distances of one table from its copy of the connections
+	static void build_table(table_t &table);
+
+	static void apply_pending_changes(karte_t *welt);
+
+	/// Task of the job which builds the tables, one per table
+	static void build_task(void *data, uint32 task);
+
+public:
+
+	/// Called when a way is built or gains a connection
+	static void way_changed(koord3d pos, waytype_t wt);
+
+	/// Called when a way is removed
+	static void way_removed();
+
+	/// Builds the tables anew at the next step(), to forget removed ways
+	static void new_month();
+
+	static void request_rebuild() { rebuild_requested = true; }
+
+	/**
+	 * Updates the tables. Must be called from the main thread
+	 * while no convoy route searches are running.
+	 */
+	static void step(karte_t *welt);
+
+	static void rotate90(sint16 y_size);
+
+	static void clear();
+};
+
+#endif
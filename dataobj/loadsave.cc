@@ -21,6 +21,7 @@
 #include "../utils/simstring.h"
 
 #include "../io/rdwr/bzip2_file_rdwr_stream.h"
+#include "../io/rdwr/chunked_zlib_file_rdwr_stream.h"
 #include "../io/rdwr/raw_file_rdwr_stream.h"
 #include "../io/rdwr/zlib_file_rdwr_stream.h"
 #if USE_ZSTD
@@ -327,6 +328,10 @@ loadsave_t::file_status_t loadsave_t::rd_open(const char *filename_utf8)
 			// fallthrough
 		case file_info_t::TYPE_ZIPPED:
 			mode |= zipped;
+			if(  chunked_zlib_file_rdwr_stream_t::is_chunked_file(filename_utf8)  ) {
+				// decompressed in parallel
+				stream = new chunked_zlib_file_rdwr_stream_t(filename_utf8, false, 0); break;
+			}
 			stream = new zlib_file_rdwr_stream_t(filename_utf8, false, 0); break;
 
 		case file_info_t::TYPE_XML:
@@ -418,7 +423,7 @@ loadsave_t::file_status_t loadsave_t::wr_open( const char *filename_utf8, mode_t
 		case zstd: stream = new zstd_file_rdwr_stream_t(filename_utf8, true, level); break;
 #endif
 		case bzip2:  stream = new bzip2_file_rdwr_stream_t(filename_utf8, true);       break;
-		case zipped: stream = new zlib_file_rdwr_stream_t(filename_utf8, true, level); break;
+		case zipped: stream = new chunked_zlib_file_rdwr_stream_t(filename_utf8, true, level); break;
 		case binary: stream = new raw_file_rdwr_stream_t(filename_utf8, true);         break;
 		default:
 			dbg->error("loadsave_t::wr_open", "Unsupported save file compression");
@@ -37,13 +37,6 @@ class marker_t {
 	/// hashtable to mark non-ground tiles (bridges, tunnels)
 	ptrhashtable_tpl <const grund_t *, bool, N_BAGS_LARGE> more;
 
-	/**
-	 * Initializes marker. Set all tiles to not marked.
-	 * @param world_size_x x-size of map
-	 * @param world_size_y y-size of map
-	 */
-	void init(int world_size_x, int world_size_y);
-
 	/// the instance (single threaded only)
 	static marker_t the_instance;
 
@@ -55,6 +48,14 @@ public:
 	marker_t() : bits(NULL) { bits_length = 0; init(0, 0); }
 	~marker_t();
 
+	/**
+	 * Initializes marker. Set all tiles to not marked.
+	 * Searches needing a second closed list can keep a marker of their own.
+	 * @param world_size_x x-size of map
+	 * @param world_size_y y-size of map
+	 */
+	void init(int world_size_x, int world_size_y);
+
 	/**
 	 * Return handle to marker instance.
 	 * @param world_size_x x-size of map
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include "road_graph.h"
+
+#include "../simdebug.h"
+#include "../simworld.h"
+#include "../simcity.h"
+#include "../boden/grund.h"
+#include "../boden/wege/strasse.h"
+#include "../vehicle/simvehicle.h"
+
+
+vector_tpl<road_graph_t::node_t> road_graph_t::nodes;
+vector_tpl<road_graph_t::edge_t> road_graph_t::edges;
+vector_tpl<road_graph_t::edge_tile_t> road_graph_t::tiles;
+
+
+bool road_graph_t::is_node(karte_t *welt, const grund_t *gr, const weg_t *w)
+{
+	// possible destinations of private cars
+	if(  w->connected_buildings.get_count() > 0  ) {
+		return true;
+	}
+	const koord k = gr->get_pos().get_2d();
+	const stadt_t *city = welt->access(k)->get_city();
+	if(  city  &&  city->get_townhall_road() == k  ) {
+		return true;
+	}
+
+	// anything but a plain two-way road may branch, end or restrict the direction of travel
+	const ribi_t::ribi ribi = gr->get_weg_ribi_unmasked(road_wt);
+	if(  !ribi_t::is_twoway(ribi)  ||  gr->get_weg_ribi(road_wt) != ribi  ||  w->has_sign()  ) {
+		return true;
+	}
+	return false;
+}
+
+
+void road_graph_t::clear()
+{
+	nodes.clear();
+	edges.clear();
+	tiles.clear();
+}
+
+
+void road_graph_t::rebuild(karte_t *welt)
+{
+	clear();
+
+	road_vehicle_t checker;
+	private_car_destination_finder_t finder(welt, &checker, NULL);
+
+	// find the nodes
+	FOR(vector_tpl<weg_t *>, const w, weg_t::get_alle_wege()) {
+		if(  w->get_waytype() != road_wt  ) {
+			continue;
+		}
+		strasse_t *const str = (strasse_t *)w;
+		str->set_road_graph_node(no_node);
+
+		const grund_t *gr = welt->lookup(w->get_pos());
+		if(  gr  &&  finder.check_next_tile(gr)  &&  is_node(welt, gr, w)  ) {
+			str->set_road_graph_node(nodes.get_count());
+			node_t node;
+			node.pos = gr->get_pos();
+			node.first_edge = 0;
+			node.edge_count = 0;
+			nodes.append(node);
+		}
+	}
+
+	// follow the roads leaving each node up to the next node
+	for(  uint32 i = 0;  i < nodes.get_count();  i++  ) {
+		node_t &node = nodes[i];
+		node.first_edge = edges.get_count();
+
+		const grund_t *gr = welt->lookup(node.pos);
+		const ribi_t::ribi ribi = finder.get_ribi(gr);
+		for(  int r = 0;  r < 4;  r++  ) {
+			grund_t *to;
+			if(  (ribi & ribi_t::nesw[r]) == 0  ||  !gr->get_neighbour(to, road_wt, ribi_t::nesw[r])  ||  !finder.check_next_tile(to)  ) {
+				continue;
+			}
+
+			edge_t edge;
+			edge.first_tile = tiles.get_count();
+			ribi_t::ribi direction = ribi_t::nesw[r];
+			bool reached_node = false;
+			while(  tiles.get_count() - edge.first_tile < max_edge_length  ) {
+				edge_tile_t tile;
+				tile.pos = to->get_pos();
+				tile.ribi_from = direction;
+				tiles.append(tile);
+
+				const strasse_t *str = (const strasse_t *)to->get_weg(road_wt);
+				if(  str->get_road_graph_node() != no_node  ) {
+					reached_node = true;
+					break;
+				}
+
+				// a plain road tile has only one way on
+				const ribi_t::ribi onward = finder.get_ribi(to) & ~ribi_t::backward(direction);
+				grund_t *next;
+				if(  !ribi_t::is_single(onward)  ||  !to->get_neighbour(next, road_wt, onward)  ||  !finder.check_next_tile(next)  ) {
+					break;
+				}
+				to = next;
+				direction = onward;
+			}
+
+			if(  reached_node  ) {
+				edge.tile_count = tiles.get_count() - edge.first_tile;
+				edges.append(edge);
+			}
+			else {
+				// a dead end without destinations
+				while(  tiles.get_count() > edge.first_tile  ) {
+					tiles.pop_back();
+				}
+			}
+		}
+
+		node.edge_count = edges.get_count() - node.first_edge;
+	}
+
+	DBG_MESSAGE("road_graph_t::rebuild()", "%u nodes, %u edges over %u tiles", nodes.get_count(), edges.get_count(), tiles.get_count());
+}
+
+
+void road_graph_t::way_changed(weg_t *w)
+{
+	if(  w->get_waytype() == road_wt  ) {
+		((strasse_t *)w)->set_road_graph_node(changed_tile);
+	}
+}
+
+
+bool road_graph_t::has_changed(const weg_t *w)
+{
+	return ((const strasse_t *)w)->get_road_graph_node() == changed_tile;
+}
+
+
+const road_graph_t::node_t *road_graph_t::get_node(const grund_t *gr)
+{
+	const strasse_t *str = (const strasse_t *)gr->get_weg(road_wt);
+	if(  str == NULL  ) {
+		return NULL;
+	}
+	const uint32 index = str->get_road_graph_node();
+	if(  index >= nodes.get_count()  ||  nodes[index].pos != gr->get_pos()  ) {
+		// built after the graph, or the graph is not available
+		return NULL;
+	}
+	return &nodes[index];
+}
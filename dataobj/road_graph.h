@@ -0,0 +1,101 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_ROAD_GRAPH_H
+#define DATAOBJ_ROAD_GRAPH_H
+
+
+#include "../simtypes.h"
+#include "koord3d.h"
+#include "ribi.h"
+
+#include "../tpl/vector_tpl.h"
+
+class karte_t;
+class grund_t;
+class weg_t;
+
+
+/**
+ * Contracted graph of the road network for the private car route checker.
+ * The nodes are the road tiles at which a private car route can branch or end:
+ * junctions, dead ends, one-way or signed tiles, tiles with connected buildings
+ * and townhall roads. Each run of plain road tiles between two nodes is an edge,
+ * which the route checker crosses without searching its tiles one by one.
+ *
+ * The graph is rebuilt whenever the private car routes are refreshed. Roads which
+ * are built, removed or changed in between are marked by way_changed(), and the
+ * route checker searches on from a marked tile tile by tile. The costs of the tiles
+ * are not stored, but taken from the ways when the edges are crossed.
+ */
+class road_graph_t
+{
+public:
+	// a tile of an edge, in driving order
+	struct edge_tile_t
+	{
+		koord3d pos;
+		uint8 ribi_from;	// direction of travel onto this tile
+	};
+
+	// a run of tiles leaving a node; the last tile is the next node
+	struct edge_t
+	{
+		uint32 first_tile;
+		uint32 tile_count;
+	};
+
+	struct node_t
+	{
+		koord3d pos;
+		uint32 first_edge;
+		uint32 edge_count;
+	};
+
+	static const uint32 no_node = UINT32_MAX_VALUE;
+
+	// marks road tiles changed since the graph was built
+	static const uint32 changed_tile = UINT32_MAX_VALUE - 1;
+
+private:
+	static vector_tpl<node_t> nodes;
+	static vector_tpl<edge_t> edges;
+	static vector_tpl<edge_tile_t> tiles;
+
+	// edges are abandoned if they become longer than this, as they cannot lead to a node
+	static const uint32 max_edge_length = 65535;
+
+	static bool is_node(karte_t *welt, const grund_t *gr, const weg_t *w);
+
+public:
+	/**
+	 * Rebuilds the graph from the current road network.
+	 * Must not be called while private car routes are being checked.
+	 */
+	static void rebuild(karte_t *welt);
+
+	static void clear();
+
+	/**
+	 * Marks the tile of @p w, if it is a road, as changed since the graph was built.
+	 * Called when a road is built, extended, signed or gets or loses a connected building.
+	 */
+	static void way_changed(weg_t *w);
+
+	/// @returns whether the road @p w changed since the graph was built
+	static bool has_changed(const weg_t *w);
+
+	/// @returns the node at this tile, or NULL if the tile is not a node of the graph
+	static const node_t *get_node(const grund_t *gr);
+
+	static const edge_t &get_edge(const uint32 index) { return edges[index]; }
+
+	static const edge_tile_t &get_edge_tile(const uint32 index) { return tiles[index]; }
+
+	static uint32 get_node_count() { return nodes.get_count(); }
+	static uint32 get_edge_tile_count() { return tiles.get_count(); }
+};
+
+#endif
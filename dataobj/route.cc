@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include <limits.h>
+#include <unordered_map>
 
 #include "../simworld.h"
 #include "../simcity.h"
@@ -20,6 +21,8 @@
 #include "../ifc/simtestdriver.h"
 #include "loadsave.h"
 #include "route.h"
+#include "road_graph.h"
+#include "landmark_table.h"
 #include "../descriptor/bridge_desc.h"
 #include "../boden/wege/strasse.h"
 #include "../obj/gebaeude.h"
@@ -177,6 +180,78 @@ void route_t::RELEASE_NODES(uint8 nodes_index)
 	_nodes_in_use[nodes_index] = false;
 }
 
+/**
+ * Checks the weight limits of the way @p w for a convoy.
+ * @returns true if the convoy should not be routed over this way
+ */
+static inline bool avoid_overweight_way(const weg_t *w, const uint8 enforce_weight_limits, const uint32 axle_load, const uint32 total_weight, const sint32 max_tile_len, const sint32 bridge_tile_count)
+{
+	if(enforce_weight_limits > 1 && w != NULL)
+	{
+		// Bernd Gabriel, Mar 10, 2010: way limit info
+		const uint32 way_max_axle_load = w->get_max_axle_load();
+		const uint32 bridge_weight_limit = w->get_bridge_weight_limit();
+
+		// This ensures that only that part of the convoy that is actually on the bridge counts.
+		uint32 adjusted_convoy_weight = max_tile_len == 0 ? total_weight : (total_weight * max(bridge_tile_count - 2, 1)) / max_tile_len;
+
+		if(axle_load > way_max_axle_load || adjusted_convoy_weight > bridge_weight_limit)
+		{
+			if(enforce_weight_limits == 2)
+			{
+				// Avoid routing over ways for which the convoy is overweight.
+				return true;
+			}
+			else if((enforce_weight_limits == 3 && (way_max_axle_load == 0 || (axle_load * 100) / way_max_axle_load > 110)) || (bridge_weight_limit == 0 || (adjusted_convoy_weight * 100) / bridge_weight_limit > 110))
+			{
+				// Avoid routing over ways for which the convoy is more than 10% overweight or which have a zero weight limit.
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+/**
+ * Adds the cost of turning from @p parent onto the node @p k, whose ribi_from must be set,
+ * and sets the driving direction of @p k.
+ * @returns false if this turn is not allowed
+ */
+static inline bool add_turn_cost(route_t::ANode *k, const route_t::ANode *parent, const route_t::find_route_flags flags)
+{
+	uint8 current_dir = k->ribi_from;
+	if(parent->parent!=NULL) {
+		current_dir |= parent->ribi_from;
+		if(parent->dir!=current_dir) {
+			k->g += 3;
+			if(ribi_t::is_perpendicular(parent->dir,current_dir))
+			{
+				if(flags == route_t::choose_signal)
+				{
+					// In the case of a choose signal, this will in some situations allow trains to
+					// route in very suboptimal ways if a route is part blocked: see here for an explanation:
+					// http://forum.simutrans.com/index.php?topic=14839.msg146645#msg146645
+					return false;
+				}
+				else
+				{
+					// discourage v turns heavily
+					k->g += 25;
+				}
+			}
+			else if(parent->parent->dir!=parent->dir  &&  parent->parent->parent!=NULL)
+			{
+				// discourage 90 degree turns
+				k->g += 10;
+			}
+		}
+	}
+	k->dir = current_dir;
+	return true;
+}
+
+
 /**
  * find the route to an unknown location
  */
@@ -486,7 +561,12 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 				koord3d previous = koord3d::invalid;
 				weg_t* w;
 				if(fresh_destination && tmp != NULL){
-					weg_t::private_car_backtrace_begin();
+					// Number the destinations once, so that writing the route over each way only takes that way's lock.
+					const uint32 destination_ids[3] = {
+						weg_t::register_private_car_destination(industry_destination_pos),
+						weg_t::register_private_car_destination(attraction_destination_pos),
+						weg_t::register_private_car_destination(city_destination_pos)
+					};
 					while (fresh_destination && tmp != NULL)
 					{
 						private_car_route_step_counter++;
@@ -498,22 +578,7 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 							// that are currently being read.
 
 							// Also, the route is iterated here *backwards*.
-
-							if (industry_destination_pos != koord::invalid)
-							{
-								w->private_car_backtrace_add(industry_destination_pos, previous);
-							}
-
-							if (attraction_destination_pos != koord::invalid)
-							{
-								w->private_car_backtrace_add(attraction_destination_pos, previous);
-							}
-
-							if (city_destination_pos != koord::invalid)
-							{
-								w->private_car_backtrace_add(city_destination_pos, previous);
-							}
-							w->private_car_backtrace_inc(previous);
+							w->private_car_backtrace_add(destination_ids, 3, previous);
 						}
 
 						// Old route storage - we probably no longer need this.
@@ -522,7 +587,6 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 						previous = tmp->gr->get_pos();
 						tmp = tmp->parent;
 					}
-					weg_t::private_car_backtrace_end();
 				}
 #ifdef MULTI_THREAD
 				uint32 max_steps;
@@ -554,6 +618,75 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 			}
 		}
 
+		if(gr->ist_bruecke())
+		{
+			bridge_tile_count++;
+		}
+		else
+		{
+			bridge_tile_count = 0;
+		}
+
+		// Private cars cross the plain road tiles between junctions and destinations along the edges
+		// of the road graph, without searching these tiles one by one.
+		const road_graph_t::node_t *graph_node = flags == private_car_checker ? road_graph_t::get_node(gr) : NULL;
+		if(graph_node)
+		{
+			for(uint32 e = graph_node->first_edge; e < graph_node->first_edge + graph_node->edge_count; e++)
+			{
+				const road_graph_t::edge_t &edge = road_graph_t::get_edge(e);
+				ANode *parent = tmp;
+				sint32 edge_bridge_tile_count = bridge_tile_count;
+				bool queue_last = false;
+				for(uint32 t = 0; t < edge.tile_count && step < MAX_STEP; t++)
+				{
+					const road_graph_t::edge_tile_t &tile = road_graph_t::get_edge_tile(edge.first_tile + t);
+					grund_t *to = welt->lookup(tile.pos);
+					if(to == NULL || koord_distance(start, tile.pos) >= max_depth || !tdriver->check_next_tile(to) || (is_tall && to->is_height_restricted()))
+					{
+						break;
+					}
+					const weg_t *w = to->get_weg(road_wt);
+					if(w == NULL || avoid_overweight_way(w, enforce_weight_limits, axle_load, total_weight, max_tile_len, edge_bridge_tile_count))
+					{
+						break;
+					}
+
+					ANode* k = &nodes[step++];
+					if (route_t::max_used_steps < step)
+					{
+						route_t::max_used_steps = step;
+					}
+					k->parent = parent;
+					k->gr = to;
+					k->count = parent->count+1;
+					k->f = 0;
+					k->g = parent->g + tdriver->get_cost(to, max_khm, parent->gr->get_pos().get_2d());
+					k->ribi_from = tile.ribi_from;
+					add_turn_cost(k, parent, flags);
+
+					parent = k;
+					edge_bridge_tile_count = to->ist_bruecke() ? edge_bridge_tile_count + 1 : 0;
+
+					// The last tile of the edge is the next node. From a tile changed since the graph
+					// was built, e.g. by a new junction, the search goes on tile by tile.
+					if(t + 1 == edge.tile_count || road_graph_t::has_changed(w))
+					{
+						queue_last = true;
+						break;
+					}
+				}
+
+				if(queue_last && !marker.is_marked(parent->gr))
+				{
+					queue.insert(parent);
+				}
+			}
+
+			start_dir = ribi_t::all;
+			continue;
+		}
+
 		// testing all four possible directions
 		ribi_t::ribi ribi;
 		if(tdriver->get_waytype() == track_wt || tdriver->get_waytype() == tram_wt || tdriver->get_waytype() == monorail_wt || tdriver->get_waytype() == narrowgauge_wt || tdriver->get_waytype() == maglev_wt)
@@ -573,14 +706,6 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 			ribi = tdriver->get_ribi(gr);
 		}
 
-		if(gr->ist_bruecke())
-		{
-			bridge_tile_count++;
-		}
-		else
-		{
-			bridge_tile_count = 0;
-		}
 		for(int r = 0; r < 4; r++)
 		{
 			// a way goes here, and it is not marked (i.e. in the closed list)
@@ -600,28 +725,9 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 					continue;
 				}
 
-				if(enforce_weight_limits > 1 && w != NULL)
+				if(avoid_overweight_way(w, enforce_weight_limits, axle_load, total_weight, max_tile_len, bridge_tile_count))
 				{
-					// Bernd Gabriel, Mar 10, 2010: way limit info
-					const uint32 way_max_axle_load = w->get_max_axle_load();
-					const uint32 bridge_weight_limit = w->get_bridge_weight_limit();
-
-					// This ensures that only that part of the convoy that is actually on the bridge counts.
-					uint32 adjusted_convoy_weight = max_tile_len == 0 ? total_weight : (total_weight * max(bridge_tile_count - 2, 1)) / max_tile_len;
-
-					if(axle_load > way_max_axle_load || adjusted_convoy_weight > bridge_weight_limit)
-					{
-						if(enforce_weight_limits == 2)
-						{
-							// Avoid routing over ways for which the convoy is overweight.
-							continue;
-						}
-						else if((enforce_weight_limits == 3 && (way_max_axle_load == 0 || (axle_load * 100) / way_max_axle_load > 110)) || (bridge_weight_limit == 0 || (adjusted_convoy_weight * 100) / bridge_weight_limit > 110))
-						{
-							// Avoid routing over ways for which the convoy is more than 10% overweight or which have a zero weight limit.
-							continue;
-						}
-					}
+					continue;
 				}
 
 				if(flags == choose_signal && w && w->has_sign())
@@ -648,34 +754,10 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 				k->g = tmp->g + tdriver->get_cost(to, max_khm, gr->get_pos().get_2d());
 				k->ribi_from = ribi_t::nesw[r];
 
-				uint8 current_dir = ribi_t::nesw[r];
-				if(tmp->parent!=NULL) {
-					current_dir |= tmp->ribi_from;
-					if(tmp->dir!=current_dir) {
-						k->g += 3;
-						if(ribi_t::is_perpendicular(tmp->dir,current_dir))
-						{
-							if(flags == choose_signal)
-							{
-								// In the case of a choose signal, this will in some situations allow trains to
-								// route in very suboptimal ways if a route is part blocked: see here for an explanation:
-								// http://forum.simutrans.com/index.php?topic=14839.msg146645#msg146645
-								continue;
-							}
-							else
-							{
-								// discourage v turns heavily
-								k->g += 25;
-							}
-						}
-						else if(tmp->parent->dir!=tmp->dir  &&  tmp->parent->parent!=NULL)
-						{
-							// discourage 90 degree turns
-							k->g += 10;
-						}
-					}
+				if(!add_turn_cost(k, tmp, flags))
+				{
+					continue;
 				}
-				k->dir = current_dir;
 
 				// insert here
 				queue.insert(k);
@@ -743,7 +825,235 @@ ribi_t::ribi *get_next_dirs(const koord3d& gr_pos, const koord3d& ziel)
 }
 
 
-route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d start, const koord3d ziel, test_driver_t* const tdriver, const sint32 max_speed, const sint64 max_cost, const uint32 axle_load, const uint32 convoy_weight, bool is_tall, const sint32 tile_length, koord3d avoid_tile, uint8 start_dir, find_route_flags flags)
+/**
+ * Cost of the curve where the route forms @p last on one tile and @p current on the next one.
+ * @p before is what it formed on the tile ahead of them, if @p has_before.
+ */
+static inline uint32 get_curve_cost(const ribi_t::ribi before, const bool has_before, const ribi_t::ribi last, const ribi_t::ribi current)
+{
+	uint32 cost = 0;
+	if(last!=current) {
+		cost += 30;
+		if(before!=last  &&  has_before) {
+			// discourage 90 degree turns
+			cost += 10;
+		}
+		else if (ribi_t::is_perpendicular(last, current))
+		{
+			// discourage v turns heavily
+			cost += 25;
+		}
+	}
+	return cost;
+}
+
+/**
+ * Cost of the curve when leaving the node @p tmp, which must have a parent,
+ * such that the route forms @p current_dir on it.
+ */
+static inline uint32 get_curve_cost(const route_t::ANode *tmp, const ribi_t::ribi current_dir)
+{
+	return get_curve_cost(tmp->parent->dir, tmp->parent->parent!=NULL, tmp->dir, current_dir);
+}
+
+
+/// How many 45 degree turns are necessary to get from @p current_dir to @p to_target
+static inline sint8 count_turns(ribi_t::ribi to_target, const ribi_t::ribi current_dir)
+{
+	sint8 turns = 0;
+	if (to_target && (to_target != current_dir)) {
+		if (ribi_t::is_single(current_dir) != ribi_t::is_single(to_target)) {
+			to_target = ribi_t::rotate45(to_target);
+			turns++;
+		}
+		while (to_target != current_dir /*&& turns < 126*/) {
+			to_target = ribi_t::rotate90(to_target);
+			turns += 2;
+		}
+		if (turns > 4) turns = 8 - turns;
+	}
+	return turns;
+}
+
+
+route_t::overweight_type route_t::check_overweight(karte_t *welt, const grund_t *to, const weg_t *w, const uint8 enforce_weight_limits, const uint32 axle_load, const uint32 convoy_weight, const sint32 tile_length, sint32 &bridge_tile_count)
+{
+	overweight_type is_overweight = not_overweight;
+	bool check_axle_load = true;
+	// Bernd Gabriel, Mar 10, 2010: way limit info
+	if (to->ist_bruecke() || w->get_desc()->get_styp() == type_elevated || w->get_waytype() == air_wt || w->get_waytype() == water_wt)
+	{
+		// Bridges care about convoy weight, whereas other types of way
+		// care about axle weight.
+		bridge_tile_count++;
+
+		// This is actually maximum convoy weight: the name is odd because of the virtual method.
+		uint32 way_max_convoy_weight = 0;
+		bool has_convoy_weight_limit = true;
+
+		// Trams need to check the weight of the underlying bridge.
+		if (w->get_desc()->get_styp() == type_tram)
+		{
+			const weg_t* underlying_bridge = welt->lookup(w->get_pos())->get_weg(road_wt);
+			if (underlying_bridge)
+			{
+				way_max_convoy_weight = underlying_bridge->get_bridge_weight_limit();
+			}
+			else
+			{
+				has_convoy_weight_limit = false;
+			}
+		}
+		else
+		{
+			way_max_convoy_weight = w->get_bridge_weight_limit();
+		}
+
+		if (has_convoy_weight_limit)
+		{
+			// This ensures that only that part of the convoy that is actually on the bridge counts.
+			const sint32 proper_tile_length = tile_length > 8888 ? tile_length - 8888 : tile_length;
+			uint32 adjusted_convoy_weight = tile_length == 0 ? convoy_weight : (convoy_weight * max(bridge_tile_count - 2, 1)) / proper_tile_length;
+			const uint32 min_weight = min(adjusted_convoy_weight, convoy_weight);
+			if (min_weight > way_max_convoy_weight)
+			{
+				switch (enforce_weight_limits)
+				{
+				case 1:
+				default:
+
+					is_overweight = slowly_only;
+					break;
+
+				case 2:
+
+					is_overweight = cannot_route;
+					break;
+
+				case 3:
+
+					is_overweight = way_max_convoy_weight == 0 || (min_weight * 100) / way_max_convoy_weight > 110 ? cannot_route : slowly_only;
+					break;
+				}
+			}
+			// For a real bridge, also check the axle load of the underlying way.
+			check_axle_load = to->ist_bruecke();
+		}
+	}
+
+	if (check_axle_load)
+	{
+		bridge_tile_count = 0;
+		const uint32 way_max_axle_load = w->get_max_axle_load();
+		max_axle_load = min(max_axle_load, way_max_axle_load);
+		if (axle_load > way_max_axle_load)
+		{
+			switch (enforce_weight_limits)
+			{
+			case 1:
+			default:
+
+				is_overweight = slowly_only;
+				break;
+
+			case 2:
+
+				is_overweight = cannot_route;
+				break;
+
+			case 3:
+
+				is_overweight = way_max_axle_load == 0 || (axle_load * 100) / way_max_axle_load > 110 ? cannot_route : slowly_only;
+				break;
+			}
+		}
+	}
+	return is_overweight;
+}
+
+
+uint32 route_t::get_entry_cost(karte_t *welt, test_driver_t* const tdriver, const grund_t *from, const grund_t *to, const ribi_t::ribi dir, const sint32 max_speed, const bool is_tall, const uint8 enforce_weight_limits, const uint32 axle_load, const uint32 convoy_weight, const sint32 tile_length, sint32 &bridge_tile_count)
+{
+	if(  !tdriver->check_next_tile(to)  ) {
+		return UINT32_MAX_VALUE;
+	}
+
+	// Do not go on a tile where a one way sign forbids going.
+	const waytype_t wegtyp = tdriver->get_waytype();
+	const weg_t *w = to->get_weg(wegtyp);
+	const ribi_t::ribi go_dir = (w == NULL) ? 0 : w->get_ribi_maske();
+	if ((dir&go_dir) != 0)
+	{
+		// Unidirectional signals allow routing in both directions but only act in one direction.
+		const bool is_rail_type = wegtyp == track_wt || wegtyp == narrowgauge_wt || wegtyp == maglev_wt || wegtyp == tram_wt || wegtyp == monorail_wt;
+		if (!is_rail_type || !w->has_signal())
+		{
+			return UINT32_MAX_VALUE;
+		}
+	}
+
+	// Low bridges
+	if (is_tall && to->is_height_restricted())
+	{
+		return UINT32_MAX_VALUE;
+	}
+
+	if (w == NULL)
+	{
+		// either in the air or in water => no costs
+		return 10;
+	}
+
+	overweight_type is_overweight = not_overweight;
+	if (enforce_weight_limits > 0)
+	{
+		is_overweight = check_overweight(welt, to, w, enforce_weight_limits, axle_load, convoy_weight, tile_length, bridge_tile_count);
+		if (is_overweight == cannot_route)
+		{
+			return UINT32_MAX_VALUE;
+		}
+	}
+	return tdriver->get_cost(to, max_speed, from->get_pos().get_2d()) + (is_overweight == slowly_only ? 400 : 0);
+}
+
+
+route_t::search_direction_t route_t::get_convoy_search_direction(const karte_t *welt, koord3d start, koord3d ziel)
+{
+	const uint32 min_distance = welt->get_settings().get_bidirectional_route_search_min_distance();
+	return min_distance > 0 && shortest_distance(start.get_2d(), ziel.get_2d()) >= min_distance ? search_bidirectional : search_forward;
+}
+
+
+uint32 route_t::search_count[2] = { 0, 0 };
+uint64 route_t::expanded_node_count[2] = { 0, 0 };
+#ifdef MULTI_THREAD
+static pthread_mutex_t search_statistics_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void route_t::add_search_statistics(search_direction_t search, uint32 expanded_nodes)
+{
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&search_statistics_mutex);
+#endif
+	// halve the totals now and then, so that the average follows the recent searches
+	if(  search_count[search] >= 65536  ) {
+		search_count[search] /= 2;
+		expanded_node_count[search] /= 2;
+	}
+	search_count[search]++;
+	expanded_node_count[search] += expanded_nodes;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&search_statistics_mutex);
+#endif
+}
+
+uint32 route_t::get_average_expanded_nodes(search_direction_t search)
+{
+	return search_count[search] ? (uint32)(expanded_node_count[search] / search_count[search]) : 0;
+}
+
+
+route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d start, const koord3d ziel, test_driver_t* const tdriver, const sint32 max_speed, const sint64 max_cost, const uint32 axle_load, const uint32 convoy_weight, bool is_tall, const sint32 tile_length, koord3d avoid_tile, uint8 start_dir, find_route_flags flags, search_direction_t search)
 {
 	route_result_t ok = no_route;
 
@@ -763,6 +1073,13 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 		return no_route;
 	}
 
+	// the backward search knows nothing of start directions, avoided tiles and the special cost models,
+	// and jump-point search on water does not work backwards
+	if(  search == search_bidirectional  &&  start != ziel  &&  start_dir == ribi_t::all  &&  avoid_tile == koord3d::invalid  &&  flags == none
+		&&  tdriver->get_waytype() != air_wt  &&  tdriver->get_waytype() != water_wt  ) {
+		return intern_calc_route_bidirectional(welt, start, ziel, tdriver, max_speed, max_cost, axle_load, convoy_weight, is_tall, tile_length);
+	}
+
 	// some thing for the search
 	const waytype_t wegtyp = tdriver->get_waytype();
 	const bool is_airplane = tdriver->get_waytype()==air_wt;
@@ -821,6 +1138,9 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 	const grund_t* avoid_ground = welt->lookup(avoid_tile);
 	marker.mark(avoid_ground);
 
+	// a closer bound of the distance still to go than as the crow flies, if the ways have landmark tables
+	const landmark_table_t::target_t landmarks(welt->lookup(ziel), wegtyp);
+
 	// clear the queue (should be empty anyhow)
 	queue.clear();
 	queue.insert(tmp);
@@ -832,6 +1152,7 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 #endif
 	sint32 bridge_tile_count = 0;
 	uint32 best_distance = 0xFFFF;
+	uint32 expanded_nodes = 0;
 
 	do {
 #ifndef MULTI_THREAD
@@ -865,6 +1186,7 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 			ziel_erreicht = true;
 			break;
 		}
+		expanded_nodes++;
 
 		uint32 topnode_f = !queue.empty() ? queue.front()->f : max_cost;
 		const weg_t* way = gr->get_weg(tdriver->get_waytype());
@@ -932,99 +1254,12 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 				sint32 is_overweight = not_overweight;
 				if (enforce_weight_limits > 0 && w != NULL)
 				{
-					// Bernd Gabriel, Mar 10, 2010: way limit info
-					if (to->ist_bruecke() || w->get_desc()->get_styp() == type_elevated || w->get_waytype() == air_wt || w->get_waytype() == water_wt)
-					{
-						// Bridges care about convoy weight, whereas other types of way
-						// care about axle weight.
-						bridge_tile_count++;
-
-						// This is actually maximum convoy weight: the name is odd because of the virtual method.
-						uint32 way_max_convoy_weight;
-
-						// Trams need to check the weight of the underlying bridge.
-
-						if (w->get_desc()->get_styp() == type_tram)
-						{
-							const weg_t* underlying_bridge = welt->lookup(w->get_pos())->get_weg(road_wt);
-							if (!underlying_bridge)
-							{
-								goto check_axle_load;
-							}
-							way_max_convoy_weight = underlying_bridge->get_bridge_weight_limit();
-
-						}
-						else
-						{
-							way_max_convoy_weight = w->get_bridge_weight_limit();
-						}
-
-						// This ensures that only that part of the convoy that is actually on the bridge counts.
-						const sint32 proper_tile_length = tile_length > 8888 ? tile_length - 8888 : tile_length;
-						uint32 adjusted_convoy_weight = tile_length == 0 ? convoy_weight : (convoy_weight * max(bridge_tile_count - 2, 1)) / proper_tile_length;
-						const uint32 min_weight = min(adjusted_convoy_weight, convoy_weight);
-						if (min_weight > way_max_convoy_weight)
-						{
-							switch (enforce_weight_limits)
-							{
-							case 1:
-							default:
-
-								is_overweight = slowly_only;
-								break;
-
-							case 2:
-
-								is_overweight = cannot_route;
-								break;
-
-							case 3:
-
-								is_overweight = way_max_convoy_weight == 0 || (min_weight * 100) / way_max_convoy_weight > 110 ? cannot_route : slowly_only;
-								break;
-							}
-						}
-						if (to->ist_bruecke())
-						{
-							// For a real bridge, also check the axle load of the underlying way.
-							goto check_axle_load;
-						}
-					}
-					else
-					{
-					check_axle_load:
-						bridge_tile_count = 0;
-						const uint32 way_max_axle_load = w->get_max_axle_load();
-						max_axle_load = min(max_axle_load, way_max_axle_load);
-						if (axle_load > way_max_axle_load)
-						{
-							switch (enforce_weight_limits)
-							{
-							case 1:
-							default:
-
-								is_overweight = slowly_only;
-								break;
-
-							case 2:
-
-								is_overweight = cannot_route;
-								break;
-
-							case 3:
-
-								is_overweight = way_max_axle_load == 0 || (axle_load * 100) / way_max_axle_load > 110 ? cannot_route : slowly_only;
-								break;
-							}
-						}
-					}
-
+					is_overweight = check_overweight(welt, to, w, enforce_weight_limits, axle_load, convoy_weight, tile_length, bridge_tile_count);
 					if (is_overweight == cannot_route)
 					{
 						// Avoid routing over ways for which the convoy is overweight.
 						continue;
 					}
-
 				}
 
 				// new values for cost g (without way it is either in the air or in water => no costs)
@@ -1036,19 +1271,7 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 				uint8 current_dir;
 				if (tmp->parent != NULL && flags != simple_cost) {
 					current_dir = next_ribi[r] | tmp->ribi_from;
-					if(tmp->dir!=current_dir) {
-						new_g += 30;
-						if(tmp->parent->dir!=tmp->dir  &&  tmp->parent->parent!=NULL) {
-							// discourage 90 degree turns
-							new_g += 10;
-						}
-						else if (ribi_t::is_perpendicular(tmp->dir, current_dir))
-						{
-							// discourage v turns heavily
-							new_g += 25;
-						}
-					}
-
+					new_g += get_curve_cost(tmp, current_dir);
 				}
 				else {
 					current_dir = next_ribi[r];
@@ -1061,19 +1284,7 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 				// count how many 45 degree turns are necessary to get to target
 				sint8 turns = 0;
 				if (dist > 1 && flags != simple_cost) {
-					ribi_t::ribi to_target = ribi_type(to->get_pos(), ziel);
-
-					if (to_target && (to_target != current_dir)) {
-						if (ribi_t::is_single(current_dir) != ribi_t::is_single(to_target)) {
-							to_target = ribi_t::rotate45(to_target);
-							turns++;
-						}
-						while (to_target != current_dir /*&& turns < 126*/) {
-							to_target = ribi_t::rotate90(to_target);
-							turns += 2;
-						}
-						if (turns > 4) turns = 8 - turns;
-					}
+					turns = count_turns(ribi_type(to->get_pos(), ziel), current_dir);
 				}
 				// add 3*turns to the heuristic bound
 
@@ -1083,7 +1294,7 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 					costup = cost_upslope * max(ziel.z - to->get_vmove(next_ribi[r]), 0);
 				}
 
-				const uint32 new_f = (new_g + dist + turns * 3 + costup) * 10;
+				const uint32 new_f = (new_g + max(dist, landmarks.get_lower_bound(w)) + turns * 3 + costup) * 10;
 
 				// add new
 				ANode* k = &nodes[step];
@@ -1171,9 +1382,280 @@ route_t::route_result_t route_t::intern_calc_route(karte_t *welt, const koord3d
 	}
 
 	RELEASE_NODES(ni);
+	add_search_statistics(search_forward, expanded_nodes);
 	return ok;
 }
 
+/**
+ * Cost of the route joined from the node @p fwd of the search from the start and the node @p bwd
+ * of the search from the target on the same tile, or UINT32_MAX_VALUE if they cannot be joined there.
+ * The search from the target adds the cost of a curve only once it knows the tile ahead of it,
+ * so the curves around the meeting tile are added here, just as the forward search counts them.
+ */
+static uint32 get_join_cost(const route_t::ANode *fwd, const route_t::ANode *bwd)
+{
+	if(  fwd->parent != NULL  &&  bwd->parent != NULL  ) {
+		if(  bwd->ribi_from == ribi_t::reverse_single(fwd->ribi_from)  ) {
+			// would turn back on this tile
+			return UINT32_MAX_VALUE;
+		}
+		if(  fwd->bridge_tiles != 0  ) {
+			// both searches count a bridge from their own end, so only one of them may cross it
+			return UINT32_MAX_VALUE;
+		}
+	}
+
+	// what the route forms on this tile, and how many tiles it goes on from here
+	const ribi_t::ribi here = fwd->ribi_from | bwd->ribi_from;
+	const uint16 tiles_on = bwd->count;
+
+	uint32 cost = fwd->g + bwd->g;
+	if(  fwd->parent != NULL  &&  tiles_on >= 1  ) {
+		cost += get_curve_cost(fwd, here);
+	}
+	if(  tiles_on >= 2  ) {
+		cost += get_curve_cost(fwd->dir, fwd->parent != NULL, here, bwd->dir);
+	}
+	if(  tiles_on >= 3  ) {
+		cost += get_curve_cost(here, true, bwd->dir, bwd->parent->dir);
+	}
+	return cost;
+}
+
+/// keeps the keys of get_bidirectional_key() positive, as no distance bound on a map comes near it
+static const uint32 bidirectional_key_offset = 1u << 20;
+
+/**
+ * Sort key of the tile @p gr in the search heading for @p heading_for from @p coming_from:
+ * twice the cost @p g so far plus the bound of the way still to go, minus the bound of the way back.
+ * The searches from both ends thus use opposite potentials (the average one), and agree on the cost of every route,
+ * so they may stop once the keys of both fronts together exceed twice the best joined route (plus the offset).
+ */
+static inline uint32 get_bidirectional_key(const grund_t *gr, const waytype_t wegtyp, const uint32 g, const koord3d heading_for, const landmark_table_t::target_t &ahead, const koord3d coming_from, const landmark_table_t::target_t &behind)
+{
+	const weg_t *w = gr->get_weg(wegtyp);
+	const uint32 to_go = max(shortest_distance(gr->get_pos().get_2d(), heading_for.get_2d()), ahead.get_lower_bound(w));
+	const uint32 gone = max(shortest_distance(gr->get_pos().get_2d(), coming_from.get_2d()), behind.get_lower_bound(w));
+	return 2 * g + to_go + bidirectional_key_offset - gone;
+}
+
+route_t::route_result_t route_t::intern_calc_route_bidirectional(karte_t *welt, const koord3d start, const koord3d ziel, test_driver_t* const tdriver, const sint32 max_speed, const sint64 max_cost, const uint32 axle_load, const uint32 convoy_weight, bool is_tall, const sint32 tile_length)
+{
+	const grund_t *start_gr = welt->lookup(start);
+	const grund_t *ziel_gr = welt->lookup(ziel);
+
+	const waytype_t wegtyp = tdriver->get_waytype();
+	const uint8 enforce_weight_limits = welt->get_settings().get_enforce_weight_limits();
+
+	// memory in static list ...
+	if(!MAX_STEP)
+	{
+		INIT_NODES(welt->get_settings().get_max_route_steps(), welt->get_size());
+	}
+
+	ANode *nodes;
+	uint8 ni = GET_NODES(&nodes);
+
+#ifdef USE_VALGRIND_MEMCHECK
+	VALGRIND_MAKE_MEM_UNDEFINED(nodes, sizeof(ANode)*MAX_STEP);
+#endif
+
+	// Index 0 is the search from the start, index 1 the search backwards from the target.
+	// They take the lower and upper half of the nodes, and each keeps its own closed list.
+	const uint32 half_step = MAX_STEP / 2;
+	uint32 step[2] = { 0, half_step };
+	const uint32 max_step[2] = { half_step, MAX_STEP };
+	const koord3d heading_for[2] = { ziel, start };
+
+	binary_heap_tpl <ANode *> queue[2];
+	marker_t* closed[2];
+	closed[0] = &marker_t::instance(welt->get_size().x, welt->get_size().y, karte_t::marker_index);
+	static thread_local marker_t backward_marker;
+	backward_marker.init(welt->get_size().x, welt->get_size().y);
+	closed[1] = &backward_marker;
+
+	const landmark_table_t::target_t landmarks[2] = { landmark_table_t::target_t(ziel_gr, wegtyp), landmark_table_t::target_t(start_gr, wegtyp) };
+
+	// the nodes taken out of each queue, to join the two halves of the route where the searches meet
+	static thread_local std::unordered_map<const grund_t *, ANode *> settled[2];
+	settled[0].clear();
+	settled[1].clear();
+
+	for(  uint8 side = 0;  side < 2;  side++  ) {
+		ANode *root = &nodes[step[side]++];
+		root->parent = NULL;
+		root->gr = side == 0 ? start_gr : ziel_gr;
+		root->f = get_bidirectional_key(root->gr, wegtyp, 0, heading_for[side], landmarks[side], heading_for[1-side], landmarks[1-side]);
+		root->g = 0;
+		root->dir = 0;
+		root->count = 0;
+		root->ribi_from = ribi_t::none;
+		root->jps_ribi = ribi_t::all;
+		root->bridge_tiles = 0;
+		queue[side].insert(root);
+	}
+
+	uint32 best_cost = UINT32_MAX_VALUE;
+	ANode *meeting[2] = { NULL, NULL };
+	uint32 expanded_nodes = 0;
+	bool too_complex = false;
+
+	while(  !queue[0].empty()  &&  !queue[1].empty()  ) {
+		// once both fronts together can only lead to dearer routes than the best one joined so far, we are done
+		if(  (uint64)queue[0].front()->f + queue[1].front()->f >= ((uint64)best_cost + bidirectional_key_offset) * 2  ) {
+			break;
+		}
+
+		// expand the smaller front
+		const uint8 side = queue[0].get_count() <= queue[1].get_count() ? 0 : 1;
+		if(  step[side] + 4 > max_step[side]  ) {
+			too_complex = true;
+			break;
+		}
+
+		ANode *tmp = queue[side].pop();
+		const grund_t *gr = tmp->gr;
+		if(  closed[side]->test_and_mark(gr)  ) {
+			// we were already here on a faster route
+			continue;
+		}
+		if(  (sint64)tmp->g >= max_cost  ) {
+			continue;
+		}
+		settled[side][gr] = tmp;
+		expanded_nodes++;
+
+		if(  closed[1-side]->is_marked(gr)  ) {
+			// the other search was here already: join the routes, unless they would turn back on this tile
+			ANode *fwd = side == 0 ? tmp : settled[0][gr];
+			ANode *bwd = side == 1 ? tmp : settled[1][gr];
+			const uint32 join_cost = get_join_cost(fwd, bwd);
+			if(  join_cost < best_cost  ) {
+				best_cost = join_cost;
+				meeting[0] = fwd;
+				meeting[1] = bwd;
+			}
+		}
+
+		if(  gr == (side == 0 ? ziel_gr : start_gr)  ) {
+			// no better route passes the far end
+			continue;
+		}
+
+		const ribi_t::ribi *next_ribi = get_next_dirs(gr->get_pos(), heading_for[side]);
+		ribi_t::ribi ribi = ribi_t::all;
+		if(  side == 0  ) {
+			const weg_t* way = gr->get_weg(wegtyp);
+			const ribi_t::ribi way_ribi = way && way->has_signal() ? gr->get_weg_ribi_unmasked(wegtyp) : tdriver->get_ribi(gr);
+			ribi = way_ribi & ~ribi_t::reverse_single(tmp->ribi_from);
+		}
+		else if(  tmp->parent != NULL  ) {
+			// the route continues from here in tmp->ribi_from, so do not come from there
+			ribi = ~tmp->ribi_from;
+		}
+
+		for(  int r = 0;  r < 4;  r++  ) {
+			if(  (ribi & next_ribi[r]) == 0  ) {
+				continue;
+			}
+
+			grund_t *to = NULL;
+			if(  !gr->get_neighbour(to, wegtyp, next_ribi[r])  ||  closed[side]->is_marked(to)  ) {
+				continue;
+			}
+
+			// the driving direction onto the later of both tiles
+			const ribi_t::ribi drive_dir = side == 0 ? next_ribi[r] : ribi_t::reverse_single(next_ribi[r]);
+			// the backward search counts the tiles of a bridge from its far end, which sums up to the same
+			sint32 bridge_tiles = tmp->bridge_tiles;
+			uint32 cost;
+			if(  side == 0  ) {
+				cost = get_entry_cost(welt, tdriver, gr, to, drive_dir, max_speed, is_tall, enforce_weight_limits, axle_load, convoy_weight, tile_length, bridge_tiles);
+			}
+			else {
+				// we would come from "to" onto this tile, so "to" must be passable and lead here
+				if(  !tdriver->check_next_tile(to)  ) {
+					continue;
+				}
+				const weg_t *to_way = to->get_weg(wegtyp);
+				const ribi_t::ribi to_ribi = to_way && to_way->has_signal() ? to->get_weg_ribi_unmasked(wegtyp) : tdriver->get_ribi(to);
+				if(  (to_ribi & drive_dir) == 0  ) {
+					continue;
+				}
+				cost = get_entry_cost(welt, tdriver, to, gr, drive_dir, max_speed, is_tall, enforce_weight_limits, axle_load, convoy_weight, tile_length, bridge_tiles);
+			}
+			if(  cost == UINT32_MAX_VALUE  ) {
+				continue;
+			}
+
+			uint32 new_g = tmp->g + cost;
+			ribi_t::ribi current_dir = drive_dir;
+			if(  tmp->parent != NULL  ) {
+				current_dir |= tmp->ribi_from;
+				if(  side == 0  ) {
+					new_g += get_curve_cost(tmp, current_dir);
+				}
+				else if(  tmp->parent->parent != NULL  &&  tmp->parent->parent->parent != NULL  ) {
+					// the curve two tiles on, now that the tile ahead of it is known as well
+					new_g += get_curve_cost(current_dir, true, tmp->dir, tmp->parent->dir);
+				}
+			}
+
+			ANode* k = &nodes[step[side]];
+			step[side]++;
+
+			k->parent = tmp;
+			k->gr = to;
+			k->g = new_g;
+			k->f = get_bidirectional_key(to, wegtyp, new_g, heading_for[side], landmarks[side], heading_for[1-side], landmarks[1-side]);
+			k->dir = current_dir;
+			k->ribi_from = drive_dir;
+			k->count = tmp->count + 1;
+			k->jps_ribi = ribi_t::all;
+			k->bridge_tiles = (uint8)min(bridge_tiles, 255);
+			queue[side].insert(k);
+
+			if(  closed[1-side]->is_marked(to)  ) {
+				// the other search was there already, so this step joins the routes
+				ANode *other = settled[1-side][to];
+				const uint32 join_cost = side == 0 ? get_join_cost(k, other) : get_join_cost(other, k);
+				if(  join_cost < best_cost  ) {
+					best_cost = join_cost;
+					meeting[side] = k;
+					meeting[1-side] = other;
+				}
+			}
+		}
+	}
+
+	if(  route_t::max_used_steps < step[0] + step[1] - half_step  ) {
+		route_t::max_used_steps = step[0] + step[1] - half_step;
+	}
+	add_search_statistics(search_bidirectional, expanded_nodes);
+
+	if(  meeting[0] == NULL  ||  (sint64)best_cost >= max_cost  ) {
+		RELEASE_NODES(ni);
+		if(  too_complex  ) {
+			dbg->warning("route_t::intern_calc_route_bidirectional()","Too many steps (%i>=max %i) in route (too long/complex)",step[0] + step[1] - half_step,MAX_STEP);
+			return route_too_complex;
+		}
+		return no_route;
+	}
+
+	// the route from the start to the meeting tile, then on from there along the backward search
+	uint32 index = meeting[0]->count;
+	route.store_at( index + meeting[1]->count, ziel );
+	for(  const ANode *tmp = meeting[0];  tmp != NULL;  tmp = tmp->parent  ) {
+		route[ tmp->count ] = tmp->gr->get_pos();
+	}
+	for(  const ANode *tmp = meeting[1]->parent;  tmp != NULL;  tmp = tmp->parent  ) {
+		route[ ++index ] = tmp->gr->get_pos();
+	}
+
+	RELEASE_NODES(ni);
+	return valid_route;
+}
+
 /*
  * Postprocess routes created by jump-point search.
  * These routes never turn when going straight.
@@ -1284,7 +1766,7 @@ void route_t::postprocess_water_route(karte_t *welt)
  * searches route, uses intern_calc_route() for distance between stations
  * handles only driving in stations by itself
  */
- route_t::route_result_t route_t::calc_route(karte_t *welt, const koord3d start, const koord3d ziel, test_driver_t* const tdriver, const sint32 max_khm, const uint32 axle_load, bool is_tall, sint32 max_len, const sint64 max_cost, const uint32 convoy_weight, koord3d avoid_tile, uint8 direction, find_route_flags flags)
+ route_t::route_result_t route_t::calc_route(karte_t *welt, const koord3d start, const koord3d ziel, test_driver_t* const tdriver, const sint32 max_khm, const uint32 axle_load, bool is_tall, sint32 max_len, const sint64 max_cost, const uint32 convoy_weight, koord3d avoid_tile, uint8 direction, find_route_flags flags, search_direction_t search)
 {
 	route.clear();
 	const uint32 distance = shortest_distance(start.get_2d(), ziel.get_2d()) * 600;
@@ -1302,7 +1784,7 @@ void route_t::postprocess_water_route(karte_t *welt)
 	// profiling for routes ...
 	long ms=dr_time();
 #endif
-	route_result_t ok = intern_calc_route(welt, start, ziel, tdriver, max_khm, max_cost, axle_load, convoy_weight, is_tall, max_len, avoid_tile, direction, flags);
+	route_result_t ok = intern_calc_route(welt, start, ziel, tdriver, max_khm, max_cost, axle_load, convoy_weight, is_tall, max_len, avoid_tile, direction, flags, search);
 #ifdef DEBUG_ROUTES
 	if(tdriver->get_waytype()==water_wt) {
 		DBG_DEBUG("route_t::calc_route()", "route from %d,%d to %d,%d with %i steps in %u ms found.", start.x, start.y, ziel.x, ziel.y, route.get_count()-1, dr_time()-ms );
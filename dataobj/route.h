@@ -18,6 +18,7 @@
 class karte_t;
 class test_driver_t;
 class grund_t;
+class weg_t;
 
 /**
  * Route, e.g. for vehicles
@@ -38,12 +39,38 @@ public:
 
 	enum find_route_flags { none, private_car_checker, choose_signal, simple_cost };
 
+	/// Whether calc_route() searches from the start only, or from both ends until the searches meet
+	enum search_direction_t { search_forward, search_bidirectional };
+
 private:
 
 	/**
 	 * The actual route search
 	 */
-	route_result_t intern_calc_route(karte_t *w, koord3d start, koord3d ziel, test_driver_t* const tdriver, const sint32 max_kmh, const sint64 max_cost, const uint32 axle_load, const uint32 convoy_weight, bool is_tall, const sint32 tile_length, const koord3d avoid_tile, uint8 start_dir = ribi_t::all, find_route_flags flags = none);
+	route_result_t intern_calc_route(karte_t *w, koord3d start, koord3d ziel, test_driver_t* const tdriver, const sint32 max_kmh, const sint64 max_cost, const uint32 axle_load, const uint32 convoy_weight, bool is_tall, const sint32 tile_length, const koord3d avoid_tile, uint8 start_dir = ribi_t::all, find_route_flags flags = none, search_direction_t search = search_forward);
+
+	/**
+	 * Searches from the start and backwards from the target at the same time.
+	 * The two searches share the node budget of intern_calc_route().
+	 */
+	route_result_t intern_calc_route_bidirectional(karte_t *w, koord3d start, koord3d ziel, test_driver_t* const tdriver, const sint32 max_kmh, const sint64 max_cost, const uint32 axle_load, const uint32 convoy_weight, bool is_tall, const sint32 tile_length);
+
+	/**
+	 * Checks the weight limits of the way @p w on the tile @p to as the search enters it.
+	 * Also lowers max_axle_load to that of the way.
+	 */
+	overweight_type check_overweight(karte_t *welt, const grund_t *to, const weg_t *w, const uint8 enforce_weight_limits, const uint32 axle_load, const uint32 convoy_weight, const sint32 tile_length, sint32 &bridge_tile_count);
+
+	/**
+	 * Cost of driving from @p from onto @p to in direction @p dir, as the search checks it.
+	 * @returns UINT32_MAX_VALUE if the vehicle may not go there
+	 */
+	uint32 get_entry_cost(karte_t *welt, test_driver_t* const tdriver, const grund_t *from, const grund_t *to, const ribi_t::ribi dir, const sint32 max_speed, const bool is_tall, const uint8 enforce_weight_limits, const uint32 axle_load, const uint32 convoy_weight, const sint32 tile_length, sint32 &bridge_tile_count);
+
+	/// Searches and expanded nodes of intern_calc_route() by search direction, summed over all threads
+	static uint32 search_count[2];
+	static uint64 expanded_node_count[2];
+	static void add_search_statistics(search_direction_t search, uint32 expanded_nodes);
 
 protected:
 	koord3d_vector_t route;           // The coordinates for the vehicle route
@@ -78,6 +105,7 @@ public:
 		uint8 ribi_from; ///< we came from this direction
 		uint16 count;    ///< length of route up to here
 		uint8 jps_ribi;  ///< extra ribi mask for jump-point search
+		uint8 bridge_tiles; ///< tiles counted as one bridge for the weight limits up to here, in the bidirectional search
 
 		/// sort nodes first with respect to f, then with respect to g
 		inline bool operator <= (const ANode &k) const { return f==k.f ? g<=k.g : f<=k.f; }
@@ -97,9 +125,16 @@ public:
 
 	static bool suspend_private_car_routing;
 
+	/// Long convoy routes are searched from both ends (see bidirectional_route_search_min_distance)
+	static search_direction_t get_convoy_search_direction(const karte_t *welt, koord3d start, koord3d ziel);
+
+	/// Average number of nodes expanded per search in the given direction, for the display dialogue
+	static uint32 get_average_expanded_nodes(search_direction_t search);
+
 	const koord3d_vector_t &get_route() const { return route; }
 
 	uint32 get_max_axle_load() const { return max_axle_load; }
+	uint32 get_max_convoy_weight() const { return max_convoy_weight; }
 
 	void rotate90( sint16 y_size ) { route.rotate90( y_size ); }
 
@@ -166,7 +201,7 @@ public:
 	/**
 	 * Calculates the route from @p start to @p target
 	 */
-	route_result_t calc_route(karte_t *welt, koord3d start, koord3d ziel, test_driver_t* const tdriver, const sint32 max_speed_kmh, const uint32 axle_load, bool is_tall, sint32 max_tile_len, const sint64 max_cost = SINT64_MAX_VALUE, const uint32 convoy_weight = 0, const koord3d avoid_tile = koord3d::invalid, uint8 direction = ribi_t::all, find_route_flags flags = none);
+	route_result_t calc_route(karte_t *welt, koord3d start, koord3d ziel, test_driver_t* const tdriver, const sint32 max_speed_kmh, const uint32 axle_load, bool is_tall, sint32 max_tile_len, const sint64 max_cost = SINT64_MAX_VALUE, const uint32 convoy_weight = 0, const koord3d avoid_tile = koord3d::invalid, uint8 direction = ribi_t::all, find_route_flags flags = none, search_direction_t search = search_forward);
 
 	/**
 	 * Load/Save of the route.
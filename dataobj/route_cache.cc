@@ -0,0 +1,211 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <algorithm>
+
+#include "route_cache.h"
+
+#include "../utils/simthread.h"
+
+
+vector_tpl<route_cache_t::entry_t> route_cache_t::entries;
+uint32 route_cache_t::next_entry = 0;
+hashtable_tpl<route_cache_t::key_t, uint32, route_cache_t::key_hash_t, 1031> route_cache_t::entry_of_key;
+vector_tpl<route_cache_t::entry_t> route_cache_t::found_routes;
+uint32 route_cache_t::generation = 0;
+bool route_cache_t::network_dirty = false;
+uint32 route_cache_t::hits = 0;
+uint32 route_cache_t::misses = 0;
+
+#ifdef MULTI_THREAD
+static pthread_mutex_t route_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+uint32 route_cache_t::key_hash_t::hash(const key_t &key)
+{
+	uint32 h = ((uint32)(uint16)key.start.x << 16) ^ (uint16)key.start.y;
+	h = h * 31 + (((uint32)(uint16)key.ziel.x << 16) ^ (uint16)key.ziel.y);
+	h = h * 31 + (uint32)(key.composition ^ (key.composition >> 32));
+	return h ^ (key.axle_load * 7) ^ key.convoy_weight;
+}
+
+
+#define COMPARE(field) if(  a.field != b.field  ) { return a.field < b.field ? -1 : 1; }
+
+route_cache_t::key_hash_t::diff_type route_cache_t::key_hash_t::comp(const key_t &a, const key_t &b)
+{
+	COMPARE(start.x) COMPARE(start.y) COMPARE(start.z)
+	COMPARE(ziel.x) COMPARE(ziel.y) COMPARE(ziel.z)
+	COMPARE(vehicle_pos.x) COMPARE(vehicle_pos.y) COMPARE(vehicle_pos.z)
+	COMPARE(composition)
+	COMPARE(max_speed)
+	COMPARE(tile_length)
+	COMPARE(axle_load)
+	COMPARE(convoy_weight)
+	COMPARE(waytype)
+	COMPARE(player_nr)
+	COMPARE(flags)
+	return 0;
+}
+
+#undef COMPARE
+
+
+bool route_cache_t::get(const key_t &key, route_t &route)
+{
+	const uint32 entry = entry_of_key.get(key);
+	const bool hit = entry != 0  &&  entries[entry - 1].generation == generation;
+	if(  hit  ) {
+		route = entries[entry - 1].route;
+	}
+
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&route_cache_mutex);
+#endif
+	if(  hit  ) {
+		hits++;
+	}
+	else {
+		misses++;
+	}
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&route_cache_mutex);
+#endif
+	return hit;
+}
+
+
+void route_cache_t::put(const key_t &key, const route_t &route, uint32 found_in_generation)
+{
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&route_cache_mutex);
+#endif
+	entry_t found;
+	found.key = key;
+	found.route = route;
+	found.generation = found_in_generation;
+	found_routes.append(found);
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&route_cache_mutex);
+#endif
+}
+
+
+void route_cache_t::network_changed()
+{
+	// The convoys read the generation while they search their routes, so it only
+	// changes in step(), which all clients of a network game reach at the same time.
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&route_cache_mutex);
+#endif
+	network_dirty = true;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&route_cache_mutex);
+#endif
+}
+
+
+void route_cache_t::add(const entry_t &found)
+{
+	uint32 entry = entry_of_key.get(found.key);
+	if(  entry == 0  ) {
+		if(  entries.get_count() < max_entries  ) {
+			entries.append(found);
+			entry = entries.get_count();
+		}
+		else {
+			// replace the oldest route
+			entry_of_key.remove(entries[next_entry].key);
+			entries[next_entry] = found;
+			entry = next_entry + 1;
+			next_entry = (next_entry + 1) % max_entries;
+		}
+		entry_of_key.put(found.key, entry);
+	}
+	else {
+		entries[entry - 1] = found;
+	}
+}
+
+
+static bool is_same_route(const route_t &a, const route_t &b)
+{
+	const koord3d_vector_t &ra = a.get_route();
+	const koord3d_vector_t &rb = b.get_route();
+	if(  ra.get_count() != rb.get_count()  ||  a.get_max_axle_load() != b.get_max_axle_load()  ||  a.get_max_convoy_weight() != b.get_max_convoy_weight()  ) {
+		return false;
+	}
+	for(  uint32 i = 0;  i < ra.get_count();  i++  ) {
+		if(  ra[i] != rb[i]  ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// orders the found routes by their keys
+class found_route_order_t
+{
+	const vector_tpl<route_cache_t::key_t> &keys;
+public:
+	found_route_order_t(const vector_tpl<route_cache_t::key_t> &keys) : keys(keys) {}
+	bool operator()(uint32 a, uint32 b) const { return route_cache_t::key_hash_t::comp(keys[a], keys[b]) < 0; }
+};
+
+
+void route_cache_t::step()
+{
+	if(  network_dirty  ) {
+		// the routes found before the change are no longer handed out
+		generation++;
+		network_dirty = false;
+	}
+
+	if(  found_routes.empty()  ) {
+		return;
+	}
+
+	// the threads found their routes in any order, so sort them
+	vector_tpl<key_t> keys(found_routes.get_count());
+	vector_tpl<uint32> order(found_routes.get_count());
+	for(  uint32 i = 0;  i < found_routes.get_count();  i++  ) {
+		keys.append(found_routes[i].key);
+		order.append(i);
+	}
+	std::sort(order.begin(), order.end(), found_route_order_t(keys));
+
+	for(  uint32 first = 0;  first < order.get_count();  ) {
+		const entry_t &found = found_routes[order[first]];
+		bool agree = found.generation == generation;
+		uint32 next = first + 1;
+		while(  next < order.get_count()  &&  key_hash_t::comp(keys[order[next]], found.key) == 0  ) {
+			const entry_t &other = found_routes[order[next]];
+			agree &= other.generation == generation  &&  is_same_route(other.route, found.route);
+			next++;
+		}
+		if(  agree  ) {
+			add(found);
+		}
+		first = next;
+	}
+
+	vector_tpl<entry_t> none;
+	swap(found_routes, none);
+}
+
+
+void route_cache_t::clear()
+{
+	vector_tpl<entry_t> no_entries;
+	swap(entries, no_entries);
+	next_entry = 0;
+	entry_of_key.clear();
+	vector_tpl<entry_t> no_found_routes;
+	swap(found_routes, no_found_routes);
+	generation++;
+	network_dirty = false;
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_ROUTE_CACHE_H
+#define DATAOBJ_ROUTE_CACHE_H
+
+
+#include "../simtypes.h"
+#include "koord3d.h"
+#include "route.h"
+
+#include "../tpl/hashtable_tpl.h"
+#include "../tpl/vector_tpl.h"
+
+
+/**
+ * Cache of recently found convoy routes. Many convoys of a line leave the same
+ * stop for the same next stop with the same vehicles and load, and would each
+ * search the same route again.
+ *
+ * Every change to the way network which may alter routes (ways built or removed,
+ * signs and signals, way ownership and access rights, stops) marks the network as
+ * changed, and the next step() advances a generation counter. Only routes found in
+ * the current generation are handed out. Since road congestion changes all the time,
+ * the generation also advances every month.
+ *
+ * The route searches of the convoys run on several threads at once. To give the
+ * same results on all clients of a network game, the cache only changes in step(),
+ * when no route searches run: the routes found since are added in the order of
+ * their keys, and only if all searches with the same key found the same route.
+ */
+class route_cache_t
+{
+public:
+	/// Everything on which the route of a convoy depends, besides the way network
+	struct key_t
+	{
+		koord3d start;
+		koord3d ziel;
+		koord3d vehicle_pos;  // access to ways of other players depends on the way under the vehicle
+		uint64 composition;   // fingerprint of the vehicle types, which decide on which ways they may go
+		sint32 max_speed;
+		sint32 tile_length;
+		uint32 axle_load;
+		uint32 convoy_weight;
+		uint8 waytype;
+		uint8 player_nr;
+		uint8 flags;          // see key_flags
+	};
+
+	enum key_flags { is_tall = 1, has_speed_limit = 2 };
+
+	class key_hash_t
+	{
+	public:
+		typedef sint64 diff_type;
+		static uint32 hash(const key_t &key);
+		static diff_type comp(const key_t &a, const key_t &b);
+	};
+
+private:
+	struct entry_t
+	{
+		key_t key;
+		route_t route;
+		uint32 generation;
+	};
+
+	// the cached routes, replaced in turn
+	static vector_tpl<entry_t> entries;
+	static uint32 next_entry;
+
+	// the number of the entry with this key plus one
+	static hashtable_tpl<key_t, uint32, key_hash_t, 1031> entry_of_key;
+
+	// routes found since the last step()
+	static vector_tpl<entry_t> found_routes;
+
+	static uint32 generation;
+
+	// set by network_changed(), the generation advances in the next step()
+	static bool network_dirty;
+
+	static uint32 hits;
+	static uint32 misses;
+
+	static const uint32 max_entries = 1024;
+
+	static void add(const entry_t &found);
+
+public:
+	/**
+	 * Copies the route for @p key into @p route, if it was found in the current generation.
+	 * May be called from any thread.
+	 */
+	static bool get(const key_t &key, route_t &route);
+
+	/**
+	 * Offers a route found for @p key while the network was in @p found_in_generation.
+	 * May be called from any thread.
+	 */
+	static void put(const key_t &key, const route_t &route, uint32 found_in_generation);
+
+	static uint32 get_generation() { return generation; }
+
+	/**
+	 * Called whenever the way network changes in a way which may alter routes.
+	 * May be called from any thread; the generation advances in the next step().
+	 */
+	static void network_changed();
+
+	/**
+	 * Advances the generation if the network changed, and takes the routes found
+	 * since the last call into the cache.
+	 * Must be called from the main thread while no convoy route searches are running.
+	 */
+	static void step();
+
+	static void clear();
+
+	static uint32 get_hits() { return hits; }
+	static uint32 get_misses() { return misses; }
+};
+
+#endif
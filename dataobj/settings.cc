@@ -543,6 +543,11 @@ settings_t::settings_t() :
 
 	path_explorer_time_midpoint = 64;
 	save_path_explorer_data = true;
+	path_explorer_max_incremental_changes = 64;
+	bidirectional_route_search_min_distance = 64;
+	route_landmarks_min_map_size = 512;
+	halt_steps_per_thread = 256;
+	monthly_update_steps = 0;
 
 	show_future_vehicle_info = true;
 }
@@ -1893,6 +1898,31 @@ void settings_t::rdwr(loadsave_t *file)
 			file->rdwr_bool(do_not_record_private_car_routes_to_distant_non_consumer_industries);
 			file->rdwr_bool(do_not_record_private_car_routes_to_city_buildings);
 		}
+
+		if (file->is_version_ex_atleast(14, 42))
+		{
+			file->rdwr_long(path_explorer_max_incremental_changes);
+		}
+
+		if (file->is_version_ex_atleast(14, 43))
+		{
+			file->rdwr_long(bidirectional_route_search_min_distance);
+		}
+
+		if (file->is_version_ex_atleast(14, 44))
+		{
+			file->rdwr_long(route_landmarks_min_map_size);
+		}
+
+		if (file->is_version_ex_atleast(14, 45))
+		{
+			file->rdwr_long(halt_steps_per_thread);
+		}
+
+		if (file->is_version_ex_atleast(14, 46))
+		{
+			file->rdwr_long(monthly_update_steps);
+		}
 		// otherwise the default values of the last one will be used
 	}
 
@@ -2015,6 +2045,10 @@ void settings_t::parse_simuconf( tabfile_t& simuconf, sint16& disp_width, sint16
 	env_t::num_threads = clamp( contents.get_int( "threads", env_t::num_threads ), 1, MAX_THREADS );
 	env_t::simple_drawing_default = contents.get_int( "simple_drawing_tile_size", env_t::simple_drawing_default );
 	env_t::simple_drawing_fast_forward = contents.get_int( "simple_drawing_fast_forward", env_t::simple_drawing_fast_forward );
+	env_t::image_cache_budget = contents.get_int( "image_cache_budget", env_t::image_cache_budget );
+	env_t::image_cache_prewarm = contents.get_int( "image_cache_prewarm", env_t::image_cache_prewarm ) != 0;
+	env_t::background_rezoom = contents.get_int( "background_rezoom", env_t::background_rezoom ) != 0;
+	env_t::static_layer_cache = contents.get_int( "static_layer_cache", env_t::static_layer_cache ) != 0;
 	env_t::visualize_schedule = contents.get_int( "visualize_schedule", env_t::visualize_schedule ) != 0;
 	env_t::show_vehicle_states = contents.get_int( "show_vehicle_states", env_t::show_vehicle_states );
 	env_t::follow_convoi_underground = contents.get_int( "follow_convoi_underground", env_t::follow_convoi_underground );
@@ -2060,6 +2094,8 @@ void settings_t::parse_simuconf( tabfile_t& simuconf, sint16& disp_width, sint16
 	env_t::additional_client_frames_behind  = max(0, contents.get_int( "additional_client_frames_behind", env_t::additional_client_frames_behind ));
 	env_t::network_frames_per_step          = max(1, contents.get_int( "server_frames_per_step",          env_t::network_frames_per_step ));
 	env_t::server_sync_steps_between_checks = max(1, contents.get_int( "server_frames_between_checks",    env_t::server_sync_steps_between_checks ));
+	env_t::server_frames_before_join        = max(0, contents.get_int( "server_frames_before_join",       env_t::server_frames_before_join ));
+	env_t::network_state_hashes             =        contents.get_int( "network_state_hashes",            env_t::network_state_hashes ) != 0;
 	env_t::pause_server_no_clients          =        contents.get_int( "pause_server_no_clients",         env_t::pause_server_no_clients )  != 0;
 	env_t::server_save_game_on_quit         =        contents.get_int( "server_save_game_on_quit",        env_t::server_save_game_on_quit ) != 0;
 	env_t::reload_and_save_on_quit          =        contents.get_int( "reload_and_save_on_quit",         env_t::reload_and_save_on_quit )  != 0;
@@ -2258,6 +2294,7 @@ void settings_t::parse_simuconf( tabfile_t& simuconf, sint16& disp_width, sint16
 	}
 
 	env_t::autosave = (contents.get_int( "autosave", env_t::autosave ));
+	env_t::background_autosave = contents.get_int( "background_autosave", env_t::background_autosave ) != 0;
 
 	// routing stuff
 	max_route_steps = contents.get_int( "max_route_steps", max_route_steps );
@@ -2799,6 +2836,11 @@ void settings_t::parse_simuconf( tabfile_t& simuconf, sint16& disp_width, sint16
 
 	path_explorer_time_midpoint = contents.get_int("path_explorer_time_midpoint", path_explorer_time_midpoint);
 	save_path_explorer_data = contents.get_int("save_path_explorer_data", save_path_explorer_data);
+	path_explorer_max_incremental_changes = contents.get_int("path_explorer_max_incremental_changes", path_explorer_max_incremental_changes);
+	bidirectional_route_search_min_distance = contents.get_int("bidirectional_route_search_min_distance", bidirectional_route_search_min_distance);
+	route_landmarks_min_map_size = contents.get_int("route_landmarks_min_map_size", route_landmarks_min_map_size);
+	halt_steps_per_thread = max(1, contents.get_int("halt_steps_per_thread", halt_steps_per_thread));
+	monthly_update_steps = max(0, contents.get_int("monthly_update_steps", monthly_update_steps));
 
 	show_future_vehicle_info = contents.get_int("show_future_vehicle_information", show_future_vehicle_info);
 
@@ -776,6 +776,23 @@ public:
 	uint32 path_explorer_time_midpoint;
 	bool save_path_explorer_data;
 
+	// The path explorer updates the last paths instead of exploring all of them
+	// if no more than this many connexions have changed (0 : always explore all paths)
+	uint32 path_explorer_max_incremental_changes;
+
+	// Convoy routes at least this many tiles long are searched from both ends (0 : never)
+	uint32 bidirectional_route_search_min_distance;
+
+	// Landmark tables for the convoy route search are built on maps at least this many tiles wide or long (0 : always)
+	uint32 route_landmarks_min_map_size;
+
+	// Number of stops stepped in each step for each thread
+	uint32 halt_steps_per_thread;
+
+	// Ways and stops start their new month row by row of the map over this many
+	// steps, instead of all in the first step of the month (0 : all at once)
+	uint32 monthly_update_steps;
+
 	// Whether players can know in advance the vehicle production end date and upgrade availability date
 	// If false, only information up to one year ahead
 	bool show_future_vehicle_info;
@@ -1298,6 +1315,11 @@ public:
 
 	uint32 get_path_explorer_time_midpoint() const { return path_explorer_time_midpoint; }
 	bool get_save_path_explorer_data() const { return save_path_explorer_data; }
+	uint32 get_path_explorer_max_incremental_changes() const { return path_explorer_max_incremental_changes; }
+	uint32 get_bidirectional_route_search_min_distance() const { return bidirectional_route_search_min_distance; }
+	uint32 get_route_landmarks_min_map_size() const { return route_landmarks_min_map_size; }
+	uint32 get_halt_steps_per_thread() const { return halt_steps_per_thread; }
+	uint32 get_monthly_update_steps() const { return monthly_update_steps; }
 
 	bool get_show_future_vehicle_info() const { return show_future_vehicle_info; }
 	//void set_show_future_vehicle_info(bool yesno) { show_future_vehicle_info = yesno; }
@@ -0,0 +1,265 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <stdio.h>
+
+#include "state_hashes.h"
+
+#include "../macros.h"
+#include "../simcity.h"
+#include "../simconvoi.h"
+#include "../simdebug.h"
+#include "../simfab.h"
+#include "../simhalt.h"
+#include "../simworld.h"
+#include "../boden/wege/schiene.h"
+#include "schedule.h"
+#include "../network/memory_rw.h"
+
+
+static const char *subsystem_names[state_hashes_t::MAX_SUBSYSTEMS] = {
+	"convoys",
+	"waiting cargo",
+	"factories",
+	"cities",
+	"track reservations"
+};
+
+
+// positions on the map as keys of objects
+static uint32 get_key(koord pos)
+{
+	return ((uint32)(uint16)pos.y << 16) | (uint16)pos.x;
+}
+
+static koord get_pos(uint32 key)
+{
+	return koord((sint16)(key & 0xFFFF), (sint16)(key >> 16));
+}
+
+
+uint32 state_hashes_t::finish(uint32 hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+
+void state_hashes_t::clear()
+{
+	calculated = false;
+	step = 0;
+	for(  uint8 i = 0;  i < MAX_SUBSYSTEMS;  i++  ) {
+		count[i] = 0;
+		for(  uint32 b = 0;  b < bucket_count;  b++  ) {
+			buckets[i][b] = 0;
+		}
+	}
+}
+
+
+uint32 state_hashes_t::get_hash(uint8 subsystem) const
+{
+	if(  !calculated  ) {
+		return 0;
+	}
+	uint32 hash = mix(start, count[subsystem]);
+	for(  uint32 b = 0;  b < bucket_count;  b++  ) {
+		hash = mix(hash, buckets[subsystem][b]);
+	}
+	// 0 means not calculated
+	return hash != 0 ? hash : 1;
+}
+
+
+uint32 state_hashes_t::get_first_differing_bucket(uint8 subsystem, const state_hashes_t &other) const
+{
+	for(  uint32 b = 0;  b < bucket_count;  b++  ) {
+		if(  buckets[subsystem][b] != other.buckets[subsystem][b]  ) {
+			return b;
+		}
+	}
+	return bucket_count;
+}
+
+
+void state_hashes_t::rdwr(memory_rw_t *buffer)
+{
+	buffer->rdwr_bool(calculated);
+	if(  calculated  ) {
+		buffer->rdwr_long(step);
+		for(  uint8 i = 0;  i < MAX_SUBSYSTEMS;  i++  ) {
+			buffer->rdwr_long(count[i]);
+			for(  uint32 b = 0;  b < bucket_count;  b++  ) {
+				buffer->rdwr_long(buckets[i][b]);
+			}
+		}
+	}
+}
+
+
+const char *state_hashes_t::get_name(uint8 subsystem)
+{
+	return subsystem_names[subsystem];
+}
+
+
+void state_hash_log_t::add(uint8 subsystem, uint32 key, uint32 hash)
+{
+	object_hash_t object;
+	object.key = key;
+	object.hash = state_hashes_t::finish(hash);
+	objects[subsystem].append(object);
+
+	hashes.count[subsystem]++;
+	hashes.buckets[subsystem][state_hashes_t::finish(key) % state_hashes_t::bucket_count] += object.hash;
+}
+
+
+void state_hash_log_t::clear()
+{
+	hashes.clear();
+	for(  uint8 i = 0;  i < state_hashes_t::MAX_SUBSYSTEMS;  i++  ) {
+		objects[i].clear();
+	}
+}
+
+
+void state_hash_log_t::calc(karte_t *welt, uint32 step)
+{
+	clear();
+
+	FOR(vector_tpl<convoihandle_t>, const cnv, welt->convoys()) {
+		const koord3d pos = cnv->get_pos();
+		uint32 hash = state_hashes_t::start;
+		hash = state_hashes_t::mix(hash, get_key(pos.get_2d()));
+		hash = state_hashes_t::mix(hash, (uint32)pos.z);
+		hash = state_hashes_t::mix(hash, cnv->get_state());
+		hash = state_hashes_t::mix(hash, cnv->get_akt_speed());
+		hash = state_hashes_t::mix(hash, cnv->get_loading_level());
+		hash = state_hashes_t::mix(hash, cnv->get_schedule() ? cnv->get_schedule()->get_current_stop() : 0);
+		hash = state_hashes_t::mix(hash, (uint32)cnv->get_jahresgewinn());
+		hash = state_hashes_t::mix(hash, (uint32)(cnv->get_jahresgewinn() >> 32));
+		hash = state_hashes_t::mix(hash, (uint32)cnv->get_total_distance_traveled());
+		add(state_hashes_t::CONVOYS, cnv.get_id(), hash);
+	}
+
+	FOR(vector_tpl<halthandle_t>, const halt, haltestelle_t::get_alle_haltestellen()) {
+		add(state_hashes_t::HALTS, halt.get_id(), state_hashes_t::mix(state_hashes_t::start, halt->get_cargo_hash()));
+	}
+
+	FOR(vector_tpl<fabrik_t *>, const fab, welt->get_fab_list()) {
+		uint32 hash = state_hashes_t::start;
+		hash = state_hashes_t::mix(hash, fab->get_status());
+		for(  uint32 i = 0;  i < fab->get_input().get_count();  i++  ) {
+			hash = state_hashes_t::mix(hash, (uint32)fab->get_input()[i].menge);
+		}
+		for(  uint32 i = 0;  i < fab->get_output().get_count();  i++  ) {
+			hash = state_hashes_t::mix(hash, (uint32)fab->get_output()[i].menge);
+		}
+		add(state_hashes_t::FACTORIES, get_key(fab->get_pos().get_2d()), hash);
+	}
+
+	FOR(weighted_vector_tpl<stadt_t *>, const city, welt->get_cities()) {
+		uint32 hash = state_hashes_t::start;
+		hash = state_hashes_t::mix(hash, (uint32)city->get_einwohner());
+		hash = state_hashes_t::mix(hash, city->get_buildings());
+		hash = state_hashes_t::mix(hash, get_key(city->get_townhall_road()));
+		add(state_hashes_t::CITIES, get_key(city->get_pos()), hash);
+	}
+
+	FOR(vector_tpl<weg_t *>, const way, weg_t::get_alle_wege()) {
+		if(  !way->is_rail_type()  ) {
+			continue;
+		}
+		const schiene_t *track = static_cast<const schiene_t *>(way);
+		const convoihandle_t cnv = track->get_reserved_convoi();
+		if(  cnv.is_bound()  ) {
+			uint32 hash = state_hashes_t::start;
+			hash = state_hashes_t::mix(hash, (uint32)track->get_pos().z);
+			hash = state_hashes_t::mix(hash, cnv.get_id());
+			hash = state_hashes_t::mix(hash, track->get_reservation_type());
+			hash = state_hashes_t::mix(hash, track->get_reserved_direction());
+			add(state_hashes_t::RESERVATIONS, get_key(track->get_pos().get_2d()), hash);
+		}
+	}
+
+	hashes.calculated = true;
+	hashes.step = step;
+}
+
+
+void state_hash_log_t::describe(karte_t *welt, uint8 subsystem, uint32 key, char *buf, size_t len)
+{
+	buf[0] = 0;
+	switch(  subsystem  ) {
+		case state_hashes_t::CONVOYS:
+			FOR(vector_tpl<convoihandle_t>, const cnv, welt->convoys()) {
+				if(  cnv.get_id() == key  ) {
+					snprintf(buf, len, "%s at %s, state %d, speed %d", cnv->get_name(), cnv->get_pos().get_str(), cnv->get_state(), cnv->get_akt_speed());
+				}
+			}
+			break;
+
+		case state_hashes_t::HALTS:
+			FOR(vector_tpl<halthandle_t>, const halt, haltestelle_t::get_alle_haltestellen()) {
+				if(  halt.get_id() == key  ) {
+					snprintf(buf, len, "%s at %s", halt->get_name(), halt->get_basis_pos3d().get_str());
+				}
+			}
+			break;
+
+		case state_hashes_t::FACTORIES:
+			if(  const fabrik_t *fab = fabrik_t::get_fab(get_pos(key))  ) {
+				snprintf(buf, len, "%s at %s, status %d", fab->get_name(), fab->get_pos().get_str(), fab->get_status());
+			}
+			break;
+
+		case state_hashes_t::CITIES:
+			FOR(weighted_vector_tpl<stadt_t *>, const city, welt->get_cities()) {
+				if(  get_key(city->get_pos()) == key  ) {
+					snprintf(buf, len, "%s, %d inhabitants, %u buildings", city->get_name(), city->get_einwohner(), city->get_buildings());
+				}
+			}
+			break;
+
+		case state_hashes_t::RESERVATIONS:
+			snprintf(buf, len, "track at %s", get_pos(key).get_str());
+			break;
+	}
+}
+
+
+void state_hash_log_t::report_mismatch(karte_t *welt, const state_hashes_t &server) const
+{
+	if(  !hashes.calculated  ||  !server.calculated  ||  hashes.step != server.step  ) {
+		dbg->warning("state_hash_log_t::report_mismatch()", "No state hashes of step %u to compare", server.step);
+		return;
+	}
+
+	for(  uint8 i = 0;  i < state_hashes_t::MAX_SUBSYSTEMS;  i++  ) {
+		const uint32 bucket = hashes.get_first_differing_bucket(i, server);
+		if(  bucket == state_hashes_t::bucket_count  &&  hashes.count[i] == server.count[i]  ) {
+			continue;
+		}
+		dbg->warning("state_hash_log_t::report_mismatch()", "Step %u: %s differ (%u on server, %u here)", server.step, state_hashes_t::get_name(i), server.count[i], hashes.count[i]);
+		if(  bucket == state_hashes_t::bucket_count  ) {
+			continue;
+		}
+
+		// the server sends no hashes of single objects, so all of the bucket are candidates
+		FOR(vector_tpl<object_hash_t>, const &object, objects[i]) {
+			if(  state_hashes_t::finish(object.key) % state_hashes_t::bucket_count == bucket  ) {
+				char buf[256];
+				describe(welt, i, object.key, buf, lengthof(buf));
+				dbg->warning("state_hash_log_t::report_mismatch()", "  key %u hash %08x: %s", object.key, object.hash, buf);
+			}
+		}
+	}
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef DATAOBJ_STATE_HASHES_H
+#define DATAOBJ_STATE_HASHES_H
+
+
+#include "../simtypes.h"
+
+#include "../tpl/vector_tpl.h"
+
+
+class karte_t;
+class memory_rw_t;
+
+
+/**
+ * Hashes of the state of the subsystems of the game after a step, to find out
+ * where the game of a client went out of sync with that of the server.
+ *
+ * The objects of each subsystem are divided into buckets by their handle or
+ * position. The hash of a bucket is the sum of the hashes of its objects, so
+ * it does not depend on the order in which they are visited, e.g. after loading.
+ * The sum over all buckets of a subsystem goes into the checklist; the buckets
+ * themselves are sent with nwc_check_t.
+ */
+struct state_hashes_t
+{
+	enum subsystem_t
+	{
+		CONVOYS,
+		HALTS,          ///< waiting cargo
+		FACTORIES,
+		CITIES,
+		RESERVATIONS,   ///< of tracks
+		MAX_SUBSYSTEMS
+	};
+
+	static const uint32 bucket_count = 32;
+
+	/// initial hash of an object, to which its values are added by mix()
+	static const uint32 start = 2166136261u;
+
+	static uint32 mix(uint32 hash, uint32 value) { return (hash ^ value) * 16777619u; }
+
+	/// Spreads the bits of the hash of an object, so that a sum of many of them is still a good hash
+	static uint32 finish(uint32 hash);
+
+	/// whether the hashes were calculated at all
+	bool calculated;
+
+	/// the step after which they were calculated
+	uint32 step;
+
+	/// number of objects in each subsystem
+	uint32 count[MAX_SUBSYSTEMS];
+
+	uint32 buckets[MAX_SUBSYSTEMS][bucket_count];
+
+	state_hashes_t() { clear(); }
+
+	void clear();
+
+	/// @returns the hash of all objects of @p subsystem, or 0 if not calculated
+	uint32 get_hash(uint8 subsystem) const;
+
+	/// @returns the first bucket of @p subsystem that differs from @p other, or bucket_count if none
+	uint32 get_first_differing_bucket(uint8 subsystem, const state_hashes_t &other) const;
+
+	void rdwr(memory_rw_t *buffer);
+
+	static const char *get_name(uint8 subsystem);
+};
+
+
+/**
+ * Calculates the state hashes of a world, and keeps the hashes of the single
+ * objects to report those of a bucket that differs from the server.
+ */
+class state_hash_log_t
+{
+public:
+	/// hash of a single object, and the handle or position by which it is found again
+	struct object_hash_t
+	{
+		uint32 key;
+		uint32 hash;
+	};
+
+private:
+	state_hashes_t hashes;
+
+	// the objects of each subsystem, in the order they were visited
+	vector_tpl<object_hash_t> objects[state_hashes_t::MAX_SUBSYSTEMS];
+
+	void add(uint8 subsystem, uint32 key, uint32 hash);
+
+	/// Writes the current state of the object of @p subsystem with @p key to @p buf
+	static void describe(karte_t *welt, uint8 subsystem, uint32 key, char *buf, size_t len);
+
+public:
+	void clear();
+
+	/// Must be called while no other thread changes the world
+	void calc(karte_t *welt, uint32 step);
+
+	const state_hashes_t &get_hashes() const { return hashes; }
+
+	/// Logs which subsystems differ from those of @p server, and the objects of the first differing bucket of each
+	void report_mismatch(karte_t *welt, const state_hashes_t &server) const;
+};
+
+#endif
@@ -162,6 +162,17 @@ void register_image(class image_t *);
 // delete all images above a certain number ...
 void display_free_all_images_above( image_id above );
 
+/// counters of the cache of zoomed and player coloured images
+struct image_cache_stats_t
+{
+	uint64 hits;       ///< images drawn from the cache
+	uint64 misses;     ///< images zoomed or coloured before drawing
+	uint64 evictions;  ///< images freed to stay within env_t::image_cache_budget
+	uint64 bytes;      ///< memory used by the cache
+};
+
+void display_get_image_cache_stats( image_cache_stats_t &stats );
+
 // unzoomed offsets
 void display_get_base_image_offset( image_id image, scr_coord_val *xoff, scr_coord_val *yoff, scr_coord_val *xw, scr_coord_val *yw );
 // zoomed offsets
@@ -172,6 +183,15 @@ void mark_rect_dirty_wc(scr_coord_val x1, scr_coord_val y1, scr_coord_val x2, sc
 void mark_rect_dirty_clip(scr_coord_val x1, scr_coord_val y1, scr_coord_val x2, scr_coord_val y2  CLIP_NUM_DEF); // clips to clip_rect
 void mark_screen_dirty();
 
+// cache of the ground and ways of the main view, in chunks of the screen
+void display_static_layer_mark_dirty(scr_coord_val x1, scr_coord_val y1, scr_coord_val x2, scr_coord_val y2);
+void display_static_layer_mark_all_dirty();
+/// copies the valid chunks within @p area into the frame buffer, and returns the part of it that must be drawn again
+scr_rect display_static_layer_restore(const scr_rect area);
+void display_static_layer_store(const scr_rect area);
+/// marks the chunks within @p area as valid, after all threads stored their part of them
+void display_static_layer_validate(const scr_rect area);
+
 scr_coord_val display_get_width();
 scr_coord_val display_get_height();
 void display_set_height(scr_coord_val);
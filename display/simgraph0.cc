@@ -70,6 +70,27 @@ void mark_screen_dirty()
 {
 }
 
+void display_static_layer_mark_dirty(scr_coord_val, scr_coord_val, scr_coord_val, scr_coord_val)
+{
+}
+
+void display_static_layer_mark_all_dirty()
+{
+}
+
+scr_rect display_static_layer_restore(const scr_rect area)
+{
+	return area;
+}
+
+void display_static_layer_store(const scr_rect)
+{
+}
+
+void display_static_layer_validate(const scr_rect)
+{
+}
+
 void display_mark_img_dirty(image_id, scr_coord_val, scr_coord_val)
 {
 }
@@ -393,6 +414,11 @@ void display_free_all_images_above(image_id)
 {
 }
 
+void display_get_image_cache_stats(image_cache_stats_t &stats)
+{
+	stats.hits = stats.misses = stats.evictions = stats.bytes = 0;
+}
+
 void simgraph_exit()
 {
 	dr_os_close();
@@ -23,6 +23,7 @@
 #include "../unicode.h"
 #include "../simticker.h"
 #include "../utils/simstring.h"
+#include "../tpl/vector_tpl.h"
 //#include "../io/raw_image.h"
 
 #include "../gui/simwin.h"
@@ -41,8 +42,15 @@
 #	include <unistd.h>
 #endif
 
+// SSE2 is part of all x86-64 processors; without it, only the plain C routines are used
+#if defined(__SSE2__)  ||  defined(_M_X64)  ||  (defined(_M_IX86_FP)  &&  _M_IX86_FP >= 2)
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifdef MULTI_THREAD
 #include "../utils/simthread.h"
+#include "../utils/job_scheduler.h"
 
 // currently just redrawing/rezooming
 static pthread_mutex_t rezoom_img_mutex[MAX_THREADS];
@@ -337,6 +345,8 @@ struct imd {
 	PIXVAL* zoom_data; // zoomed original data
 	uint32 len;    // current zoom image data size (or base if not zoomed) (used for allocation purposes only)
 
+	uint32 last_used; // frame in which the cached data was drawn last
+
 	sint16 base_x; // min x offset
 	sint16 base_y; // min y offset
 	sint16 base_w; // width
@@ -391,6 +401,33 @@ static image_id anz_images = 0;
 static image_id alloc_images = 0;
 
 
+/*
+ * Counters of the image cache (data and zoom_data of the images), per thread
+ */
+MSVC_ALIGN(64) struct image_cache_counters_t {
+	uint32 hits;
+	uint32 misses;
+	sint64 bytes; // allocated minus freed
+} GCC_ALIGN(64); // aligned to separate cachelines
+
+#ifdef MULTI_THREAD
+static image_cache_counters_t cache_counters[MAX_THREADS];
+#define CC0 cache_counters[0]
+#else
+static image_cache_counters_t cache_counters;
+#define CC0 cache_counters
+#endif
+
+#define CC cache_counters CLIP_NUM_INDEX
+
+// counted up by display_flush_buffer(), to find the least recently drawn images
+static uint32 cache_frame = 1;
+
+// counters of all threads up to the last frame
+static image_cache_stats_t cache_stats;
+static sint64 cache_bytes = 0;
+
+
 /*
  * Output framebuffer
  */
@@ -1104,6 +1141,129 @@ void display_mark_img_dirty(image_id image, scr_coord_val xp, scr_coord_val yp)
 }
 
 
+/*
+ * Cache of the ground and ways of the main view (see main_view_t::display)
+ * The screen is divided into chunks, which are copied back into the frame buffer
+ * instead of drawing their tiles again as long as nothing in them changed.
+ */
+#define STATIC_LAYER_CHUNK_SHIFT 6
+#define STATIC_LAYER_CHUNK_SIZE (1 << STATIC_LAYER_CHUNK_SHIFT)
+
+static PIXVAL *static_layer = NULL;
+static uint8 *static_layer_dirty = NULL; // one flag per chunk
+static scr_coord_val static_layer_chunks_per_line = 0;
+static scr_coord_val static_layer_chunk_lines = 0;
+
+
+static void free_static_layer()
+{
+	free( static_layer );
+	free( static_layer_dirty );
+	static_layer = NULL;
+	static_layer_dirty = NULL;
+}
+
+
+void display_static_layer_mark_dirty(scr_coord_val x1, scr_coord_val y1, scr_coord_val x2, scr_coord_val y2)
+{
+	if(  static_layer_dirty  &&  x2 >= 0  &&  y2 >= 0  &&  x1 < disp_width  &&  y1 < disp_height  ) {
+		x1 = max( x1, 0 ) >> STATIC_LAYER_CHUNK_SHIFT;
+		y1 = max( y1, 0 ) >> STATIC_LAYER_CHUNK_SHIFT;
+		x2 = min( x2, disp_width - 1 ) >> STATIC_LAYER_CHUNK_SHIFT;
+		y2 = min( y2, disp_height - 1 ) >> STATIC_LAYER_CHUNK_SHIFT;
+		for(  ;  y1 <= y2;  y1++  ) {
+			memset( static_layer_dirty + y1 * static_layer_chunks_per_line + x1, 1, x2 - x1 + 1 );
+		}
+	}
+}
+
+
+void display_static_layer_mark_all_dirty()
+{
+	if(  !static_layer  ) {
+		static_layer_chunks_per_line = (disp_width + STATIC_LAYER_CHUNK_SIZE - 1) >> STATIC_LAYER_CHUNK_SHIFT;
+		static_layer_chunk_lines = (disp_height + STATIC_LAYER_CHUNK_SIZE - 1) >> STATIC_LAYER_CHUNK_SHIFT;
+		static_layer = MALLOCN( PIXVAL, disp_width * disp_height );
+		static_layer_dirty = MALLOCN( uint8, static_layer_chunks_per_line * static_layer_chunk_lines );
+	}
+	memset( static_layer_dirty, 1, static_layer_chunks_per_line * static_layer_chunk_lines );
+}
+
+
+scr_rect display_static_layer_restore(const scr_rect area)
+{
+	if(  !static_layer  ||  area.w <= 0  ||  area.h <= 0  ) {
+		return area;
+	}
+
+	const scr_coord_val cx1 = area.x >> STATIC_LAYER_CHUNK_SHIFT;
+	const scr_coord_val cx2 = (area.get_right() - 1) >> STATIC_LAYER_CHUNK_SHIFT;
+	const scr_coord_val cy1 = area.y >> STATIC_LAYER_CHUNK_SHIFT;
+	const scr_coord_val cy2 = (area.get_bottom() - 1) >> STATIC_LAYER_CHUNK_SHIFT;
+
+	// the rows of chunks from the first to the last one with an invalid chunk are drawn again
+	scr_coord_val first_dirty = cy2 + 1;
+	scr_coord_val last_dirty = cy1 - 1;
+	for(  scr_coord_val cy = cy1;  cy <= cy2;  cy++  ) {
+		const uint8 *dirty = static_layer_dirty + cy * static_layer_chunks_per_line;
+		for(  scr_coord_val cx = cx1;  cx <= cx2;  cx++  ) {
+			if(  dirty[cx]  ) {
+				first_dirty = min( first_dirty, cy );
+				last_dirty = cy;
+				break;
+			}
+		}
+	}
+
+	// all others are copied from the cache
+	for(  scr_coord_val cy = cy1;  cy <= cy2;  cy++  ) {
+		if(  cy == first_dirty  ) {
+			cy = last_dirty;
+			continue;
+		}
+		const scr_coord_val y_end = min( area.get_bottom(), (cy + 1) << STATIC_LAYER_CHUNK_SHIFT );
+		for(  scr_coord_val y = max( area.y, cy << STATIC_LAYER_CHUNK_SHIFT );  y < y_end;  y++  ) {
+			const int offset = y * disp_width + area.x;
+			memcpy( textur + offset, static_layer + offset, area.w * sizeof(PIXVAL) );
+		}
+	}
+
+	if(  first_dirty > last_dirty  ) {
+		return scr_rect( area.x, area.y, area.w, 0 );
+	}
+	const scr_coord_val y_start = max( area.y, first_dirty << STATIC_LAYER_CHUNK_SHIFT );
+	const scr_coord_val y_end = min( area.get_bottom(), (last_dirty + 1) << STATIC_LAYER_CHUNK_SHIFT );
+	return scr_rect( area.x, y_start, area.w, y_end - y_start );
+}
+
+
+void display_static_layer_store(const scr_rect area)
+{
+	if(  static_layer  ) {
+		for(  scr_coord_val y = area.y;  y < area.get_bottom();  y++  ) {
+			const int offset = y * disp_width + area.x;
+			memcpy( static_layer + offset, textur + offset, area.w * sizeof(PIXVAL) );
+		}
+	}
+}
+
+
+void display_static_layer_validate(const scr_rect area)
+{
+	const scr_coord_val x1 = max( area.x, 0 );
+	const scr_coord_val y1 = max( area.y, 0 );
+	const scr_coord_val x2 = min( area.get_right(), disp_width ) - 1;
+	const scr_coord_val y2 = min( area.get_bottom(), disp_height ) - 1;
+	if(  static_layer_dirty  &&  x1 <= x2  &&  y1 <= y2  ) {
+		const scr_coord_val cx1 = x1 >> STATIC_LAYER_CHUNK_SHIFT;
+		const scr_coord_val cx2 = x2 >> STATIC_LAYER_CHUNK_SHIFT;
+		for(  scr_coord_val cy = y1 >> STATIC_LAYER_CHUNK_SHIFT;  cy <= (y2 >> STATIC_LAYER_CHUNK_SHIFT);  cy++  ) {
+			memset( static_layer_dirty + cy * static_layer_chunks_per_line + cx1, 0, cx2 - cx1 + 1 );
+		}
+	}
+}
+
+
 // ------------------------- rendering images for display --------------------------------
 
 /*
@@ -1111,16 +1271,171 @@ void display_mark_img_dirty(image_id image, scr_coord_val xp, scr_coord_val yp)
  * They are derived from a base image, which may need zooming too
  */
 
+static void rezoom_img(const image_id n, image_cache_counters_t &counters);
+static void recode_img(const image_id n, const sint8 player_nr  CLIP_NUM_DEF);
+
+
+/*
+ * The images to zoom again after a zoom change, those drawn in the last frame first
+ */
+static vector_tpl<image_id> rezoom_list;
+
+#ifdef MULTI_THREAD
+// rezoom_list is zoomed in tasks of this many images
+#define REZOOM_TASK_IMAGES (64)
+
+struct rezoom_range_t
+{
+	uint32 first;
+	uint32 end;
+};
+
+static void rezoom_task(void *data, uint32 task);
+
+static rezoom_range_t prewarm_range;
+static rezoom_range_t background_range;
+static job_scheduler_t::job_t prewarm_job( &rezoom_task, &prewarm_range );
+static job_scheduler_t::job_t background_rezoom_job( &rezoom_task, &background_range );
+
+static bool background_rezoom_running = false;
+static volatile bool background_rezoom_cancelled = false;
+
+// cache counters of the rezoom tasks, collected after each frame
+static image_cache_counters_t rezoom_counters;
+static pthread_mutex_t rezoom_counters_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void rezoom_task(void *data, uint32 task)
+{
+	const rezoom_range_t &range = *(const rezoom_range_t *)data;
+	const uint32 first = range.first + task * REZOOM_TASK_IMAGES;
+	const uint32 end = range.end - first > REZOOM_TASK_IMAGES ? first + REZOOM_TASK_IMAGES : range.end;
+
+	image_cache_counters_t counters;
+	counters.bytes = 0;
+	for(  uint32 i = first;  i < end  &&  !background_rezoom_cancelled;  i++  ) {
+		rezoom_img( rezoom_list[i], counters );
+	}
+
+	pthread_mutex_lock( &rezoom_counters_mutex );
+	rezoom_counters.bytes += counters.bytes;
+	pthread_mutex_unlock( &rezoom_counters_mutex );
+}
+
+
+static uint32 get_rezoom_task_count(const rezoom_range_t &range)
+{
+	return (range.end - range.first + REZOOM_TASK_IMAGES - 1) / REZOOM_TASK_IMAGES;
+}
+
+
+// i.e. drawn at the last zoom factor and not evicted since
+static bool has_cached_data(const image_id n)
+{
+	if(  images[n].zoom_data != NULL  ) {
+		return true;
+	}
+	for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
+		if(  images[n].data[i] != NULL  ) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+
+/**
+ * Waits for the images zoomed in the background, or stops zooming them.
+ * Must be called before anything else changes the images or the zoom factor.
+ */
+static void finish_background_rezoom(bool cancel)
+{
+#ifdef MULTI_THREAD
+	if(  background_rezoom_running  ) {
+		background_rezoom_cancelled = cancel;
+		job_scheduler_t::wait( background_rezoom_job );
+		background_rezoom_cancelled = false;
+		background_rezoom_running = false;
+	}
+#else
+	(void)cancel;
+#endif
+}
+
+
 /**
- * Flag all images for rezoom on next draw
+ * Flag all images for rezoom on next draw.
+ * Those drawn before are zoomed again at once (image_cache_prewarm) and
+ * by the worker threads in the background (background_rezoom), the images
+ * of the last frame first. Those left are zoomed when drawn.
  */
 static void rezoom()
 {
+	rezoom_list.clear();
 	for(  image_id n = 0;  n < anz_images;  n++  ) {
 		if(  (images[n].recode_flags & FLAG_ZOOMABLE) != 0  &&  images[n].base_h > 0  ) {
 			images[n].recode_flags |= FLAG_REZOOM;
+			if(  images[n].last_used + 1 >= cache_frame  ) {
+				rezoom_list.append( n );
+			}
+		}
+	}
+	const uint32 visible_count = rezoom_list.get_count();
+
+	if(  env_t::image_cache_prewarm  ) {
+		// zoom them now, in all colours they were drawn in
+		vector_tpl<uint16> cached_players( visible_count );
+		for(  uint32 i = 0;  i < visible_count;  i++  ) {
+			uint16 players = 0;
+			for(  uint8 p = 0;  p < MAX_PLAYER_COUNT;  p++  ) {
+				if(  images[rezoom_list[i]].data[p] != NULL  ) {
+					players |= 1 << p;
+				}
+			}
+			cached_players.append( players );
+		}
+
+#ifdef MULTI_THREAD
+		if(  job_scheduler_t::get_worker_count() > 0  ) {
+			prewarm_range.first = 0;
+			prewarm_range.end = visible_count;
+			job_scheduler_t::run( prewarm_job, get_rezoom_task_count( prewarm_range ) );
+		}
+		else
+#endif
+		{
+			for(  uint32 i = 0;  i < visible_count;  i++  ) {
+				rezoom_img( rezoom_list[i], CC0 );
+			}
+		}
+
+		// recoding shares the player colour tables, so there is nothing to gain from more threads
+		for(  uint32 i = 0;  i < visible_count;  i++  ) {
+			for(  uint8 p = 0;  p < MAX_PLAYER_COUNT;  p++  ) {
+				if(  cached_players[i] & (1 << p)  ) {
+					recode_img( rezoom_list[i], p  CLIP_NUM_DEFAULT );
+				}
+			}
 		}
 	}
+
+#ifdef MULTI_THREAD
+	if(  env_t::background_rezoom  &&  job_scheduler_t::get_worker_count() > 0  ) {
+		// then the other images drawn at the last zoom factor
+		for(  image_id n = 0;  n < anz_images;  n++  ) {
+			if(  (images[n].recode_flags & FLAG_REZOOM)  &&  images[n].last_used + 1 < cache_frame  &&  has_cached_data( n )  ) {
+				rezoom_list.append( n );
+			}
+		}
+		background_range.first = env_t::image_cache_prewarm ? visible_count : 0;
+		background_range.end = rezoom_list.get_count();
+		if(  background_range.end > background_range.first  ) {
+			job_scheduler_t::submit( background_rezoom_job, get_rezoom_task_count( background_range ) );
+			background_rezoom_running = true;
+		}
+	}
+#endif
 }
 
 int get_zoom_factor()
@@ -1132,6 +1447,7 @@ void set_zoom_factor(int z)
 {
 	// do not zoom beyond 4 pixels
 	if(  (base_tile_raster_width * zoom_num[z]) / zoom_den[z] > 4  ) {
+		finish_background_rezoom( true );
 		zoom_factor = z;
 		tile_raster_width = (base_tile_raster_width * zoom_num[zoom_factor]) / zoom_den[zoom_factor];
 		dbg->message("set_zoom_factor()", "Zoom level now %d (%i/%i)", zoom_factor, zoom_num[zoom_factor], zoom_den[zoom_factor] );
@@ -1337,7 +1653,7 @@ image_id get_image_count()
 /**
  * Handles the conversion of an image to the output color
  */
-static void recode_img(const image_id n, const sint8 player_nr)
+static void recode_img(const image_id n, const sint8 player_nr  CLIP_NUM_DEF)
 {
 	// may this image be zoomed
 #ifdef MULTI_THREAD
@@ -1352,6 +1668,7 @@ static void recode_img(const image_id n, const sint8 player_nr)
 
 	if(  images[n].data[player_nr] == NULL  ) {
 		images[n].data[player_nr] = MALLOCN( PIXVAL, images[n].len );
+		CC.bytes += images[n].len * sizeof(PIXVAL);
 	}
 	// contains now the player color ...
 	activate_player_color( player_nr, true );
@@ -1422,7 +1739,7 @@ PIXVAL inline zoomin_pixel(uint8 *p, uint8* pab, uint8 *prl, uint8* pdia)
  * Uses averages of all sampled points to get the "real" value
  * Blurs a bit
  */
-static void rezoom_img(const image_id n)
+static void rezoom_img(const image_id n, image_cache_counters_t &counters)
 {
 	// may this image be zoomed
 	if(  n < anz_images  &&  images[n].base_h > 0  ) {
@@ -1442,11 +1759,13 @@ static void rezoom_img(const image_id n)
 		if(  images[n].zoom_data != NULL  ) {
 			free( images[n].zoom_data );
 			images[n].zoom_data = NULL;
+			counters.bytes -= images[n].len * sizeof(PIXVAL);
 		}
 		for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
 			if(  images[n].data[i] != NULL  ) {
 				free( images[n].data[i] );
 				images[n].data[i] = NULL;
+				counters.bytes -= images[n].len * sizeof(PIXVAL);
 			}
 		}
 
@@ -1884,6 +2203,7 @@ static void rezoom_img(const image_id n)
 				images[n].len = (uint32)(zoom_len / sizeof(PIXVAL));
 				images[n].zoom_data = MALLOCN(PIXVAL, images[n].len);
 				assert( images[n].zoom_data );
+				counters.bytes += zoom_len;
 				memcpy( images[n].zoom_data, rezoom_baseimage[n % env_t::num_threads], zoom_len );
 			}
 		}
@@ -1902,10 +2222,30 @@ static void rezoom_img(const image_id n)
 }
 
 
+/**
+ * Rezooms and recodes the cached image of a player if needed before drawing it
+ */
+static void prepare_img(const image_id n, const sint8 player_nr  CLIP_NUM_DEF)
+{
+	images[n].last_used = cache_frame;
+	if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
+		rezoom_img( n, CC );
+	}
+	if(  (images[n].player_flags & (1<<player_nr))  ) {
+		recode_img( n, player_nr  CLIP_NUM_PAR );
+		CC.misses++;
+	}
+	else {
+		CC.hits++;
+	}
+}
+
+
 // force a certain size on a image (for rescaling tool images)
 void display_fit_img_to_width( const image_id n, sint16 new_w )
 {
 	if(  n < anz_images  &&  images[n].base_h > 0  &&  images[n].w != new_w  ) {
+		finish_background_rezoom( true );
 		int old_zoom_factor = zoom_factor;
 		for(  int i=0;  i<=MAX_ZOOM_FACTOR;  i++  ) {
 			int zoom_w = (images[n].base_w * zoom_num[i]) / zoom_den[i];
@@ -1913,7 +2253,7 @@ void display_fit_img_to_width( const image_id n, sint16 new_w )
 				uint8 old_zoom_flag = images[n].recode_flags & FLAG_ZOOMABLE;
 				images[n].recode_flags |= FLAG_REZOOM | FLAG_ZOOMABLE;
 				zoom_factor = i;
-				rezoom_img(n);
+				rezoom_img( n, CC0 );
 				images[n].recode_flags &= ~FLAG_ZOOMABLE;
 				images[n].recode_flags |= old_zoom_flag;
 				zoom_factor = old_zoom_factor;
@@ -2109,6 +2449,8 @@ void register_image(image_t *image_in)
 {
 	struct imd *image;
 
+	finish_background_rezoom( true );
+
 	/* valid image? */
 	if(  image_in->len == 0  ||  image_in->h == 0  ) {
 		fprintf(stderr, "Warning: ignoring image %d because of missing data\n", anz_images);
@@ -2176,6 +2518,7 @@ void register_image(image_t *image_in)
 
 	image->zoom_data = NULL;
 	image->len = image_in->len;
+	image->last_used = 0;
 
 	image->base_x = image_in->x;
 	image->base_w = image_in->w;
@@ -2194,20 +2537,131 @@ void register_image(image_t *image_in)
 // (mostly needed when changing climate zones)
 void display_free_all_images_above( image_id above )
 {
+	finish_background_rezoom( true );
 	while(  above < anz_images  ) {
 		anz_images--;
 		if(  images[anz_images].zoom_data != NULL  ) {
 			free( images[anz_images].zoom_data );
+			cache_bytes -= images[anz_images].len * sizeof(PIXVAL);
 		}
 		for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
 			if(  images[anz_images].data[i] != NULL  ) {
 				free( images[anz_images].data[i] );
+				cache_bytes -= images[anz_images].len * sizeof(PIXVAL);
 			}
 		}
 	}
 }
 
 
+/**
+ * Frees the cached data of an image, which is recreated when it is drawn next
+ * @returns the number of bytes freed
+ */
+static sint64 free_cached_img(const image_id n)
+{
+	sint64 freed = 0;
+	for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
+		if(  images[n].data[i] != NULL  ) {
+			free( images[n].data[i] );
+			images[n].data[i] = NULL;
+			images[n].player_flags |= 1 << i;
+			freed += images[n].len * sizeof(PIXVAL);
+		}
+	}
+	// images not zoomable may have been fitted to a size by display_fit_img_to_width(), which cannot be redone
+	if(  images[n].zoom_data != NULL  &&  (images[n].recode_flags & FLAG_ZOOMABLE)  ) {
+		free( images[n].zoom_data );
+		images[n].zoom_data = NULL;
+		images[n].recode_flags |= FLAG_REZOOM;
+		freed += images[n].len * sizeof(PIXVAL);
+	}
+	return freed;
+}
+
+
+static bool is_less_recently_used(const image_id a, const image_id b)
+{
+	return images[a].last_used < images[b].last_used;
+}
+
+
+/**
+ * Frees the images drawn least recently until the cache is below its budget.
+ * Must be called while no thread draws.
+ */
+static void evict_cached_images()
+{
+	const sint64 budget = (sint64)env_t::image_cache_budget << 20;
+	if(  budget == 0  ||  cache_bytes <= budget  ) {
+		return;
+	}
+	finish_background_rezoom( true );
+
+	// images drawn in this or the last frame are likely needed in the next one
+	static vector_tpl<image_id> candidates;
+	candidates.clear();
+	for(  image_id n = 0;  n < anz_images;  n++  ) {
+		if(  images[n].last_used + 1 < cache_frame  ) {
+			candidates.append( n );
+		}
+	}
+	std::sort( candidates.begin(), candidates.end(), is_less_recently_used );
+
+	// free a bit more than needed, so this is not done again in the next frame
+	const sint64 target = budget - budget / 10;
+	uint32 evicted = 0;
+	for(  uint32 i = 0;  i < candidates.get_count()  &&  cache_bytes > target;  i++  ) {
+		const sint64 freed = free_cached_img( candidates[i] );
+		if(  freed > 0  ) {
+			cache_bytes -= freed;
+			evicted++;
+		}
+	}
+	cache_stats.evictions += evicted;
+
+	dbg->message( "evict_cached_images()", "Freed %u images, %lli KiB left of %u MiB budget", evicted, (long long)(cache_bytes >> 10), env_t::image_cache_budget );
+}
+
+
+/**
+ * Collects the counters of the image cache after a frame, and keeps it within its budget
+ */
+static void end_image_cache_frame()
+{
+#ifdef MULTI_THREAD
+	for(  int i = 0;  i < MAX_THREADS;  i++  ) {
+		image_cache_counters_t &counters = cache_counters[i];
+#else
+	{
+		image_cache_counters_t &counters = cache_counters;
+#endif
+		cache_stats.hits += counters.hits;
+		cache_stats.misses += counters.misses;
+		cache_bytes += counters.bytes;
+		counters.hits = 0;
+		counters.misses = 0;
+		counters.bytes = 0;
+	}
+#ifdef MULTI_THREAD
+	pthread_mutex_lock( &rezoom_counters_mutex );
+	cache_bytes += rezoom_counters.bytes;
+	rezoom_counters.bytes = 0;
+	pthread_mutex_unlock( &rezoom_counters_mutex );
+#endif
+
+	evict_cached_images();
+	cache_frame++;
+}
+
+
+void display_get_image_cache_stats(image_cache_stats_t &stats)
+{
+	stats = cache_stats;
+	stats.bytes = (uint64)max(cache_bytes, 0);
+}
+
+
 // query offsets
 void display_get_image_offset(image_id image, scr_coord_val *xoff, scr_coord_val *yoff, scr_coord_val *xw, scr_coord_val *yw)
 {
@@ -2667,7 +3121,7 @@ void display_img_aux(const image_id n, scr_coord_val xp, scr_coord_val yp, const
 		PIXVAL *sp;
 
 		if(  use_player > 0  ) {
-			// player colour images are rezoomed/recoloured in display_color_img
+			prepare_img( n, use_player  CLIP_NUM_PAR );
 			sp = images[n].data[use_player];
 			if(  sp == NULL  ) {
 				printf("CImg[%i] %u failed!\n", use_player, n);
@@ -2675,13 +3129,7 @@ void display_img_aux(const image_id n, scr_coord_val xp, scr_coord_val yp, const
 			}
 		}
 		else {
-			if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
-				rezoom_img( n );
-				recode_img( n, 0 );
-			}
-			else if(  (images[n].player_flags & 1)  ) {
-				recode_img( n, 0 );
-			}
+			prepare_img( n, 0  CLIP_NUM_PAR );
 			sp = images[n].data[0];
 			if(  sp == NULL  ) {
 				printf("Img %u failed!\n", n);
@@ -3035,21 +3483,19 @@ void display_color_img(const image_id n, scr_coord_val xp, scr_coord_val yp, sin
 	if(  n < anz_images  ) {
 		// do we have to use a player nr?
 		const sint8 player_nr = (images[n].recode_flags & FLAG_HAS_PLAYER_COLOR) * player_nr_raw;
-		// first: size check
-		if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
-			rezoom_img( n );
-		}
 
 		if(  daynight  ||  night_shift == 0  ) {
-			// ok, now we could use the same faster code as for the normal images
-			if(  (images[n].player_flags & (1<<player_nr))  ) {
-				recode_img( n, player_nr );
-			}
+			// ok, now we could use the same faster code as for the normal images (which rezooms and recodes them)
 			display_img_aux( n, xp, yp, player_nr, true, dirty  CLIP_NUM_PAR);
 			return;
 		}
 		else {
 		// do player colour substitution but not daynight - can't use cached images. Do NOT call multithreaded.
+			// first: size check
+			if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
+				rezoom_img( n, CC );
+			}
+			images[n].last_used = cache_frame;
 		// now test if visible and clipping needed
 			const scr_coord_val x = images[n].x + xp;
 			      scr_coord_val y = images[n].y + yp;
@@ -3447,6 +3893,51 @@ static void pix_outline25_16(PIXVAL *dest, const PIXVAL *, const PIXVAL colour,
 }
 
 
+#ifdef USE_SSE2
+/// multiplies by 1 or 3
+template<int weight>
+static inline __m128i weigh_sse2(const __m128i v)
+{
+	return weight == 1 ? v : _mm_add_epi16( _mm_add_epi16( v, v ), v );
+}
+
+
+/**
+ * Blends 8 pixels at once: dest = src_weight*((src>>shift)&mask) + dest_weight*((dest>>shift)&mask)
+ * with dest_weight = (1<<shift)-src_weight, like the routine scalar, which does the rest
+ */
+template<int shift, PIXVAL mask, int src_weight, blend_proc scalar>
+static void pix_blend_sse2(PIXVAL *dest, const PIXVAL *src, const PIXVAL colour, const PIXVAL len)
+{
+	const __m128i m = _mm_set1_epi16( mask );
+
+	const PIXVAL *const end = dest + len;
+	for(  ;  end - dest >= 8;  dest += 8, src += 8  ) {
+		const __m128i s = _mm_and_si128( _mm_srli_epi16( _mm_loadu_si128( (const __m128i *)src ), shift ), m );
+		const __m128i d = _mm_and_si128( _mm_srli_epi16( _mm_loadu_si128( (const __m128i *)dest ), shift ), m );
+		_mm_storeu_si128( (__m128i *)dest, _mm_add_epi16( weigh_sse2<src_weight>( s ), weigh_sse2<(1 << shift) - src_weight>( d ) ) );
+	}
+	scalar( dest, src, colour, (PIXVAL)(end - dest) );
+}
+
+
+/// As pix_blend_sse2(), but with a single colour instead of an image
+template<int shift, PIXVAL mask, int src_weight, blend_proc scalar>
+static void pix_outline_sse2(PIXVAL *dest, const PIXVAL *src, const PIXVAL colour, const PIXVAL len)
+{
+	const __m128i m = _mm_set1_epi16( mask );
+	const __m128i c = _mm_set1_epi16( src_weight * ((colour >> shift) & mask) );
+
+	const PIXVAL *const end = dest + len;
+	for(  ;  end - dest >= 8;  dest += 8  ) {
+		const __m128i d = _mm_and_si128( _mm_srli_epi16( _mm_loadu_si128( (const __m128i *)dest ), shift ), m );
+		_mm_storeu_si128( (__m128i *)dest, _mm_add_epi16( c, weigh_sse2<(1 << shift) - src_weight>( d ) ) );
+	}
+	scalar( dest, src, colour, (PIXVAL)(end - dest) );
+}
+#endif
+
+
 // will kept the actual values
 static blend_proc blend[3];
 static blend_proc blend_recode[3];
@@ -3485,7 +3976,7 @@ void display_blend_wh_rgb(scr_coord_val xp, scr_coord_val yp, scr_coord_val w, s
 
 			default:
 				// any percentage blending: SLOW!
-				if(  blend[0] == pix_blend25_15  ) {
+				if(  bitdepth == 15  ) {
 					// 555 BITMAPS
 					const PIXVAL r_src = (colval >> 10) & 0x1F;
 					const PIXVAL g_src = (colval >> 5) & 0x1F;
@@ -3748,6 +4239,50 @@ static void pix_alpha_recode_16(PIXVAL *dest, const PIXVAL *src, const PIXVAL *a
 }
 
 
+#ifdef USE_SSE2
+/**
+ * Blends 8 pixels at once like pix_alpha_15/16(), for the colour format with
+ * red at bit red_shift and a green of green_mask. Since the red and blue of
+ * a pixel do not overlap while blending, doing each channel on its own gives
+ * the same results.
+ */
+template<int red_shift, PIXVAL green_mask, alpha_proc scalar>
+static void pix_alpha_sse2(PIXVAL *dest, const PIXVAL *src, const PIXVAL *alphamap, const unsigned alpha_flags, const PIXVAL colour, const PIXVAL len)
+{
+	const __m128i rmask = _mm_set1_epi16( alpha_flags & ALPHA_RED ? 0x7c00 : 0 );
+	const __m128i gmask = _mm_set1_epi16( alpha_flags & ALPHA_GREEN ? 0x03e0 : 0 );
+	const __m128i bmask = _mm_set1_epi16( alpha_flags & ALPHA_BLUE ? 0x001f : 0 );
+	const __m128i five_bits = _mm_set1_epi16( 0x1f );
+	const __m128i green_bits = _mm_set1_epi16( green_mask );
+
+	const PIXVAL *const end = dest + len;
+	for(  ;  end - dest >= 8;  dest += 8, src += 8, alphamap += 8  ) {
+		// read mask components - always 15bpp
+		const __m128i am = _mm_loadu_si128( (const __m128i *)alphamap );
+		__m128i a = _mm_add_epi16( _mm_add_epi16( _mm_and_si128( am, bmask ), _mm_srli_epi16( _mm_and_si128( am, gmask ), 5 ) ), _mm_srli_epi16( _mm_and_si128( am, rmask ), 10 ) );
+		const __m128i opaque = _mm_cmpgt_epi16( a, _mm_set1_epi16( 30 ) );
+		const __m128i clear = _mm_cmpeq_epi16( a, _mm_setzero_si128() );
+		a = _mm_sub_epi16( a, _mm_cmpgt_epi16( a, _mm_set1_epi16( 15 ) ) ); // +1 above 15
+		const __m128i ia = _mm_sub_epi16( _mm_set1_epi16( 32 ), a );
+
+		const __m128i s = _mm_loadu_si128( (const __m128i *)src );
+		const __m128i d = _mm_loadu_si128( (const __m128i *)dest );
+
+		const __m128i r = _mm_srli_epi16( _mm_add_epi16( _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi16( s, red_shift ), five_bits ), a ), _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi16( d, red_shift ), five_bits ), ia ) ), 5 );
+		const __m128i g = _mm_srli_epi16( _mm_add_epi16( _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi16( s, 5 ), green_bits ), a ), _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi16( d, 5 ), green_bits ), ia ) ), 5 );
+		const __m128i b = _mm_srli_epi16( _mm_add_epi16( _mm_mullo_epi16( _mm_and_si128( s, five_bits ), a ), _mm_mullo_epi16( _mm_and_si128( d, five_bits ), ia ) ), 5 );
+		const __m128i blended = _mm_or_si128( _mm_or_si128( _mm_slli_epi16( r, red_shift ), _mm_slli_epi16( g, 5 ) ), b );
+
+		// opaque pixels are copied and clear ones kept as they are
+		__m128i result = _mm_or_si128( _mm_and_si128( clear, d ), _mm_andnot_si128( clear, blended ) );
+		result = _mm_or_si128( _mm_and_si128( opaque, s ), _mm_andnot_si128( opaque, result ) );
+		_mm_storeu_si128( (__m128i *)dest, result );
+	}
+	scalar( dest, src, alphamap, alpha_flags, colour, (PIXVAL)(end - dest) );
+}
+#endif
+
+
 static void display_img_alpha_wc(scr_coord_val h, const scr_coord_val xp, const scr_coord_val yp, const PIXVAL *sp, const PIXVAL *alphamap, const uint8 alpha_flags, int colour, alpha_proc p  CLIP_NUM_DEF )
 {
 	if(  h > 0  ) {
@@ -3794,13 +4329,7 @@ void display_rezoomed_img_blend(const image_id n, scr_coord_val xp, scr_coord_va
 {
 	if(  n < anz_images  ) {
 		// need to go to nightmode and or rezoomed?
-		if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
-			rezoom_img( n );
-			recode_img( n, 0 );
-		}
-		else if(  (images[n].player_flags & 1)  ) {
-			recode_img( n, 0 );
-		}
+		prepare_img( n, 0  CLIP_NUM_PAR );
 		PIXVAL *sp = images[n].data[0];
 
 		// now, since zooming may have change this image
@@ -3875,16 +4404,11 @@ void display_rezoomed_img_alpha(const image_id n, const image_id alpha_n, const
 {
 	if(  n < anz_images  &&  alpha_n < anz_images  ) {
 		// need to go to nightmode and or rezoomed?
-		if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
-			rezoom_img( n );
-			recode_img( n, 0 );
-		}
-		else if(  (images[n].player_flags & 1)  ) {
-			recode_img( n, 0 );
-		}
+		prepare_img( n, 0  CLIP_NUM_PAR );
 		if(  (images[alpha_n].recode_flags & FLAG_REZOOM)  ) {
-			rezoom_img( alpha_n );
+			rezoom_img( alpha_n, CC );
 		}
+		images[alpha_n].last_used = cache_frame;
 		PIXVAL *sp = images[n].data[0];
 		// alphamap image uses base data as we don't want to recode
 		PIXVAL *alphamap = images[alpha_n].zoom_data != NULL ? images[alpha_n].zoom_data : images[alpha_n].base_data;
@@ -5483,6 +6007,8 @@ void display_flush_buffer()
 	uint32 *tmp = tile_dirty_old;
 	tile_dirty_old = tile_dirty;
 	tile_dirty = tmp; // _old was cleared to 0 in above loops
+
+	end_image_cache_frame();
 }
 
 
@@ -5595,16 +6121,27 @@ bool simgraph_init(scr_size window_size, bool full_screen)
 		if(c==31) {
 			// 15 bit per pixel
 			bitdepth = 15;
+#ifdef USE_SSE2
+			blend[0] = pix_blend_sse2<2, TWO_OUT_15, 1, pix_blend25_15>;
+			blend[1] = pix_blend_sse2<1, ONE_OUT_15, 1, pix_blend50_15>;
+			blend[2] = pix_blend_sse2<2, TWO_OUT_15, 3, pix_blend75_15>;
+			outline[0] = pix_outline_sse2<2, TWO_OUT_15, 1, pix_outline25_15>;
+			outline[1] = pix_outline_sse2<1, ONE_OUT_15, 1, pix_outline50_15>;
+			outline[2] = pix_outline_sse2<2, TWO_OUT_15, 3, pix_outline75_15>;
+			alpha = pix_alpha_sse2<10, 0x1f, pix_alpha_15>;
+#else
 			blend[0] = pix_blend25_15;
 			blend[1] = pix_blend50_15;
 			blend[2] = pix_blend75_15;
-			blend_recode[0] = pix_blend_recode25_15;
-			blend_recode[1] = pix_blend_recode50_15;
-			blend_recode[2] = pix_blend_recode75_15;
 			outline[0] = pix_outline25_15;
 			outline[1] = pix_outline50_15;
 			outline[2] = pix_outline75_15;
 			alpha = pix_alpha_15;
+#endif
+			// these look up each pixel in the colour map
+			blend_recode[0] = pix_blend_recode25_15;
+			blend_recode[1] = pix_blend_recode50_15;
+			blend_recode[2] = pix_blend_recode75_15;
 			alpha_recode = pix_alpha_recode_15;
 			recode_img_src_target = recode_img_src_target_15;
 #ifndef RGB555
@@ -5612,16 +6149,26 @@ bool simgraph_init(scr_size window_size, bool full_screen)
 #endif
 		}
 		else {
+#ifdef USE_SSE2
+			blend[0] = pix_blend_sse2<2, TWO_OUT_16, 1, pix_blend25_16>;
+			blend[1] = pix_blend_sse2<1, ONE_OUT_16, 1, pix_blend50_16>;
+			blend[2] = pix_blend_sse2<2, TWO_OUT_16, 3, pix_blend75_16>;
+			outline[0] = pix_outline_sse2<2, TWO_OUT_16, 1, pix_outline25_16>;
+			outline[1] = pix_outline_sse2<1, ONE_OUT_16, 1, pix_outline50_16>;
+			outline[2] = pix_outline_sse2<2, TWO_OUT_16, 3, pix_outline75_16>;
+			alpha = pix_alpha_sse2<11, 0x3f, pix_alpha_16>;
+#else
 			blend[0] = pix_blend25_16;
 			blend[1] = pix_blend50_16;
 			blend[2] = pix_blend75_16;
-			blend_recode[0] = pix_blend_recode25_16;
-			blend_recode[1] = pix_blend_recode50_16;
-			blend_recode[2] = pix_blend_recode75_16;
 			outline[0] = pix_outline25_16;
 			outline[1] = pix_outline50_16;
 			outline[2] = pix_outline75_16;
 			alpha = pix_alpha_16;
+#endif
+			blend_recode[0] = pix_blend_recode25_16;
+			blend_recode[1] = pix_blend_recode50_16;
+			blend_recode[2] = pix_blend_recode75_16;
 			alpha_recode = pix_alpha_recode_16;
 			recode_img_src_target = recode_img_src_target_16;
 #ifdef RGB555
@@ -5652,6 +6199,7 @@ void simgraph_exit()
 
 	free( tile_dirty_old );
 	free( tile_dirty );
+	free_static_layer();
 	display_free_all_images_above(0);
 	free(images);
 
@@ -5693,6 +6241,9 @@ void simgraph_resize(scr_size new_window_size)
 			tile_dirty = MALLOCN( uint32, tile_buffer_length );
 			tile_dirty_old = MALLOCN( uint32, tile_buffer_length );
 
+			// allocated again at the next frame of the main view
+			free_static_layer();
+
 			display_set_clip_wh(0, 0, disp_actual_width, disp_height);
 		}
 
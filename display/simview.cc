@@ -30,6 +30,10 @@ main_view_t::main_view_t(karte_t *welt)
 {
 	this->welt = welt;
 	outside_visible = true;
+	static_layer = false;
+	static_layer_state = static_layer_state_t();
+	static_layer_cursor = koord(-1000, -1000);
+	static_layer_water_stage = 0;
 	viewport = welt->get_viewport();
 	assert(welt  &&  viewport);
 }
@@ -126,6 +130,7 @@ void main_view_t::display(bool force_dirty)
 	// redraw everything?
 	force_dirty = force_dirty || welt->is_dirty();
 	welt->unset_dirty();
+	bool static_layer_dirty = force_dirty;
 	if(  force_dirty  ) {
 		mark_screen_dirty();
 		welt->set_background_dirty();
@@ -142,11 +147,12 @@ void main_view_t::display(bool force_dirty)
 
 	// change to night mode?
 	// images will be recalculated only, when there has been a change, so we set always
+	sint16 night;
 	if(grund_t::underground_mode == grund_t::ugm_all) {
-		display_day_night_shift(0);
+		night = 0;
 	}
 	else if(!env_t::night_shift) {
-		display_day_night_shift(env_t::daynight_level);
+		night = env_t::daynight_level;
 	}
 	else {
 		// calculate also days if desired
@@ -161,8 +167,9 @@ void main_view_t::display(bool force_dirty)
 		else {
 			hours2 = ( (ticks_this_month * 3) >> (welt->ticks_per_world_month_shift-4) )%48;
 		}
-		display_day_night_shift(hours2night[hours2]+env_t::daynight_level);
+		night = hours2night[hours2]+env_t::daynight_level;
 	}
+	display_day_night_shift(night);
 
 	// not very elegant, but works:
 	// fill everything with black for Underground mode ...
@@ -175,6 +182,8 @@ void main_view_t::display(bool force_dirty)
 		welt->unset_background_dirty();
 		// reset
 		outside_visible = false;
+		// the cache may hold parts of the old background
+		static_layer_dirty = true;
 	}
 	// to save calls to grund_t::get_disp_height
 	// gr->get_disp_height() == min(gr->get_hoehe(), hmax_ground)
@@ -202,6 +211,36 @@ void main_view_t::display(bool force_dirty)
 		viewport->prepared_rect = view_rect;
 	}
 
+	// the ground and ways are copied from the cache where they did not change
+	// (in underground mode the screen is cleared each frame anyway)
+	static_layer = env_t::static_layer_cache  &&  grund_t::underground_mode == grund_t::ugm_none;
+	if(  static_layer  ) {
+		static_layer_state_t state;
+		state.clip = clip_rr;
+		state.display = scr_size( disp_width, disp_real_height );
+		state.ij_off = koord( i_off, j_off );
+		state.x_off = const_x_off;
+		state.y_off = const_y_off;
+		state.tile_size = IMG_SIZE;
+		state.night = night;
+		state.threads = env_t::num_threads;
+		state.grid = grund_t::show_grid;
+		state.simple_drawing = env_t::simple_drawing;
+		state.earth_border = env_t::draw_earth_border;
+		state.outside_tile = env_t::draw_outside_tile;
+		if(  static_layer_dirty  ||  state != static_layer_state  ) {
+			display_static_layer_mark_all_dirty();
+			static_layer_state = state;
+		}
+		else {
+			mark_static_layer_dirty( clip_rr, y_min, dpy_height + 4 * 4 );
+		}
+	}
+	else {
+		// all is drawn again when it is used next
+		static_layer_state = static_layer_state_t();
+	}
+
 #ifdef MULTI_THREAD
 	if(  can_multithreading  ) {
 		if(  !spawned_threads  ) {
@@ -268,6 +307,11 @@ void main_view_t::display(bool force_dirty)
 	display_region(koord(clip_rr.x, clip_rr.y), koord(clip_rr.w, clip_rr.h), y_min, dpy_height + 4 * 4, false );
 #endif
 
+	if(  static_layer  ) {
+		// all threads have copied or stored their part of the cache
+		display_static_layer_validate( clip_rr );
+	}
+
 	// and finally overlays (station coverage and signs)
 	bool plotted = false; // display overlays even on very large mountains
 	for(sint16 y=y_min; y<dpy_height+4*4  ||  plotted; y++) {
@@ -385,6 +429,14 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 	const koord cursor_pos = welt->get_zeiger() ? welt->get_zeiger()->get_pos().get_2d() : koord(-1000, -1000);
 	const bool needs_hiding = !env_t::hide_trees  ||  (env_t::hide_buildings != env_t::ALL_HIDDEN_BUILDING);
 
+	// the ground is drawn only where it is not copied from the cache
+	const clip_dimension clip = display_get_clip_wh( CLIP_NUM_VAR );
+	scr_rect redraw( clip.x, clip.y, clip.w, clip.h );
+	if(  static_layer  ) {
+		redraw = display_static_layer_restore( redraw );
+		display_set_clip_wh( redraw.x, redraw.y, redraw.w, redraw.h  CLIP_NUM_PAR );
+	}
+
 	for(  int y = y_min;  y < y_max;  y++  ) {
 		const sint16 ypos = y * (IMG_SIZE / 4) + const_y_off;
 		// plotted = we plotted something
@@ -400,6 +452,7 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 				if(  grund_t* const kb = welt->lookup_kartenboden(pos)  ) {
 					const sint16 yypos = ypos - tile_raster_scale_y( min( kb->get_hoehe(), hmax_ground ) * TILE_HEIGHT_STEP, IMG_SIZE );
 					if(  yypos - IMG_SIZE < lt.y + wh.y  &&  yypos + IMG_SIZE > lt.y  ) {
+						const bool redraw_tile = !static_layer  ||  (redraw.h > 0  &&  yypos + IMG_SIZE > redraw.y  &&  get_boden_top( kb, ypos, IMG_SIZE, hmax_ground ) < redraw.get_bottom());
 #ifdef MULTI_THREAD
 						bool force_show_grid = false;
 						if(  env_t::hide_under_cursor  ) {
@@ -411,7 +464,9 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 								}
 							}
 						}
-						kb->display_if_visible( xpos, yypos, IMG_SIZE, clip_num, force_show_grid );
+						if(  redraw_tile  ) {
+							kb->display_if_visible( xpos, yypos, IMG_SIZE, clip_num, force_show_grid );
+						}
 #else
 						if(  env_t::hide_under_cursor  ) {
 							const bool saved_grid = grund_t::show_grid;
@@ -422,10 +477,12 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 									grund_t::show_grid = true;
 								}
 							}
-							kb->display_if_visible( xpos, yypos, IMG_SIZE );
+							if(  redraw_tile  ) {
+								kb->display_if_visible( xpos, yypos, IMG_SIZE );
+							}
 							grund_t::show_grid = saved_grid;
 						}
-						else {
+						else if(  redraw_tile  ) {
 							kb->display_if_visible( xpos, yypos, IMG_SIZE );
 						}
 #endif
@@ -461,6 +518,11 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 		}
 	}
 
+	if(  static_layer  ) {
+		display_static_layer_store( redraw );
+		display_set_clip_wh( clip.x, clip.y, clip.w, clip.h  CLIP_NUM_PAR );
+	}
+
 	// and then things (and other ground)
 	// especially necessary for vehicles
 	for(  int y = y_min;  y < y_max;  y++  ) {
@@ -589,6 +651,78 @@ void main_view_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y_max
 }
 
 
+sint16 main_view_t::get_boden_top( const grund_t *gr, const sint16 ypos, const sint16 raster_tile_width, const sint8 hmax_ground ) const
+{
+	// walls and slopes reach up to the height of the tiles behind
+	sint8 h_top = gr->get_hoehe();
+	for(  int i = 0;  i < 2;  i++  ) {
+		if(  const grund_t *back = welt->lookup_kartenboden( gr->get_pos().get_2d() + koord::nesw[(i + 3) & 3] )  ) {
+			h_top = max( h_top, back->get_hoehe() );
+		}
+	}
+	return ypos - tile_raster_scale_y( (min( h_top, hmax_ground ) + 2) * TILE_HEIGHT_STEP, raster_tile_width );
+}
+
+
+bool main_view_t::static_layer_state_t::operator ==(const static_layer_state_t &other) const
+{
+	return tile_size == other.tile_size  &&  clip == other.clip  &&  display == other.display  &&  ij_off == other.ij_off
+		&&  x_off == other.x_off  &&  y_off == other.y_off  &&  night == other.night  &&  threads == other.threads
+		&&  grid == other.grid  &&  simple_drawing == other.simple_drawing
+		&&  earth_border == other.earth_border  &&  outside_tile == other.outside_tile;
+}
+
+
+void main_view_t::mark_static_layer_dirty( const scr_rect &clip_rr, const sint16 y_min, const sint16 y_max )
+{
+	const sint16 IMG_SIZE = get_tile_raster_width();
+
+	const int i_off = viewport->get_world_position().x + viewport->get_viewport_ij_offset().x;
+	const int j_off = viewport->get_world_position().y + viewport->get_viewport_ij_offset().y;
+	const int const_x_off = viewport->get_x_off();
+	const int const_y_off = viewport->get_y_off();
+
+	const int dpy_width = display_get_width() / IMG_SIZE + 2;
+
+	const sint8 hmax_ground = (grund_t::underground_mode == grund_t::ugm_level) ? grund_t::underground_level : 127;
+
+	// tiles near the cursor are drawn again each frame, see display_region(), and once more after it moved away
+	const koord cursor_pos = welt->get_zeiger() ? welt->get_zeiger()->get_pos().get_2d() : koord(-1000, -1000);
+	const uint32 cursor_range = env_t::hide_under_cursor ? env_t::cursor_hide_range + 2u : 0;
+	const bool water_changed = wasser_t::stage != static_layer_water_stage;
+
+	bool plotted = false;
+	for(  int y = y_min;  y < y_max  ||  plotted;  y++  ) {
+		const sint16 ypos = y * (IMG_SIZE / 4) + const_y_off;
+		plotted = false;
+
+		for(  sint16 x = -2 - ((y + dpy_width) & 1);  (x * (IMG_SIZE / 2) + const_x_off) < clip_rr.get_right();  x += 2  ) {
+			const sint16 xpos = x * (IMG_SIZE / 2) + const_x_off;
+
+			if(  xpos + IMG_SIZE > clip_rr.x  ) {
+				const koord pos( ((y + x) >> 1) + i_off, ((y - x) >> 1) + j_off );
+				const planquadrat_t *plan = welt->access(pos);
+				if(  plan  &&  plan->get_kartenboden()  ) {
+					const grund_t *gr = plan->get_kartenboden();
+					const sint16 yypos = ypos - tile_raster_scale_y( min( gr->get_hoehe(), hmax_ground ) * TILE_HEIGHT_STEP, IMG_SIZE );
+					if(  yypos - IMG_SIZE < clip_rr.get_bottom()  &&  yypos + IMG_SIZE > clip_rr.y  ) {
+						plotted = true;
+						if(  gr->is_boden_dirty()
+							||  (water_changed  &&  (gr->is_water()  ||  plan->get_climate_corners() != 0))
+							||  (cursor_range > 0  &&  (shortest_distance( pos, cursor_pos ) <= cursor_range  ||  shortest_distance( pos, static_layer_cursor ) <= cursor_range))  ) {
+							display_static_layer_mark_dirty( xpos, get_boden_top( gr, ypos, IMG_SIZE, hmax_ground ), xpos + IMG_SIZE - 1, yypos + IMG_SIZE - 1 );
+						}
+					}
+				}
+			}
+		}
+	}
+
+	static_layer_cursor = cursor_pos;
+	static_layer_water_stage = wasser_t::stage;
+}
+
+
 void main_view_t::display_background( scr_coord_val xp, scr_coord_val yp, scr_coord_val w, scr_coord_val h, bool dirty )
 {
 	if(  !(env_t::draw_earth_border  &&  env_t::draw_outside_tile)  ) {
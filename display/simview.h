@@ -10,6 +10,7 @@
 #include "simgraph.h"
 
 
+class grund_t;
 class karte_t;
 class viewport_t;
 
@@ -29,6 +30,42 @@ private:
 	/// Cached value from last display run to determine if the background was visible, we'll save redraws if it was not.
 	bool outside_visible;
 
+	/// Whether display_region() takes the ground and ways from the cache of this frame, see env_t::static_layer_cache.
+	bool static_layer;
+
+	/// What the cached ground and ways were drawn with, all of them are drawn again if any of it changes.
+	struct static_layer_state_t
+	{
+		scr_rect clip;
+		scr_size display;
+		koord ij_off;
+		sint32 x_off, y_off;
+		sint16 tile_size;
+		sint16 night;
+		sint16 threads;
+		bool grid;
+		bool simple_drawing;
+		bool earth_border;
+		bool outside_tile;
+
+		bool operator ==(const static_layer_state_t &other) const;
+		bool operator !=(const static_layer_state_t &other) const { return !(*this == other); }
+	};
+	static_layer_state_t static_layer_state;
+
+	/// Cursor position and stage of the water animation when the cache was last updated
+	koord static_layer_cursor;
+	int static_layer_water_stage;
+
+	/**
+	 * Marks the cached ground and ways of all tiles changed since the last frame to be drawn again.
+	 * Loops over the same tiles as the first pass of display_region().
+	 */
+	void mark_static_layer_dirty( const scr_rect &clip_rr, const sint16 y_min, const sint16 y_max );
+
+	/// @returns the topmost screen row display_boden() of @p gr may draw to, if its tile row is at @p ypos
+	sint16 get_boden_top( const grund_t *gr, const sint16 ypos, const sint16 raster_tile_width, const sint8 hmax_ground ) const;
+
 public:
 	main_view_t(karte_t *welt);
 
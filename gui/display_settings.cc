@@ -12,6 +12,8 @@
 #include "../dataobj/settings.h"
 #include "../dataobj/environment.h"
 #include "../dataobj/translator.h"
+#include "../dataobj/route.h"
+#include "../dataobj/route_cache.h"
 #include "../obj/baum.h"
 #include "../obj/zeiger.h"
 #include "../display/simgraph.h"
@@ -22,6 +24,7 @@
 #include "gui_theme.h"
 #include "themeselector.h"
 #include "loadfont_frame.h"
+#include "step_profiler_frame.h"
 #include "simwin.h"
 
 #include "../path_explorer.h"
@@ -53,6 +56,7 @@ enum {
 	IDBTN_LEFT_TO_RIGHT_GRAPHS,
 	IDBTN_SHOW_SIGNALBOX_COVERAGE,
 	IDBTN_CLASSES_WAITING_BAR,
+	IDBTN_SHOW_STEP_PROFILER,
 	COLORS_MAX_BUTTONS,
 };
 
@@ -197,6 +201,12 @@ gui_settings_t::gui_settings_t()
 		status_label.update();
 		add_component(&status_label);
 
+		new_component<gui_label_t>("Path explorer memory:");
+		path_memory_label.buf().printf("-");
+		path_memory_label.set_color(SYSCOL_TEXT_TITLE);
+		path_memory_label.update();
+		add_component(&path_memory_label);
+
 		// Private cars hereafter
 
 		new_component<gui_label_t>("Private car routes reading index:");
@@ -216,8 +226,30 @@ gui_settings_t::gui_settings_t()
 		cities_to_process_label.set_color(SYSCOL_TEXT_TITLE);
 		cities_to_process_label.update();
 		add_component(&cities_to_process_label);
+
+		new_component<gui_label_t>("Nodes per route search (from start / both ends):");
+		route_search_nodes_label.buf().printf("-");
+		route_search_nodes_label.set_color(SYSCOL_TEXT_TITLE);
+		route_search_nodes_label.update();
+		add_component(&route_search_nodes_label);
+
+		new_component<gui_label_t>("Convoy route cache (hits / misses):");
+		route_cache_label.buf().printf("-");
+		route_cache_label.set_color(SYSCOL_TEXT_TITLE);
+		route_cache_label.update();
+		add_component(&route_cache_label);
+
+		new_component<gui_label_t>("Image cache (hits / misses / evictions):");
+		image_cache_label.buf().printf("-");
+		image_cache_label.set_color(SYSCOL_TEXT_TITLE);
+		image_cache_label.update();
+		add_component(&image_cache_label);
 	}
 	end_table();
+
+	// Show the times of the phases of the world steps
+	buttons[ IDBTN_SHOW_STEP_PROFILER ].init( button_t::roundbox_state | button_t::flexible, "Show step profiler" );
+	add_component( buttons + IDBTN_SHOW_STEP_PROFILER );
 }
 
 void gui_settings_t::draw(scr_coord offset)
@@ -278,6 +310,9 @@ void gui_settings_t::draw(scr_coord offset)
 	reroute_goods_label.buf().printf("%lu", path_explorer_t::get_limit_reroute_goods());
 	reroute_goods_label.update();
 
+	path_memory_label.buf().printf("%.1f MiB", path_explorer_t::get_total_memory_usage() / (1024.0 * 1024.0));
+	path_memory_label.update();
+
 	reading_index_label.buf().printf("%lu", weg_t::private_car_routes_currently_reading_element);
 	reading_index_label.update();
 
@@ -287,6 +322,17 @@ void gui_settings_t::draw(scr_coord offset)
 	cities_to_process_label.buf().printf("%i", world()->get_cities_to_process());
 	cities_to_process_label.update();
 
+	route_search_nodes_label.buf().printf("%u / %u", route_t::get_average_expanded_nodes(route_t::search_forward), route_t::get_average_expanded_nodes(route_t::search_bidirectional));
+	route_search_nodes_label.update();
+
+	route_cache_label.buf().printf("%u / %u", route_cache_t::get_hits(), route_cache_t::get_misses());
+	route_cache_label.update();
+
+	image_cache_stats_t image_cache_stats;
+	display_get_image_cache_stats(image_cache_stats);
+	image_cache_label.buf().printf("%llu / %llu / %llu, %.1f MiB", (unsigned long long)image_cache_stats.hits, (unsigned long long)image_cache_stats.misses, (unsigned long long)image_cache_stats.evictions, image_cache_stats.bytes / (1024.0 * 1024.0));
+	image_cache_label.update();
+
 	// All components are updated, now draw them...
 	gui_aligned_container_t::draw(offset);
 }
@@ -858,6 +904,9 @@ bool color_gui_t::action_triggered( gui_action_creator_t *comp, value_t )
 	case IDBTN_CHANGE_FONT:
 		create_win( new loadfont_frame_t(), w_info, magic_font );
 		break;
+	case IDBTN_SHOW_STEP_PROFILER:
+		create_win( new step_profiler_frame_t(), w_info, magic_step_profiler );
+		break;
 	case IDBTN_LEFT_TO_RIGHT_GRAPHS:
 		env_t::left_to_right_graphs = !env_t::left_to_right_graphs;
 		buttons[IDBTN_LEFT_TO_RIGHT_GRAPHS].pressed ^= 1;
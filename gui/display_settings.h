@@ -34,10 +34,15 @@ private:
 		explore_path_label,
 		reroute_goods_label,
 		status_label,
+		path_memory_label,
 
 		reading_index_label,
 		cities_awaiting_private_car_route_check_label,
-		cities_to_process_label;
+		cities_to_process_label,
+
+		route_search_nodes_label,
+		route_cache_label,
+		image_cache_label;
 
 public:
 	button_t toolbar_pos[4];
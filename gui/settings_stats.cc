@@ -124,7 +124,12 @@ static const char *revision_ex[] =
 	"39",
 	"40",
 	"41",
-	"42"
+	"42",
+	"43",
+	"44",
+	"45",
+	"46",
+	"47"
 };
 
 
@@ -232,6 +237,11 @@ void settings_extended_general_stats_t::init( settings_t *sets )
 
 	INIT_NUM("path_explorer_time_midpoint", sets->get_path_explorer_time_midpoint(), 1, 2048, gui_numberinput_t::PLAIN, false);
 	INIT_BOOL("save_path_explorer_data", sets->get_save_path_explorer_data());
+	INIT_NUM("path_explorer_max_incremental_changes", sets->get_path_explorer_max_incremental_changes(), 0, 65535, gui_numberinput_t::PLAIN, false);
+	INIT_NUM("bidirectional_route_search_min_distance", sets->get_bidirectional_route_search_min_distance(), 0, 65535, gui_numberinput_t::PLAIN, false);
+	INIT_NUM("route_landmarks_min_map_size", sets->get_route_landmarks_min_map_size(), 0, 65535, gui_numberinput_t::PLAIN, false);
+	INIT_NUM("halt_steps_per_thread", sets->get_halt_steps_per_thread(), 1, 65535, gui_numberinput_t::PLAIN, false);
+	INIT_NUM("monthly_update_steps", sets->get_monthly_update_steps(), 0, 65535, gui_numberinput_t::PLAIN, false);
 
 	SEPERATOR;
 
@@ -352,6 +362,11 @@ void settings_extended_general_stats_t::read(settings_t *sets)
 
 	READ_NUM_VALUE(sets->path_explorer_time_midpoint);
 	READ_BOOL_VALUE(sets->save_path_explorer_data);
+	READ_NUM_VALUE(sets->path_explorer_max_incremental_changes);
+	READ_NUM_VALUE(sets->bidirectional_route_search_min_distance);
+	READ_NUM_VALUE(sets->route_landmarks_min_map_size);
+	READ_NUM_VALUE(sets->halt_steps_per_thread);
+	READ_NUM_VALUE(sets->monthly_update_steps);
 
 	READ_BOOL_VALUE(env_t::pause_server_no_clients);
 	READ_BOOL_VALUE(env_t::server_runs_background_tasks_when_paused);
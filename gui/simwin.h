@@ -126,6 +126,7 @@ enum magic_numbers {
 	magic_depotlist           = magic_line_class_manager  + 843,
 	magic_vehiclelist         = magic_depotlist           + MAX_PLAYER_COUNT,
 	magic_signalboxlist,
+	magic_step_profiler,
 	magic_max
 };
 
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include "step_profiler_frame.h"
+
+#include "../dataobj/translator.h"
+
+
+step_profiler_frame_t::step_profiler_frame_t() :
+	gui_frame_t( translator::translate("Step profiler") )
+{
+	step_profiler_t::set_shown(true);
+
+	set_table_layout(4, 0);
+
+	new_component<gui_label_t>("Phase");
+	new_component<gui_label_t>("Last ms", SYSCOL_TEXT, gui_label_t::right);
+	new_component<gui_label_t>("Average ms", SYSCOL_TEXT, gui_label_t::right);
+	new_component<gui_label_t>("Max ms", SYSCOL_TEXT, gui_label_t::right);
+
+	for(  uint8 phase = 0;  phase < step_profiler_t::MAX_PHASES;  phase++  ) {
+		// indent the sub-phases below their phase
+		uint8 depth = 0;
+		for(  uint8 parent = step_profiler_t::get_parent(phase);  parent != step_profiler_t::MAX_PHASES;  parent = step_profiler_t::get_parent(parent)  ) {
+			depth++;
+		}
+		add_table(2, 1);
+		{
+			new_component<gui_margin_t>(depth * D_H_SPACE * 2);
+			new_component<gui_label_t>(step_profiler_t::get_name(phase));
+		}
+		end_table();
+
+		gui_label_buf_t *labels[3] = { last_labels + phase, average_labels + phase, max_labels + phase };
+		for(  uint8 i = 0;  i < 3;  i++  ) {
+			labels[i]->init(SYSCOL_TEXT, gui_label_t::right);
+			labels[i]->buf().printf("9999.999");
+			labels[i]->update();
+			add_component(labels[i]);
+		}
+	}
+
+	reset_min_windowsize();
+	set_windowsize(get_min_windowsize());
+}
+
+
+step_profiler_frame_t::~step_profiler_frame_t()
+{
+	step_profiler_t::set_shown(false);
+}
+
+
+void step_profiler_frame_t::draw(scr_coord pos, scr_size size)
+{
+	for(  uint8 phase = 0;  phase < step_profiler_t::MAX_PHASES;  phase++  ) {
+		last_labels[phase].buf().printf("%.3f", step_profiler_t::get_last_ms(phase));
+		last_labels[phase].update();
+		average_labels[phase].buf().printf("%.3f", step_profiler_t::get_average_ms(phase));
+		average_labels[phase].update();
+		max_labels[phase].buf().printf("%.3f", step_profiler_t::get_max_ms(phase));
+		max_labels[phase].update();
+	}
+
+	gui_frame_t::draw(pos, size);
+}
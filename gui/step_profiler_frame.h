@@ -0,0 +1,32 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef GUI_STEP_PROFILER_FRAME_H
+#define GUI_STEP_PROFILER_FRAME_H
+
+
+#include "gui_frame.h"
+#include "components/gui_label.h"
+#include "../utils/step_profiler.h"
+
+
+/**
+ * Shows how long the phases of the world steps took, in the latest step
+ * and on average and at most over the last steps.
+ */
+class step_profiler_frame_t : public gui_frame_t
+{
+	gui_label_buf_t last_labels[step_profiler_t::MAX_PHASES];
+	gui_label_buf_t average_labels[step_profiler_t::MAX_PHASES];
+	gui_label_buf_t max_labels[step_profiler_t::MAX_PHASES];
+
+public:
+	step_profiler_frame_t();
+	~step_profiler_frame_t();
+
+	void draw(scr_coord pos, scr_size size) OVERRIDE;
+};
+
+#endif
@@ -0,0 +1,566 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include "chunked_zlib_file_rdwr_stream.h"
+
+#include "../../macros.h"
+#include "../../simdebug.h"
+#include "../../tpl/vector_tpl.h"
+#include "../../utils/job_scheduler.h"
+
+#ifdef MULTI_THREAD
+#include "../../utils/simthread.h"
+#endif
+
+#include <cassert>
+#include <cstring>
+#include <zlib.h>
+
+
+#define CHUNK_SIZE (1 << 20) // 1MiB of uncompressed data
+
+// gzip header with an extra field 'SC' of 8 bytes: size of the member, size of the uncompressed data
+#define MEMBER_HEADER_SIZE 24
+#define MEMBER_TRAILER_SIZE 8
+#define MEMBER_CAPACITY (MEMBER_HEADER_SIZE + compressBound(CHUNK_SIZE) + MEMBER_TRAILER_SIZE)
+
+static const uint8 member_header[MEMBER_HEADER_SIZE - 8] = {
+	0x1F, 0x8B,             // magic
+	8,                      // deflate
+	4,                      // flags: extra field present
+	0, 0, 0, 0,             // no modification time
+	0,                      // extra flags
+	255,                    // unknown operating system
+	12, 0,                  // size of the extra field
+	'S', 'C', 8, 0          // subfield id and size
+};
+
+
+struct chunk_t
+{
+	uint8 *data;
+	uint32 len;
+
+	// the compressed gzip member
+	uint8 *member;
+	uint32 member_len;
+};
+
+
+struct chunked_zlib_file_rdwr_stream_t::batch_t
+{
+	vector_tpl<chunk_t> chunks;
+
+	// chunks completely filled, or read from the file
+	uint32 filled;
+	int level;
+	bool busy;
+
+	void (*function)(batch_t &batch, uint32 chunk);
+
+	// while busy: the next chunk to hand out, and the chunks not yet (de)compressed
+	uint32 next;
+	uint32 unfinished;
+
+	batch_t(uint32 chunk_count, int level, void (*function)(batch_t &, uint32));
+	~batch_t();
+};
+
+
+#ifdef MULTI_THREAD
+struct chunked_zlib_file_rdwr_stream_t::workers_t
+{
+	vector_tpl<pthread_t> threads;
+
+	// guards everything below and the handing out of the chunks of the batches
+	pthread_mutex_t mutex;
+	pthread_cond_t chunks_started;
+	pthread_cond_t chunks_finished;
+
+	// the batches with chunks not yet handed out
+	vector_tpl<batch_t *> started;
+	bool stopping;
+};
+#endif
+
+
+static void set_le32(uint8 *p, uint32 v)
+{
+	p[0] = (uint8)v;
+	p[1] = (uint8)(v >> 8);
+	p[2] = (uint8)(v >> 16);
+	p[3] = (uint8)(v >> 24);
+}
+
+
+static uint32 get_le32(const uint8 *p)
+{
+	return (uint32)p[0] | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+
+/**
+ * Checks that @p header is the header of a member with a chunk index.
+ * @returns the size of the member and of its data
+ */
+static bool parse_member_header(const uint8 *header, uint32 &member_len, uint32 &len)
+{
+	if(  memcmp(header, member_header, 4) != 0  ||  memcmp(header + 10, member_header + 10, sizeof(member_header) - 10) != 0  ) {
+		return false;
+	}
+	member_len = get_le32(header + MEMBER_HEADER_SIZE - 8);
+	len = get_le32(header + MEMBER_HEADER_SIZE - 4);
+	return member_len >= MEMBER_HEADER_SIZE + MEMBER_TRAILER_SIZE  &&  member_len <= MEMBER_CAPACITY  &&  len <= CHUNK_SIZE;
+}
+
+
+/**
+ * Makes a complete gzip member of @p len bytes at @p data into @p member of @p capacity bytes.
+ * @returns the size of the member, or 0 on error
+ */
+static uint32 compress_member(const uint8 *data, uint32 len, int level, uint8 *member, uint32 capacity)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	// negative window bits: raw deflate data, header and trailer are added below
+	if(  deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK  ) {
+		return 0;
+	}
+	zs.next_in = const_cast<Bytef *>(data);
+	zs.avail_in = len;
+	zs.next_out = member + MEMBER_HEADER_SIZE;
+	zs.avail_out = capacity - MEMBER_HEADER_SIZE - MEMBER_TRAILER_SIZE;
+	const int ret = deflate(&zs, Z_FINISH);
+	const uint32 deflated = (uint32)zs.total_out;
+	deflateEnd(&zs);
+	if(  ret != Z_STREAM_END  ) {
+		return 0;
+	}
+
+	const uint32 member_len = MEMBER_HEADER_SIZE + deflated + MEMBER_TRAILER_SIZE;
+	memcpy(member, member_header, sizeof(member_header));
+	set_le32(member + MEMBER_HEADER_SIZE - 8, member_len);
+	set_le32(member + MEMBER_HEADER_SIZE - 4, len);
+
+	uint8 *trailer = member + MEMBER_HEADER_SIZE + deflated;
+	set_le32(trailer, (uint32)crc32(crc32(0, Z_NULL, 0), data, len));
+	set_le32(trailer + 4, len);
+	return member_len;
+}
+
+
+void chunked_zlib_file_rdwr_stream_t::compress_chunk(batch_t &batch, uint32 number)
+{
+	chunk_t &chunk = batch.chunks[number];
+	if(  chunk.member == NULL  ) {
+		chunk.member = new uint8[MEMBER_CAPACITY];
+	}
+	chunk.member_len = compress_member(chunk.data, chunk.len, batch.level, chunk.member, MEMBER_CAPACITY);
+}
+
+
+void chunked_zlib_file_rdwr_stream_t::decompress_chunk(batch_t &batch, uint32 number)
+{
+	chunk_t &chunk = batch.chunks[number];
+
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if(  inflateInit2(&zs, -MAX_WBITS) != Z_OK  ) {
+		chunk.member_len = 0;
+		return;
+	}
+	zs.next_in = chunk.member + MEMBER_HEADER_SIZE;
+	zs.avail_in = chunk.member_len - MEMBER_HEADER_SIZE - MEMBER_TRAILER_SIZE;
+	zs.next_out = chunk.data;
+	zs.avail_out = chunk.len;
+	const int ret = inflate(&zs, Z_FINISH);
+	const uint32 inflated = (uint32)zs.total_out;
+	inflateEnd(&zs);
+
+	const uint8 *trailer = chunk.member + chunk.member_len - MEMBER_TRAILER_SIZE;
+	if(  ret != Z_STREAM_END  ||  inflated != chunk.len  ||  get_le32(trailer + 4) != chunk.len  ||
+	     get_le32(trailer) != (uint32)crc32(crc32(0, Z_NULL, 0), chunk.data, chunk.len)  ) {
+		// marks the chunk as corrupt
+		chunk.member_len = 0;
+	}
+}
+
+
+chunked_zlib_file_rdwr_stream_t::batch_t::batch_t(uint32 chunk_count, int level, void (*function)(batch_t &, uint32)) :
+	chunks(chunk_count),
+	filled(0),
+	level(level),
+	busy(false),
+	function(function),
+	next(0),
+	unfinished(0)
+{
+	for(  uint32 i = 0;  i < chunk_count;  i++  ) {
+		chunk_t chunk;
+		chunk.data = new uint8[CHUNK_SIZE];
+		chunk.len = 0;
+		chunk.member = NULL;
+		chunk.member_len = 0;
+		chunks.append(chunk);
+	}
+}
+
+
+chunked_zlib_file_rdwr_stream_t::batch_t::~batch_t()
+{
+	FOR(vector_tpl<chunk_t>, const &chunk, chunks) {
+		delete [] chunk.data;
+		delete [] chunk.member;
+	}
+}
+
+
+#ifdef MULTI_THREAD
+void *chunked_zlib_file_rdwr_stream_t::worker_thread(void *args)
+{
+	workers_t &workers = *static_cast<workers_t *>(args);
+
+	pthread_mutex_lock(&workers.mutex);
+	while(  true  ) {
+		batch_t *batch;
+		uint32 chunk;
+		if(  take_chunk(workers, NULL, batch, chunk)  ) {
+			pthread_mutex_unlock(&workers.mutex);
+			(*batch->function)(*batch, chunk);
+			pthread_mutex_lock(&workers.mutex);
+			if(  --batch->unfinished == 0  ) {
+				pthread_cond_broadcast(&workers.chunks_finished);
+			}
+		}
+		else if(  workers.stopping  ) {
+			break;
+		}
+		else {
+			pthread_cond_wait(&workers.chunks_started, &workers.mutex);
+		}
+	}
+	pthread_mutex_unlock(&workers.mutex);
+	return NULL;
+}
+
+
+bool chunked_zlib_file_rdwr_stream_t::take_chunk(workers_t &workers, batch_t *only, batch_t *&batch, uint32 &chunk)
+{
+	for(  uint32 i = 0;  i < workers.started.get_count();  i++  ) {
+		batch_t *started = workers.started[i];
+		if(  only  &&  started != only  ) {
+			continue;
+		}
+		batch = started;
+		chunk = batch->next++;
+		if(  batch->next == batch->filled  ) {
+			workers.started.remove_at(i);
+		}
+		return true;
+	}
+	return false;
+}
+#endif
+
+
+chunked_zlib_file_rdwr_stream_t::chunked_zlib_file_rdwr_stream_t(const std::string &filename, bool writing, int compression) :
+	raw_file_rdwr_stream_t(filename, writing),
+	current(0),
+	workers(NULL),
+	read_chunk(0),
+	read_pos(0),
+	last_member_read(false)
+{
+	// as many workers as the job scheduler, so none in the copy of the process which makes a background save
+	const uint32 worker_count = job_scheduler_t::get_worker_count();
+
+	// a chunk for each worker and for the thread waiting for them
+	const uint32 chunk_count = worker_count + 1;
+	compression = clamp(compression, 1, 9);
+	void (*function)(batch_t &, uint32) = writing ? &compress_chunk : &decompress_chunk;
+	batches[0] = new batch_t(chunk_count, compression, function);
+	batches[1] = new batch_t(chunk_count, compression, function);
+
+#ifdef MULTI_THREAD
+	if(  worker_count > 0  ) {
+		workers = new workers_t;
+		pthread_mutex_init(&workers->mutex, NULL);
+		pthread_cond_init(&workers->chunks_started, NULL);
+		pthread_cond_init(&workers->chunks_finished, NULL);
+		workers->stopping = false;
+		for(  uint32 i = 0;  i < worker_count;  i++  ) {
+			pthread_t thread;
+			const int rc = pthread_create(&thread, NULL, &worker_thread, workers);
+			if(  rc  ) {
+				// the thread waiting for the chunks (de)compresses those left over
+				dbg->warning("chunked_zlib_file_rdwr_stream_t", "Failed to create worker thread, error %d", rc);
+				break;
+			}
+			workers->threads.append(thread);
+		}
+	}
+#endif
+
+	if(  !writing  &&  status == STATUS_OK  ) {
+		read_batch(*batches[0]);
+		read_batch(*batches[1]);
+	}
+}
+
+
+chunked_zlib_file_rdwr_stream_t::~chunked_zlib_file_rdwr_stream_t()
+{
+	if(  !is_writing()  ) {
+		await_batch(*batches[0]);
+		await_batch(*batches[1]);
+	}
+	else {
+		batch_t &batch = *batches[current];
+		if(  batch.filled < batch.chunks.get_count()  &&  batch.chunks[batch.filled].len > 0  ) {
+			batch.filled++;
+		}
+		// compresses the last chunks, and writes those before them
+		switch_batches();
+		finish_batch(*batches[current ^ 1]);
+
+		if(  status == STATUS_OK  ) {
+			// the empty member marking the end of the file
+			uint8 member[64];
+			const uint8 no_data = 0;
+			const uint32 member_len = compress_member(&no_data, 0, 1, member, sizeof(member));
+			raw_file_rdwr_stream_t::write(member, member_len);
+		}
+	}
+
+#ifdef MULTI_THREAD
+	if(  workers  ) {
+		pthread_mutex_lock(&workers->mutex);
+		workers->stopping = true;
+		pthread_cond_broadcast(&workers->chunks_started);
+		pthread_mutex_unlock(&workers->mutex);
+
+		FOR(vector_tpl<pthread_t>, thread, workers->threads) {
+			pthread_join(thread, NULL);
+		}
+		pthread_cond_destroy(&workers->chunks_finished);
+		pthread_cond_destroy(&workers->chunks_started);
+		pthread_mutex_destroy(&workers->mutex);
+		delete workers;
+	}
+#endif
+
+	delete batches[0];
+	delete batches[1];
+}
+
+
+bool chunked_zlib_file_rdwr_stream_t::is_chunked_file(const std::string &filename)
+{
+	raw_file_rdwr_stream_t file(filename, false);
+	uint8 header[MEMBER_HEADER_SIZE];
+	uint32 member_len, len;
+	return file.get_status() == STATUS_OK  &&  file.read(header, MEMBER_HEADER_SIZE) == MEMBER_HEADER_SIZE  &&  parse_member_header(header, member_len, len);
+}
+
+
+size_t chunked_zlib_file_rdwr_stream_t::read(void *buf, size_t len)
+{
+	assert(!is_writing());
+	uint8 *dst = static_cast<uint8 *>(buf);
+	size_t left = len;
+
+	while(  left > 0  &&  status == STATUS_OK  ) {
+		batch_t &batch = *batches[current];
+		await_batch(batch);
+		if(  read_chunk == batch.filled  ) {
+			// nothing more was in the file
+			status = STATUS_EOF;
+			break;
+		}
+
+		const chunk_t &chunk = batch.chunks[read_chunk];
+		if(  chunk.member_len == 0  ) {
+			dbg->error("chunked_zlib_file_rdwr_stream_t::read", "Error during decompression");
+			status = STATUS_ERR_CORRUPT;
+			return 0;
+		}
+		const size_t available = chunk.len - read_pos;
+		const size_t n = left < available ? left : available;
+		memcpy(dst, chunk.data + read_pos, n);
+		read_pos += (uint32)n;
+		dst += n;
+		left -= n;
+
+		if(  read_pos == chunk.len  ) {
+			read_pos = 0;
+			read_chunk++;
+			if(  read_chunk == batch.filled  ) {
+				// refill this batch while the other one is read
+				read_batch(batch);
+				current ^= 1;
+				read_chunk = 0;
+			}
+		}
+	}
+
+	return len - left;
+}
+
+
+void chunked_zlib_file_rdwr_stream_t::read_batch(batch_t &batch)
+{
+	batch.filled = 0;
+	while(  !last_member_read  &&  batch.filled < batch.chunks.get_count()  ) {
+		chunk_t &chunk = batch.chunks[batch.filled];
+		if(  chunk.member == NULL  ) {
+			chunk.member = new uint8[MEMBER_CAPACITY];
+		}
+
+		const size_t header_read = raw_file_rdwr_stream_t::read(chunk.member, MEMBER_HEADER_SIZE);
+		if(  header_read == 0  &&  status == STATUS_EOF  ) {
+			// a file without the empty member at its end
+			status = STATUS_OK;
+			last_member_read = true;
+			break;
+		}
+		if(  header_read != MEMBER_HEADER_SIZE  ||  !parse_member_header(chunk.member, chunk.member_len, chunk.len)  ) {
+			dbg->error("chunked_zlib_file_rdwr_stream_t::read_batch", "Missing chunk index");
+			status = STATUS_ERR_CORRUPT;
+			break;
+		}
+		const uint32 rest = chunk.member_len - MEMBER_HEADER_SIZE;
+		if(  raw_file_rdwr_stream_t::read(chunk.member + MEMBER_HEADER_SIZE, rest) != rest  ) {
+			dbg->error("chunked_zlib_file_rdwr_stream_t::read_batch", "Truncated chunk");
+			status = STATUS_ERR_CORRUPT;
+			break;
+		}
+
+		if(  chunk.len == 0  ) {
+			// the empty member at the end
+			last_member_read = true;
+			break;
+		}
+		batch.filled++;
+	}
+
+	start_batch(batch);
+}
+
+
+size_t chunked_zlib_file_rdwr_stream_t::write(const void *buf, size_t len)
+{
+	assert(is_writing());
+	const uint8 *src = static_cast<const uint8 *>(buf);
+	size_t left = len;
+
+	while(  left > 0  &&  status == STATUS_OK  ) {
+		batch_t &batch = *batches[current];
+		chunk_t &chunk = batch.chunks[batch.filled];
+		const size_t room = CHUNK_SIZE - chunk.len;
+		const size_t n = left < room ? left : room;
+		memcpy(chunk.data + chunk.len, src, n);
+		chunk.len += (uint32)n;
+		src += n;
+		left -= n;
+
+		if(  chunk.len == CHUNK_SIZE  ) {
+			batch.filled++;
+			if(  batch.filled == batch.chunks.get_count()  ) {
+				switch_batches();
+			}
+		}
+	}
+
+	return status == STATUS_OK ? len : 0;
+}
+
+
+void chunked_zlib_file_rdwr_stream_t::start_batch(batch_t &batch)
+{
+	batch.busy = true;
+	batch.next = 0;
+	batch.unfinished = batch.filled;
+
+#ifdef MULTI_THREAD
+	if(  workers  ) {
+		if(  batch.filled > 0  ) {
+			pthread_mutex_lock(&workers->mutex);
+			workers->started.append(&batch);
+			pthread_cond_broadcast(&workers->chunks_started);
+			pthread_mutex_unlock(&workers->mutex);
+		}
+		return;
+	}
+#endif
+
+	for(  uint32 i = 0;  i < batch.filled;  i++  ) {
+		(*batch.function)(batch, i);
+	}
+	batch.next = batch.filled;
+	batch.unfinished = 0;
+}
+
+
+void chunked_zlib_file_rdwr_stream_t::switch_batches()
+{
+	start_batch(*batches[current]);
+
+	current ^= 1;
+	finish_batch(*batches[current]);
+}
+
+
+void chunked_zlib_file_rdwr_stream_t::await_batch(batch_t &batch)
+{
+	if(  !batch.busy  ) {
+		return;
+	}
+
+#ifdef MULTI_THREAD
+	if(  workers  ) {
+		pthread_mutex_lock(&workers->mutex);
+		while(  batch.unfinished > 0  ) {
+			// the waiting thread helps with the chunks not yet handed out
+			batch_t *taken;
+			uint32 chunk;
+			if(  take_chunk(*workers, &batch, taken, chunk)  ) {
+				pthread_mutex_unlock(&workers->mutex);
+				(*batch.function)(batch, chunk);
+				pthread_mutex_lock(&workers->mutex);
+				batch.unfinished--;
+			}
+			else {
+				pthread_cond_wait(&workers->chunks_finished, &workers->mutex);
+			}
+		}
+		pthread_mutex_unlock(&workers->mutex);
+	}
+#endif
+	batch.busy = false;
+}
+
+
+void chunked_zlib_file_rdwr_stream_t::finish_batch(batch_t &batch)
+{
+	if(  !batch.busy  ) {
+		return;
+	}
+	await_batch(batch);
+
+	for(  uint32 i = 0;  i < batch.filled;  i++  ) {
+		chunk_t &chunk = batch.chunks[i];
+		if(  status == STATUS_OK  ) {
+			if(  chunk.member_len == 0  ) {
+				dbg->error("chunked_zlib_file_rdwr_stream_t::finish_batch", "Error during compression");
+				status = STATUS_ERR_CORRUPT;
+			}
+			else {
+				raw_file_rdwr_stream_t::write(chunk.member, chunk.member_len);
+			}
+		}
+		chunk.len = 0;
+	}
+	batch.filled = 0;
+}
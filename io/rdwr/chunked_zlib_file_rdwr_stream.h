@@ -0,0 +1,83 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef IO_RDWR_CHUNKED_ZLIB_FILE_RDWR_STREAM_H
+#define IO_RDWR_CHUNKED_ZLIB_FILE_RDWR_STREAM_H
+
+
+#include "raw_file_rdwr_stream.h"
+
+
+/**
+ * Reads/writes a gzip file as a series of independently compressed chunks,
+ * which are (de)compressed in parallel. The stream has workers of its own, as many
+ * as the job scheduler, since the world stops and restarts the workers of the
+ * scheduler while a game is loaded.
+ *
+ * Each chunk of up to 1 MiB of data is a gzip member of its own. Concatenated
+ * members are a valid gzip file, which zlib_file_rdwr_stream_t (and any other
+ * gzip reader) reads in one go. In addition, the header of each member holds
+ * an extra field 'SC' with the size of the member and of its uncompressed data,
+ * as an index by which a reader can find all chunks without decompressing them.
+ * The file ends with an empty member, so a truncated file can be recognised.
+ */
+class chunked_zlib_file_rdwr_stream_t : public raw_file_rdwr_stream_t
+{
+public:
+	chunked_zlib_file_rdwr_stream_t(const std::string &filename, bool writing, int compression);
+	~chunked_zlib_file_rdwr_stream_t();
+
+	/// @returns whether @p filename starts with a chunk written by this class
+	static bool is_chunked_file(const std::string &filename);
+
+public:
+	/// @copydoc rdwr_stream_t::read
+	size_t read(void *buf, size_t len) OVERRIDE;
+
+	/// @copydoc rdwr_stream_t::write
+	size_t write(const void *buf, size_t len) OVERRIDE;
+
+private:
+	struct batch_t;
+	struct workers_t;
+
+	// one batch is filled (or read) while the other one is (de)compressed
+	batch_t *batches[2];
+	uint32 current;
+
+	// NULL if the chunks are (de)compressed at once on the calling thread
+	workers_t *workers;
+
+	// while reading: the chunk of the current batch being read, and the position in it
+	uint32 read_chunk;
+	uint32 read_pos;
+	bool last_member_read;
+
+	static void compress_chunk(batch_t &batch, uint32 chunk);
+	static void decompress_chunk(batch_t &batch, uint32 chunk);
+
+	static void *worker_thread(void *args);
+
+	/// Takes the next chunk to (de)compress from the started batches, or only from @p only if given
+	static bool take_chunk(workers_t &workers, batch_t *only, batch_t *&batch, uint32 &chunk);
+
+	/// Starts (de)compressing the filled chunks of @p batch
+	void start_batch(batch_t &batch);
+
+	/// Starts compressing the current batch, and continues with the other one
+	void switch_batches();
+
+	/// Waits until the chunks of @p batch are (de)compressed
+	void await_batch(batch_t &batch);
+
+	/// Waits until @p batch is compressed, and writes its chunks
+	void finish_batch(batch_t &batch);
+
+	/// Reads the next members from the file into @p batch, and starts decompressing them
+	void read_batch(batch_t &batch);
+};
+
+
+#endif
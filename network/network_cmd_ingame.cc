@@ -393,6 +393,9 @@ bool nwc_chat_t::execute (karte_t* welt)
 
 
 SOCKET nwc_join_t::pending_join_client = INVALID_SOCKET;
+uint32 nwc_join_t::pending_join_sync_step = 0;
+uint32 nwc_join_t::pending_join_map_counter = 0;
+vector_tpl<uint32> nwc_join_t::additional_join_clients;
 
 void nwc_join_t::rdwr()
 {
@@ -417,22 +420,40 @@ bool nwc_join_t::execute(karte_t *welt)
 			socket_list_t::get_client(nwj.client_id).nickname = nickname;
 		}
 
-		// no other joining process active?
-		nwj.answer = socket_list_t::get_client(nwj.client_id).is_active()  &&  pending_join_client == INVALID_SOCKET ? 1 : 0;
+		// no other joining process active, or can join with the pending one?
+		const bool join_pending = pending_join_client != INVALID_SOCKET  &&  welt->get_sync_steps() < pending_join_sync_step;
+		nwj.answer = socket_list_t::get_client(nwj.client_id).is_active()  &&  (pending_join_client == INVALID_SOCKET  ||  join_pending) ? 1 : 0;
 		DBG_MESSAGE( "nwc_join_t::execute", "client_id=%i active=%i pending_join_client=%i active=%d", socket_list_t::get_client_id(packet->get_sender()), socket_list_t::get_client(nwj.client_id).is_active(), pending_join_client, nwj.answer );
 		nwj.rdwr();
 		if(  nwj.send( packet->get_sender() )  ) {
-			if(  nwj.answer==1  ) {
+			if(  nwj.answer==1  &&  join_pending  ) {
+				// the game saved for the pending join is sent to this client too
+				nwc_sync_t nw_sync(pending_join_sync_step, welt->get_map_counter(), nwj.client_id, pending_join_map_counter);
+				nw_sync.rdwr();
+				if(  nw_sync.send( packet->get_sender() )  ) {
+					additional_join_clients.append(nwj.client_id);
+					DBG_MESSAGE( "nwc_join_t::execute", "client_id=%i joins with pending_join_client %i", nwj.client_id, pending_join_client);
+				}
+				else {
+					dbg->warning("nwc_join_t::execute", "send of NWC_SYNC to the joining client failed");
+				}
+			}
+			else if(  nwj.answer==1  ) {
 				// now send sync command
 				const uint32 new_map_counter = welt->generate_new_map_counter();
+				// clients asking to join until then receive the same game
+				const uint32 sync_step = welt->get_sync_steps() + 1 + env_t::server_frames_before_join;
 				// since network_send_all() does not include non-playing clients -> send sync command separately to the joining client
-				nwc_sync_t nw_sync(welt->get_sync_steps() + 1, welt->get_map_counter(), nwj.client_id, new_map_counter);
+				nwc_sync_t nw_sync(sync_step, welt->get_map_counter(), nwj.client_id, new_map_counter);
 				nw_sync.rdwr();
 				if(  nw_sync.send( packet->get_sender() )  ) {
 					// now send sync command to the server and the remaining clients
-					nwc_sync_t *nws = new nwc_sync_t(welt->get_sync_steps() + 1, welt->get_map_counter(), nwj.client_id, new_map_counter);
+					nwc_sync_t *nws = new nwc_sync_t(sync_step, welt->get_map_counter(), nwj.client_id, new_map_counter);
 					network_send_all(nws, false);
 					pending_join_client = packet->get_sender();
+					pending_join_sync_step = sync_step;
+					pending_join_map_counter = new_map_counter;
+					additional_join_clients.clear();
 					DBG_MESSAGE( "nwc_join_t::execute", "pending_join_client now %i", pending_join_client);
 					// unpause world
 					if (welt->is_paused()) {
@@ -744,18 +765,30 @@ void nwc_sync_t::do_command(karte_t *welt)
 		env_t::restore_UI = true;
 		welt->save( fn, false, SERVER_SAVEGAME_VER_NR, EXTENDED_VER_NR, EXTENDED_REVISION_NR, false );
 
-		// ok, now sending game
-		// this sends nwc_game_t
-		const char *err = network_send_file( client_id, fn );
-		if (err) {
-			dbg->warning("nwc_sync_t::do_command","send game failed with: %s", err);
+		// the clients that asked to join while this was pending receive the same game
+		vector_tpl<uint32> receivers;
+		receivers.append(client_id);
+		if(  get_sync_step() == nwc_join_t::pending_join_sync_step  ) {
+			FOR(vector_tpl<uint32>, const id, nwc_join_t::additional_join_clients) {
+				receivers.append(id);
+			}
 		}
+		nwc_join_t::additional_join_clients.clear();
 
-		else {
-			// Knightly : synchronise the iteration limits
-			SOCKET sock = socket_list_t::get_socket(client_id);
-			if(  sock==INVALID_SOCKET  ||  !nwc_routesearch_t::transmit_active_limit_set(sock, welt->get_sync_steps(), new_map_counter)  ) {
-				dbg->warning("nwc_sync_t::do_command", "send of NWC_ROUTESEARCH failed");
+		// ok, now sending game
+		FOR(vector_tpl<uint32>, const receiver, receivers) {
+			// this sends nwc_game_t
+			const char *err = network_send_file( receiver, fn );
+			if (err) {
+				dbg->warning("nwc_sync_t::do_command","send game failed with: %s", err);
+			}
+
+			else {
+				// Knightly : synchronise the iteration limits
+				SOCKET sock = socket_list_t::get_socket(receiver);
+				if(  sock==INVALID_SOCKET  ||  !nwc_routesearch_t::transmit_active_limit_set(sock, welt->get_sync_steps(), new_map_counter)  ) {
+					dbg->warning("nwc_sync_t::do_command", "send of NWC_ROUTESEARCH failed");
+				}
 			}
 		}
 
@@ -769,26 +802,28 @@ void nwc_sync_t::do_command(karte_t *welt)
 		// apply new map counter
 		welt->set_map_counter(new_map_counter);
 
-		// unpause the client that received the game
-		// we do not want to wait for him (maybe loading failed due to pakset-errors)
-		SOCKET sock = socket_list_t::get_socket(client_id);
-		if(  sock != INVALID_SOCKET  ) {
-			nwc_ready_t nwc( old_sync_steps, welt->get_map_counter(), welt->get_checklist_at(old_sync_steps) );
-			if (nwc.send(sock)) {
-				socket_list_t::change_state( client_id, socket_info_t::playing);
-				if (socket_list_t::is_valid_client_id(client_id)) {
-					socket_list_t::get_client(client_id).player_unlocked = unlocked_players;
-					// send information about locked state
-					nwc_auth_player_t nwc;
-					nwc.player_unlocked = unlocked_players;
-					nwc.send(sock);
-
-					// welcome message
-					nwc_nick_t::server_tools(welt, client_id, nwc_nick_t::WELCOME, NULL);
+		// unpause the clients that received the game
+		// we do not want to wait for them (maybe loading failed due to pakset-errors)
+		FOR(vector_tpl<uint32>, const receiver, receivers) {
+			SOCKET sock = socket_list_t::get_socket(receiver);
+			if(  sock != INVALID_SOCKET  ) {
+				nwc_ready_t nwc( old_sync_steps, welt->get_map_counter(), welt->get_checklist_at(old_sync_steps) );
+				if (nwc.send(sock)) {
+					socket_list_t::change_state( receiver, socket_info_t::playing);
+					if (socket_list_t::is_valid_client_id(receiver)) {
+						socket_list_t::get_client(receiver).player_unlocked = unlocked_players;
+						// send information about locked state
+						nwc_auth_player_t nwc;
+						nwc.player_unlocked = unlocked_players;
+						nwc.send(sock);
+
+						// welcome message
+						nwc_nick_t::server_tools(welt, receiver, nwc_nick_t::WELCOME, NULL);
+					}
+				}
+				else {
+					dbg->warning( "nwc_sync_t::do_command", "send of NWC_READY failed" );
 				}
-			}
-			else {
-				dbg->warning( "nwc_sync_t::do_command", "send of NWC_READY failed" );
 			}
 		}
 		nwc_join_t::pending_join_client = INVALID_SOCKET;
@@ -964,6 +999,7 @@ void nwc_check_t::rdwr()
 {
 	network_world_command_t::rdwr();
 	server_checklist.rdwr(packet);
+	server_state_hashes.rdwr(packet);
 	packet->rdwr_long(server_sync_step);
 	if (packet->is_loading()  &&  env_t::server) {
 		// server does not receive nwc_check_t-commands
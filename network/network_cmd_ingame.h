@@ -103,6 +103,8 @@ private:
  * nwc_join_t
  * @from-client: client wants to join the server
  *      server sends nwc_join_t to sender, nwc_sync_t to all clients
+ *      the game is saved env_t::server_frames_before_join sync steps later, and clients
+ *      asking to join until then receive the same game, so the other clients reload only once
  * @from-server:
  *      @data answer == 1 (if joining now is ok)
  *      @data client_id
@@ -124,6 +126,14 @@ public:
 	 */
 	static SOCKET pending_join_client;
 
+	/**
+	 * the sync step and new map counter of the nwc_sync_t of the pending join,
+	 * and the clients joining with pending_join_client
+	 */
+	static uint32 pending_join_sync_step;
+	static uint32 pending_join_map_counter;
+	static vector_tpl<uint32> additional_join_clients;
+
 	static bool is_pending() { return pending_join_client != INVALID_SOCKET; }
 private:
 	nwc_join_t(const nwc_join_t&);
@@ -278,11 +288,13 @@ private:
 class nwc_check_t : public network_world_command_t {
 public:
 	nwc_check_t() : network_world_command_t(NWC_CHECK, 0, 0), server_sync_step(0) { }
-	nwc_check_t(uint32 sync_steps, uint32 map_counter, const checklist_t &server_checklist_, uint32 server_sync_step_) : network_world_command_t(NWC_CHECK, sync_steps, map_counter), server_checklist(server_checklist_), server_sync_step(server_sync_step_) {}
+	nwc_check_t(uint32 sync_steps, uint32 map_counter, const checklist_t &server_checklist_, const state_hashes_t &server_state_hashes_, uint32 server_sync_step_) : network_world_command_t(NWC_CHECK, sync_steps, map_counter), server_checklist(server_checklist_), server_state_hashes(server_state_hashes_), server_sync_step(server_sync_step_) {}
 	void rdwr() OVERRIDE;
 	void do_command(karte_t*) OVERRIDE { }
 
 	checklist_t server_checklist;
+	// to find the objects that differ if the checklists do
+	state_hashes_t server_state_hashes;
 	uint32 server_sync_step;
 	// no action required -> can be ignored if too old
 	bool ignore_old_events() const OVERRIDE { return true; }
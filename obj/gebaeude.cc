@@ -41,6 +41,7 @@ static pthread_mutex_t add_to_city_mutex = PTHREAD_MUTEX_INITIALIZER;
 #include "../dataobj/translator.h"
 #include "../dataobj/settings.h"
 #include "../dataobj/environment.h"
+#include "../dataobj/road_graph.h"
 
 #include "../gui/building_info.h"
 #include "../gui/headquarter_info.h"
@@ -371,6 +372,8 @@ void gebaeude_t::check_road_tiles(bool del)
 				if (way)
 				{
 					way->connected_buildings.append_unique(this);
+					// a new destination of private cars
+					road_graph_t::way_changed(way);
 				}
 			}
 		}
@@ -9,6 +9,7 @@
 
 #include "../boden/grund.h"
 #include "../dataobj/loadsave.h"
+#include "../dataobj/route_cache.h"
 #include "../dataobj/translator.h"
 #include "../display/simgraph.h"
 #include "../display/simimg.h"
@@ -129,6 +130,10 @@ void obj_t::set_owner(player_t *player)
 {
 	int i = welt->sp2num(player);
 	assert(i>=0);
+	if(  get_typ() == way  &&  owner_n != (uint8)i  ) {
+		// who may use a way depends on its owner
+		route_cache_t::network_changed();
+	}
 	owner_n = (uint8)i;
 }
 
@@ -339,6 +344,10 @@ void obj_t::mark_image_dirty(image_id image, sint16 yoff) const
 		// too close to border => set dirty to be sure (smoke, skyscrapers, birds, or the like)
 		scr_coord_val xbild = 0, ybild = 0, wbild = 0, hbild = 0;
 		display_get_image_offset( image, &xbild, &ybild, &wbild, &hbild );
+		if(  get_typ() == obj_t::way  ) {
+			// ways are drawn with the ground, which the main view keeps in a cache
+			display_static_layer_mark_dirty( scr_pos.x + xpos + xbild, scr_pos.y + ypos + yoff + ybild, scr_pos.x + xpos + xbild + wbild - 1, scr_pos.y + ypos + yoff + ybild + hbild - 1 );
+		}
 		const sint16 distance_to_border = 3 - (yoff+get_yoff()+ybild)/(rasterweite/4);
 		if(  pos.x <= distance_to_border  ||  pos.y <= distance_to_border  ) {
 			// but only if the image is actually visible ...
@@ -5,6 +5,10 @@
 
 #include "path_explorer.h"
 
+#include <algorithm>
+#include <functional>
+#include <string.h>
+
 #include "tpl/slist_tpl.h"
 #include "dataobj/translator.h"
 #include "bauer/goods_manager.h"
@@ -16,6 +20,7 @@
 #include "dataobj/schedule.h"
 #include "simconvoi.h"
 #include "simloadingscreen.h"
+#include "utils/job_scheduler.h"
 
 
 // #define DEBUG_EXPLORER_SPEED
@@ -468,17 +473,24 @@ bool path_explorer_t::compartment_t::local_limits_changed = false;
 uint16 path_explorer_t::compartment_t::representative_halt_count = 0;
 uint8 path_explorer_t::compartment_t::representative_category = 0;
 
+#ifdef MULTI_THREAD_PATH_EXPLORER
+uint16 path_explorer_t::compartment_t::explore_paths_via = 0;
+uint32 path_explorer_t::compartment_t::explore_paths_task_count = 0;
+
+// the data of the job is the compartment whose explore units are relaxed
+static job_scheduler_t::job_t explore_paths_job(NULL, NULL);
+#endif
+vector_tpl<uint32*> path_explorer_t::compartment_t::explore_scratch;
+uint32 path_explorer_t::compartment_t::explore_scratch_size = 0;
+
 path_explorer_t::compartment_t::compartment_t()
 {
 	refresh_start_time = 0;
 
-	finished_matrix = NULL;
 	finished_halt_index_map = NULL;
 	finished_halt_count = 0;
 
-	working_matrix = NULL;
 	transport_index_map = NULL;
-	transport_matrix = NULL;
 	working_halt_index_map = NULL;
 	working_halt_list = NULL;
 	working_halt_count = 0;
@@ -515,6 +527,12 @@ path_explorer_t::compartment_t::compartment_t()
 	inbound_connections = NULL;
 	outbound_connections = NULL;
 	process_next_transfer = true;
+	via_cluster_map = NULL;
+
+	working_edges_valid = false;
+	search_iterations = 0;
+	finished_search_iterations = 0;
+	incremental_refresh_count = 0;
 
 	statistic_duration = 0;
 	statistic_iteration = 0;
@@ -523,40 +541,16 @@ path_explorer_t::compartment_t::compartment_t()
 
 path_explorer_t::compartment_t::~compartment_t()
 {
-	if (finished_matrix)
-	{
-		for (uint16 i = 0; i < finished_halt_count; ++i)
-		{
-			delete[] finished_matrix[i];
-		}
-		delete[] finished_matrix;
-	}
 	if (finished_halt_index_map)
 	{
 		delete[] finished_halt_index_map;
 	}
 
 
-	if (working_matrix)
-	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] working_matrix[i];
-		}
-		delete[] working_matrix;
-	}
 	if (transport_index_map)
 	{
 		delete[] transport_index_map;
 	}
-	if (transport_matrix)
-	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] transport_matrix[i];
-		}
-		delete[] transport_matrix;
-	}
 	if (working_halt_index_map)
 	{
 		delete[] working_halt_index_map;
@@ -581,6 +575,10 @@ path_explorer_t::compartment_t::~compartment_t()
 	{
 		delete[] transfer_list;
 	}
+	if (via_cluster_map)
+	{
+		delete[] via_cluster_map;
+	}
 
 	if (inbound_connections)
 	{
@@ -605,47 +603,31 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 
 	if (reset_finished_set)
 	{
-		if (finished_matrix)
-		{
-			for (uint16 i = 0; i < finished_halt_count; ++i)
-			{
-				delete[] finished_matrix[i];
-			}
-			delete[] finished_matrix;
-			finished_matrix = NULL;
-		}
+		// the storage of the matrix is retained for re-use
+		finished_matrix.release();
 		if (finished_halt_index_map)
 		{
 			delete[] finished_halt_index_map;
 			finished_halt_index_map = NULL;
 		}
 		finished_halt_count = 0;
+
+		finished_edges.clear();
+		finished_transfers.clear();
+		finished_search_iterations = 0;
+		incremental_refresh_count = 0;
 	}
 
 
-	if (working_matrix)
-	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] working_matrix[i];
-		}
-		delete[] working_matrix;
-		working_matrix = NULL;
-	}
+	working_matrix.release();
+	working_edges.clear();
+	working_edges_valid = false;
+	search_iterations = 0;
 	if (transport_index_map)
 	{
 		delete[] transport_index_map;
 		transport_index_map = NULL;
 	}
-	if (transport_matrix)
-	{
-		for (uint16 i = 0; i < working_halt_count; ++i)
-		{
-			delete[] transport_matrix[i];
-		}
-		delete[] transport_matrix;
-		transport_matrix = NULL;
-	}
 	if (working_halt_index_map)
 	{
 		delete[] working_halt_index_map;
@@ -680,6 +662,11 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 		transfer_list = NULL;
 	}
 	transfer_count = 0;
+	if (via_cluster_map)
+	{
+		delete[] via_cluster_map;
+		via_cluster_map = NULL;
+	}
 
 	if (inbound_connections)
 	{
@@ -692,6 +679,7 @@ void path_explorer_t::compartment_t::reset(const bool reset_finished_set)
 		outbound_connections = NULL;
 	}
 	process_next_transfer = true;
+	explore_units.clear();
 
 #ifdef DEBUG_COMPARTMENT_STEP
 	step_count = 0;
@@ -728,9 +716,720 @@ void path_explorer_t::compartment_t::initialise()
 
 void path_explorer_t::compartment_t::finalise()
 {
+	free_explore_scratch();
 	finalise_connexion_list();
 }
 
+
+#ifdef MULTI_THREAD_PATH_EXPLORER
+void path_explorer_t::compartment_t::explore_paths_task(void *data, uint32 task)
+{
+	// each task relaxes the rows of its own share of the origins, see relax_explore_units()
+	reinterpret_cast<compartment_t *>(data)->relax_explore_units(explore_paths_via, task, explore_paths_task_count);
+}
+#endif
+
+
+/**
+ * Relax the aggregate times of a contiguous span of targets through the current transfer.
+ * Targets which do not belong to the given outbound cluster are left unchanged.
+ * This loop is kept free of branches, so that the compiler can vectorise it.
+ */
+static inline void relax_aggregate_times(uint32 *const origin_times, const uint32 *const via_times, const uint32 *const via_clusters,
+										 const uint32 target_cluster, const uint32 origin_via_time, uint32 *const improved, const uint32 span)
+{
+	for( uint32 j = 0; j < span; ++j )
+	{
+		const uint32 combined_time = origin_via_time + via_times[j];
+		const uint32 current_time = origin_times[j];
+		const uint32 better = ( via_clusters[j] == target_cluster ) & ( combined_time < current_time );
+		improved[j] = better;
+		origin_times[j] = better ? combined_time : current_time;
+	}
+}
+
+
+void path_explorer_t::compartment_t::relax_explore_units(const uint16 via, const uint32 thread_number, const uint32 thread_count)
+{
+	const uint32 *const via_times = working_matrix.get_aggregate_time_row(via);
+	const transport_element_t *const via_transports = working_matrix.get_transport_row(via);
+	uint32 *const improved = explore_scratch[thread_number];
+
+	const uint32 unit_count = explore_units.get_count();
+	for( uint32 u = 0; u < unit_count; ++u )
+	{
+		const uint16 origin = explore_units[u].origin;
+
+		// all units of an origin are processed by the same thread, so that each row is only ever written by one thread
+		if( origin % thread_count != thread_number )
+		{
+			continue;
+		}
+
+		const uint32 target_cluster = explore_units[u].target_cluster;
+		const vector_tpl<uint16> &target_halt_list = (*outbound_connections)[target_cluster].connected_halts;
+		const uint32 target_count = target_halt_list.get_count();
+
+		uint32 *const origin_times = working_matrix.get_aggregate_time_row(origin);
+		halthandle_t *const origin_transfers = working_matrix.get_next_transfer_row(origin);
+		transport_element_t *const origin_transports = working_matrix.get_transport_row(origin);
+
+		// neither element changes while relaxing through via, as origin and target are never via itself
+		const uint32 origin_via_time = origin_times[via];
+		const halthandle_t origin_via_transfer = origin_transfers[via];
+		const uint16 origin_via_transport = origin_transports[via].first_transport;
+
+		// connected halts are registered in ascending order
+		const uint16 first_target = target_halt_list[0];
+		const uint32 span = (uint32)target_halt_list[target_count - 1] - first_target + 1;
+
+		if( target_count * dense_explore_ratio >= span )
+		{
+			// targets are densely packed -> relax the aggregate times of the whole span first, then complete the improved elements
+			relax_aggregate_times(origin_times + first_target, via_times + first_target, via_cluster_map + first_target, target_cluster, origin_via_time, improved, span);
+
+			for( uint32 target_member_index = 0; target_member_index < target_count; ++target_member_index )
+			{
+				const uint16 target = target_halt_list[target_member_index];
+				if( improved[target - first_target] )
+				{
+					origin_transfers[target] = origin_via_transfer;
+					origin_transports[target].first_transport = origin_via_transport;
+					origin_transports[target].last_transport = via_transports[target].last_transport;
+				}
+			}
+		}
+		else
+		{
+			for( uint32 target_member_index = 0; target_member_index < target_count; ++target_member_index )
+			{
+				const uint16 target = target_halt_list[target_member_index];
+				const uint32 combined_time = origin_via_time + via_times[target];
+
+				if( combined_time < origin_times[target] )
+				{
+					origin_times[target] = combined_time;
+					origin_transfers[target] = origin_via_transfer;
+					origin_transports[target].first_transport = origin_via_transport;
+					origin_transports[target].last_transport = via_transports[target].last_transport;
+				}
+			}
+		}
+	}
+}
+
+
+void path_explorer_t::compartment_t::reserve_explore_scratch(const uint32 thread_count)
+{
+	if( explore_scratch_size < working_halt_count )
+	{
+		for( uint32 i = 0; i < explore_scratch.get_count(); ++i )
+		{
+			delete[] explore_scratch[i];
+			explore_scratch[i] = new uint32[working_halt_count];
+		}
+		explore_scratch_size = working_halt_count;
+	}
+	while( explore_scratch.get_count() < thread_count )
+	{
+		explore_scratch.append( new uint32[explore_scratch_size] );
+	}
+}
+
+
+void path_explorer_t::compartment_t::free_explore_scratch()
+{
+	clear_ptr_vector(explore_scratch);
+	explore_scratch_size = 0;
+}
+
+
+void path_explorer_t::compartment_t::process_explore_units(const uint16 via, const uint64 batch_iterations)
+{
+#ifdef MULTI_THREAD_PATH_EXPLORER
+	// only one thread explores paths at a time, see allow_path_explorer_on_this_thread
+	const uint32 worker_count = job_scheduler_t::get_worker_count();
+	if( batch_iterations >= parallel_explore_threshold  &&  worker_count > 0 )
+	{
+		explore_paths_task_count = worker_count + 1;
+		reserve_explore_scratch(explore_paths_task_count);
+
+		explore_paths_via = via;
+		explore_paths_job.function = &explore_paths_task;
+		explore_paths_job.data = this;
+		job_scheduler_t::run(explore_paths_job, explore_paths_task_count);
+
+		explore_units.clear();
+		return;
+	}
+#else
+	(void)batch_iterations;
+#endif
+
+	reserve_explore_scratch(1);
+	relax_explore_units(via, 0, 1);
+	explore_units.clear();
+}
+
+
+void path_explorer_t::compartment_t::build_via_cluster_map()
+{
+	if( !via_cluster_map )
+	{
+		via_cluster_map = new uint32[working_halt_count];
+	}
+	for( uint16 idx = 0; idx < working_halt_count; ++idx )
+	{
+		via_cluster_map[idx] = no_cluster;
+	}
+	for( uint32 c = 0; c < outbound_connections->get_cluster_count(); ++c )
+	{
+		const vector_tpl<uint16> &connected_halts = (*outbound_connections)[c].connected_halts;
+		for( uint32 m = 0; m < connected_halts.get_count(); ++m )
+		{
+			via_cluster_map[ connected_halts[m] ] = c;
+		}
+	}
+}
+
+
+void path_explorer_t::compartment_t::path_matrix_t::init(const uint16 count, const bool with_transports)
+{
+	const uint32 stride = ( (uint32)count + row_alignment - 1 ) & ~( row_alignment - 1 );
+	const uint32 required = stride * count;
+
+	// re-allocate only if the storage is too small, or far larger than necessary
+	if( required > capacity || required < capacity / 4 )
+	{
+		free_storage();
+		capacity = required;
+		if( capacity > 0 )
+		{
+			aggregate_times = new uint32[capacity];
+			next_transfers = new halthandle_t[capacity];
+		}
+	}
+	if( with_transports && !transports && capacity > 0 )
+	{
+		transports = new transport_element_t[capacity];
+	}
+
+	row_stride = stride;
+	halt_count = count;
+	in_use = true;
+
+	// no paths are known yet
+	for( uint32 i = 0; i < required; ++i )
+	{
+		aggregate_times[i] = UINT32_MAX_VALUE;
+	}
+	for( uint32 i = 0; i < required; ++i )
+	{
+		next_transfers[i] = halthandle_t();
+	}
+	if( transports )
+	{
+		const transport_element_t no_transport;
+		for( uint32 i = 0; i < required; ++i )
+		{
+			transports[i] = no_transport;
+		}
+	}
+}
+
+
+void path_explorer_t::compartment_t::path_matrix_t::free_storage()
+{
+	delete[] aggregate_times;
+	aggregate_times = NULL;
+	delete[] next_transfers;
+	next_transfers = NULL;
+	delete[] transports;
+	transports = NULL;
+	capacity = 0;
+	row_stride = 0;
+	halt_count = 0;
+	in_use = false;
+}
+
+
+void path_explorer_t::compartment_t::path_matrix_t::swap(path_matrix_t &other)
+{
+	std::swap(aggregate_times, other.aggregate_times);
+	std::swap(next_transfers, other.next_transfers);
+	std::swap(transports, other.transports);
+	std::swap(capacity, other.capacity);
+	std::swap(row_stride, other.row_stride);
+	std::swap(halt_count, other.halt_count);
+	std::swap(in_use, other.in_use);
+}
+
+
+void path_explorer_t::compartment_t::path_matrix_t::copy_from(const path_matrix_t &other)
+{
+	init(other.halt_count, true);
+	const uint32 count = row_stride * halt_count;
+	std::copy(other.aggregate_times, other.aggregate_times + count, aggregate_times);
+	std::copy(other.next_transfers, other.next_transfers + count, next_transfers);
+	std::copy(other.transports, other.transports + count, transports);
+}
+
+
+bool path_explorer_t::compartment_t::try_incremental_refresh()
+{
+	if ( !working_edges_valid )
+	{
+		return false;
+	}
+
+	// connexions are collected in order of origin only; keep them sorted for comparison with the next refresh
+	std::sort(working_edges.begin(), working_edges.end());
+
+	const uint32 max_changes = world->get_settings().get_path_explorer_max_incremental_changes();
+	if ( max_changes == 0 || incremental_refresh_count >= max_incremental_refreshes
+		|| !finished_matrix.is_in_use() || !finished_matrix.has_transports() || !finished_halt_index_map
+		|| working_halt_count == 0 || finished_halt_count != working_halt_count
+		|| finished_transfers.get_count() != transfer_count
+		|| memcmp(finished_halt_index_map, working_halt_index_map, 65536 * sizeof(uint16)) != 0 )
+	{
+		return false;
+	}
+	for ( uint16 t = 0; t < transfer_count; ++t )
+	{
+		if ( finished_transfers[t] != transfer_list[t] )
+		{
+			return false;
+		}
+	}
+
+	// compare the connexions with those of the last refresh
+	vector_tpl<direct_edge_t> improved_edges;	// new connexions, or faster ones with the same transport
+	vector_tpl<direct_edge_t> worsened_edges;	// old connexions which are gone, slower, or served by another transport
+	uint32 old_index = 0;
+	uint32 new_index = 0;
+	while ( old_index < finished_edges.get_count() || new_index < working_edges.get_count() )
+	{
+		if ( new_index == working_edges.get_count() || ( old_index < finished_edges.get_count() && finished_edges[old_index] < working_edges[new_index] ) )
+		{
+			worsened_edges.append( finished_edges[old_index++] );
+		}
+		else if ( old_index == finished_edges.get_count() || working_edges[new_index] < finished_edges[old_index] )
+		{
+			improved_edges.append( working_edges[new_index++] );
+		}
+		else
+		{
+			const direct_edge_t &old_edge = finished_edges[old_index++];
+			const direct_edge_t &new_edge = working_edges[new_index++];
+			if ( old_edge.transport != new_edge.transport )
+			{
+				worsened_edges.append(old_edge);
+				improved_edges.append(new_edge);
+			}
+			else if ( new_edge.aggregate_time > old_edge.aggregate_time )
+			{
+				worsened_edges.append(old_edge);
+			}
+			else if ( new_edge.aggregate_time < old_edge.aggregate_time )
+			{
+				improved_edges.append(new_edge);
+			}
+		}
+
+		if ( improved_edges.get_count() + worsened_edges.get_count() > max_changes )
+		{
+			return false;
+		}
+	}
+
+	const uint16 halt_count = working_halt_count;
+
+	vector_tpl<uint8> is_transfer(halt_count);
+	vector_tpl<uint8> is_affected(halt_count);
+	for ( uint16 i = 0; i < halt_count; ++i )
+	{
+		is_transfer.append(0);
+		is_affected.append(0);
+	}
+	for ( uint16 t = 0; t < transfer_count; ++t )
+	{
+		is_transfer[ transfer_list[t] ] = 1;
+	}
+
+	// rows in which goods would be routed over a worsened connexion have to be recomputed;
+	// the routes are followed through the next transfers, one target column at a time
+	uint32 affected_count = 0;
+	if ( !worsened_edges.empty() )
+	{
+		vector_tpl<uint8> has_worsened(halt_count);
+		vector_tpl<uint8> route_state(halt_count);	// 0 : unknown, 1 : intact, 2 : broken, 3 : being followed
+		vector_tpl<uint16> trail(halt_count);
+		for ( uint16 i = 0; i < halt_count; ++i )
+		{
+			has_worsened.append(0);
+			route_state.append(0);
+		}
+		FOR(vector_tpl<direct_edge_t>, const& edge, worsened_edges)
+		{
+			has_worsened[edge.origin] = 1;
+		}
+
+		for ( uint16 target = 0; target < halt_count; ++target )
+		{
+			for ( uint16 i = 0; i < halt_count; ++i )
+			{
+				route_state[i] = 0;
+			}
+			route_state[target] = 1;
+
+			for ( uint16 origin = 0; origin < halt_count; ++origin )
+			{
+				trail.clear();
+				uint16 current = origin;
+				uint8 state = 0;
+				while ( route_state[current] == 0 )
+				{
+					route_state[current] = 3;
+					trail.append(current);
+					if ( finished_matrix.get_aggregate_time(current, target) == UINT32_MAX_VALUE )
+					{
+						state = 1;
+						break;
+					}
+					const halthandle_t next_halt = finished_matrix.get_next_transfer(current, target);
+					const uint16 next = next_halt.is_bound() ? finished_halt_index_map[next_halt.get_id()] : 65535u;
+					if ( next >= halt_count )
+					{
+						state = 1;
+						break;
+					}
+					if ( has_worsened[current] )
+					{
+						direct_edge_t hop;
+						hop.origin = current;
+						hop.target = next;
+						if ( std::binary_search(worsened_edges.begin(), worsened_edges.end(), hop) )
+						{
+							state = 2;
+							break;
+						}
+					}
+					current = next;
+				}
+				if ( state == 0 )
+				{
+					// a route which runs into itself never reaches the target, so it cannot be broken either
+					state = route_state[current] == 3 ? 1 : route_state[current];
+				}
+				FOR(vector_tpl<uint16>, const halt, trail)
+				{
+					route_state[halt] = state;
+				}
+			}
+
+			for ( uint16 origin = 0; origin < halt_count; ++origin )
+			{
+				if ( route_state[origin] == 2 && !is_affected[origin] )
+				{
+					is_affected[origin] = 1;
+					++affected_count;
+				}
+			}
+			if ( affected_count * incremental_row_ratio > halt_count )
+			{
+				return false;
+			}
+		}
+	}
+
+	// estimate the iterations needed, on the same scale as path exploration, and give up unless
+	// they fit into one step and are clearly fewer than those of the last full exploration
+	uint64 estimated_iterations = (uint64)affected_count * ( working_edges.get_count() + halt_count );
+	FOR(vector_tpl<direct_edge_t>, const& edge, improved_edges)
+	{
+		uint32 reaching_halts = 0;
+		for ( uint16 i = 0; i < halt_count; ++i )
+		{
+			if ( finished_matrix.get_aggregate_time(i, edge.origin) != UINT32_MAX_VALUE )
+			{
+				++reaching_halts;
+			}
+		}
+		estimated_iterations += (uint64)reaching_halts * ( is_transfer[edge.target] ? halt_count : 1u );
+	}
+	if ( ( use_limits && estimated_iterations > limit_explore_paths ) || estimated_iterations > finished_search_iterations / 2 )
+	{
+		return false;
+	}
+
+	// start from the paths of the last refresh
+	working_matrix.copy_from(finished_matrix);
+
+	// rebuild the affected rows from the current connexions
+	if ( affected_count > 0 )
+	{
+		vector_tpl<uint32> edge_offsets(halt_count + 1u);
+		uint32 edge_index = 0;
+		for ( uint16 i = 0; i < halt_count; ++i )
+		{
+			while ( edge_index < working_edges.get_count() && working_edges[edge_index].origin < i )
+			{
+				++edge_index;
+			}
+			edge_offsets.append(edge_index);
+		}
+		edge_offsets.append( working_edges.get_count() );
+
+		vector_tpl<uint64> open_list(halt_count);
+		for ( uint16 i = 0; i < halt_count; ++i )
+		{
+			if ( is_affected[i] )
+			{
+				recompute_row(i, edge_offsets.begin(), is_transfer.begin(), open_list);
+			}
+		}
+	}
+
+	// let all paths benefit from the improved connexions : origin -> ... -> edge origin -> edge target -> ... -> target
+	FOR(vector_tpl<direct_edge_t>, const& edge, improved_edges)
+	{
+		const uint16 u = edge.origin;
+		const uint16 v = edge.target;
+		const uint16 transport = edge.transport;
+		const uint32 *const times_from_v = working_matrix.get_aggregate_time_row(v);
+		const transport_element_t *const transports_from_v = working_matrix.get_transport_row(v);
+		const uint16 target_end = is_transfer[v] ? halt_count : v + 1u;
+
+		for ( uint16 i = 0; i < halt_count; ++i )
+		{
+			const uint32 time_to_u = working_matrix.get_aggregate_time(i, u);
+			if ( i == v || time_to_u == UINT32_MAX_VALUE )
+			{
+				continue;
+			}
+			if ( i != u && ( !is_transfer[u] || ( transport != 0 && working_matrix.transport(i, u).last_transport == transport ) ) )
+			{
+				continue;
+			}
+			const halthandle_t first_hop = i == u ? working_halt_list[v] : working_matrix.get_next_transfer(i, u);
+			const uint16 first_transport = i == u ? transport : working_matrix.transport(i, u).first_transport;
+
+			uint32 *const times = working_matrix.get_aggregate_time_row(i);
+			halthandle_t *const next_transfers = working_matrix.get_next_transfer_row(i);
+			transport_element_t *const transports = working_matrix.get_transport_row(i);
+			for ( uint16 j = is_transfer[v] ? 0 : v; j < target_end; ++j )
+			{
+				if ( j == i || times_from_v[j] == UINT32_MAX_VALUE )
+				{
+					continue;
+				}
+				if ( j != v && transport != 0 && transports_from_v[j].first_transport == transport )
+				{
+					continue;
+				}
+				const uint32 time = time_to_u + edge.aggregate_time + times_from_v[j];
+				if ( time < times[j] )
+				{
+					times[j] = time;
+					next_transfers[j] = first_hop;
+					transports[j].first_transport = first_transport;
+					transports[j].last_transport = j == v ? transport : transports_from_v[j].last_transport;
+				}
+			}
+		}
+	}
+
+	total_iterations += static_cast<uint32>(estimated_iterations);
+	return true;
+}
+
+
+void path_explorer_t::compartment_t::recompute_row(const uint16 origin, const uint32 *const edge_offsets, const uint8 *const is_transfer, vector_tpl<uint64> &open_list)
+{
+	const uint16 halt_count = working_halt_count;
+	uint32 *const times = working_matrix.get_aggregate_time_row(origin);
+	halthandle_t *const next_transfers = working_matrix.get_next_transfer_row(origin);
+	transport_element_t *const transports = working_matrix.get_transport_row(origin);
+
+	const transport_element_t no_transport;
+	for ( uint16 i = 0; i < halt_count; ++i )
+	{
+		times[i] = UINT32_MAX_VALUE;
+		next_transfers[i] = halthandle_t();
+		transports[i] = no_transport;
+	}
+	times[origin] = 0;
+
+	// the open list holds ( time << 16 | halt ) so that ties are always broken in the same way
+	open_list.clear();
+	open_list.append(origin);
+	while ( !open_list.empty() )
+	{
+		std::pop_heap(open_list.begin(), open_list.end(), std::greater<uint64>());
+		const uint64 node = open_list.back();
+		open_list.pop_back();
+
+		const uint16 current = (uint16)( node & 0xFFFFu );
+		const uint32 current_time = (uint32)( node >> 16 );
+		if ( current_time != times[current] )
+		{
+			// superseded by a faster path
+			continue;
+		}
+		if ( current != origin && !is_transfer[current] )
+		{
+			// goods only change transport at transfer halts
+			continue;
+		}
+
+		for ( uint32 e = edge_offsets[current]; e < edge_offsets[current + 1u]; ++e )
+		{
+			const direct_edge_t &edge = working_edges[e];
+			if ( edge.target == origin )
+			{
+				continue;
+			}
+			if ( current != origin && edge.transport != 0 && edge.transport == transports[current].last_transport )
+			{
+				continue;
+			}
+			const uint32 time = current_time + edge.aggregate_time;
+			if ( time < times[edge.target] )
+			{
+				times[edge.target] = time;
+				if ( current == origin )
+				{
+					next_transfers[edge.target] = working_halt_list[edge.target];
+					transports[edge.target].first_transport = edge.transport;
+				}
+				else
+				{
+					next_transfers[edge.target] = next_transfers[current];
+					transports[edge.target].first_transport = transports[current].first_transport;
+				}
+				transports[edge.target].last_transport = edge.transport;
+
+				open_list.append( ( (uint64)time << 16 ) | edge.target );
+				std::push_heap(open_list.begin(), open_list.end(), std::greater<uint64>());
+			}
+		}
+	}
+}
+
+
+void path_explorer_t::compartment_t::complete_path_search()
+{
+	// path search completed -> delete old path info
+	if (finished_halt_index_map)
+	{
+		delete[] finished_halt_index_map;
+		finished_halt_index_map = NULL;
+	}
+
+	// transfer working to finished; the storage of the old finished matrix is kept for the next refresh
+	finished_matrix.swap(working_matrix);
+	working_matrix.release();
+	finished_halt_index_map = working_halt_index_map;
+	working_halt_index_map = NULL;
+	finished_halt_count = working_halt_count;
+
+	// keep the inputs of this search for comparison by the next refresh
+	swap(finished_edges, working_edges);
+	working_edges.clear();
+	finished_transfers.clear();
+	if ( working_edges_valid )
+	{
+		for ( uint16 t = 0; t < transfer_count; ++t )
+		{
+			finished_transfers.append( transfer_list[t] );
+		}
+	}
+	else
+	{
+		finished_edges.clear();
+	}
+	working_edges_valid = false;
+	search_iterations = 0;
+
+	// path search completed -> delete auxilliary data structures
+	working_halt_count = 0;
+	if (transfer_list)
+	{
+		delete[] transfer_list;
+		transfer_list = NULL;
+	}
+	transfer_count = 0;
+	if (via_cluster_map)
+	{
+		delete[] via_cluster_map;
+		via_cluster_map = NULL;
+	}
+
+	if (inbound_connections)
+	{
+		delete inbound_connections;
+		inbound_connections = NULL;
+	}
+	if (outbound_connections)
+	{
+		delete outbound_connections;
+		outbound_connections = NULL;
+	}
+	process_next_transfer = true;
+
+	// Debug paths : to execute, working_halt_list should not be deleted in the previous phase
+	// enumerate_all_paths(finished_matrix, working_halt_list, finished_halt_index_map, finished_halt_count);
+
+	current_phase = phase_reroute_goods;	// proceed to the next phase
+
+	// reset counters
+	phase_counter = 0;
+	via_index = 0;
+	origin_cluster_index = 0;
+	target_cluster_index = 0;
+	origin_member_index = 0;
+
+	paths_available = true;
+}
+
+
+size_t path_explorer_t::compartment_t::get_memory_usage() const
+{
+	size_t usage = finished_matrix.get_memory_usage() + working_matrix.get_memory_usage();
+	if( finished_halt_index_map )
+	{
+		usage += 65536 * sizeof(uint16);
+	}
+	if( working_halt_index_map )
+	{
+		usage += 65536 * sizeof(uint16);
+	}
+	if( transport_index_map )
+	{
+		usage += 131072 * sizeof(uint16);
+	}
+	usage += ( (size_t)finished_edges.get_size() + working_edges.get_size() ) * sizeof(direct_edge_t);
+	return usage;
+}
+
+
+size_t path_explorer_t::get_total_memory_usage()
+{
+	size_t usage = 0;
+	if( !goods_compartment )
+	{
+		return usage;
+	}
+	for( uint8 ca = 0; ca < max_categories; ++ca )
+	{
+		for( uint8 cl = 0; cl < max_classes; ++cl )
+		{
+			usage += goods_compartment[ca][cl].get_memory_usage();
+		}
+	}
+	return usage;
+}
+
 void path_explorer_t::compartment_t::set_absolute_limits()
 {
 	time_midpoint = get_world()->get_settings().get_path_explorer_time_midpoint();
@@ -1385,23 +2084,16 @@ void path_explorer_t::compartment_t::step()
 			{
 				if (working_halt_count > 0)
 				{
-					// build working matrix
-					working_matrix = new path_element_t*[working_halt_count];
-					for (uint16 i = 0; i < working_halt_count; ++i)
-					{
-						working_matrix[i] = new path_element_t[working_halt_count];
-					}
-
-					// build transport matrix
-					transport_matrix = new transport_element_t*[working_halt_count];
-					for (uint16 i = 0; i < working_halt_count; ++i)
-					{
-						transport_matrix[i] = new transport_element_t[working_halt_count];
-					}
+					// build working matrix together with its transports, re-using storage from previous refreshes
+					working_matrix.init(working_halt_count, true);
 
 					// build transfer list
 					transfer_list = new uint16[working_halt_count];
 				}
+
+				// direct connexions are only needed for incremental refreshes
+				working_edges.clear();
+				working_edges_valid = get_world()->get_settings().get_path_explorer_max_incremental_changes() > 0;
 			}
 
 			// temporary variables
@@ -1475,18 +2167,28 @@ void path_explorer_t::compartment_t::step()
 					}
 
 					// update corresponding matrix element
-					working_matrix[phase_counter][reachable_halt_index].next_transfer = reachable_halt;
-					working_matrix[phase_counter][reachable_halt_index].aggregate_time = current_connexion->waiting_time + current_connexion->journey_time + current_connexion->transfer_time;
-					transport_matrix[phase_counter][reachable_halt_index].first_transport
-						= transport_matrix[phase_counter][reachable_halt_index].last_transport
+					working_matrix.next_transfer(phase_counter, reachable_halt_index) = reachable_halt;
+					working_matrix.aggregate_time(phase_counter, reachable_halt_index) = current_connexion->waiting_time + current_connexion->journey_time + current_connexion->transfer_time;
+					working_matrix.transport(phase_counter, reachable_halt_index).first_transport
+						= working_matrix.transport(phase_counter, reachable_halt_index).last_transport
 						= transport_idx;
 
+					if ( working_edges_valid && reachable_halt_index != phase_counter )
+					{
+						direct_edge_t edge;
+						edge.origin = phase_counter;
+						edge.target = reachable_halt_index;
+						edge.transport = transport_idx;
+						edge.aggregate_time = working_matrix.aggregate_time(phase_counter, reachable_halt_index);
+						working_edges.append(edge);
+					}
+
 					// Debug journey times
-					// printf("\n%s -> %s : %lu \n",current_halt->get_name(), reachable_halt->get_name(), working_matrix[phase_counter][reachable_halt_index].journey_time);
+					// printf("\n%s -> %s : %lu \n",current_halt->get_name(), reachable_halt->get_name(), working_matrix.aggregate_time(phase_counter, reachable_halt_index));
 				}
 
 				// Special case
-				working_matrix[phase_counter][phase_counter].aggregate_time = 0;
+				working_matrix.aggregate_time(phase_counter, phase_counter) = 0;
 
 				++phase_counter;
 
@@ -1544,6 +2246,9 @@ void path_explorer_t::compartment_t::step()
 				statistic_duration = 0;
 				statistic_iteration = 0;
 
+				// if only a few connexions have changed, update the last paths instead of exploring all of them
+				const bool incremental = try_incremental_refresh();
+
 				// delete immediately after use
 				if (working_halt_list)
 				{
@@ -1556,8 +2261,16 @@ void path_explorer_t::compartment_t::step()
 					transport_index_map = NULL;
 				}
 
-				current_phase = phase_explore_paths;	// proceed to the next phase
-				phase_counter = 0;	// reset counter
+				if ( incremental )
+				{
+					++incremental_refresh_count;
+					complete_path_search();
+				}
+				else
+				{
+					current_phase = phase_explore_paths;	// proceed to the next phase
+					phase_counter = 0;	// reset counter
+				}
 
 #ifdef DEBUG_COMPARTMENT_STEP
 				printf("\tTransfer Count :  %lu \n", transfer_count);
@@ -1582,9 +2295,8 @@ void path_explorer_t::compartment_t::step()
 			printf("\t\tCurrent Step : %lu \n", step_count);
 #endif
 			// temporary variables
-			uint32 combined_time;
-			uint32 target_member_index;
 			uint64 iterations_processed = 0;
+			uint64 batch_iterations;
 
 			// initialize only when not resuming
 			if ( via_index == 0 && origin_cluster_index == 0 && target_cluster_index == 0 && origin_member_index == 0 )
@@ -1594,6 +2306,9 @@ void path_explorer_t::compartment_t::step()
 				outbound_connections = new connection_t(64u, working_halt_count);
 			}
 
+			// the cluster map is not saved, so it is rebuilt for the current transfer when resuming
+			bool via_cluster_map_built = false;
+
 			start = dr_time();	// start timing
 
 			// for each transfer
@@ -1607,12 +2322,14 @@ void path_explorer_t::compartment_t::step()
 					process_next_transfer = false;
 
 					// identify halts which are connected with the current transfer halt
+					const uint32 *const via_times = working_matrix.get_aggregate_time_row(via);
+					const transport_element_t *const via_transports = working_matrix.get_transport_row(via);
 					for ( uint16 idx = 0; idx < working_halt_count; ++idx )
 					{
-						if ( working_matrix[via][idx].aggregate_time != UINT32_MAX_VALUE && via != idx )
+						if ( via_times[idx] != UINT32_MAX_VALUE && via != idx )
 						{
-							inbound_connections->register_connection( transport_matrix[idx][via].last_transport, idx );
-							outbound_connections->register_connection( transport_matrix[via][idx].first_transport, idx );
+							inbound_connections->register_connection( working_matrix.transport(idx, via).last_transport, idx );
+							outbound_connections->register_connection( via_transports[idx].first_transport, idx );
 						}
 					}
 
@@ -1621,6 +2338,17 @@ void path_explorer_t::compartment_t::step()
 					total_iterations += (uint32)working_halt_count + ( inbound_connections->get_total_member_count() << 1 );
 				}
 
+				if ( !via_cluster_map_built )
+				{
+					build_via_cluster_map();
+					via_cluster_map_built = true;
+				}
+
+				// collect the units of work for this transfer in the same order and with the same iteration
+				// accounting as they would be processed serially, so that the point where the iteration limit
+				// interrupts the search does not depend on the number of threads
+				batch_iterations = 0;
+
 				// for each origin cluster
 				while ( origin_cluster_index < inbound_connections->get_cluster_count() )
 				{
@@ -1638,36 +2366,25 @@ void path_explorer_t::compartment_t::step()
 							++target_cluster_index;
 							continue;
 						}
-						const vector_tpl<uint16> &target_halt_list = target_cluster.connected_halts;
+						const uint32 target_halt_count = target_cluster.connected_halts.get_count();
 
 						// for each origin cluster member
 						while ( origin_member_index < origin_halt_list.get_count() )
 						{
-							const uint16 origin = origin_halt_list[origin_member_index];
-
-							// for each target cluster member
-							for ( target_member_index = 0; target_member_index < target_halt_list.get_count(); ++target_member_index )
-							{
-								const uint16 target = target_halt_list[target_member_index];
-
-								if ( ( combined_time = working_matrix[origin][via].aggregate_time
-													 + working_matrix[via][target].aggregate_time )
-											< working_matrix[origin][target].aggregate_time			   )
-								{
-									working_matrix[origin][target].aggregate_time = combined_time;
-									working_matrix[origin][target].next_transfer = working_matrix[origin][via].next_transfer;
-									transport_matrix[origin][target].first_transport = transport_matrix[origin][via].first_transport;
-									transport_matrix[origin][target].last_transport = transport_matrix[via][target].last_transport;
-								}
-							}	// loop : target cluster member
+							explore_unit_t unit;
+							unit.origin = origin_halt_list[origin_member_index];
+							unit.target_cluster = target_cluster_index;
+							explore_units.append(unit);
 
 							++origin_member_index;
 
 							// iteration control
-							iterations_processed += target_halt_list.get_count();
-							total_iterations += target_halt_list.get_count();
+							batch_iterations += target_halt_count;
+							iterations_processed += target_halt_count;
+							total_iterations += target_halt_count;
 							if ( use_limits && iterations_processed >= limit_explore_paths )
 							{
+								process_explore_units(via, batch_iterations);
 								goto loop_termination;
 							}
 
@@ -1687,10 +2404,14 @@ void path_explorer_t::compartment_t::step()
 
 				origin_cluster_index = 0;
 
+				// relax all paths through this transfer
+				process_explore_units(via, batch_iterations);
+
 				// clear the inbound/outbound connections
 				inbound_connections->reset();
 				outbound_connections->reset();
 				process_next_transfer = true;
+				via_cluster_map_built = false;
 
 				++via_index;
 			}	// loop : transfer
@@ -1699,6 +2420,8 @@ void path_explorer_t::compartment_t::step()
 
 			diff = dr_time() - start;	// stop timing
 
+			search_iterations += iterations_processed;
+
 			// iterations statistics collection
 			if ( catg == representative_category )
 			{
@@ -1744,72 +2467,11 @@ void path_explorer_t::compartment_t::step()
 				statistic_iteration = 0;
 
 
-				// path search completed -> delete old path info
-				if (finished_matrix)
-				{
-					for (uint16 i = 0; i < finished_halt_count; ++i)
-					{
-						delete[] finished_matrix[i];
-					}
-					delete[] finished_matrix;
-					finished_matrix = NULL;
-				}
-				if (finished_halt_index_map)
-				{
-					delete[] finished_halt_index_map;
-					finished_halt_index_map = NULL;
-				}
-
-				// transfer working to finished
-				finished_matrix = working_matrix;
-				working_matrix = NULL;
-				finished_halt_index_map = working_halt_index_map;
-				working_halt_index_map = NULL;
-				finished_halt_count = working_halt_count;
-				// working_halt_count is reset below after deleting transport matrix
+				// the incremental refreshes which follow are measured against this search
+				finished_search_iterations = search_iterations;
+				incremental_refresh_count = 0;
 
-				// path search completed -> delete auxilliary data structures
-				if (transport_matrix)
-				{
-					for (uint16 i = 0; i < working_halt_count; ++i)
-					{
-						delete[] transport_matrix[i];
-					}
-					delete[] transport_matrix;
-					transport_matrix = NULL;
-				}
-				working_halt_count = 0;
-				if (transfer_list)
-				{
-					delete[] transfer_list;
-					transfer_list = NULL;
-				}
-				transfer_count = 0;
-
-				if (inbound_connections)
-				{
-					delete inbound_connections;
-					inbound_connections = NULL;
-				}
-				if (outbound_connections)
-				{
-					delete outbound_connections;
-					outbound_connections = NULL;
-				}
-				process_next_transfer = true;
-
-				// Debug paths : to execute, working_halt_list should not be deleted in the previous phase
-				// enumerate_all_paths(finished_matrix, working_halt_list, finished_halt_index_map, finished_halt_count);
-
-				current_phase = phase_reroute_goods;	// proceed to the next phase
-
-				// reset counters
-				via_index = 0;
-				origin_cluster_index = 0;
-				target_cluster_index = 0;
-				origin_member_index = 0;
-
-				paths_available = true;
+				complete_path_search();
 			}
 
 			iterations = 0;	// reset iteration counter // desync debug
@@ -1939,7 +2601,7 @@ void path_explorer_t::compartment_t::step()
 }
 
 
-void path_explorer_t::compartment_t::enumerate_all_paths(const path_element_t *const *const matrix, const halthandle_t *const halt_list,
+void path_explorer_t::compartment_t::enumerate_all_paths(const path_matrix_t &matrix, const halthandle_t *const halt_list,
 														 const uint16 *const halt_map, const uint16 halt_count)
 {
 	// Debugging code : Enumerate all paths for validation
@@ -1954,9 +2616,9 @@ void path_explorer_t::compartment_t::enumerate_all_paths(const path_element_t *c
 				// print origin
 				printf("\n\nOrigin :  %s\n", halt_list[x]->get_name());
 
-				transfer_halt = matrix[x][y].next_transfer;
+				transfer_halt = matrix.get_next_transfer(x, y);
 
-				if (matrix[x][y].aggregate_time == UINT32_MAX_VALUE)
+				if (matrix.get_aggregate_time(x, y) == UINT32_MAX_VALUE)
 				{
 					printf("\t\t\t\t******** No Route ********\n");
 				}
@@ -1968,7 +2630,7 @@ void path_explorer_t::compartment_t::enumerate_all_paths(const path_element_t *c
 
 						if ( halt_map[transfer_halt.get_id()] != 65535)
 						{
-							transfer_halt = matrix[ halt_map[transfer_halt.get_id()] ][y].next_transfer;
+							transfer_halt = matrix.get_next_transfer(halt_map[transfer_halt.get_id()], y);
 						}
 						else
 						{
@@ -1995,10 +2657,10 @@ bool path_explorer_t::compartment_t::get_path_between(const halthandle_t origin_
 	if ( paths_available /*&& origin_halt.is_bound() && target_halt.is_bound()*/
 			&& ( origin_index = finished_halt_index_map[ origin_halt.get_id() ] ) != 65535
 			&& ( target_index = finished_halt_index_map[ target_halt.get_id() ] ) != 65535
-			&& finished_matrix[origin_index][target_index].next_transfer.is_bound() )
+			&& finished_matrix.get_next_transfer(origin_index, target_index).is_bound() )
 	{
-		aggregate_time = finished_matrix[origin_index][target_index].aggregate_time;
-		next_transfer = finished_matrix[origin_index][target_index].next_transfer;
+		aggregate_time = finished_matrix.get_aggregate_time(origin_index, target_index);
+		next_transfer = finished_matrix.get_next_transfer(origin_index, target_index);
 		return true;
 	}
 
@@ -2088,6 +2750,15 @@ void path_explorer_t::compartment_t::finalise_connexion_list()
 
 void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 {
+	if (file->is_loading())
+	{
+		// the inputs of the last search are not saved, so the next refresh must be a full one
+		finished_edges.clear();
+		finished_transfers.clear();
+		working_edges.clear();
+		working_edges_valid = false;
+	}
+
 	file->rdwr_longlong(refresh_start_time);
 
 	file->rdwr_short(finished_halt_count);
@@ -2107,48 +2778,27 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 		}
 	}
 
-	bool finished_matrix_live = finished_matrix != NULL;
+	bool finished_matrix_live = finished_matrix.is_in_use();
 	file->rdwr_bool(finished_matrix_live);
 
 	if (finished_matrix_live)
 	{
-		if (file->is_saving())
+		if (file->is_loading() && finished_halt_count > 0)
 		{
-			uint16 tmp_idx;
-			for (uint16 i = 0; i < finished_halt_count; i++)
-			{
-				//  This is a 2 dimensional array
-				for (uint32 j = 0; j < finished_halt_count; j++)
-				{
-					file->rdwr_long(finished_matrix[i][j].aggregate_time);
-					tmp_idx = finished_matrix[i][j].next_transfer.get_id();
-					file->rdwr_short(tmp_idx);
-				}
-			}
+			// Build the (empty) finished matrix
+			finished_matrix.init(finished_halt_count, false);
 		}
-		else // Loading
+
+		//  This is a 2 dimensional array
+		uint16 tmp_idx;
+		for (uint16 i = 0; i < finished_halt_count; i++)
 		{
-			// Create the matrices
-			if (finished_halt_count > 0)
+			for (uint32 j = 0; j < finished_halt_count; j++)
 			{
-				// Build the (empty) finished matrix
-				uint16 tmp_idx;
-				finished_matrix = new path_element_t*[finished_halt_count];
-				for (uint16 i = 0; i < finished_halt_count; ++i)
-				{
-					finished_matrix[i] = new path_element_t[finished_halt_count];
-				}
-
-				// Now load them. These are 2 dimensional arrays.
-				for (uint16 i = 0; i < finished_halt_count; i++)
-				{
-					for (uint32 j = 0; j < finished_halt_count; j++)
-					{
-						file->rdwr_long(finished_matrix[i][j].aggregate_time);
-						file->rdwr_short(tmp_idx);
-						finished_matrix[i][j].next_transfer.set_id(tmp_idx);
-					}
-				}
+				file->rdwr_long(finished_matrix.aggregate_time(i, j));
+				tmp_idx = finished_matrix.next_transfer(i, j).get_id();
+				file->rdwr_short(tmp_idx);
+				finished_matrix.next_transfer(i, j).set_id(tmp_idx);
 			}
 		}
 	}
@@ -2156,62 +2806,30 @@ void path_explorer_t::compartment_t::rdwr(loadsave_t* file)
 	file->rdwr_short(working_halt_count);
 
 	// Working matrix
-	bool working_matrix_live = working_matrix != NULL;
+	bool working_matrix_live = working_matrix.is_in_use();
 	file->rdwr_bool(working_matrix_live);
 
 	if (working_matrix_live)
 	{
-		if (file->is_saving())
+		if (file->is_loading() && working_halt_count > 0)
 		{
-			uint16 tmp_idx;
-			for (uint16 i = 0; i < working_halt_count; i++)
-			{
-				for (uint32 j = 0; j < working_halt_count; j++)
-				{
-					file->rdwr_long(working_matrix[i][j].aggregate_time);
-					tmp_idx = working_matrix[i][j].next_transfer.get_id();
-					file->rdwr_short(tmp_idx);
-
-					file->rdwr_short(transport_matrix[i][j].first_transport);
-					file->rdwr_short(transport_matrix[i][j].last_transport);
-				}
-			}
+			// build working matrix together with its transports
+			working_matrix.init(working_halt_count, true);
 		}
 
-		else // Loading
+		// These are 2 dimensional arrays.
+		uint16 tmp_idx;
+		for (uint16 i = 0; i < working_halt_count; i++)
 		{
-			// Create the matrices
-			if (working_halt_count > 0)
+			for (uint32 j = 0; j < working_halt_count; j++)
 			{
-				// build working matrix
-				uint16 tmp_idx;
-				working_matrix = new path_element_t*[working_halt_count];
-				for (uint16 i = 0; i < working_halt_count; ++i)
-				{
-					working_matrix[i] = new path_element_t[working_halt_count];
-
-				}
-
-				// build transport matrix
-				transport_matrix = new transport_element_t*[working_halt_count];
-				for (uint16 i = 0; i < working_halt_count; ++i)
-				{
-					transport_matrix[i] = new transport_element_t[working_halt_count];
-				}
-
-				// Now load them. These are 2 dimensional arrays.
-				for (uint16 i = 0; i < working_halt_count; i++)
-				{
-					for (uint32 j = 0; j < working_halt_count; j++)
-					{
-						file->rdwr_long(working_matrix[i][j].aggregate_time);
-						file->rdwr_short(tmp_idx);
-						working_matrix[i][j].next_transfer.set_id(tmp_idx);
+				file->rdwr_long(working_matrix.aggregate_time(i, j));
+				tmp_idx = working_matrix.next_transfer(i, j).get_id();
+				file->rdwr_short(tmp_idx);
+				working_matrix.next_transfer(i, j).set_id(tmp_idx);
 
-						file->rdwr_short(transport_matrix[i][j].first_transport);
-						file->rdwr_short(transport_matrix[i][j].last_transport);
-					}
-				}
+				file->rdwr_short(working_matrix.transport(i, j).first_transport);
+				file->rdwr_short(working_matrix.transport(i, j).last_transport);
 			}
 		}
 	}
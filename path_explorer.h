@@ -106,15 +106,6 @@ private:
 
 	private:
 
-		// element used during path search and for storing calculated paths
-		struct path_element_t
-		{
-			uint32 aggregate_time;
-			halthandle_t next_transfer;
-
-			path_element_t() : aggregate_time(UINT32_MAX_VALUE) { }
-		};
-
 		// element used during path search only for storing best lines/convoys
 		struct transport_element_t
 		{
@@ -124,6 +115,72 @@ private:
 			transport_element_t() : first_transport(0), last_transport(0) { }
 		};
 
+		// contiguous storage for a matrix of paths between halts, in structure-of-arrays form :
+		// aggregate times, next transfers and (optionally) transports are kept in separate arrays,
+		// each laid out row by row with rows padded to whole cache lines.
+		// The storage is retained when the matrix is released, so that it can be re-used by the next refresh.
+		class path_matrix_t
+		{
+		private:
+
+			uint32 *aggregate_times;
+			halthandle_t *next_transfers;
+			transport_element_t *transports;	// only allocated for matrices used in path search
+
+			uint32 capacity;	// number of elements allocated in each array
+			uint32 row_stride;	// number of elements between the start of consecutive rows
+			uint16 halt_count;
+			bool in_use;
+
+			// number of elements in a row is rounded up to a multiple of this
+			static const uint32 row_alignment = 16;
+
+			path_matrix_t(const path_matrix_t&);
+			path_matrix_t& operator=(const path_matrix_t&);
+
+		public:
+
+			path_matrix_t() : aggregate_times(NULL), next_transfers(NULL), transports(NULL), capacity(0), row_stride(0), halt_count(0), in_use(false) { }
+
+			~path_matrix_t() { free_storage(); }
+
+			// prepare the matrix for the given number of halts with no paths between them
+			void init(const uint16 count, const bool with_transports);
+
+			// mark the matrix as unused, but keep the storage for re-use
+			void release() { in_use = false; halt_count = 0; }
+
+			// release the matrix and also its storage
+			void free_storage();
+
+			void swap(path_matrix_t &other);
+
+			// make this matrix an exact copy of another one which has transports
+			void copy_from(const path_matrix_t &other);
+
+			bool is_in_use() const { return in_use; }
+			uint16 get_halt_count() const { return halt_count; }
+			uint32 get_row_stride() const { return row_stride; }
+
+			// memory allocated for this matrix in bytes, including retained storage
+			size_t get_memory_usage() const
+			{
+				return (size_t)capacity * ( sizeof(uint32) + sizeof(halthandle_t) + ( transports ? sizeof(transport_element_t) : 0 ) );
+			}
+
+			uint32 *get_aggregate_time_row(const uint16 row) { return aggregate_times + (size_t)row * row_stride; }
+			const uint32 *get_aggregate_time_row(const uint16 row) const { return aggregate_times + (size_t)row * row_stride; }
+			halthandle_t *get_next_transfer_row(const uint16 row) { return next_transfers + (size_t)row * row_stride; }
+			transport_element_t *get_transport_row(const uint16 row) { return transports + (size_t)row * row_stride; }
+			bool has_transports() const { return transports != NULL; }
+
+			uint32 &aggregate_time(const uint16 origin, const uint16 target) { return aggregate_times[(size_t)origin * row_stride + target]; }
+			uint32 get_aggregate_time(const uint16 origin, const uint16 target) const { return aggregate_times[(size_t)origin * row_stride + target]; }
+			halthandle_t &next_transfer(const uint16 origin, const uint16 target) { return next_transfers[(size_t)origin * row_stride + target]; }
+			halthandle_t get_next_transfer(const uint16 origin, const uint16 target) const { return next_transfers[(size_t)origin * row_stride + target]; }
+			transport_element_t &transport(const uint16 origin, const uint16 target) { return transports[(size_t)origin * row_stride + target]; }
+		};
+
 		// structure used for storing indices of halts connected to a transfer, grouped by transport
 		class connection_t
 		{
@@ -240,18 +297,40 @@ private:
 			convoihandle_t convoy;
 		};
 
+		// direct connexion between two halts, as entered into the working matrix before path exploration
+		struct direct_edge_t
+		{
+			uint16 origin;
+			uint16 target;
+			uint16 transport;
+			uint32 aggregate_time;
+
+			bool operator < (const direct_edge_t &other) const
+			{
+				return origin < other.origin || ( origin == other.origin && target < other.target );
+			}
+		};
+
+		// unit of work in path exploration : one origin halt against one outbound cluster of the current transfer
+		// Note : for a fixed transfer, no two units write to the same matrix element, so units may be processed in any order;
+		//        units with the same origin are always processed by the same thread
+		struct explore_unit_t
+		{
+			uint16 origin;
+			uint32 target_cluster;
+		};
+
 		// store the start time of refresh
 		sint64 refresh_start_time;
 
 		// set of variables for finished path data
-		path_element_t **finished_matrix;
+		path_matrix_t finished_matrix;
 		uint16 *finished_halt_index_map;
 		uint16 finished_halt_count;
 
 		// set of variables for working path data
-		path_element_t **working_matrix;
+		path_matrix_t working_matrix;
 		uint16 *transport_index_map;
-		transport_element_t **transport_matrix;
 		uint16 *working_halt_index_map;
 		halthandle_t *working_halt_list;
 		uint16 working_halt_count;
@@ -297,6 +376,25 @@ private:
 		connection_t *outbound_connections;		// relative to the current transfer
 		bool process_next_transfer;
 
+		// units of work collected for the current transfer within the iteration limit
+		vector_tpl<explore_unit_t> explore_units;
+
+		// index of the outbound cluster of each halt relative to the current transfer, or no_cluster
+		uint32 *via_cluster_map;
+		static const uint32 no_cluster = UINT32_MAX_VALUE;
+
+		// direct connexions of the current refresh, collected while filling the working matrix
+		vector_tpl<direct_edge_t> working_edges;
+		bool working_edges_valid;	// false if filling was interrupted by loading a saved game
+		uint64 search_iterations;	// iterations spent on path exploration in the current refresh
+
+		// inputs of the search which produced the finished matrix; these are not saved, so that
+		// the first refresh after loading is always a full one on every client
+		vector_tpl<direct_edge_t> finished_edges;
+		vector_tpl<uint16> finished_transfers;
+		uint64 finished_search_iterations;	// iterations spent by the last full path exploration
+		uint8 incremental_refresh_count;	// consecutive refreshes done incrementally
+
 		// statistics for determining limits
 		uint32 statistic_duration;
 		uint32 statistic_iteration;
@@ -366,7 +464,53 @@ private:
 		static const uint32 percent_lower_limit = 100 - percent_deviation;
 		static const uint32 percent_upper_limit = 100 + percent_deviation;
 
-		void enumerate_all_paths(const path_element_t *const *const matrix, const halthandle_t *const halt_list,
+		// a full path exploration is forced after this many consecutive incremental refreshes
+		static const uint8 max_incremental_refreshes = 16;
+
+		// an incremental refresh is abandoned if more than 1/incremental_row_ratio of the rows need recomputation
+		static const uint32 incremental_row_ratio = 4;
+
+		// minimum number of iterations in a batch of explore units before it is shared with worker threads
+		static const uint32 parallel_explore_threshold = 0x4000;
+
+#ifdef MULTI_THREAD_PATH_EXPLORER
+		// the transfer and the number of tasks of the job of the job scheduler which shares the relaxation step
+		static uint16 explore_paths_via;
+		static uint32 explore_paths_task_count;
+
+		static void explore_paths_task(void *data, uint32 task);
+#endif
+
+		// targets of an explore unit are relaxed as one contiguous span if they fill at least 1/dense_explore_ratio of it
+		static const uint32 dense_explore_ratio = 4;
+
+		// per thread buffers used when relaxing contiguous spans of targets
+		static vector_tpl<uint32*> explore_scratch;
+		static uint32 explore_scratch_size;
+
+		void reserve_explore_scratch(const uint32 thread_count);
+		static void free_explore_scratch();
+
+		// relax the explore units of all origins assigned to the given thread through the transfer via
+		void relax_explore_units(const uint16 via, const uint32 thread_number, const uint32 thread_count);
+
+		// relax all collected explore units, using the worker threads if the batch is large enough
+		void process_explore_units(const uint16 via, const uint64 batch_iterations);
+
+		// fill via_cluster_map from the outbound connections of the current transfer
+		void build_via_cluster_map();
+
+		// update a copy of the finished matrix with the connexions which changed since the last refresh,
+		// instead of exploring all paths; returns false if a full path exploration is needed
+		bool try_incremental_refresh();
+
+		// recompute a row of the working matrix from the direct connexions in working_edges
+		void recompute_row(const uint16 origin, const uint32 *const edge_offsets, const uint8 *const is_transfer, vector_tpl<uint64> &open_list);
+
+		// make the working matrix the finished one and proceed to rerouting goods
+		void complete_path_search();
+
+		void enumerate_all_paths(const path_matrix_t &matrix, const halthandle_t *const halt_list,
 								 const uint16 *const halt_map, const uint16 halt_count);
 
 	public:
@@ -396,6 +540,9 @@ private:
 		uint16 get_transfer_count() const { return transfer_count; }
 		uint32 get_total_iterations() { const uint32 ti = total_iterations; total_iterations = 0; return ti; }
 
+		// memory allocated for path data of this compartment in bytes
+		size_t get_memory_usage() const;
+
 		void set_category(uint8 category);
 		void set_class(uint8 value);
 		void set_refresh() { refresh_requested = true; }
@@ -519,6 +666,8 @@ public:
 	static uint16 get_all_halt_count(uint8 catg, uint8 g_class) { return goods_compartment[catg][g_class].get_all_halt_count(); }
 	static uint16 get_transfer_count(uint8 catg, uint8 g_class) { return goods_compartment[catg][g_class].get_transfer_count(); }
 	static uint32 get_total_iterations(uint8 catg, uint8 g_class) { return goods_compartment[catg][g_class].get_total_iterations(); }
+	static size_t get_memory_usage(uint8 catg, uint8 g_class) { return goods_compartment[catg][g_class].get_memory_usage(); }
+	static size_t get_total_memory_usage();
 
 	inline static void set_absolute_limits_external() { compartment_t::set_absolute_limits();  }
 
@@ -37,6 +37,7 @@
 #include "../dataobj/settings.h"
 #include "../dataobj/scenario.h"
 #include "../dataobj/loadsave.h"
+#include "../dataobj/route_cache.h"
 #include "../dataobj/translator.h"
 #include "../dataobj/environment.h"
 #include "../dataobj/schedule.h"
@@ -1456,6 +1457,7 @@ void player_t::take_over(player_t* target_player)
 			if (player->allows_access_to(target_player->get_player_nr()))
 			{
 				player->set_allow_access_to(get_player_nr(), true);
+				route_cache_t::network_changed();
 			}
 		}
 	}
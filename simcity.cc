@@ -1380,8 +1380,7 @@ bool stadt_t::enlarge_city_borders(ribi_t::ribi direction) {
 		}
 	}
 	// OK, it's safe to expand in this direction.  Do so.
-	lo = new_lo;
-	ur = new_ur;
+	set_city_limits(new_lo, new_ur);
 	// Mark the tiles as owned by this city.
 	for (koord test = test_first; test != test_stop; test = test + test_increment) {
 		planquadrat_t* pl = welt->access(test);
@@ -1428,6 +1427,16 @@ bool stadt_t::enlarge_city_borders() {
 }
 
 
+void stadt_t::set_city_limits(koord new_lo, koord new_ur)
+{
+	const koord old_lo = lo;
+	const koord old_ur = ur;
+	lo = new_lo;
+	ur = new_ur;
+	welt->update_city_limits(this, old_lo, old_ur);
+}
+
+
 bool stadt_t::is_within_city_limits(koord k) const
 {
 	return lo.x <= k.x  &&  ur.x >= k.x  &&  lo.y <= k.y  &&  ur.y >= k.y;
@@ -1558,8 +1567,7 @@ void stadt_t::reset_city_borders()
 			}
 		}
 	}
-	lo = new_lo;
-	ur = new_ur;
+	set_city_limits(new_lo, new_ur);
 	// Remark all city tiles
 	check_city_tiles(false);
 }
@@ -3395,13 +3403,11 @@ class building_place_with_road_finder: public building_placefinder_t
 		// get distance to next special building
 		int find_dist_next_special(koord pos) const
 		{
-			const weighted_vector_tpl<gebaeude_t*>& attractions = welt->get_attractions();
 			int dist = welt->get_size().x * welt->get_size().y;
-			FOR(  weighted_vector_tpl<gebaeude_t*>, const i, attractions  ) {
-				int const d = koord_distance(i->get_pos(), pos);
-				if(  d < dist  ) {
-					dist = d;
-				}
+			vector_tpl<gebaeude_t*> nearest;
+			welt->get_attraction_index().get_nearest(pos, 1, nearest);
+			if(  !nearest.empty()  ) {
+				dist = min(dist, (int)koord_distance(nearest[0]->get_pos(), pos));
 			}
 			FOR(  weighted_vector_tpl<stadt_t *>, const city, welt->get_cities() ) {
 				int const d = koord_distance(city->get_pos(), pos);
@@ -3807,8 +3813,7 @@ void stadt_t::check_bau_townhall(bool new_town)
 			bauer.build();
 		}
 		else if (neugruendung) {
-			lo = best_pos+offset - koord(2, 2);
-			ur = best_pos+offset + koord(desc->get_x(layout), desc->get_y(layout)) + koord(2, 2);
+			set_city_limits(best_pos+offset - koord(2, 2), best_pos+offset + koord(desc->get_x(layout), desc->get_y(layout)) + koord(2, 2));
 		}
 		const koord new_pos = best_pos + offset;
 		if(  pos!=new_pos  ) {
@@ -357,6 +357,9 @@ private:
 	 */
 	bool enlarge_city_borders(ribi_t::ribi direction);
 
+	/// Sets the city limits, and moves the city in the spatial index of the world
+	void set_city_limits(koord new_lo, koord new_ur);
+
 	// calculates the growth rate for next growth_interval using all the different indicators
 	void calc_growth();
 
@@ -68,8 +68,10 @@
 
 #ifdef MULTI_THREAD
 #include "utils/simthread.h"
+#include "utils/job_scheduler.h"
 static pthread_mutex_t step_convois_mutex = PTHREAD_MUTEX_INITIALIZER;
-static vector_tpl<pthread_t> unreserve_threads;
+// only one convoy at a time may unreserve its route
+static pthread_mutex_t unreserve_route_mutex = PTHREAD_MUTEX_INITIALIZER;
 waytype_t convoi_t::current_waytype = road_wt;
 uint16 convoi_t::current_unreserver = 0;
 #endif
@@ -369,6 +371,27 @@ void convoi_t::unreserve_route_range(route_range_specification range)
 	}
 }
 
+void convoi_t::unreserve_route_task(void *, uint32 task)
+{
+	const uint32 task_count = world()->get_parallel_operations() + 1;
+	const uint32 max_count = weg_t::get_all_ways_count() - 1;
+	const uint32 fraction = max_count / task_count;
+
+	route_range_specification range;
+
+	range.start = task * fraction;
+	if (task == task_count - 1)
+	{
+		range.end = max_count;
+	}
+	else
+	{
+		range.end = min(((task + 1) * fraction - 1), max_count);
+	}
+
+	unreserve_route_range(range);
+}
+
 #endif
 
 /**
@@ -379,14 +402,17 @@ void convoi_t::unreserve_route()
 	// Clears all reserved tiles on the whole map belonging to this convoy.
 #ifdef MULTI_THREAD_ROUTE_UNRESERVER
 
+	static job_scheduler_t::job_t unreserve_route_job(&convoi_t::unreserve_route_task, NULL);
+
+	pthread_mutex_lock(&unreserve_route_mutex);
 	current_unreserver = self.get_id();
 	current_waytype = front()->get_waytype();
 
-	simthread_barrier_wait(&karte_t::unreserve_route_barrier);
-	simthread_barrier_wait(&karte_t::unreserve_route_barrier);
+	job_scheduler_t::run(unreserve_route_job, world()->get_parallel_operations() + 1);
 
 	current_unreserver = 0;
 	current_waytype = invalid_wt;
+	pthread_mutex_unlock(&unreserve_route_mutex);
 
 #else
 	FOR(vector_tpl<weg_t*>, const way, weg_t::get_alle_wege())
@@ -785,7 +785,7 @@ public:
 #ifdef MULTI_THREAD
 private:
 	static void unreserve_route_range(route_range_specification range);
-	friend void *unreserve_route_threaded(void* args);
+	static void unreserve_route_task(void *data, uint32 task);
 	static waytype_t current_waytype;
 	static uint16 current_unreserver;
 public:
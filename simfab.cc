@@ -40,6 +40,7 @@
 #include "dataobj/environment.h"
 #include "dataobj/translator.h"
 #include "dataobj/loadsave.h"
+#include "dataobj/road_graph.h"
 
 #include "descriptor/factory_desc.h"
 #include "bauer/hausbauer.h"
@@ -1028,6 +1029,8 @@ void fabrik_t::mark_connected_roads(bool del)
 				else
 				{
 					str->connected_buildings.append_unique(building);
+					// a new destination of private cars
+					road_graph_t::way_changed(str);
 				}
 			}
 		}
@@ -2130,15 +2133,8 @@ bool fabrik_t::is_consumer_active_at(koord consumer_pos ) const
 
 
 
-void fabrik_t::step(uint32 delta_t)
+void fabrik_t::step_production(uint32 delta_t)
 {
-	if(!has_calculated_intransit_percentages)
-	{
-		// Can only do it here (once after loading) as paths
-		// are not available when loading, even in finish_rd
-		calc_max_intransit_percentages();
-	}
-
 	if(  delta_t==0  ) {
 		return;
 	}
@@ -2341,6 +2337,21 @@ void fabrik_t::step(uint32 delta_t)
 	if(  !desc->is_electricity_producer()  ) {
 		power = 0;
 	}
+}
+
+
+void fabrik_t::step_distribution(uint32 delta_t)
+{
+	if(!has_calculated_intransit_percentages)
+	{
+		// Can only do it here (once after loading) as paths
+		// are not available when loading, even in finish_rd
+		calc_max_intransit_percentages();
+	}
+
+	if(  delta_t==0  ) {
+		return;
+	}
 
 	delta_sum += delta_t;
 	if(  delta_sum > PRODUCTION_DELTA_T  ) {
@@ -575,7 +575,17 @@ public:
 	*/
 	bool out_of_stock_selective();
 
-	void step(uint32 delta_t);                  // factory muss auch arbeiten ("factory must also work")
+	/**
+	 * The first half of the factory step: production and consumption of the stock.
+	 * It only changes this factory, so the factories may do it in parallel.
+	 */
+	void step_production(uint32 delta_t);
+
+	/**
+	 * The second half of the factory step, run for one factory after the other:
+	 * distributes the goods to the stops, and expands the factory.
+	 */
+	void step_distribution(uint32 delta_t);
 
 	void new_month();
 
@@ -40,6 +40,8 @@
 #include "dataobj/settings.h"
 #include "dataobj/schedule.h"
 #include "dataobj/loadsave.h"
+#include "dataobj/route_cache.h"
+#include "dataobj/state_hashes.h"
 #include "dataobj/translator.h"
 #include "dataobj/environment.h"
 
@@ -51,6 +53,7 @@
 #include "gui/halt_detail.h"
 #include "gui/minimap.h"
 
+#include "utils/job_scheduler.h"
 #include "utils/simrandom.h"
 #include "utils/simstring.h"
 
@@ -77,22 +80,156 @@ uint8 haltestelle_t::reconnect_counter = 0;
 
 // controls the halt iterator in step_all():
 static bool restart_halt_iterator = true;
+static uint32 next_halt_to_step = 0;
+
+
+/**
+ * A change to an object other than the halt itself, made while halts step on
+ * several threads at once. These are collected for each task, and made once
+ * all halts have stepped, in the order of the halts.
+ */
+struct halt_step_effect_t
+{
+	enum effect_type { deliver, deposit, end_transit, pedestrians, refund };
+
+	uint8 type;
+	ware_t ware;
+	halthandle_t halt;  // the halt to deliver to, else the halt which stepped
+	uint8 walked_between_stations;
+	sint64 refund_amount;
+	linehandle_t line;
+	convoihandle_t convoy;
+
+	halt_step_effect_t() : type(deliver), walked_between_stations(0), refund_amount(0) {}
+
+	halt_step_effect_t(uint8 type, const ware_t &ware, halthandle_t halt, uint8 walked_between_stations = 0) :
+		type(type),
+		ware(ware),
+		halt(halt),
+		walked_between_stations(walked_between_stations),
+		refund_amount(0)
+	{}
+};
+
+// the changes of the halts stepping on this thread, or NULL to make them at once
+static thread_local vector_tpl<halt_step_effect_t> *halt_step_effects = NULL;
+
+
+static void apply_halt_step_effect(const halt_step_effect_t &effect)
+{
+	switch(  effect.type  ) {
+		case halt_step_effect_t::deliver:
+			effect.halt->liefere_an(effect.ware, effect.walked_between_stations);
+			break;
+		case halt_step_effect_t::deposit:
+			world()->deposit_ware_at_destination(effect.ware);
+			break;
+		case halt_step_effect_t::end_transit:
+			fabrik_t::update_transit(effect.ware, false);
+			break;
+		case halt_step_effect_t::pedestrians:
+			pedestrian_t::generate_pedestrians_at(effect.halt->get_basis_pos3d(), effect.ware.menge);
+			break;
+		case halt_step_effect_t::refund:
+			effect.halt->get_owner()->book_revenue(-effect.refund_amount, effect.halt->get_basis_pos(), ignore_wt, ATV_REVENUE_PASSENGER);
+			if(  effect.line.is_bound()  ) {
+				effect.line->book(-effect.refund_amount, LINE_PROFIT);
+				effect.line->book(-effect.refund_amount, LINE_REFUNDS);
+			}
+			else if(  effect.convoy.is_bound()  ) {
+				effect.convoy->book(-effect.refund_amount, convoi_t::CONVOI_PROFIT);
+				effect.convoy->book(-effect.refund_amount, convoi_t::CONVOI_REFUNDS);
+			}
+			break;
+	}
+}
+
+
+static void add_halt_step_effect(const halt_step_effect_t &effect)
+{
+	if(  halt_step_effects  ) {
+		halt_step_effects->append(effect);
+	}
+	else {
+		apply_halt_step_effect(effect);
+	}
+}
+
+
+// the halts to step in this step, shared out in equal parts between the tasks
+static vector_tpl<halthandle_t> halts_to_step;
+static vector_tpl<vector_tpl<halt_step_effect_t> *> effects_of_task;
+
+static void step_halts_task(void *, uint32 task)
+{
+	const uint32 halt_count = halts_to_step.get_count();
+	const uint32 task_count = effects_of_task.get_count();
+
+	vector_tpl<halt_step_effect_t> *const effects = effects_of_task[task];
+	halt_step_effects = effects;
+
+#ifdef MULTI_THREAD
+	// arriving passengers and goods wait in the first list of transferring cargoes of the halt
+	const uint32 thread_number = karte_t::passenger_generation_thread_number;
+	karte_t::passenger_generation_thread_number = 0;
+#endif
+
+	for(  uint32 i = halt_count * task / task_count;  i < halt_count * (task + 1) / task_count;  i++  ) {
+		halts_to_step[i]->step();
+	}
+
+#ifdef MULTI_THREAD
+	karte_t::passenger_generation_thread_number = thread_number;
+#endif
+	halt_step_effects = NULL;
+}
+
+static job_scheduler_t::job_t step_halts_job(&step_halts_task, NULL);
+
 
 void haltestelle_t::step_all()
 {
 	const uint32 count = alle_haltestellen.get_count();
 	if (count)
 	{
-		const uint32 loops = min(count, 256u);
-		static vector_tpl<halthandle_t>::iterator iter;
+		// The number of threads is the same on all clients of a network game.
+		const uint32 threads = max(welt->get_parallel_operations(), 0) + 1;
+		const uint32 loops = min(count, welt->get_settings().get_halt_steps_per_thread() * threads);
+		if (restart_halt_iterator)
+		{
+			restart_halt_iterator = false;
+			next_halt_to_step = 0;
+		}
+		halts_to_step.clear();
 		for (uint32 i = 0; i < loops; ++i)
 		{
-			if (restart_halt_iterator || iter == alle_haltestellen.end())
+			if (next_halt_to_step >= count)
+			{
+				next_halt_to_step = 0;
+			}
+			halts_to_step.append(alle_haltestellen[next_halt_to_step++]);
+		}
+
+		const uint32 task_count = min(threads, loops);
+		while (effects_of_task.get_count() < task_count)
+		{
+			effects_of_task.append(new vector_tpl<halt_step_effect_t>());
+		}
+		while (effects_of_task.get_count() > task_count)
+		{
+			delete effects_of_task.pop_back();
+		}
+
+		job_scheduler_t::run(step_halts_job, task_count);
+
+		// The halts may only affect each other now, in the order in which they stepped.
+		FOR(vector_tpl<vector_tpl<halt_step_effect_t> *>, effects, effects_of_task)
+		{
+			FOR(vector_tpl<halt_step_effect_t>, const& effect, *effects)
 			{
-				restart_halt_iterator = false;
-				iter = alle_haltestellen.begin();
+				apply_halt_step_effect(effect);
 			}
-			(*iter++)->step();
+			effects->clear();
 		}
 	}
 }
@@ -1241,7 +1378,7 @@ void haltestelle_t::check_transferring_cargoes()
 					// This is the final destination: register the cargoes
 					// at their ultimate end point.
 
-					world()->deposit_ware_at_destination(ware);
+					add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::deposit, ware, self));
 					resort_freight_info = true;
 				}
 				else if (removed)
@@ -1314,7 +1451,7 @@ void haltestelle_t::step()
 				if(!gb || (tmp.is_freight() && !fab))
 				{
 					// The goods/passengers leave.  We must record the lower "in transit" count on factories.
-					fabrik_t::update_transit(tmp, false);
+					add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::end_transit, tmp, self));
 					tmp.menge = 0;
 
 					// No need to record waiting times if the goods are discarded because their destination
@@ -1356,9 +1493,9 @@ void haltestelle_t::step()
 							if(tmp.get_zwischenziel().is_bound() && shortest_distance(get_next_pos(tmp.get_zwischenziel()->get_basis_pos()), get_next_pos(tmp.get_zwischenziel()->get_basis_pos())) <= max_walking_distance)
 							{
 								// Passengers can walk to their next transfer.
-								pedestrian_t::generate_pedestrians_at(get_basis_pos3d(), tmp.menge);
+								add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::pedestrians, tmp, self));
 								tmp.set_last_transfer(self);
-								tmp.get_zwischenziel()->liefere_an(tmp, 1);
+								add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::deliver, tmp, tmp.get_zwischenziel(), 1));
 								passengers_walked = true;
 							}
 
@@ -1381,25 +1518,16 @@ void haltestelle_t::step()
 							{
 								const uint32 distance_meters = (uint32) distance * welt->get_settings().get_meters_per_tile();
 								// Refund is approximation: 2x distance at standard rate with no adjustments.
-								const sint64 refund_amount = (tmp.menge * tmp.get_desc()->get_refund(distance_meters) + 2048ll) / 4096ll;
+								halt_step_effect_t refund(halt_step_effect_t::refund, tmp, self);
+								refund.refund_amount = (tmp.menge * tmp.get_desc()->get_refund(distance_meters) + 2048ll) / 4096ll;
 
-								owner->book_revenue(-refund_amount, get_basis_pos(), ignore_wt, ATV_REVENUE_PASSENGER);
 								// Find the line the pasenger was *trying to go on* -- make it pay the refund
-								linehandle_t account_line = get_preferred_line(tmp.get_zwischenziel(), tmp.get_catg(), tmp.get_class());
-								if(account_line.is_bound())
-								{
-									account_line->book(-refund_amount, LINE_PROFIT);
-									account_line->book(-refund_amount, LINE_REFUNDS);
-								}
-								else
+								refund.line = get_preferred_line(tmp.get_zwischenziel(), tmp.get_catg(), tmp.get_class());
+								if(!refund.line.is_bound())
 								{
-									convoihandle_t account_convoy = get_preferred_convoy(tmp.get_zwischenziel(), tmp.get_catg(), tmp.get_class());
-									if(account_convoy.is_bound())
-									{
-										account_convoy->book(-refund_amount, convoi_t::CONVOI_PROFIT);
-										account_convoy->book(-refund_amount, convoi_t::CONVOI_REFUNDS);
-									}
+									refund.convoy = get_preferred_convoy(tmp.get_zwischenziel(), tmp.get_catg(), tmp.get_class());
 								}
+								add_halt_step_effect(refund);
 							}
 						}
 
@@ -1413,7 +1541,7 @@ void haltestelle_t::step()
 						add_waiting_time(waiting_tenths, tmp.get_zwischenziel(), tmp.get_desc()->get_catg_index(), tmp.get_class());
 
 						// The goods/passengers leave.  We must record the lower "in transit" count on factories.
-						fabrik_t::update_transit(tmp, false);
+						add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::end_transit, tmp, self));
 						tmp.menge = 0;
 
 						// Normally we record long waits below, but we just did, so don't do it twice.
@@ -1557,8 +1685,8 @@ uint32 haltestelle_t::reroute_goods(const uint8 catg)
 			   && !get_preferred_convoy(ware.get_zwischenziel(), 0, ware.get_class()).is_bound()
 			   && !get_preferred_line(ware.get_zwischenziel(), 0, ware.get_class()).is_bound())
 			{
-				pedestrian_t::generate_pedestrians_at(get_basis_pos3d(), ware.menge);
-				ware.get_zwischenziel()->liefere_an(ware, 1); // start counting walking steps at 1 again
+				add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::pedestrians, ware, self));
+				add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::deliver, ware, ware.get_zwischenziel(), 1)); // start counting walking steps at 1 again
 				continue;
 			}
 
@@ -1592,7 +1720,7 @@ uint32 haltestelle_t::reroute_goods(const uint8 catg)
 								const fabrik_t* fab = building ? building->get_fabrik() : NULL;
 								if (fab)
 								{
-									fab->update_transit(ware, false);
+									add_halt_step_effect(halt_step_effect_t(halt_step_effect_t::end_transit, ware, self));
 								}
 							}
 						}
@@ -2842,6 +2970,29 @@ uint32 haltestelle_t::get_ware_summe(const goods_desc_t *wtyp, uint8 g_class, bo
 	return sum;
 }
 
+uint32 haltestelle_t::get_cargo_hash() const
+{
+	// summed up, since the order of the goods in the lists does not matter
+	uint32 sum = 0;
+	for(  uint8 i = 0;  i < goods_manager_t::get_max_catg_index();  i++  ) {
+		if(  cargo[i]  ) {
+			FOR(vector_tpl<ware_t>, const& ware, *cargo[i]) {
+				uint32 hash = state_hashes_t::start;
+				hash = state_hashes_t::mix(hash, ware.menge);
+				hash = state_hashes_t::mix(hash, ware.get_index());
+				hash = state_hashes_t::mix(hash, ware.get_class());
+				hash = state_hashes_t::mix(hash, ware.get_ziel().get_id());
+				hash = state_hashes_t::mix(hash, ware.get_zwischenziel().get_id());
+				hash = state_hashes_t::mix(hash, ware.get_origin().get_id());
+				hash = state_hashes_t::mix(hash, ((uint32)(uint16)ware.get_zielpos().y << 16) | (uint16)ware.get_zielpos().x);
+				sum += state_hashes_t::finish(hash);
+			}
+		}
+	}
+	return sum;
+}
+
+
 uint32 haltestelle_t::get_transferring_goods_sum(const goods_desc_t *wtyp, uint8 g_class) const
 {
 	if (g_class != 255 && g_class >= wtyp->get_number_of_classes()) {
@@ -5272,6 +5423,9 @@ bool haltestelle_t::add_grund(grund_t *gr, bool relink_factories, bool recalc_ne
 	gr->set_halt( self );
 	tiles.append( gr );
 
+	// routes of convoys run on to the end of their platforms
+	route_cache_t::network_changed();
+
 	// add to hashtable
 	if (all_koords) {
 		sint32 n = get_halt_key( gr->get_pos(), welt->get_size().y );
@@ -5415,6 +5569,7 @@ bool haltestelle_t::rem_grund(grund_t *gr)
 	}
 
 	station_signals.remove(gr->get_pos());
+	route_cache_t::network_changed();
 
 	slist_tpl<tile_t>::iterator i = std::find(tiles.begin(), tiles.end(), gr);
 	if (i == tiles.end()) {
@@ -71,7 +71,9 @@
 #include "sound/sound.h"
 
 #include "utils/cbuffer_t.h"
+#include "utils/csv.h"
 #include "utils/simrandom.h"
+#include "utils/step_profiler.h"
 
 #include "bauer/vehikelbauer.h"
 
@@ -146,6 +148,36 @@ static void show_times(karte_t *welt, main_view_t *view)
 	}
 	dbg->message( "display_color_img()", "3x %i iterations took %li ms", i, dr_time() - ms );
 
+	// the blend and alpha routines, in pixels per second to compare them between versions
+	scr_coord_val xoff, yoff, w, h;
+	display_get_image_offset( img, &xoff, &yoff, &w, &h );
+	const double img_pixels = (double)w * h;
+
+	const struct {
+		const char *name;
+		FLAGGED_PIXVAL color_index;
+	} blends[] = {
+		{ "display_img_blend() 25%", TRANSPARENT25_FLAG },
+		{ "display_img_blend() 50%", TRANSPARENT50_FLAG },
+		{ "display_img_blend() 75%", TRANSPARENT75_FLAG },
+		{ "display_img_blend() outline 50%", (FLAGGED_PIXVAL)(TRANSPARENT50_FLAG | OUTLINE_FLAG | color_idx_to_rgb(COL_WHITE)) }
+	};
+	for(  uint32 b = 0;  b < lengthof(blends);  b++  ) {
+		ms = dr_time();
+		for (i = 0;  i < 1000000;  i++) {
+			display_img_blend( img, 50, 50, blends[b].color_index, true, true );
+		}
+		const long blend_ms = dr_time() - ms;
+		dbg->message( blends[b].name, "%i iterations took %li ms, %.0f Mpixels/s", i, blend_ms, img_pixels * i / (blend_ms + 1) / 1000.0 );
+	}
+
+	ms = dr_time();
+	for (i = 0;  i < 1000000;  i++) {
+		display_img_alpha( img, img, ALPHA_RED | ALPHA_GREEN | ALPHA_BLUE, 50, 50, 0, true, true );
+	}
+	const long alpha_ms = dr_time() - ms;
+	dbg->message( "display_img_alpha()", "%i iterations took %li ms, %.0f Mpixels/s", i, alpha_ms, img_pixels * i / (alpha_ms + 1) / 1000.0 );
+
 	ms = dr_time();
 	for (i = 0;  i < 600000;  i++) {
 		dr_prepare_flush();
@@ -197,6 +229,69 @@ static void show_times(karte_t *welt, main_view_t *view)
 #endif
 
 
+/**
+ * Writes the results of -benchmark as CSV. The checksum digests the checklist of
+ * the final state, so runs of different builds can be compared at a glance.
+ */
+static void write_benchmark_report(karte_t *welt, const char *filename, uint32 months, uint32 wall_ms)
+{
+	const checklist_t checklist = welt->calc_checklist();
+	uint32 checksum = 2166136261u; // FNV-1a
+	const uint32 values[] = { checklist.st, checklist.random_seed, checklist.halt_entry, checklist.line_entry, checklist.convoy_entry };
+	for(  uint32 i = 0;  i < lengthof(values);  i++  ) {
+		checksum = (checksum ^ values[i]) * 16777619u;
+	}
+	for(  uint32 i = 0;  i < CHK_RANDS;  i++  ) {
+		checksum = (checksum ^ checklist.rand[i]) * 16777619u;
+	}
+	for(  uint32 i = 0;  i < CHK_DEBUG_SUMS;  i++  ) {
+		checksum = (checksum ^ checklist.debug_sum[i]) * 16777619u;
+	}
+
+	const uint32 steps = step_profiler_t::get_total_steps();
+	char buf[64];
+	CSV_t csv;
+	csv.add_field("measure");
+	csv.add_field("value");
+	csv.new_line();
+	csv.add_field("months");
+	csv.add_field((int)months);
+	csv.new_line();
+	csv.add_field("steps");
+	csv.add_field((int)steps);
+	csv.new_line();
+	csv.add_field("wall time (ms)");
+	csv.add_field((int)wall_ms);
+	csv.new_line();
+	sprintf(buf, "%.2f", steps * 1000.0 / max(1u, wall_ms));
+	csv.add_field("steps per second");
+	csv.add_field(buf);
+	csv.new_line();
+	csv.add_field("peak memory (KiB)");
+	csv.add_field((int)(dr_get_peak_memory() / 1024));
+	csv.new_line();
+	sprintf(buf, "%08x", checksum);
+	csv.add_field("checksum");
+	csv.add_field(buf);
+	csv.new_line();
+	for(  uint8 phase = 0;  phase < step_profiler_t::MAX_PHASES;  phase++  ) {
+		sprintf(buf, "%.3f", step_profiler_t::get_total_ms(phase));
+		csv.add_field(step_profiler_t::get_name(phase));
+		csv.add_field(buf);
+		csv.new_line();
+	}
+
+	FILE *file = dr_fopen(filename, "w");
+	if(  !file  ) {
+		dbg->warning("write_benchmark_report()", "Cannot write the benchmark results to '%s'", filename);
+		return;
+	}
+	fputs(csv.get_str(), file);
+	fclose(file);
+	dbg->message("write_benchmark_report()", "%u steps in %u ms, checksum %08x", steps, wall_ms, checksum);
+}
+
+
 void modal_dialogue( gui_frame_t *gui, ptrdiff_t magic, karte_t *welt, bool (*quit)() )
 {
 	if(  display_get_width()==0  ) {
@@ -460,6 +555,15 @@ int simu_main(int argc, char** argv)
 			"command line parameters available: \n"
 			" -addons             loads also addons (with -objects)\n"
 			" -async              asynchronous images, only for SDL\n"
+			" -benchmark MONTHS FILE\n"
+			"                     runs the game given by -load for MONTHS months in fast\n"
+			"                     forward without drawing, writes the times to FILE (CSV)\n"
+			"                     and quits; best built with the 'none' display backend\n"
+#ifdef MULTI_THREAD
+			" -benchmark_passengers N\n"
+			"                     generates N packets of passengers with 1, 2, ... threads\n"
+			"                     after loading, and prints the packets per second\n"
+#endif
 			" -use_hw             hardware double buffering, only for SDL\n"
 			" -debug NUM          enables debugging (1..5)\n"
 			" -easyserver         set up every for server (query own IP, port forwarding)\n"
@@ -482,6 +586,7 @@ int simu_main(int argc, char** argv)
 			" -objects DIR_NAME/  load the pakset in specified directory\n"
 			" -pause              starts game with paused after loading\n"
 			"                     a server will pause if there are no clients, even if this be not specified in simuconf.tab\n"
+			" -profile_steps FILE writes the times of the phases of each step to FILE (CSV)\n"
 			" -res N              starts in specified resolution: \n"
 			"                      1=640x480, 2=800x600, 3=1024x768, 4=1280x1024\n"
 			" -screensize WxH     set screensize to width W and height H\n"
@@ -1266,6 +1371,10 @@ int simu_main(int argc, char** argv)
 		env_t::server_runs_background_tasks_when_paused = true;
 	}
 
+	if(  const char *filename = gimme_arg(argc, argv, "-profile_steps", 1)  ) {
+		step_profiler_t::open_csv(filename);
+	}
+
 	if(  gimme_arg(argc, argv, "-load", 0) != NULL  ) {
 		cbuffer_t buf;
 		dr_chdir( env_t::user_dir );
@@ -1513,6 +1622,38 @@ int simu_main(int argc, char** argv)
 	}
 #endif
 
+#ifdef MULTI_THREAD
+	// measure how the passenger generation scales with the threads?
+	if(  const char *ref_str = gimme_arg(argc, argv, "-benchmark_passengers", 1)  ) {
+		if(  env_t::networkmode  ) {
+			dbg->warning("simu_main()", "The passenger generation benchmark is not available in network games");
+		}
+		else {
+			welt->benchmark_passenger_generation(max(1, atoi(ref_str)));
+		}
+	}
+#endif
+
+	// run a loaded game for some months as fast as possible?
+	const char *benchmark_file = NULL;
+	uint32 benchmark_months = 0;
+	uint32 benchmark_start = 0;
+	if(  const char *months = gimme_arg(argc, argv, "-benchmark", 1)  ) {
+		if(  new_world  ||  env_t::networkmode  ) {
+			dbg->warning("simu_main()", "The benchmark needs a savegame given by -load, and is not available in network games");
+		}
+		else if(  (benchmark_file = gimme_arg(argc, argv, "-benchmark", 2)) == NULL  ) {
+			dbg->warning("simu_main()", "No file given for the results of the benchmark");
+		}
+		else {
+			benchmark_months = max(1, atoi(months));
+			quit_month = welt->get_current_month() + benchmark_months;
+			welt->set_fast_forward(true);
+			step_profiler_t::start_totals();
+			benchmark_start = dr_time();
+		}
+	}
+
 	welt->reset_timer();
 	if(  !env_t::networkmode  &&  !env_t::server  &&  new_world  ) {
 #ifdef display_in_main
@@ -1602,6 +1743,10 @@ int simu_main(int argc, char** argv)
 
 	intr_disable();
 
+	if(  benchmark_months > 0  ) {
+		write_benchmark_report(welt, benchmark_file, benchmark_months, dr_time() - benchmark_start);
+	}
+
 	// save setting ...
 	dr_chdir( env_t::user_dir );
 	if(  file.wr_open(xml_filename,loadsave_t::xml,0,"settings only/",SAVEGAME_VER_NR, EXTENDED_VER_NR, EXTENDED_REVISION_NR)==loadsave_t::FILE_STATUS_OK   ) {
@@ -1616,6 +1761,8 @@ int simu_main(int argc, char** argv)
 	delete welt;
 	welt = NULL;
 
+	step_profiler_t::close_csv();
+
 	delete view;
 	view = NULL;
 
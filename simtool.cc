@@ -78,6 +78,7 @@
 #include "dataobj/environment.h"
 #include "dataobj/schedule.h"
 #include "dataobj/route.h"
+#include "dataobj/route_cache.h"
 #include "dataobj/replace_data.h"
 #include "dataobj/scenario.h"
 #include "network/network_cmd_ingame.h" // for dragging raise / lower tools
@@ -9903,6 +9904,7 @@ bool tool_access_t::init(player_t *)
 	}
 
 	setting_player->set_allow_access_to(id_receiving_player, allow_access);
+	route_cache_t::network_changed();
 	if(allow_access == false)
 	{
 		// If access is withdrawn, the routing/scheduling must be updated to take account of the fact
@@ -89,10 +89,15 @@
 #include "dataobj/environment.h"
 #include "dataobj/powernet.h"
 #include "dataobj/marker.h"
+#include "dataobj/road_graph.h"
+#include "dataobj/landmark_table.h"
+#include "dataobj/route_cache.h"
 
 #include "utils/cbuffer_t.h"
 #include "utils/simrandom.h"
 #include "utils/simstring.h"
+#include "utils/job_scheduler.h"
+#include "utils/step_profiler.h"
 
 #include "network/memory_rw.h"
 
@@ -123,41 +128,48 @@
 #ifdef MULTI_THREAD
 #include "utils/simthread.h"
 
+// The searches for private car routes pause in the middle of a route between steps, so these keep their own threads.
 static vector_tpl<pthread_t> private_car_route_threads;
-static vector_tpl<pthread_t> unreserve_route_threads;
-static vector_tpl<pthread_t> step_passengers_and_mail_threads;
-static vector_tpl<pthread_t> individual_convoy_step_threads;
-static vector_tpl<pthread_t> path_explorer_threads;
-static pthread_t convoy_step_master_thread;
-static pthread_t path_explorer_thread;
 
 static pthread_attr_t thread_attributes;
 static pthread_mutexattr_t mutex_attributes;
 
 //static pthread_mutex_t private_car_route_mutex = PTHREAD_MUTEX_INITIALIZER;
 //pthread_mutex_t karte_t::step_passengers_and_mail_mutex = PTHREAD_MUTEX_INITIALIZER;
-//static pthread_mutex_t path_explorer_await_mutex = PTHREAD_MUTEX_INITIALIZER;
-//pthread_mutex_t karte_t::unreserve_route_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 pthread_mutex_t karte_t::private_car_route_mutex;
 bool karte_t::private_car_route_mutex_initialised;
 pthread_mutex_t karte_t::step_passengers_and_mail_mutex;
-static pthread_mutex_t path_explorer_await_mutex;
-pthread_mutex_t karte_t::unreserve_route_mutex;
 
 simthread_barrier_t karte_t::private_car_barrier;
-simthread_barrier_t karte_t::unreserve_route_barrier;
-static simthread_barrier_t step_passengers_and_mail_barrier;
-static simthread_barrier_t path_explorer_barrier;
-static simthread_barrier_t step_convoys_barrier_internal;
-simthread_barrier_t karte_t::step_convoys_barrier_external;
+
+// All other parallel work runs as jobs of the job scheduler.
+void step_passengers_and_mail_task(void *data, uint32 task);
+void step_convoys_task(void *data, uint32 task);
+void path_explorer_task(void *data, uint32 task);
+
+static job_scheduler_t::job_t step_passengers_and_mail_job(&step_passengers_and_mail_task, NULL);
+static job_scheduler_t::job_t step_convoys_job(&step_convoys_task, NULL);
+static job_scheduler_t::job_t path_explorer_job(&path_explorer_task, NULL);
+
+// The passengers and mail which each task generates in a step, and its random numbers
+struct passenger_generation_task_t
+{
+	sint32 next_step_passenger;
+	sint32 next_step_mail;
+	sint32 total_units_passenger;
+	sint32 total_units_mail;
+	simrand_state_t random;
+};
+
+static vector_tpl<passenger_generation_task_t> passenger_generation_tasks;
 
 bool karte_t::threads_initialised = false;
 
 thread_local uint32 karte_t::passenger_generation_thread_number;
 thread_local uint32 karte_t::marker_index = UINT32_MAX_VALUE;
 
-vector_tpl<convoihandle_t> convoys_next_step;
+vector_tpl<convoihandle_t> karte_t::convoys_next_step;
 
 vector_tpl<pedestrian_t*> *karte_t::pedestrians_added_threaded;
 vector_tpl<private_car_t*> *karte_t::private_cars_added_threaded;
@@ -172,6 +184,132 @@ vector_tpl<halthandle_t> karte_t::destination_list;
 #endif
 
 
+// A figure which the passenger generation books on a city, a building, a factory or a stop
+struct passenger_statistic_t
+{
+	enum type_t {
+		city_generated,         // detail is the history type
+		city_private_car_trip,  // other_city is the destination town
+		city_walked,
+		city_transported_mail,
+		city_destination,       // marks pos in color on the destination map of the city
+		building_generated_commuting,
+		building_generated_visiting,
+		building_generated_mail,
+		building_succeeded_commuting,
+		building_succeeded_visiting,
+		building_succeeded_mail,
+		factory_mail_departed,
+		halt_unhappy,
+		halt_too_slow,
+		halt_no_route,
+		halt_mail_no_route,
+		debug_sum_generated
+	};
+
+	uint8 type;
+	uint32 amount;
+	sint32 detail;
+	stadt_t *city;
+	stadt_t *other_city;
+	gebaeude_t *building;
+	fabrik_t *fab;
+	halthandle_t halt;
+	koord pos;
+	PIXVAL color;
+
+	passenger_statistic_t() : type(city_generated), amount(0), detail(0), city(NULL), other_city(NULL), building(NULL), fab(NULL), pos(koord::invalid), color(0) {}
+	passenger_statistic_t(uint8 type, uint32 amount) : type(type), amount(amount), detail(0), city(NULL), other_city(NULL), building(NULL), fab(NULL), pos(koord::invalid), color(0) {}
+};
+
+static void apply_passenger_statistic(const passenger_statistic_t &statistic)
+{
+	const uint32 amount = statistic.amount;
+	switch(  statistic.type  ) {
+		case passenger_statistic_t::city_generated:          statistic.city->set_generated_passengers(amount, statistic.detail); break;
+		case passenger_statistic_t::city_private_car_trip:   statistic.city->set_private_car_trip(amount, statistic.other_city); break;
+		case passenger_statistic_t::city_walked:             statistic.city->add_walking_passengers(amount); break;
+		case passenger_statistic_t::city_transported_mail:   statistic.city->add_transported_mail(amount); break;
+		case passenger_statistic_t::city_destination:        statistic.city->merke_passagier_ziel(statistic.pos, statistic.color); break;
+		case passenger_statistic_t::building_generated_commuting: statistic.building->add_passengers_generated_commuting(amount); break;
+		case passenger_statistic_t::building_generated_visiting:  statistic.building->add_passengers_generated_visiting(amount); break;
+		case passenger_statistic_t::building_generated_mail:      statistic.building->add_mail_generated(amount); break;
+		case passenger_statistic_t::building_succeeded_commuting: statistic.building->add_passengers_succeeded_commuting(amount); break;
+		case passenger_statistic_t::building_succeeded_visiting:  statistic.building->add_passengers_succeeded_visiting(amount); break;
+		case passenger_statistic_t::building_succeeded_mail:      statistic.building->add_mail_delivery_succeeded(amount); break;
+		case passenger_statistic_t::factory_mail_departed:   statistic.fab->book_stat(amount, FAB_MAIL_DEPARTED); break;
+		case passenger_statistic_t::debug_sum_generated:     world()->add_to_debug_sums(5, amount); break;
+		default:
+			// the stop may have been removed since
+			if(  statistic.halt.is_bound()  ) {
+				switch(  statistic.type  ) {
+					case passenger_statistic_t::halt_unhappy:       statistic.halt->add_pax_unhappy(amount); break;
+					case passenger_statistic_t::halt_too_slow:      statistic.halt->add_pax_too_slow(amount); break;
+					case passenger_statistic_t::halt_no_route:      statistic.halt->add_pax_no_route(amount); break;
+					case passenger_statistic_t::halt_mail_no_route: statistic.halt->add_mail_no_route(amount); break;
+				}
+			}
+	}
+}
+
+#ifdef MULTI_THREAD
+// The figures booked by each passenger generation task, added up in the order of the tasks once all have finished.
+// Thus the tasks need not wait for each other, and the figures are the same on all clients of a network game.
+static vector_tpl<passenger_statistic_t> *passenger_statistics = NULL;
+static thread_local vector_tpl<passenger_statistic_t> *booked_passenger_statistics = NULL;
+#endif
+
+static void book_passenger_statistic(const passenger_statistic_t &statistic)
+{
+#ifdef MULTI_THREAD
+	if(  booked_passenger_statistics  ) {
+		booked_passenger_statistics->append(statistic);
+		return;
+	}
+#endif
+	apply_passenger_statistic(statistic);
+}
+
+static void book_city_statistic(uint8 type, stadt_t *city, uint32 amount, sint32 detail = 0, stadt_t *other_city = NULL)
+{
+	passenger_statistic_t statistic(type, amount);
+	statistic.city = city;
+	statistic.detail = detail;
+	statistic.other_city = other_city;
+	book_passenger_statistic(statistic);
+}
+
+static void book_passenger_destination(stadt_t *city, koord pos, PIXVAL color)
+{
+	passenger_statistic_t statistic(passenger_statistic_t::city_destination, 0);
+	statistic.city = city;
+	statistic.pos = pos;
+	statistic.color = color;
+	book_passenger_statistic(statistic);
+}
+
+static void book_building_statistic(uint8 type, gebaeude_t *building, uint32 amount)
+{
+	passenger_statistic_t statistic(type, amount);
+	statistic.building = building;
+	book_passenger_statistic(statistic);
+}
+
+static void book_halt_statistic(uint8 type, halthandle_t halt, uint32 amount)
+{
+	passenger_statistic_t statistic(type, amount);
+	statistic.halt = halt;
+	book_passenger_statistic(statistic);
+}
+
+static void book_mail_departed(fabrik_t *fab, uint32 amount)
+{
+	passenger_statistic_t statistic(passenger_statistic_t::factory_mail_departed, amount);
+	statistic.fab = fab;
+	book_passenger_statistic(statistic);
+}
+
+
 static uint32 last_clients = -1;
 static uint8 last_active_player_nr = 0;
 static std::string last_network_game;
@@ -181,65 +319,36 @@ karte_t* karte_t::world = NULL;
 stringhashtable_tpl<karte_t::missing_level_t, N_BAGS_MEDIUM>missing_pak_names;
 
 #ifdef MULTI_THREAD
-#include "utils/simthread.h"
-#include <semaphore.h>
-
-bool spawned_world_threads=false; // global job indicator array
-static simthread_barrier_t world_barrier_start;
-static simthread_barrier_t world_barrier_end;
-
-
-// to start a thread
-typedef struct{
+// the bands of rows of a world_xy_loop()
+struct world_xy_loop_job_t
+{
 	karte_t *welt;
-	int thread_num;
+	xy_loop_func function;
 	sint16 x_step;
 	sint16 x_world_max;
-	sint16 y_min;
-	sint16 y_max;
-	sem_t* wait_for_previous;
-	sem_t* signal_to_next;
-	xy_loop_func function;
-	bool keep_running;
-} world_thread_param_t;
+	sint16 y_world_max;
+	uint32 band_count;
+	sint32 wave; // with SYNCX_FLAG, the band b processes the block (wave - b)
+};
 
 
-// now the parameters
-static world_thread_param_t world_thread_param[MAX_THREADS];
-
-void *karte_t::world_xy_loop_thread(void *ptr)
+void karte_t::world_xy_loop_task(void *data, uint32 band)
 {
-	world_thread_param_t *param = reinterpret_cast<world_thread_param_t *>(ptr);
-	while(true) {
-		if(param->keep_running) {
-			simthread_barrier_wait( &world_barrier_start ); // wait for all to start
-		}
+	const world_xy_loop_job_t &job = *reinterpret_cast<const world_xy_loop_job_t *>(data);
+	const sint16 y_min = (band * job.y_world_max) / job.band_count;
+	const sint16 y_max = ((band + 1) * job.y_world_max) / job.band_count;
 
-		sint16 x_min = 0;
-		sint16 x_max = param->x_step;
-
-		while(  x_min < param->x_world_max  ) {
-			// wait for predecessor to finish its block
-			if(  param->wait_for_previous  ) {
-				sem_wait( param->wait_for_previous );
-			}
-			(param->welt->*(param->function))(x_min, x_max, param->y_min, param->y_max);
-
-			// signal to next thread that we finished one block
-			if(  param->signal_to_next  ) {
-				sem_post( param->signal_to_next );
-			}
-			x_min = x_max;
-			x_max = min(x_max + param->x_step, param->x_world_max);
-		}
-
-		if(param->keep_running) {
-			simthread_barrier_wait( &world_barrier_end ); // wait for all to finish
-		}
-		else {
-			return NULL;
+	sint16 x_min = 0;
+	sint16 x_max = job.x_world_max;
+	if(  job.wave >= 0  ) {
+		const sint32 block = job.wave - (sint32)band;
+		x_min = block * job.x_step;
+		if(  block < 0  ||  x_min >= job.x_world_max  ) {
+			return;
 		}
+		x_max = min(x_min + job.x_step, job.x_world_max);
 	}
+	(job.welt->*(job.function))(x_min, x_max, y_min, y_max);
 }
 #endif
 
@@ -254,61 +363,27 @@ void karte_t::world_xy_loop(xy_loop_func function, uint8 flags)
 
 	const bool sync_x_steps = (flags & SYNCX_FLAG) == SYNCX_FLAG;
 
-	// semaphores to synchronize progress in x direction
-	sem_t sems[MAX_THREADS-1];
+	job_scheduler_t::start(env_t::num_threads - 1, &route_t::TERM_NODES);
 
-	for(  int t = 0;  t < env_t::num_threads;  t++  ) {
-		if(  sync_x_steps  &&  t < env_t::num_threads - 1  ) {
-			sem_init(&sems[t], 0, 0);
-		}
-
-		world_thread_param[t].welt = this;
-		world_thread_param[t].thread_num = t;
-		world_thread_param[t].x_step = sync_x_steps ? min( 64, max_x / env_t::num_threads ) : max_x;
-		world_thread_param[t].x_world_max = max_x;
-		world_thread_param[t].y_min = (t * max_y) / env_t::num_threads;
-		world_thread_param[t].y_max = ((t + 1) * max_y) / env_t::num_threads;
-		world_thread_param[t].function = function;
-
-		world_thread_param[t].wait_for_previous = sync_x_steps  &&  t > 0 ? &sems[t-1] : NULL;
-		world_thread_param[t].signal_to_next    = sync_x_steps  &&  t < env_t::num_threads - 1 ? &sems[t] : NULL;
-
-		world_thread_param[t].keep_running = t < env_t::num_threads - 1;
-	}
+	world_xy_loop_job_t data;
+	data.welt = this;
+	data.function = function;
+	data.x_step = sync_x_steps ? max( 1, min( 64, max_x / env_t::num_threads ) ) : max_x;
+	data.x_world_max = max_x;
+	data.y_world_max = max_y;
+	data.band_count = env_t::num_threads;
+	job_scheduler_t::job_t job(&karte_t::world_xy_loop_task, &data);
 
-	if(  !spawned_world_threads  ) {
-		// we can do the parallel display using posix threads ...
-		pthread_t thread[MAX_THREADS];
-		/* Initialize and set thread detached attribute */
-		pthread_attr_t attr;
-		pthread_attr_init( &attr );
-		pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
-		// init barrier
-		simthread_barrier_init( &world_barrier_start, NULL, env_t::num_threads );
-		simthread_barrier_init( &world_barrier_end, NULL, env_t::num_threads );
-
-		for(  int t = 0;  t < env_t::num_threads - 1;  t++  ) {
-			if(  pthread_create( &thread[t], &attr, world_xy_loop_thread, (void *)&world_thread_param[t] )  ) {
-				dbg->fatal( "karte_t::world_xy_loop()", "cannot multithread, error at thread #%i", t+1 );
-			}
+	if(  sync_x_steps  ) {
+		// each band must finish a block before the band below starts it, so process the blocks in diagonal waves
+		const sint32 block_count = (max_x + data.x_step - 1) / data.x_step;
+		for(  data.wave = 0;  data.wave < block_count + (sint32)data.band_count - 1;  data.wave++  ) {
+			job_scheduler_t::run(job, data.band_count);
 		}
-		spawned_world_threads = true;
-		pthread_attr_destroy( &attr );
 	}
-
-	// and start processing
-	simthread_barrier_wait( &world_barrier_start );
-
-	// the last we can run ourselves
-	world_xy_loop_thread(&world_thread_param[env_t::num_threads-1]);
-
-	simthread_barrier_wait( &world_barrier_end );
-
-	// return from thread
-	for(  int t = 0;  t < env_t::num_threads - 1;  t++  ) {
-		if(  sync_x_steps  ) {
-			sem_destroy(&sems[t]);
-		}
+	else {
+		data.wave = -1;
+		job_scheduler_t::run(job, data.band_count);
 	}
 
 	clear_random_mode( INTERACTIVE_RANDOM ); // do not allow simrand() here!
@@ -320,7 +395,7 @@ void karte_t::world_xy_loop(xy_loop_func function, uint8 flags)
 }
 
 
-checklist_t::checklist_t(uint32 _ss, uint32 _st, uint8 _nfc, uint32 _random_seed, uint16 _halt_entry, uint16 _line_entry, uint16 _convoy_entry, uint32 *_rands, uint32 *_debug_sums)
+checklist_t::checklist_t(uint32 _ss, uint32 _st, uint8 _nfc, uint32 _random_seed, uint16 _halt_entry, uint16 _line_entry, uint16 _convoy_entry, uint32 *_rands, uint32 *_debug_sums, const state_hashes_t &_state_hashes)
 	: ss(_ss), st(_st), nfc(_nfc), random_seed(_random_seed), halt_entry(_halt_entry), line_entry(_line_entry), convoy_entry(_convoy_entry)
 {
 	for(  uint8 i = 0;  i < CHK_RANDS; i++  ) {
@@ -329,6 +404,9 @@ checklist_t::checklist_t(uint32 _ss, uint32 _st, uint8 _nfc, uint32 _random_seed
 	for(  uint8 i = 0;  i < CHK_DEBUG_SUMS; i++  ) {
 		debug_sum[i]	 = _debug_sums[i];
 	}
+	for(  uint8 i = 0;  i < state_hashes_t::MAX_SUBSYSTEMS;  i++  ) {
+		state_hash[i] = _state_hashes.get_hash(i);
+	}
 }
 
 
@@ -350,18 +428,22 @@ void checklist_t::rdwr(memory_rw_t *buffer)
 	for(  uint8 i = 0;  i < CHK_DEBUG_SUMS;  i++  ) {
 		buffer->rdwr_long(debug_sum[i]);
 	}
+	for(  uint8 i = 0;  i < state_hashes_t::MAX_SUBSYSTEMS;  i++  ) {
+		buffer->rdwr_long(state_hash[i]);
+	}
 }
 
 
 
 int checklist_t::print(char *buffer, const char *entity) const
 {
-	return sprintf(buffer, "%s=[ss=%u st=%u nfc=%u rand=%u halt=%u line=%u cnvy=%u\n\tssr=%u,%u,%u,%u,%u,%u,%u,%u\n\tstr=%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n\texr=%u,%u,%u,%u,%u,%u,%u,%u\n\tsums=%u,%u,%u,%u,%u,%u,%u,%u,%u,%u]\n",
+	return sprintf(buffer, "%s=[ss=%u st=%u nfc=%u rand=%u halt=%u line=%u cnvy=%u\n\tssr=%u,%u,%u,%u,%u,%u,%u,%u\n\tstr=%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n\texr=%u,%u,%u,%u,%u,%u,%u,%u\n\tsums=%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n\thashes=%u,%u,%u,%u,%u]\n",
 		entity, ss, st, nfc, random_seed, halt_entry, line_entry, convoy_entry,
 		rand[0], rand[1], rand[2], rand[3], rand[4], rand[5], rand[6], rand[7],
 		rand[8], rand[9], rand[10], rand[11], rand[12], rand[13], rand[14], rand[15], rand[16], rand[17], rand[18], rand[19], rand[20], rand[21], rand[22], rand[23],
 		rand[24], rand[25], rand[26], rand[27], rand[28], rand[29], rand[30], rand[31],
-		debug_sum[0], debug_sum[1], debug_sum[2], debug_sum[3], debug_sum[4], debug_sum[5], debug_sum[6], debug_sum[7], debug_sum[8], debug_sum[9]
+		debug_sum[0], debug_sum[1], debug_sum[2], debug_sum[3], debug_sum[4], debug_sum[5], debug_sum[6], debug_sum[7], debug_sum[8], debug_sum[9],
+		state_hash[0], state_hash[1], state_hash[2], state_hash[3], state_hash[4]
 	);
 }
 
@@ -531,6 +613,9 @@ void karte_t::destroy()
 	destroying = true;
 	DBG_MESSAGE("karte_t::destroy()", "destroying world");
 
+	// the game may be quit or replaced now, so the file must be complete
+	check_background_save(true);
+
 #ifdef MULTI_THREAD
 	suspend_private_car_threads();
 	destroy_threads();
@@ -549,6 +634,10 @@ void karte_t::destroy()
 		visitor_targets[i].clear();
 	}
 
+	road_graph_t::clear();
+	landmark_table_t::clear();
+	route_cache_t::clear();
+
 	uint32 max_display_progress = 256+stadt.get_count()*10 + haltestelle_t::get_alle_haltestellen().get_count() + convoi_array.get_count() + (cached_size.x*cached_size.y)*2;
 	uint32 old_progress = 0;
 
@@ -663,10 +752,16 @@ void karte_t::destroy()
 
 	// hier nur entfernen, aber nicht loeschen
 	world_attractions.clear();
+	city_limits_index.clear();
+	city_centre_index.clear();
+	attraction_index.clear();
+	factory_index.clear();
 	DBG_MESSAGE("karte_t::destroy()", "attraction list destroyed");
 
 	weg_t::clear_travel_time_updates();
 	weg_t::clear_list_of__ways();
+	weg_t::private_car_route_map::reset(0, vector_tpl<koord>());
+	weg_t::private_car_route_map::reset(1, vector_tpl<koord>());
 	DBG_MESSAGE("karte_t::destroy()", "way list destroyed");
 
 	delete scenario;
@@ -713,6 +808,8 @@ void karte_t::add_city(stadt_t *s)
 {
 	settings.set_city_count(settings.get_city_count() + 1);
 	stadt.append(s, s->get_einwohner());
+	city_limits_index.add(s, s->get_linksoben(), s->get_rechtsunten());
+	city_centre_index.add(s, s->get_center());
 }
 
 
@@ -728,6 +825,8 @@ bool karte_t::remove_city(stadt_t *s)
 		DBG_MESSAGE("karte_t::remove_city()", "%s", s->get_name());
 	}
 	stadt.remove(s);
+	city_limits_index.remove(s, s->get_linksoben(), s->get_rechtsunten());
+	city_centre_index.remove(s, s->get_center());
 	DBG_DEBUG4("karte_t::remove_city()", "reduce city to %i", settings.get_city_count() - 1);
 	settings.set_city_count(settings.get_city_count() - 1);
 
@@ -739,6 +838,37 @@ bool karte_t::remove_city(stadt_t *s)
 }
 
 
+void karte_t::update_city_limits(stadt_t *s, koord old_lo, koord old_ur)
+{
+	// cities not yet added to the world are indexed when they are
+	if(  city_limits_index.remove(s, old_lo, old_ur)  ) {
+		city_limits_index.add(s, s->get_linksoben(), s->get_rechtsunten());
+		city_centre_index.remove(s, old_lo/2 + old_ur/2);
+		city_centre_index.add(s, s->get_center());
+	}
+}
+
+
+void karte_t::rebuild_spatial_indices()
+{
+	city_limits_index.resize(get_size());
+	city_centre_index.resize(get_size());
+	attraction_index.resize(get_size());
+	factory_index.resize(get_size());
+
+	FOR(weighted_vector_tpl<stadt_t*>, const s, stadt) {
+		city_limits_index.add(s, s->get_linksoben(), s->get_rechtsunten());
+		city_centre_index.add(s, s->get_center());
+	}
+	FOR(weighted_vector_tpl<gebaeude_t*>, const gb, world_attractions) {
+		attraction_index.add(gb, gb->get_pos().get_2d());
+	}
+	FOR(vector_tpl<fabrik_t*>, const fab, fab_list) {
+		factory_index.add(fab, fab->get_pos().get_2d());
+	}
+}
+
+
 // just allocates space;
 void karte_t::init_tiles()
 {
@@ -752,6 +882,7 @@ void karte_t::init_tiles()
 	MEMZERON(grid_hgts, (x + 1) * (y + 1));
 	water_hgts = new sint8[x * y];
 	MEMZERON(water_hgts, x * y);
+	rebuild_spatial_indices();
 
 	win_set_world( this );
 	minimap_t::get_instance()->init();
@@ -786,6 +917,7 @@ void karte_t::init_tiles()
 	last_month_bev = 0;
 
 	tile_counter = 0;
+	monthly_update_row = UINT32_MAX_VALUE;
 
 	convoihandle_t::init( 1024 );
 	linehandle_t::init( 1024 );
@@ -1625,7 +1757,7 @@ void *check_road_connexions_threaded(void *args)
 	const uint32 thread_number = *thread_number_ptr;
 	delete thread_number_ptr;
 
-	karte_t::marker_index = thread_number + world()->get_parallel_operations();
+	karte_t::marker_index = thread_number + job_scheduler_t::get_worker_count();
 
 	do
 	{
@@ -1651,7 +1783,10 @@ void *check_road_connexions_threaded(void *args)
 				continue;
 			}
 
-			city->check_all_private_car_routes();
+			{
+				step_profiler_t::scope_t profile(step_profiler_t::TASK_PRIVATE_CARS);
+				city->check_all_private_car_routes();
+			}
 
 			error = pthread_mutex_lock(&karte_t::private_car_route_mutex);
 			karte_t::cities_to_process--;
@@ -1684,6 +1819,7 @@ void *check_road_connexions_threaded(void *args)
 }
 
 #ifdef DEBUG_MARCHETTI_CONSTANT
+// Not guarded against the passenger generation tasks, so only approximate with several of them
 uint32 passengers_generated_this_month = 0;
 uint32 total_journey_time_tolerance_this_month = 0;
 uint32 passengers_this_month_with_tolerance_of_over_10_hours = 0;
@@ -1697,162 +1833,152 @@ uint32 passengers_travelled_this_month_with_tolerance_of_under_10_minutes = 0;
 uint32 total_journey_times_this_month = 0;
 #endif
 
-void *step_passengers_and_mail_threaded(void* args)
+void step_passengers_and_mail_task(void *, uint32 task)
 {
-	const uint32* thread_number_ptr = (const uint32*)args;
-	karte_t::passenger_generation_thread_number = *thread_number_ptr;
-	const uint32 seed_base = karte_t::world->get_settings().get_random_counter();
+	step_profiler_t::scope_t profile(step_profiler_t::TASK_PASSENGERS);
+	passenger_generation_task_t &generation = passenger_generation_tasks[task];
 
-	// This may easily overflow, but this is irrelevant for the purposes of a random seed
-	// (so long as both server and client are using the same size of integer)
+	// +1 because we need thread number 0 to represent the main thread.
+	// The task may run on the main thread while it waits, so its number is restored afterwards.
+	const uint32 thread_number = karte_t::passenger_generation_thread_number;
+	karte_t::passenger_generation_thread_number = task + 1;
+	booked_passenger_statistics = &passenger_statistics[task];
 
-	const uint32 seed = 325651 + seed_base * karte_t::passenger_generation_thread_number;
+	// Each task continues its own random numbers, on whichever thread it runs,
+	// so that these are deterministic between different clients in a networked
+	// multi-player setup.
+	simrand_state_t thread_random;
+	get_simrand_state(thread_random);
+	set_simrand_state(generation.random);
 
-	delete thread_number_ptr;
+	sint32 next_step_passenger_this_thread = generation.next_step_passenger;
+	sint32 next_step_mail_this_thread = generation.next_step_mail;
 
-	// The random seed is now thread local, so this must be initialised here
-	// with values that will be deterministic between different clients in
-	// a networked multi-player setup.
-	setsimrand(seed, 0xFFFFFFFFu);
-	set_random_mode(STEP_RANDOM);
+	// The generate passengers function is called many times (often well > 100) each step; the mail version is called only once or twice each step, sometimes not at all.
+	sint32 units_this_step = 0;
+	sint32 total_units_passenger = 0;
+	sint32 total_units_mail = 0;
+	bool no_origins = false;
 
-	sint32 next_step_passenger_this_thread;
-	sint32 next_step_mail_this_thread;
+#ifndef FIXED_PASSENGER_NUMBERS_PER_STEP_FOR_TESTING
+	if (karte_t::world->passenger_step_interval <= next_step_passenger_this_thread)
+	{
+		do
+		{
+			if (karte_t::world->passenger_origins.get_count() == 0)
+			{
+				no_origins = true;
+				break;
+			}
+			units_this_step = karte_t::world->generate_passengers_or_mail(goods_manager_t::passengers);
+			total_units_passenger += units_this_step;
+			next_step_passenger_this_thread -= (karte_t::world->passenger_step_interval * units_this_step);
 
-	sint32 total_units_passenger;
-	sint32 total_units_mail;
+		} while (karte_t::world->passenger_step_interval <= next_step_passenger_this_thread);
+	}
 
-	while (true)
+	if (!no_origins && karte_t::world->mail_step_interval <= next_step_mail_this_thread)
 	{
-	top:
-		simthread_barrier_wait(&step_passengers_and_mail_barrier);
-		if (karte_t::world->is_terminating_threads())
+		do
 		{
-			break;
-		}
+			if (karte_t::world->mail_origins_and_targets.get_count() == 0)
+			{
+				no_origins = true;
+				break;
+			}
+			units_this_step = karte_t::world->generate_passengers_or_mail(goods_manager_t::mail);
+			total_units_mail += units_this_step;
+			next_step_mail_this_thread -= (karte_t::world->mail_step_interval * units_this_step);
+
+		} while (karte_t::world->mail_step_interval <= next_step_mail_this_thread);
+	}
+#else
+	for (uint32 i = 0; i < 2; i++)
+	{
+		karte_t::world->generate_passengers_or_mail(goods_manager_t::passengers);
+		karte_t::world->generate_passengers_or_mail(goods_manager_t::mail);
+	}
+#endif
 
-		// The generate passengers function is called many times (often well > 100) each step; the mail version is called only once or twice each step, sometimes not at all.
-		sint32 units_this_step = 0;
-		total_units_passenger = 0;
-		total_units_mail = 0;
+	// Without origins, nothing generated in this step is accounted for.
+	generation.total_units_passenger = no_origins ? 0 : total_units_passenger;
+	generation.total_units_mail = no_origins ? 0 : total_units_mail;
 
-#ifndef FIXED_PASSENGER_NUMBERS_PER_STEP_FOR_TESTING
-		next_step_passenger_this_thread = karte_t::world->next_step_passenger / (karte_t::world->get_parallel_operations());
+	get_simrand_state(generation.random);
+	set_simrand_state(thread_random);
+	booked_passenger_statistics = NULL;
+	karte_t::passenger_generation_thread_number = thread_number;
+}
+
+void karte_t::start_passengers_and_mail_threads()
+{
+	// Share out the passengers and mail to be generated in this step between the tasks.
+	const uint32 task_count = passenger_generation_tasks.get_count();
+	for (uint32 i = 0; i < task_count; i++)
+	{
+		passenger_generation_task_t &generation = passenger_generation_tasks[i];
+		const uint32 thread_number = i + 1;
 
-		next_step_mail_this_thread = karte_t::world->next_step_mail / (karte_t::world->get_parallel_operations());
+		generation.next_step_passenger = next_step_passenger / get_parallel_operations();
+		generation.next_step_mail = next_step_mail / get_parallel_operations();
 
 #ifdef FORBID_PARALLELL_PASSENGER_GENERATION_IN_NETWORK_MODE
 		if (env_t::networkmode)
 		{
-			if (karte_t::passenger_generation_thread_number == 0)
+			if (thread_number == 1)
 			{
-				next_step_passenger_this_thread = karte_t::world->next_step_passenger;
+				generation.next_step_passenger = next_step_passenger;
 			}
 			else
 			{
-				next_step_passenger_this_thread = 0;
+				generation.next_step_passenger = 0;
 			}
 		}
 		else
 		{
 #else
 
-			if (next_step_passenger_this_thread < karte_t::world->passenger_step_interval && karte_t::world->next_step_passenger > karte_t::world->passenger_step_interval)
+			if (generation.next_step_passenger < passenger_step_interval && next_step_passenger > passenger_step_interval)
 			{
-				if (karte_t::passenger_generation_thread_number == 0)
+				if (thread_number == 1)
 				{
 					// In case of very small numbers, make this effectively single threaded, or else rounding errors will prevent any passenger generation.
-					next_step_passenger_this_thread = karte_t::world->next_step_passenger;
+					generation.next_step_passenger = next_step_passenger;
 				}
 				else
 				{
-					next_step_passenger_this_thread = 0;
+					generation.next_step_passenger = 0;
 				}
 			}
-			else if (karte_t::passenger_generation_thread_number == 0)
+			else if (thread_number == 1)
 			{
-				next_step_passenger_this_thread += karte_t::world->next_step_passenger % (karte_t::world->get_parallel_operations());
+				generation.next_step_passenger += next_step_passenger % get_parallel_operations();
 			}
 
-			if (next_step_mail_this_thread < karte_t::world->mail_step_interval && karte_t::world->next_step_mail > karte_t::world->mail_step_interval)
+			if (generation.next_step_mail < mail_step_interval && next_step_mail > mail_step_interval)
 			{
-				if (karte_t::passenger_generation_thread_number == 0)
+				if (thread_number == 1)
 				{
 					// In case of very small numbers, make this effectively single threaded, or else rounding errors will prevent any mail generation.
-					next_step_mail_this_thread = karte_t::world->next_step_mail;
+					generation.next_step_mail = next_step_mail;
 				}
 				else
 				{
-					next_step_mail_this_thread = 0;
+					generation.next_step_mail = 0;
 				}
 			}
-			else if (karte_t::passenger_generation_thread_number == 0)
+			else if (thread_number == 1)
 			{
-				next_step_mail_this_thread += karte_t::world->next_step_mail % (karte_t::world->get_parallel_operations());
+				generation.next_step_mail += next_step_mail % get_parallel_operations();
 			}
 #endif
 
 #ifdef FORBID_PARALLELL_PASSENGER_GENERATION_IN_NETWORK_MODE
 		}
 #endif
-
-		if (karte_t::world->passenger_step_interval <= next_step_passenger_this_thread)
-		{
-			do
-			{
-				if (karte_t::world->passenger_origins.get_count() == 0)
-				{
-					goto top;
-				}
-				units_this_step = karte_t::world->generate_passengers_or_mail(goods_manager_t::passengers);
-				total_units_passenger += units_this_step;
-				next_step_passenger_this_thread -= (karte_t::world->passenger_step_interval * units_this_step);
-
-			} while (karte_t::world->passenger_step_interval <= next_step_passenger_this_thread);
-		}
-
-		if (karte_t::world->mail_step_interval <= next_step_mail_this_thread)
-		{
-			do
-			{
-				if (karte_t::world->mail_origins_and_targets.get_count() == 0)
-				{
-					goto top;
-				}
-				units_this_step = karte_t::world->generate_passengers_or_mail(goods_manager_t::mail);
-				total_units_mail += units_this_step;
-				next_step_mail_this_thread -= (karte_t::world->mail_step_interval * units_this_step);
-
-			} while (karte_t::world->mail_step_interval <= next_step_mail_this_thread);
-		}
-#else
-		for (uint32 i = 0; i < 2; i++)
-		{
-			karte_t::world->generate_passengers_or_mail(goods_manager_t::passengers);
-			karte_t::world->generate_passengers_or_mail(goods_manager_t::mail);
-		}
-#endif
-
-		simthread_barrier_wait(&step_passengers_and_mail_barrier); // Having three of these is intentional.
-		int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-		assert(mutex_error == 0);
-		(void)mutex_error;
-
-		karte_t::world->next_step_passenger -= (total_units_passenger * karte_t::world->passenger_step_interval);
-		karte_t::world->next_step_mail -= (total_units_mail * karte_t::world->mail_step_interval);
-
-		mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-		simthread_barrier_wait(&step_passengers_and_mail_barrier);
-		assert(mutex_error == 0);
-		(void)mutex_error;
 	}
 
-	return args;
-}
-
-void karte_t::start_passengers_and_mail_threads()
-{
-	simthread_barrier_wait(&step_passengers_and_mail_barrier);
+	job_scheduler_t::submit(step_passengers_and_mail_job, task_count);
 	passengers_and_mail_threads_working = true;
 }
 #endif //MULTI_THREAD
@@ -1866,10 +1992,22 @@ void karte_t::await_passengers_and_mail_threads()
 #endif
 		if (passengers_and_mail_threads_working)
 		{
-			// Two barriers, to allow synchronised update of generation figures
-			simthread_barrier_wait(&step_passengers_and_mail_barrier);
-			simthread_barrier_wait(&step_passengers_and_mail_barrier);
+			job_scheduler_t::wait(step_passengers_and_mail_job);
 			passengers_and_mail_threads_working = false;
+
+			// Update the generation figures only once all tasks have finished, as the tasks share them out at the start.
+			for (uint32 i = 0; i < passenger_generation_tasks.get_count(); i++)
+			{
+				const passenger_generation_task_t &generation = passenger_generation_tasks[i];
+				next_step_passenger -= (generation.total_units_passenger * passenger_step_interval);
+				next_step_mail -= (generation.total_units_mail * mail_step_interval);
+
+				FOR(vector_tpl<passenger_statistic_t>, const& statistic, passenger_statistics[i])
+				{
+					apply_passenger_statistic(statistic);
+				}
+				passenger_statistics[i].clear();
+			}
 		}
 #ifdef FORBID_MULTI_THREAD_PASSENGER_GENERATION_IN_NETWORK_MODE
 	}
@@ -1877,71 +2015,102 @@ void karte_t::await_passengers_and_mail_threads()
 #endif
 }
 
-#ifdef MULTI_THREAD
-void *step_convoys_threaded(void* args)
+#ifdef MULTI_THREAD_PASSENGER_GENERATION
+// the passengers which the tasks of the passenger generation benchmark generate
+struct passenger_benchmark_job_t
 {
-	karte_t* world = (karte_t*)args;
+	uint32 packets;
+	uint32 task_count;
+};
 
-	while (true)
-	{
-		simthread_barrier_wait(&karte_t::step_convoys_barrier_external);
-		if (world->is_terminating_threads())
-		{
-			return NULL;
-		}
-
-		// since convois will be deleted during stepping, we need to step backwards
-		for (uint32 i = world->convoi_array.get_count(); i-- != 0;)
-		{
-			convoihandle_t cnv = world->convoi_array[i];
-			convoys_next_step.append(cnv);
-		}
+void passenger_benchmark_task(void *data, uint32 task)
+{
+	const passenger_benchmark_job_t &job = *reinterpret_cast<const passenger_benchmark_job_t *>(data);
+	passenger_generation_task_t &generation = passenger_generation_tasks[task];
 
-		simthread_barrier_wait(&step_convoys_barrier_internal);
-		simthread_barrier_wait(&step_convoys_barrier_internal); // The multiples of these is intentional: we must wait for the individual threads to finish before the clear() command is executed.
-		convoys_next_step.clear();
+	const uint32 thread_number = karte_t::passenger_generation_thread_number;
+	karte_t::passenger_generation_thread_number = task + 1;
+	booked_passenger_statistics = &passenger_statistics[task];
+	simrand_state_t thread_random;
+	get_simrand_state(thread_random);
+	set_simrand_state(generation.random);
 
-		simthread_barrier_wait(&karte_t::step_convoys_barrier_external);
+	for (uint32 i = job.packets * task / job.task_count; i < job.packets * (task + 1) / job.task_count; i++)
+	{
+		karte_t::world->generate_passengers_or_mail(goods_manager_t::passengers);
 	}
 
-	return args;
+	get_simrand_state(generation.random);
+	set_simrand_state(thread_random);
+	booked_passenger_statistics = NULL;
+	karte_t::passenger_generation_thread_number = thread_number;
 }
 
-void* step_individual_convoy_threaded(void* args)
+void karte_t::benchmark_passenger_generation(uint32 packets)
 {
-	const uint32* thread_number_ptr = (const uint32*)args;
-	const uint32 thread_number = *thread_number_ptr;
-	karte_t::marker_index = thread_number;
-	delete thread_number_ptr;
+	if (passenger_origins.empty() || passenger_generation_tasks.empty())
+	{
+		dbg->warning("karte_t::benchmark_passenger_generation()", "No passengers can be generated");
+		return;
+	}
 
-	while (true)
+	await_all_threads();
+	printf("Passenger generation: %u packets with %u worker threads\n", packets, job_scheduler_t::get_worker_count());
+	for (uint32 task_count = 1; task_count <= passenger_generation_tasks.get_count(); task_count++)
 	{
-		simthread_barrier_wait(&step_convoys_barrier_internal);
-		if (karte_t::world->is_terminating_threads())
-		{
-			route_t::TERM_NODES();
-			return NULL;
-		}
+		passenger_benchmark_job_t data;
+		data.packets = packets;
+		data.task_count = task_count;
+		job_scheduler_t::job_t job(&passenger_benchmark_task, &data);
+
+		const uint32 start = dr_time();
+		job_scheduler_t::run(job, task_count);
+		const uint32 ms = max(dr_time() - start, 1u);
 
-		const uint32 convoys_next_step_count = convoys_next_step.get_count();
-		for (uint32 i = thread_number; i < convoys_next_step_count; i += karte_t::world->get_parallel_operations())
+		for (uint32 i = 0; i < task_count; i++)
 		{
-			convoihandle_t cnv = convoys_next_step[i];
-			if (cnv.is_bound())
+			FOR(vector_tpl<passenger_statistic_t>, const& statistic, passenger_statistics[i])
 			{
-				cnv->threaded_step();
+				apply_passenger_statistic(statistic);
 			}
+			passenger_statistics[i].clear();
 		}
+		printf("%3u tasks: %6u ms, %8u packets/second\n", task_count, ms, (uint32)((uint64)packets * 1000 / ms));
+	}
+}
+#endif
 
-		simthread_barrier_wait(&step_convoys_barrier_internal);
+#ifdef MULTI_THREAD
+void step_convoys_task(void *, uint32 task)
+{
+	step_profiler_t::scope_t profile(step_profiler_t::TASK_CONVOYS);
+	karte_t::marker_index = job_scheduler_t::get_worker_number();
+
+	const vector_tpl<convoihandle_t> &convoys_next_step = karte_t::convoys_next_step;
+	const uint32 convoys_next_step_count = convoys_next_step.get_count();
+	const uint32 task_count = max(karte_t::world->get_parallel_operations(), 1);
+	for (uint32 i = task; i < convoys_next_step_count; i += task_count)
+	{
+		convoihandle_t cnv = convoys_next_step[i];
+		if (cnv.is_bound())
+		{
+			cnv->threaded_step();
+		}
 	}
 
-	return args;
+	karte_t::marker_index = UINT32_MAX_VALUE;
 }
 
 void karte_t::start_convoy_threads()
 {
-	simthread_barrier_wait(&step_convoys_barrier_external);
+	// since convois will be deleted during stepping, we need to step backwards
+	convoys_next_step.clear();
+	for (uint32 i = convoi_array.get_count(); i-- != 0;)
+	{
+		convoys_next_step.append(convoi_array[i]);
+	}
+
+	job_scheduler_t::submit(step_convoys_job, max(get_parallel_operations(), 1));
 	convoy_threads_working = true;
 }
 #endif
@@ -1951,7 +2120,7 @@ void karte_t::await_convoy_threads()
 #ifdef MULTI_THREAD_CONVOYS
 	if (convoy_threads_working)
 	{
-		simthread_barrier_wait(&step_convoys_barrier_external);
+		job_scheduler_t::wait(step_convoys_job);
 		convoy_threads_working = false;
 	}
 #endif
@@ -2001,45 +2170,21 @@ void karte_t::suspend_private_car_threads()
 	(void)error;
 }
 
-void* path_explorer_threaded(void* args)
+void path_explorer_task(void *, uint32)
 {
+	step_profiler_t::scope_t profile(step_profiler_t::TASK_PATH_EXPLORER);
+	const bool allow_path_explorer = path_explorer_t::allow_path_explorer_on_this_thread;
 	path_explorer_t::allow_path_explorer_on_this_thread = true;
-	while (true)
-	{
-		simthread_barrier_wait(&path_explorer_barrier);
-		if (karte_t::world->is_terminating_threads())
-		{
-			return NULL;
-		}
-		path_explorer_t::step();
-		simthread_barrier_wait(&path_explorer_barrier);
-	}
-
-	return args;
+	path_explorer_t::step();
+	path_explorer_t::allow_path_explorer_on_this_thread = allow_path_explorer;
 }
 #endif
 
 void karte_t::await_path_explorer()
 {
 #ifdef MULTI_THREAD_PATH_EXPLORER
-	// This first check isn't entirely redundant, because we need to
-	// protect against trying to lock a destroyed mutex.
-	if (path_explorer_working)
-	{
-		// This can be accessed by multiple threads, so we need to
-		// ensure only one thread reaches the barrier.
-		int error = pthread_mutex_lock(&path_explorer_await_mutex);
-		assert(error == 0);
-		(void)error;
-
-		if (path_explorer_working)
-		{
-			simthread_barrier_wait(&path_explorer_barrier);
-			path_explorer_working = false;
-		}
-		error = pthread_mutex_unlock(&path_explorer_await_mutex);
-		assert(error == 0);
-	}
+	// This can be called from several threads at once; all return once the path explorer has finished.
+	job_scheduler_t::wait(path_explorer_job);
 #endif
 }
 
@@ -2047,63 +2192,18 @@ void karte_t::await_path_explorer()
 void karte_t::start_path_explorer()
 {
 #ifdef MULTI_THREAD_PATH_EXPLORER
-	simthread_barrier_wait(&path_explorer_barrier);
-	path_explorer_working = true;
+	job_scheduler_t::submit(path_explorer_job, 1);
 #endif
 }
-
-void* unreserve_route_threaded(void* args)
-{
-	const uint32* thread_number_ptr = (const uint32*)args;
-	const uint32 thread_number = *thread_number_ptr;
-	delete thread_number_ptr;
-
-	do
-	{
-		simthread_barrier_wait(&karte_t::unreserve_route_barrier);
-
-		if (karte_t::world->is_terminating_threads())
-		{
-			break;
-		}
-		if (convoi_t::current_unreserver == 0)
-		{
-			int error = pthread_mutex_unlock(&karte_t::unreserve_route_mutex);
-			assert(error == 0);
-			(void)error;
-
-			continue;
-		}
-
-		const uint32 max_count = weg_t::get_all_ways_count() - 1;
-		const uint32 fraction = max_count / karte_t::world->get_parallel_operations();
-
-		route_range_specification range;
-
-		range.start = thread_number * fraction;
-		if (thread_number == karte_t::world->get_parallel_operations() - 1)
-		{
-			range.end = max_count;
-		}
-		else
-		{
-			range.end = min(((thread_number + 1) * fraction - 1), max_count);
-		}
-
-		convoi_t::unreserve_route_range(range);
-
-		simthread_barrier_wait(&karte_t::unreserve_route_barrier);
-
-	} while (!karte_t::world->is_terminating_threads());
-
-	pthread_exit(NULL);
-	return args;
-}
 #endif
 
 void karte_t::await_all_threads()
 {
 #ifdef MULTI_THREAD
+	if(  is_background_save_copy  ) {
+		// the threads were not copied, and did not work when the copy was made
+		return;
+	}
 	// Call this when saving or doing disruptive stuff like map rotation.
 	await_convoy_threads();
 	await_path_explorer();
@@ -2121,10 +2221,16 @@ void karte_t::init_threads()
 
 	const sint32 parallel_operations = get_parallel_operations();
 
+	// One worker for each core besides the main thread. The number of tasks into which work is divided
+	// depends only on the number of parallel operations, which is the same on all clients of a network game.
+	job_scheduler_t::start(env_t::num_threads - 1, &route_t::TERM_NODES);
+	const uint32 worker_count = job_scheduler_t::get_worker_count();
+
 	private_cars_added_threaded = new vector_tpl<private_car_t*>[parallel_operations + 2];
 	pedestrians_added_threaded = new vector_tpl<pedestrian_t*>[parallel_operations + 2];
 	transferring_cargoes = new vector_tpl<transferring_cargo_t>[parallel_operations + 2];
-	marker_t::markers = new marker_t[parallel_operations * 2];
+	// one for each worker, followed by one for each private car thread
+	marker_t::markers = new marker_t[worker_count + parallel_operations];
 
 	start_halts = new vector_tpl<nearby_halt_t>[parallel_operations + 2];
 	destination_list = new vector_tpl<halthandle_t>[parallel_operations + 2];
@@ -2136,11 +2242,6 @@ void karte_t::init_threads()
 	const bool one_private_car_thread = false; // Because we allow servers to run private car threading in the background when no clients are connected, we should now always allow multiple thread instances here.
 
 	simthread_barrier_init(&private_car_barrier, NULL, one_private_car_thread ? 2 : parallel_operations + 1);
-	simthread_barrier_init(&karte_t::unreserve_route_barrier, NULL, parallel_operations + 2); // This and the next does not run concurrently with anything significant on the main thread, so the number of parallel operations need to be +1 compared to the others.
-	simthread_barrier_init(&step_passengers_and_mail_barrier, NULL, parallel_operations + 2);
-	simthread_barrier_init(&step_convoys_barrier_external, NULL, 2);
-	simthread_barrier_init(&step_convoys_barrier_internal, NULL, parallel_operations + 1);
-	simthread_barrier_init(&path_explorer_barrier, NULL, 2);
 
 	// Initialise mutexes
 	pthread_mutexattr_init(&mutex_attributes);
@@ -2150,14 +2251,12 @@ void karte_t::init_threads()
 	pthread_mutex_init(&private_car_route_mutex, &mutex_attributes);
 
 	pthread_mutex_init(&step_passengers_and_mail_mutex, &mutex_attributes);
-	pthread_mutex_init(&path_explorer_await_mutex, &mutex_attributes);
-	pthread_mutex_init(&unreserve_route_mutex, &mutex_attributes);
 
 	pthread_t thread;
 
-	for (uint32 i = 0; i < parallel_operations + 1; i++)
+	for (uint32 i = 0; i < (uint32)parallel_operations; i++)
 	{
-		if ((i < parallel_operations && !one_private_car_thread) || i < 1)
+		if (!one_private_car_thread || i < 1)
 		{
 			uint32* thread_number_checker = new uint32;
 			*thread_number_checker = i;
@@ -2172,72 +2271,34 @@ void karte_t::init_threads()
 			}
 			private_car_threads_working = false;
 		}
-		// The next two need an extra thread compared with the others, as they do not run concurrently with anything non-trivial on the main thread
-		sint32* thread_number_unres = new sint32;
-		*thread_number_unres = i;
-		rc = pthread_create(&thread, &thread_attributes, &unreserve_route_threaded, (void*)thread_number_unres);
-		if (rc)
-		{
-			dbg->fatal("void karte_t::init_threads()", "Failed to create private car thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
-		}
-		else
-		{
-			unreserve_route_threads.append(thread);
-		}
-
-#ifdef MULTI_THREAD_PASSENGER_GENERATION
-		sint32* thread_number_pass = new sint32;
-		*thread_number_pass = i + 1; // +1 because we need thread number 0 to represent the main thread.
-		rc = pthread_create(&thread, &thread_attributes, &step_passengers_and_mail_threaded, (void*)thread_number_pass);
-		if (rc)
-		{
-			dbg->fatal("void karte_t::init_threads()", "Failed to create step passengers and mail thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
-		}
-		else
-		{
-			step_passengers_and_mail_threads.append(thread);
-		}
-#endif
-		if (i == parallel_operations)
-		{
-			break;
-		}
-
-#ifdef MULTI_THREAD_CONVOYS
-		uint32* thread_number_cnv = new uint32;
-		*thread_number_cnv = i;
-		rc = pthread_create(&thread, &thread_attributes, &step_individual_convoy_threaded, (void*)thread_number_cnv);
-		if (rc)
-		{
-			dbg->fatal("void karte_t::init_threads()", "Failed to create individual convoy thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
-		}
-		else
-		{
-			individual_convoy_step_threads.append(thread);
-		}
-#endif
 	}
-#ifdef MULTI_THREAD_CONVOYS
-	rc = pthread_create(&convoy_step_master_thread, &thread_attributes, &step_convoys_threaded, (void*)this);
-	if (rc)
-	{
-		dbg->fatal("void karte_t::init_threads()", "Failed to create convoy master thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
-	}
-	convoy_threads_working = false;
-#endif
 
 #ifdef MULTI_THREAD_PASSENGER_GENERATION
+	// The passenger generation needs an extra task compared with the others, as it does not run concurrently with anything non-trivial on the main thread.
+	// Each task continues its own random numbers from one step to the next.
+	const uint32 seed_base = get_settings().get_random_counter();
+	simrand_state_t main_random;
+	get_simrand_state(main_random);
+	passenger_generation_tasks.clear();
+	passenger_statistics = new vector_tpl<passenger_statistic_t>[parallel_operations + 1];
+	for (uint32 i = 0; i < (uint32)parallel_operations + 1; i++)
+	{
+		// This may easily overflow, but this is irrelevant for the purposes of a random seed
+		// (so long as both server and client are using the same size of integer)
+		const uint32 seed = 325651 + seed_base * (i + 1);
+		setsimrand(seed, 0xFFFFFFFFu);
+		set_random_mode(STEP_RANDOM);
+
+		passenger_generation_task_t generation;
+		get_simrand_state(generation.random);
+		passenger_generation_tasks.append(generation);
+	}
+	set_simrand_state(main_random);
 	passengers_and_mail_threads_working = false;
 #endif
 
-#ifdef MULTI_THREAD_PATH_EXPLORER
-
-	rc = pthread_create(&path_explorer_thread, &thread_attributes, &path_explorer_threaded, (void*)this);
-	if (rc)
-	{
-		dbg->fatal("void karte_t::init_threads()", "Failed to create path explorer thread, error %d. See here for a translation of the error numbers: http://epydoc.sourceforge.net/stdlib/errno-module.html", rc);
-	}
-	path_explorer_working = false;
+#ifdef MULTI_THREAD_CONVOYS
+	convoy_threads_working = false;
 #endif
 
 	threads_initialised = true;
@@ -2260,55 +2321,21 @@ void karte_t::destroy_threads()
 #endif
 
 		terminating_threads = true;
-#ifdef MULTI_THREAD_CONVOYS
-		simthread_barrier_wait(&step_convoys_barrier_external);
-		simthread_barrier_wait(&step_convoys_barrier_internal);
-#endif
-#ifdef MULTI_THREAD_PASSENGER_GENERATION
-		simthread_barrier_wait(&step_passengers_and_mail_barrier);
-#endif
 		await_private_car_threads();
 		simthread_barrier_wait(&private_car_barrier);
 
-		simthread_barrier_wait(&unreserve_route_barrier);
-#ifdef MULTI_THREAD_PATH_EXPLORER
-		simthread_barrier_wait(&path_explorer_barrier);
-		pthread_join(path_explorer_thread, 0);
-#endif
-#ifdef MULTI_THREAD_CONVOYS
-		pthread_join(convoy_step_master_thread, 0);
-		clean_threads(&individual_convoy_step_threads);
-		individual_convoy_step_threads.clear();
-#endif
 		clean_threads(&private_car_route_threads);
 		private_car_route_threads.clear();
-#ifdef MULTI_THREAD_PASSENGER_GENERATION
-		clean_threads(&step_passengers_and_mail_threads);
-		step_passengers_and_mail_threads.clear();
-#endif
 
-		clean_threads(&unreserve_route_threads);
-		unreserve_route_threads.clear();
-#ifdef MULTI_THREAD_CONVOYS
-		simthread_barrier_destroy(&step_convoys_barrier_external);
-		simthread_barrier_destroy(&step_convoys_barrier_internal);
-#endif
-#ifdef MULTI_THREAD_PASSENGER_GENERATION
-		simthread_barrier_destroy(&step_passengers_and_mail_barrier);
-#endif
 		simthread_barrier_destroy(&private_car_barrier);
-		simthread_barrier_destroy(&unreserve_route_barrier);
 
-#ifdef MULTI_THREAD_PATH_EXPLORER
-		simthread_barrier_destroy(&path_explorer_barrier);
-#endif
+		// The workers release their route nodes, which depend on the size of the world.
+		job_scheduler_t::stop();
 
 		// Destroy mutexes
 		pthread_mutex_destroy(&private_car_route_mutex);
 		private_car_route_mutex_initialised = false;
 		pthread_mutex_destroy(&step_passengers_and_mail_mutex);
-		pthread_mutex_destroy(&path_explorer_await_mutex);
-		pthread_mutex_destroy(&unreserve_route_mutex);
 
 		pthread_mutexattr_destroy(&mutex_attributes);
 	}
@@ -2319,6 +2346,8 @@ void karte_t::destroy_threads()
 	pedestrians_added_threaded = NULL;
 	delete[] transferring_cargoes;
 	transferring_cargoes = NULL;
+	delete[] passenger_statistics;
+	passenger_statistics = NULL;
 	delete[] marker_t::markers;
 	marker_t::markers = NULL;
 	delete[]start_halts;
@@ -2738,6 +2767,7 @@ void karte_t::enlarge_map(settings_t const* sets, sint8 const* const h_field)
 	cached_size_max = max(cached_grid_size.x,cached_grid_size.y);
 	cached_size.x = cached_grid_size.x-1;
 	cached_size.y = cached_grid_size.y-1;
+	rebuild_spatial_indices();
 
 	intr_disable();
 
@@ -3078,10 +3108,18 @@ karte_t::karte_t() :
 	convoi_array(0),
 	world_attractions(16),
 	stadt(0),
+	city_limits_index(64),
+	city_centre_index(64),
+	attraction_index(32),
+	factory_index(32),
 	idle_time(0),
+	background_save_pid(0),
+	background_save_start(0),
+	is_background_save_copy(false),
 	speed_factors_are_set(false)
 {
 	destroying = false;
+	current_state_hash_log = 0;
 
 	// length of day and other time stuff
 	ticks_per_world_month_shift = 20;
@@ -3182,7 +3220,6 @@ karte_t::karte_t() :
 #ifdef MULTI_THREAD
 	passengers_and_mail_threads_working = false;
 	convoy_threads_working = false;
-	path_explorer_working = false;
 	private_car_threads_working = false;
 #endif
 }
@@ -4638,6 +4675,12 @@ DBG_MESSAGE( "karte_t::rotate90()", "called" );
 	// Modified by : Knightly
 	path_explorer_t::refresh_all_categories(false);
 
+	// the road graph and the spatial indices refer to tile positions
+	road_graph_t::rebuild(this);
+	rebuild_spatial_indices();
+	landmark_table_t::rotate90(cached_size.x);
+	route_cache_t::clear();
+
 	set_dirty();
 }
 // -------- Verwaltung von Fabriken -----------------------------
@@ -4649,6 +4692,7 @@ bool karte_t::add_fab(fabrik_t *fab)
 	assert(fab != NULL);
 	//fab_list.insert( fab );
 	fab_list.append(fab);
+	factory_index.add(fab, fab->get_pos().get_2d());
 	goods_in_game.clear(); // Force rebuild of goods list
 	return true;
 }
@@ -4664,6 +4708,7 @@ bool karte_t::rem_fab(fabrik_t *fab)
 	else
 	{
 		fab_list.remove(fab);
+		factory_index.remove(fab, fab->get_pos().get_2d());
 	}
 
 	// Force rebuild of goods list
@@ -4716,6 +4761,7 @@ void karte_t::add_attraction(gebaeude_t *gb)
 {
 	assert(gb != NULL);
 	world_attractions.append(gb, gb->get_adjusted_visitor_demand());
+	attraction_index.add(gb, gb->get_pos().get_2d());
 }
 
 
@@ -4723,6 +4769,7 @@ void karte_t::remove_attraction(gebaeude_t *gb)
 {
 	assert(gb != NULL);
 	world_attractions.remove(gb);
+	attraction_index.remove(gb, gb->get_pos().get_2d());
 	stadt_t* city = get_city(gb->get_pos().get_2d());
 	if(!city)
 	{
@@ -4734,12 +4781,56 @@ void karte_t::remove_attraction(gebaeude_t *gb)
 // -------- Verwaltung von Staedten -----------------------------
 // "look for next city" (Babelfish)
 
-stadt_t *karte_t::find_nearest_city(const koord k, uint32 rank) const
-{
-	uint32 min_dist = 99999999;
-	bool contains = false;
-	stadt_t *best = NULL;	// within city limits
-	rank = max(rank, 1);
+// orders cities as in the list of cities, since the searches below prefer the first one found there
+class city_list_order_t
+{
+	const weighted_vector_tpl<stadt_t*> &cities;
+public:
+	city_list_order_t(const weighted_vector_tpl<stadt_t*> &cities) : cities(cities) {}
+	bool operator()(stadt_t *a, stadt_t *b) const { return cities.index_of(a) < cities.index_of(b); }
+};
+
+
+stadt_t *karte_t::find_nearest_city(const koord k, uint32 rank) const
+{
+	uint32 min_dist = 99999999;
+	bool contains = false;
+	stadt_t *best = NULL;	// within city limits
+	rank = max(rank, 1);
+
+	if(  rank == 1  ) {
+		if(  !is_within_limits(k)  ) {
+			return NULL;
+		}
+
+		// the nearest of the cities whose limits contain k, without their lower and right borders
+		vector_tpl<stadt_t*> nearest;
+		vector_tpl<stadt_t*> candidates;
+		city_limits_index.get_at(k, candidates);
+		FOR(vector_tpl<stadt_t*>, const s, candidates) {
+			if(  k.x < s->get_rechtsunten().x  &&  k.y < s->get_rechtsunten().y  ) {
+				const uint32 dist = koord_distance( k, s->get_center() );
+				if(  dist < min_dist  ) {
+					nearest.clear();
+					min_dist = dist;
+				}
+				if(  dist == min_dist  ) {
+					nearest.append(s);
+				}
+			}
+		}
+
+		if(  nearest.empty()  ) {
+			// otherwise the city with the nearest centre
+			candidates.clear();
+			city_centre_index.get_nearest(k, 1, candidates);
+			if(  candidates.empty()  ) {
+				return NULL;
+			}
+			city_centre_index.get_within(k, koord_distance(k, candidates[0]->get_center()), nearest);
+		}
+		return *std::min_element(nearest.begin(), nearest.end(), city_list_order_t(stadt));
+	}
 
 	inthashtable_tpl<uint32, stadt_t*, N_BAGS_MEDIUM> distances;
 	slist_tpl<uint32> ordered_distances;
@@ -4801,8 +4892,15 @@ stadt_t *karte_t::get_city(const koord pos) const
 
 	if(is_within_limits(pos))
 	{
+		vector_tpl<stadt_t*> candidates;
+		city_limits_index.get_at(pos, candidates);
+		if(candidates.get_count() > 1)
+		{
+			std::sort(candidates.begin(), candidates.end(), city_list_order_t(stadt));
+		}
+
 		int cities = 0;
-		FOR(weighted_vector_tpl<stadt_t*>, const c, stadt)
+		FOR(vector_tpl<stadt_t*>, const c, candidates)
 		{
 			if(c->is_within_city_limits(pos))
 			{
@@ -4888,6 +4986,8 @@ void karte_t::sync_list_t::sync_step(uint32 delta_t)
  */
 void karte_t::sync_step(uint32 delta_t, bool do_sync_step, bool display )
 {
+	step_profiler_t::scope_t profile(step_profiler_t::SYNC_STEP);
+
 	rands[0] = get_random_seed();
 	rands[7] = 0;
 
@@ -4936,7 +5036,10 @@ void karte_t::sync_step(uint32 delta_t, bool do_sync_step, bool display )
 		clear_random_mode( INTERACTIVE_RANDOM );
 
 		debug_sums[8] = sync.list.get_count();
-		sync.sync_step( delta_t );
+		{
+			step_profiler_t::scope_t profile(step_profiler_t::SYNC_STEP_OBJECTS);
+			sync.sync_step( delta_t );
+		}
 		debug_sums[9] = sync.list.get_count();
 
 		rands[4] = get_random_seed();
@@ -4989,7 +5092,10 @@ void karte_t::sync_step(uint32 delta_t, bool do_sync_step, bool display )
 		}
 
 		// display new frame with water animation
-		intr_refresh_display( false );
+		{
+			step_profiler_t::scope_t profile(step_profiler_t::SYNC_STEP_DISPLAY);
+			intr_refresh_display( false );
+		}
 		update_frame_sleep_time();
 	}
 
@@ -5160,8 +5266,18 @@ void karte_t::new_month()
 
 	// this should be done before a map update, since the map may want an update of the way usage
 //	DBG_MESSAGE("karte_t::new_month()","ways");
-	FOR(vector_tpl<weg_t*>, const w, weg_t::get_alle_wege()) {
-		w->new_month();
+	if(  settings.get_monthly_update_steps() == 0  ) {
+		FOR(vector_tpl<weg_t*>, const w, weg_t::get_alle_wege()) {
+			w->new_month();
+		}
+	}
+	else {
+		// the rows not done in the last month first; the stops start the month here then, too
+		if(  monthly_update_row < (uint32)get_size().y  ) {
+			new_month_rows(monthly_update_row, get_size().y);
+		}
+		// ways and stops follow in the next steps, starting with this one
+		monthly_update_row = 0;
 	}
 
 	// Update the maximum vehicle speed records to calibrate when passengers should not burden the journey time database.
@@ -5303,9 +5419,11 @@ void karte_t::new_month()
 	INT_CHECK("simworld 3130");
 
 //	DBG_MESSAGE("karte_t::new_month()","halts");
-	FOR(vector_tpl<halthandle_t>, const s, haltestelle_t::get_alle_haltestellen()) {
-		s->new_month();
-		INT_CHECK("simworld 1877");
+	if(  settings.get_monthly_update_steps() == 0  ) {
+		FOR(vector_tpl<halthandle_t>, const s, haltestelle_t::get_alle_haltestellen()) {
+			s->new_month();
+			INT_CHECK("simworld 1877");
+		}
 	}
 
 	INT_CHECK("simworld 2522");
@@ -5323,6 +5441,9 @@ void karte_t::new_month()
 	}
 
 	way_builder_t::new_month();
+	landmark_table_t::new_month();
+	// road congestion and the state of the ways have changed
+	route_cache_t::network_changed();
 	INT_CHECK("simworld 1299");
 
 	hausbauer_t::new_month();
@@ -5356,11 +5477,18 @@ void karte_t::new_month()
 	tool_t::update_toolbars();
 
 
-	// no autosave in networkmode or when the new world dialogue is shown
-	if( !env_t::networkmode && env_t::autosave>0 && last_month%env_t::autosave==0 && !win_get_magic(magic_welt_gui_t) ) {
+	// no autosave in networkmode (unless the server saves in the background) or when the new world dialogue is shown
+	const bool may_autosave = !env_t::networkmode  ||  (env_t::server  &&  env_t::background_autosave);
+	if( may_autosave && env_t::autosave>0 && last_month%env_t::autosave==0 && !win_get_magic(magic_welt_gui_t) ) {
 		char buf[128];
 		sprintf( buf, "save/autosave%02i.sve", last_month+1 );
-		save( buf, true, env_t::savegame_version_str, env_t::savegame_ex_version_str, env_t::savegame_ex_revision_str, true );
+		if(  env_t::background_autosave  ) {
+			// at the end of the step, when no other thread is working
+			background_save_name = buf;
+		}
+		else {
+			save( buf, true, env_t::savegame_version_str, env_t::savegame_ex_version_str, env_t::savegame_ex_revision_str, true );
+		}
 	}
 
 	recalc_passenger_destination_weights();
@@ -5396,6 +5524,50 @@ void karte_t::new_month()
 }
 
 
+void karte_t::new_month_rows(uint32 first_row, uint32 end_row)
+{
+	for(  uint32 y = first_row;  y < end_row;  y++  ) {
+		for(  sint16 x = 0;  x < get_size().x;  x++  ) {
+			const planquadrat_t *plan = access_nocheck(x, y);
+			for(  uint32 i = 0;  i < plan->get_boden_count();  i++  ) {
+				const grund_t *gr = plan->get_boden_bei(i);
+				for(  int n = 0;  n < 2;  n++  ) {
+					if(  weg_t *w = gr->get_weg_nr(n)  ) {
+						w->new_month();
+					}
+				}
+			}
+		}
+	}
+
+	FOR(vector_tpl<halthandle_t>, const s, haltestelle_t::get_alle_haltestellen()) {
+		// stops without tiles in the first row
+		const uint32 y = (uint32)max(0, s->get_basis_pos().y);
+		if(  first_row <= y  &&  y < end_row  ) {
+			s->new_month();
+		}
+	}
+}
+
+
+void karte_t::step_monthly_update()
+{
+	const uint32 rows = get_size().y;
+	const uint32 update_steps = settings.get_monthly_update_steps();
+	// all remaining rows at once if spreading them was switched off meanwhile
+	const uint32 rows_per_step = update_steps > 0 ? (rows + update_steps - 1) / update_steps : rows;
+	const uint32 end_row = monthly_update_row + rows_per_step < rows ? monthly_update_row + rows_per_step : rows;
+
+	new_month_rows(monthly_update_row, end_row);
+	monthly_update_row = end_row;
+
+	if(  monthly_update_row >= rows  ) {
+		// ways may have been renewed or degraded since the start of the month
+		route_cache_t::network_changed();
+	}
+}
+
+
 void karte_t::new_year()
 {
 	last_year = current_month/12;
@@ -5610,8 +5782,30 @@ void karte_t::pause_step()
 #endif
 }
 
+// the factories whose production a task of the factory step calculates
+struct factory_production_job_t
+{
+	const vector_tpl<fabrik_t*> *factories;
+	uint32 delta_t;
+	uint32 task_count;
+};
+
+static void factory_production_task(void *data, uint32 task)
+{
+	step_profiler_t::scope_t profile(step_profiler_t::TASK_FACTORIES);
+	const factory_production_job_t &job = *reinterpret_cast<const factory_production_job_t *>(data);
+	const uint32 count = job.factories->get_count();
+	for(  uint32 i = count * task / job.task_count;  i < count * (task + 1) / job.task_count;  i++  ) {
+		(*job.factories)[i]->step_production(job.delta_t);
+	}
+}
+
 void karte_t::step()
 {
+	step_profiler_t::step_scope_t profile_step(steps);
+
+	check_background_save(false);
+
 	rands[8] = get_random_seed();
 	DBG_DEBUG4("karte_t::step", "start step");
 	uint32 time = dr_time();
@@ -5636,8 +5830,13 @@ void karte_t::step()
 		next_month_ticks += karte_t::ticks_per_world_month;
 
 		DBG_DEBUG4("karte_t::step", "calling new_month");
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_NEW_MONTH);
 		new_month();
 	}
+	if(  monthly_update_row < (uint32)get_size().y  ) {
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_NEW_MONTH);
+		step_monthly_update();
+	}
 	rands[9] = get_random_seed();
 
 	DBG_DEBUG4("karte_t::step", "time calculations");
@@ -5732,6 +5931,7 @@ void karte_t::step()
 		for (sint32 j = 0; j < cities_to_process; j++)
 		{
 			stadt_t* city = cities_awaiting_private_car_route_check.remove_first();
+			step_profiler_t::scope_t profile(step_profiler_t::TASK_PRIVATE_CARS);
 			city->check_all_private_car_routes();
 		}
 #endif
@@ -5772,37 +5972,57 @@ void karte_t::step()
 	INT_CHECK("karte_t::step 1");
 
 #ifdef MULTI_THREAD_PATH_EXPLORER
-	// Stop the path explorer before we use its results.
-	await_path_explorer();
+	{
+		// Stop the path explorer before we use its results.
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_AWAIT_PATH_EXPLORER);
+		await_path_explorer();
+	}
 #else
-	// Knightly : calling global path explorer
-	path_explorer_t::step();
+	{
+		// Knightly : calling global path explorer
+		step_profiler_t::scope_t profile(step_profiler_t::TASK_PATH_EXPLORER);
+		path_explorer_t::step();
+	}
 #endif
 	rands[12] = get_random_seed();
 
 	INT_CHECK("karte_t::step 2");
 
 #ifdef MULTI_THREAD_CONVOYS
-	// Finish the threaded part of the convoys' steps: this is mainly route searches. Block reservation, etc., is in the single threaded part.
-	await_convoy_threads();
+	{
+		// Finish the threaded part of the convoys' steps: this is mainly route searches. Block reservation, etc., is in the single threaded part.
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_AWAIT_CONVOYS);
+		await_convoy_threads();
+	}
 #else
-	for (uint32 i = convoi_array.get_count(); i-- != 0;)
 	{
-		convoihandle_t cnv = convoi_array[i];
-		cnv->threaded_step();
+		step_profiler_t::scope_t profile(step_profiler_t::TASK_CONVOYS);
+		for (uint32 i = convoi_array.get_count(); i-- != 0;)
+		{
+			convoihandle_t cnv = convoi_array[i];
+			cnv->threaded_step();
+		}
 	}
 #endif
 
+	// No route searches run now, so the landmark tables can take in the changes to the ways,
+	// and the route cache the routes found since the last step.
+	landmark_table_t::step(this);
+	route_cache_t::step();
+
 	rands[13] = get_random_seed();
 
 	// The more computationally intensive parts of this have been extracted and made multi-threaded.
 	DBG_DEBUG4("karte_t::step 4", "step %d convois", convoi_array.get_count());
 	// since convois will be deleted during stepping, we need to step backwards
-	for (uint32 i = convoi_array.get_count(); i-- != 0;) {
-		convoihandle_t cnv = convoi_array[i];
-		cnv->step();
-		if((i&7)==0) {
-			INT_CHECK("karte_t::step 3");
+	{
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_CONVOYS);
+		for (uint32 i = convoi_array.get_count(); i-- != 0;) {
+			convoihandle_t cnv = convoi_array[i];
+			cnv->step();
+			if((i&7)==0) {
+				INT_CHECK("karte_t::step 3");
+			}
 		}
 	}
 
@@ -5822,9 +6042,12 @@ void karte_t::step()
 #ifndef CONCURRENT_ROUTE_PROCESSING
 	uint32 step_cities_count = 0;
 #endif
-	FOR(weighted_vector_tpl<stadt_t*>, const i, stadt)
 	{
-		i->step(delta_t);
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_CITIES);
+		FOR(weighted_vector_tpl<stadt_t*>, const i, stadt)
+		{
+			i->step(delta_t);
+		}
 	}
 
 	rands[15] = get_random_seed();
@@ -5835,6 +6058,7 @@ void karte_t::step()
 	// The placement of this method call must be before any code that in any way relies on the private car routes between cities, most especially the mail and passenger generation (step_passengers_and_mail(delta_t)).
 	if (check_city_routes)
 	{
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_AWAIT_PRIVATE_CARS);
 		await_private_car_threads();
 	}
 #endif
@@ -5900,11 +6124,15 @@ void karte_t::step()
 	}
 	else
 	{
+		step_profiler_t::scope_t profile(step_profiler_t::TASK_PASSENGERS);
 		step_passengers_and_mail(delta_t);
 	}
 #endif
 #else
-	step_passengers_and_mail(delta_t);
+	{
+		step_profiler_t::scope_t profile(step_profiler_t::TASK_PASSENGERS);
+		step_passengers_and_mail(delta_t);
+	}
 #endif
 	DBG_DEBUG4("karte_t::step", "step generate passengers and mail");
 
@@ -5931,8 +6159,11 @@ void karte_t::step()
 
 	INT_CHECK("karte_t::step 4");
 
-	// This does nothing if the threading is disabled.
-	await_passengers_and_mail_threads();
+	{
+		// This does nothing if the threading is disabled.
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_AWAIT_PASSENGERS);
+		await_passengers_and_mail_threads();
+	}
 
 	rands[19] = get_random_seed();
 
@@ -6003,8 +6234,22 @@ void karte_t::step()
 	INT_CHECK("karte_t::step 5");
 
 	DBG_DEBUG4("karte_t::step", "step factories");
-	FOR(vector_tpl<fabrik_t*>, const f, fab_list) {
-		f->step(delta_t);
+	{
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_FACTORIES);
+
+		// Each factory produces from its own stock, so they may do so in parallel.
+		// The number of tasks is the same on all clients of a network game.
+		factory_production_job_t data;
+		data.factories = &fab_list;
+		data.delta_t = delta_t;
+		data.task_count = min(fab_list.get_count(), (uint32)max(get_parallel_operations(), 0) + 1);
+		job_scheduler_t::job_t job(&factory_production_task, &data);
+		job_scheduler_t::run(job, data.task_count);
+
+		// Distributing the goods changes stops and other factories, so it runs in the order of the factory list.
+		FOR(vector_tpl<fabrik_t*>, const f, fab_list) {
+			f->step_distribution(delta_t);
+		}
 	}
 	rands[20] = get_random_seed();
 
@@ -6023,9 +6268,12 @@ void karte_t::step()
 	DBG_DEBUG4("karte_t::step", "step players");
 	// then step all players
 	// This is not computationally intensive (except possibly occasionally when liquidating a company)
-	for(  int i=0;  i<MAX_PLAYER_COUNT;  i++  ) {
-		if(  players[i] != NULL  ) {
-			players[i]->step();
+	{
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_PLAYERS);
+		for(  int i=0;  i<MAX_PLAYER_COUNT;  i++  ) {
+			if(  players[i] != NULL  ) {
+				players[i]->step();
+			}
 		}
 	}
 	rands[22] = get_random_seed();
@@ -6034,7 +6282,10 @@ void karte_t::step()
 
 	// This is not computationally intensive
 	DBG_DEBUG4("karte_t::step", "step halts");
-	haltestelle_t::step_all();
+	{
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_HALTS);
+		haltestelle_t::step_all();
+	}
 	rands[23] = get_random_seed();
 
 	// Re-check paths if the time has come.
@@ -6053,10 +6304,22 @@ void karte_t::step()
 
 	INT_CHECK("karte_t::step 8");
 
-	check_transferring_cargoes();
+	{
+		step_profiler_t::scope_t profile(step_profiler_t::STEP_TRANSFERS);
+		check_transferring_cargoes();
+	}
 
 	rands[25] = get_random_seed();
 
+	if(  env_t::networkmode  &&  env_t::network_state_hashes  ) {
+		current_state_hash_log ^= 1;
+		state_hash_logs[current_state_hash_log].calc(this, (uint32)steps);
+	}
+
+	if(  !background_save_name.empty()  ) {
+		start_background_save();
+	}
+
 #ifdef MULTI_THREAD_PATH_EXPLORER
 	// Start the path explorer ready for the next step. This can be very
 	// computationally intensive, but intermittently so.
@@ -6128,22 +6391,32 @@ void karte_t::refresh_private_car_routes() {
 #endif
 	weg_t::swap_private_car_routes_currently_reading_element();
 	clear_private_car_routes();
+	road_graph_t::rebuild(this);
 	for(auto & city : stadt) {
 		cities_awaiting_private_car_route_check.insert(city);
 	}
 }
 
 void karte_t::clear_private_car_routes() {
-	weg_t::private_car_route_map::route_map_lock();
+	const uint8 writing_elem = weg_t::get_private_car_routes_currently_writing_element();
 	for(auto & w : weg_t::get_alle_wege()) {
-		for(auto & l : w->private_car_routes[weg_t::get_private_car_routes_currently_writing_element()]) {
-			l.pre_reset();
-		}
+		w->private_car_routes[writing_elem].reset_table();
 	}
-	weg_t::private_car_route_map::reset(weg_t::get_private_car_routes_currently_writing_element());
-
-	weg_t::private_car_route_map::route_map_unlock();
 
+	// Every destination a route may be recorded to, numbered in spatial order
+	vector_tpl<koord> destinations(fab_list.get_count() + world_attractions.get_count() + stadt.get_count());
+	FOR(vector_tpl<fabrik_t*>, const fab, fab_list) {
+		destinations.append(fab->get_pos().get_2d());
+	}
+	FOR(weighted_vector_tpl<gebaeude_t*>, const attraction, world_attractions) {
+		destinations.append(attraction->get_first_tile()->get_pos().get_2d());
+	}
+	FOR(weighted_vector_tpl<stadt_t*>, const city, stadt) {
+		if(city->get_townhall_road() != koord::invalid) {
+			destinations.append(city->get_townhall_road());
+		}
+	}
+	weg_t::private_car_route_map::reset(writing_elem, destinations);
 }
 
 void karte_t::step_time_interval_signals()
@@ -6417,18 +6690,8 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 	{
 		// Mail is generated in non-city buildings such as attractions.
 		// That will be the only legitimate case in which this condition is not fulfilled.
-#ifdef MULTI_THREAD
-		int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-		assert(mutex_error == 0);
-		(void)mutex_error;
-#endif
-		city->set_generated_passengers(units_this_step, history_type + 1);
-		add_to_debug_sums(5, units_this_step);
-#ifdef MULTI_THREAD
-		mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-		assert(mutex_error == 0);
-		(void)mutex_error;
-#endif
+		book_city_statistic(passenger_statistic_t::city_generated, city, units_this_step, history_type + 1);
+		book_passenger_statistic(passenger_statistic_t(passenger_statistic_t::debug_sum_generated, units_this_step));
 	}
 
 	koord3d origin_pos = gb->get_pos();
@@ -6597,17 +6860,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			// Added here as the original journey had its generated passengers set much earlier, outside the for loop.
 			if(city)
 			{
-#ifdef MULTI_THREAD
-				int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-				(void)mutex_error;
-#endif
-				city->set_generated_passengers(units_this_step, history_type + 1);
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-				(void)mutex_error;
-#endif
+				book_city_statistic(passenger_statistic_t::city_generated, city, units_this_step, history_type + 1);
 			}
 
 			if(route_status != private_car)
@@ -6651,46 +6904,17 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 
 		if(trip == commuting_trip)
 		{
-#ifdef MULTI_THREAD
-			int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-			(void)mutex_error;
-#endif
-			first_origin->add_passengers_generated_commuting(units_this_step);
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-			(void)mutex_error;
-#endif
+			book_building_statistic(passenger_statistic_t::building_generated_commuting, first_origin, units_this_step);
 		}
 
 		else if(trip == visiting_trip)
 		{
-#ifdef MULTI_THREAD
-			int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-			(void)mutex_error;
-#endif
-			first_origin->add_passengers_generated_visiting(units_this_step);
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-			(void)mutex_error;
-#endif
+			book_building_statistic(passenger_statistic_t::building_generated_visiting, first_origin, units_this_step);
 		}
 
 		else if (trip == mail_trip)
 		{
-#ifdef MULTI_THREAD
-			int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-			(void)mutex_error;
-#endif
-			first_origin->add_mail_generated(units_this_step);
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-#endif
+			book_building_statistic(passenger_statistic_t::building_generated_mail, first_origin, units_this_step);
 		}
 
 		/**
@@ -7249,19 +7473,9 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 		bool set_return_trip = false;
 		stadt_t* destination_town;
 
-#ifdef MULTI_THREAD
-		int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-		assert(mutex_error == 0);
-		(void)mutex_error;
-#endif
-
 		switch(route_status)
 		{
 		case public_transport:
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-#endif
 			if(tolerance < UINT32_MAX_VALUE)
 			{
 				tolerance -= best_journey_time;
@@ -7269,13 +7483,9 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			}
 			pax.set_origin(start_halt);
 			start_halt->starte_mit_route(pax, origin_pos.get_2d());
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-#endif
 			if(city && wtyp == goods_manager_t::passengers)
 			{
-				city->merke_passagier_ziel(destination_pos, color_idx_to_rgb(COL_YELLOW));
+				book_passenger_destination(city, destination_pos, color_idx_to_rgb(COL_YELLOW));
 			}
 			set_return_trip = true;
 			// create pedestrians in the near area?
@@ -7287,7 +7497,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			// However, as for the destination, this can be set when the passengers arrive.
 			if(trip == commuting_trip && first_origin)
 			{
-				first_origin->add_passengers_succeeded_commuting(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_commuting, first_origin, units_this_step);
 #ifdef DEBUG_MARCHETTI_CONSTANT
 				if (trip_count == 0)
 				{
@@ -7302,7 +7512,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			}
 			else if(trip == visiting_trip && first_origin)
 			{
-				first_origin->add_passengers_succeeded_visiting(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_visiting, first_origin, units_this_step);
 #ifdef DEBUG_MARCHETTI_CONSTANT
 				if (trip_count == 0)
 				{
@@ -7317,7 +7527,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			}
 			else if (trip == mail_trip && first_origin)
 			{
-				first_origin->add_mail_delivery_succeeded(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_mail, first_origin, units_this_step);
 			}
 		break;
 
@@ -7334,16 +7544,25 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			{
 				// Make sure to normalise the destination for attractions
 				const koord adjusted_destination_pos = current_destination.building->get_first_tile()->get_pos().get_2d();
+#ifdef MULTI_THREAD
+				int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
+				assert(mutex_error == 0);
+#endif
 				city->generate_private_cars(origin_pos.get_2d(), car_minutes, adjusted_destination_pos, units_this_step);
+#ifdef MULTI_THREAD
+				mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
+				assert(mutex_error == 0);
+				(void)mutex_error;
+#endif
 				if(wtyp == goods_manager_t::passengers)
 				{
-					city->set_private_car_trip(units_this_step, destination_town);
-					city->merke_passagier_ziel(destination_pos, color_idx_to_rgb(COL_TURQUOISE));
+					book_city_statistic(passenger_statistic_t::city_private_car_trip, city, units_this_step, 0, destination_town);
+					book_passenger_destination(city, destination_pos, color_idx_to_rgb(COL_TURQUOISE));
 				}
 				else
 				{
 					// Mail
-					city->add_transported_mail(units_this_step);
+					book_city_statistic(passenger_statistic_t::city_transported_mail, city, units_this_step);
 				}
 			}
 
@@ -7352,7 +7571,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			// We cannot do this on arrival, as the ware packets do not remember their origin building.
 			if(trip == commuting_trip)
 			{
-				first_origin->add_passengers_succeeded_commuting(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_commuting, first_origin, units_this_step);
 #ifdef DEBUG_MARCHETTI_CONSTANT
 				if (trip_count == 0)
 				{
@@ -7367,7 +7586,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			}
 			else if(trip == visiting_trip)
 			{
-				first_origin->add_passengers_succeeded_visiting(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_visiting, first_origin, units_this_step);
 #ifdef DEBUG_MARCHETTI_CONSTANT
 				if (trip_count == 0)
 				{
@@ -7382,17 +7601,9 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			}
 			else if(trip == mail_trip)
 			{
-				first_origin->add_mail_delivery_succeeded(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_mail, first_origin, units_this_step);
 			}
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-#endif
 			add_to_waiting_list(pax, origin_pos.get_2d());
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-#endif
 			break;
 
 		case on_foot:
@@ -7416,13 +7627,13 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			{
 				if(wtyp == goods_manager_t::passengers)
 				{
-					city->merke_passagier_ziel(destination_pos, color_idx_to_rgb(COL_DARK_YELLOW));
-					city->add_walking_passengers(units_this_step);
+					book_passenger_destination(city, destination_pos, color_idx_to_rgb(COL_DARK_YELLOW));
+					book_city_statistic(passenger_statistic_t::city_walked, city, units_this_step);
 				}
 				else
 				{
 					// Mail
-					city->add_transported_mail(units_this_step);
+					book_city_statistic(passenger_statistic_t::city_transported_mail, city, units_this_step);
 				}
 			}
 			set_return_trip = true;
@@ -7430,7 +7641,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			// We cannot do this on arrival, as the ware packets do not remember their origin building.
 			if(trip == commuting_trip)
 			{
-				first_origin->add_passengers_succeeded_commuting(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_commuting, first_origin, units_this_step);
 #ifdef DEBUG_MARCHETTI_CONSTANT
 				if (trip_count == 0)
 				{
@@ -7445,7 +7656,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			}
 			else if(trip == visiting_trip)
 			{
-				first_origin->add_passengers_succeeded_visiting(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_visiting, first_origin, units_this_step);
 #ifdef DEBUG_MARCHETTI_CONSTANT
 				if (trip_count == 0)
 				{
@@ -7460,28 +7671,17 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			}
 			else if (trip == mail_trip)
 			{
-				first_origin->add_mail_delivery_succeeded(units_this_step);
+				book_building_statistic(passenger_statistic_t::building_succeeded_mail, first_origin, units_this_step);
 			}
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-
-			// Prevent deadlocks because of double-locking:
-			// there is already a mutex lock in the add_to_waiting_list
-#endif
 			add_to_waiting_list(pax, origin_pos.get_2d());
 			// Do nothing if trip == mail.
-#ifdef MULTI_THREAD
-			mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-			assert(mutex_error == 0);
-#endif
 			break;
 
 		case overcrowded:
 
 			if(city && wtyp == goods_manager_t::passengers)
 			{
-				city->merke_passagier_ziel(best_bad_destination, color_idx_to_rgb(COL_RED));
+				book_passenger_destination(city, best_bad_destination, color_idx_to_rgb(COL_RED));
 			}
 #ifdef MULTI_THREAD
 			if(start_halts[passenger_generation_thread_number].get_count() > 0)
@@ -7494,7 +7694,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 #endif
 				if(start_halt.is_bound())
 				{
-					start_halt->add_pax_unhappy(units_this_step);
+					book_halt_statistic(passenger_statistic_t::halt_unhappy, start_halt, units_this_step);
 				}
 			}
 
@@ -7505,11 +7705,11 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 			{
 				if(car_minutes >= best_journey_time && best_journey_time < UINT32_MAX_VALUE)
 				{
-					city->merke_passagier_ziel(best_bad_destination, color_idx_to_rgb(COL_PURPLE));
+					book_passenger_destination(city, best_bad_destination, color_idx_to_rgb(COL_PURPLE));
 				}
 				else if(car_minutes < UINT32_MAX_VALUE)
 				{
-					city->merke_passagier_ziel(best_bad_destination, color_idx_to_rgb(COL_LIGHT_PURPLE));
+					book_passenger_destination(city, best_bad_destination, color_idx_to_rgb(COL_LIGHT_PURPLE));
 				}
 				else
 				{
@@ -7532,7 +7732,7 @@ sint32 karte_t::generate_passengers_or_mail(const goods_desc_t * wtyp)
 #endif
 			if(start_halt.is_bound() && best_journey_time < UINT32_MAX_VALUE)
 			{
-				start_halt->add_pax_too_slow(units_this_step);
+				book_halt_statistic(passenger_statistic_t::halt_too_slow, start_halt, units_this_step);
 			}
 			break;
 
@@ -7544,11 +7744,11 @@ no_route:
 			{
 				if(route_status == destination_unavailable)
 				{
-					city->merke_passagier_ziel(first_destination.location, color_idx_to_rgb(COL_DARK_RED));
+					book_passenger_destination(city, first_destination.location, color_idx_to_rgb(COL_DARK_RED));
 				}
 				else
 				{
-					city->merke_passagier_ziel(first_destination.location, color_idx_to_rgb(COL_DARK_ORANGE));
+					book_passenger_destination(city, first_destination.location, color_idx_to_rgb(COL_DARK_ORANGE));
 				}
 			}
 #ifdef MULTI_THREAD
@@ -7564,20 +7764,16 @@ no_route:
 				{
 					if (trip == mail_trip)
 					{
-						start_halt->add_mail_no_route(units_this_step);
+						book_halt_statistic(passenger_statistic_t::halt_mail_no_route, start_halt, units_this_step);
 					}
 					else
 					{
-						start_halt->add_pax_no_route(units_this_step);
+						book_halt_statistic(passenger_statistic_t::halt_no_route, start_halt, units_this_step);
 					}
 				}
 			}
 		};
 
-#ifdef MULTI_THREAD
-		mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-		assert(mutex_error == 0);
-#endif
 #ifdef FORBID_RETURN_TRIPS
 		if(false)
 #else
@@ -7596,29 +7792,13 @@ no_route:
 			if(destination_town)
 			{
 #ifndef FORBID_SET_GENERATED_PASSENGERS
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
-				destination_town->set_generated_passengers(units_this_step, history_type + 1);
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
+				book_city_statistic(passenger_statistic_t::city_generated, destination_town, units_this_step, history_type + 1);
 #endif
 			}
 			else if(city)
 			{
 #ifndef FORBID_SET_GENERATED_PASSENGERS
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
-				city->set_generated_passengers(units_this_step, history_type + 1);
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
+				book_city_statistic(passenger_statistic_t::city_generated, city, units_this_step, history_type + 1);
 #endif
 				// Cannot add success figures for buildings here as cannot get a building from a koord.
 				// However, this should not matter much, as equally not recording generated passengers
@@ -7729,18 +7909,10 @@ no_route:
 								// This is somewhat anomalous, as we are recording that the passengers have departed, not arrived, whereas for cities, we record
 								// that they have successfully arrived. However, this is not easy to implement for factories, as passengers do not store their ultimate
 								// origin, so the origin factory is not known by the time that the passengers reach the end of their journey.
-#ifdef MULTI_THREAD
-								mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-								assert(mutex_error == 0);
-#endif
 								if (trip == mail_trip)
 								{
-									current_destination.building->get_fabrik()->book_stat(units_this_step, FAB_MAIL_DEPARTED);
+									book_mail_departed(current_destination.building->get_fabrik(), units_this_step);
 								}
-#ifdef MULTI_THREAD
-								mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-								assert(mutex_error == 0);
-#endif
 							}
 						}
 						else
@@ -7752,15 +7924,7 @@ no_route:
 							}
 							else
 							{
-#ifdef MULTI_THREAD
-								mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-								assert(mutex_error == 0);
-#endif
-								ret_halt->add_pax_unhappy(units_this_step);
-#ifdef MULTI_THREAD
-								mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-								assert(mutex_error == 0);
-#endif
+								book_halt_statistic(passenger_statistic_t::halt_unhappy, ret_halt, units_this_step);
 							}
 						}
 					}
@@ -7775,25 +7939,13 @@ no_route:
 					}
 					else
 					{
-#ifdef MULTI_THREAD
-						mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-						assert(mutex_error == 0);
-#endif
-						ret_halt->add_pax_no_route(units_this_step);
-#ifdef MULTI_THREAD
-						mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-						assert(mutex_error == 0);
-#endif
+						book_halt_statistic(passenger_statistic_t::halt_no_route, ret_halt, units_this_step);
 					}
 				}
 			}
 
 			if(return_in_private_car)
 			{
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
 				if(car_minutes < UINT32_MAX_VALUE)
 				{
 					// Do not check tolerance, as they must come back!
@@ -7801,12 +7953,12 @@ no_route:
 					{
 						if(destination_town)
 						{
-							destination_town->set_private_car_trip(units_this_step, city);
+							book_city_statistic(passenger_statistic_t::city_private_car_trip, destination_town, units_this_step, 0, city);
 						}
 						else
 						{
 							// Industry, attraction or local
-							city->set_private_car_trip(units_this_step, NULL);
+							book_city_statistic(passenger_statistic_t::city_private_car_trip, city, units_this_step);
 						}
 					}
 					else
@@ -7814,11 +7966,11 @@ no_route:
 						// Mail
 						if(destination_town)
 						{
-							destination_town->add_transported_mail(units_this_step);
+							book_city_statistic(passenger_statistic_t::city_transported_mail, destination_town, units_this_step);
 						}
 						else if(city)
 						{
-							city->add_transported_mail(units_this_step);
+							book_city_statistic(passenger_statistic_t::city_transported_mail, city, units_this_step);
 						}
 					}
 					const grund_t* gr_origin = lookup(origin_pos);
@@ -7832,35 +7984,36 @@ no_route:
 						}
 					}
 
+#ifdef MULTI_THREAD
+					int mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
+					assert(mutex_error == 0);
+#endif
 					city->generate_private_cars(current_destination.location, car_minutes, adjusted_return_pos, units_this_step);
+#ifdef MULTI_THREAD
+					mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
+					assert(mutex_error == 0);
+					(void)mutex_error;
+#endif
 					if(current_destination.type == factory && trip == mail_trip)
 					{
-						current_destination.building->get_fabrik()->book_stat(units_this_step, FAB_MAIL_DEPARTED);
+						book_mail_departed(current_destination.building->get_fabrik(), units_this_step);
 					}
 				}
 				else
 				{
 					if(ret_halt.is_bound())
 					{
-						ret_halt->add_pax_no_route(units_this_step);
+						book_halt_statistic(passenger_statistic_t::halt_no_route, ret_halt, units_this_step);
 					}
 					if(city)
 					{
-						city->merke_passagier_ziel(origin_pos.get_2d(), color_idx_to_rgb(COL_DARK_ORANGE));
+						book_passenger_destination(city, origin_pos.get_2d(), color_idx_to_rgb(COL_DARK_ORANGE));
 					}
 				}
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
 			}
 return_on_foot:
 			if(return_on_foot)
 			{
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_lock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
 				if(wtyp == goods_manager_t::passengers)
 				{
 					if (settings.get_random_pedestrians())
@@ -7873,13 +8026,13 @@ return_on_foot:
 					}
 					if(destination_town)
 					{
-						destination_town->add_walking_passengers(units_this_step);
+						book_city_statistic(passenger_statistic_t::city_walked, destination_town, units_this_step);
 					}
 					else if(city)
 					{
 						// Local, attraction or industry.
-						city->merke_passagier_ziel(origin_pos.get_2d(), color_idx_to_rgb(COL_DARK_YELLOW));
-						city->add_walking_passengers(units_this_step);
+						book_passenger_destination(city, origin_pos.get_2d(), color_idx_to_rgb(COL_DARK_YELLOW));
+						book_city_statistic(passenger_statistic_t::city_walked, city, units_this_step);
 					}
 				}
 				else
@@ -7887,21 +8040,17 @@ return_on_foot:
 					// Mail
 					if(destination_town)
 					{
-						destination_town->add_transported_mail(units_this_step);
+						book_city_statistic(passenger_statistic_t::city_transported_mail, destination_town, units_this_step);
 					}
 					else if(city)
 					{
-						city->add_transported_mail(units_this_step);
+						book_city_statistic(passenger_statistic_t::city_transported_mail, city, units_this_step);
 					}
 				}
 				if(current_destination.type == factory && trip == mail_trip)
 				{
-					current_destination.building->get_fabrik()->book_stat(units_this_step, FAB_MAIL_DEPARTED);
+					book_mail_departed(current_destination.building->get_fabrik(), units_this_step);
 				}
-#ifdef MULTI_THREAD
-				mutex_error = pthread_mutex_unlock(&karte_t::step_passengers_and_mail_mutex);
-				assert(mutex_error == 0);
-#endif
 			}
 
 		} // Set return trip
@@ -8455,9 +8604,10 @@ bool karte_t::play_sound_area_clipped(koord const k, uint16 const idx, sound_typ
 }
 
 
-void karte_t::save(const char *filename, bool autosave, const char *version_str, const char *ex_version_str, const char* ex_revision_str, bool silent )
+bool karte_t::save(const char *filename, bool autosave, const char *version_str, const char *ex_version_str, const char* ex_revision_str, bool silent )
 {
 DBG_MESSAGE("karte_t::save()", "saving game to '%s'", filename);
+	bool saved = false;
 	loadsave_t  file;
 	std::string savename = filename;
 	if (!env_t::networkmode || env_t::server)
@@ -8469,7 +8619,10 @@ DBG_MESSAGE("karte_t::save()", "saving game to '%s'", filename);
 		savename[savename.length() - 1] = '_';
 	}
 
-	display_show_load_pointer( true );
+	// the copy for a background save must not touch the display of the original
+	if(  !is_background_save_copy  ) {
+		display_show_load_pointer( true );
+	}
 
 	const loadsave_t::mode_t mode = autosave ? loadsave_t::autosave_mode : loadsave_t::save_mode;
 	const int level = autosave ? loadsave_t::autosave_level : loadsave_t::save_level;
@@ -8488,12 +8641,14 @@ DBG_MESSAGE("karte_t::save()", "saving game to '%s'", filename);
 			create_win( new news_img(err_str), w_time_delete, magic_none);
 		}
 		else {
+			saved = true;
 			if (!env_t::networkmode || env_t::server)
 			{
 				const int renamed_correctly = dr_rename(savename.c_str(), filename);
 				if (renamed_correctly)
 				{
 					dbg->error("karte_t::save()", "cannot open file for renaming: error %u. check permissions.", renamed_correctly);
+					saved = false;
 				}
 			}
 			if(!silent) {
@@ -8504,7 +8659,82 @@ DBG_MESSAGE("karte_t::save()", "saving game to '%s'", filename);
 		}
 		reset_interaction();
 	}
-	display_show_load_pointer( false );
+	if(  !is_background_save_copy  ) {
+		display_show_load_pointer( false );
+	}
+	return saved;
+}
+
+
+void karte_t::start_background_save()
+{
+	const std::string filename = background_save_name;
+	background_save_name.clear();
+
+	if(  background_save_pid > 0  ) {
+		dbg->warning("karte_t::start_background_save()", "Previous autosave still running, skipping '%s'", filename.c_str());
+		return;
+	}
+
+	// No worker of the job scheduler may hold one of its locks when the copy is made,
+	// e.g. while the landmark tables started at the new month are built.
+	job_scheduler_t::await_idle();
+
+	const int pid = dr_fork();
+	if(  pid == 0  ) {
+		// the copy: the connections belong to the original, so only close them here
+		is_background_save_copy = true;
+		socket_list_t::reset();
+		// the workers were not copied, so the copy saves (and compresses) on this thread only
+		job_scheduler_t::forget_workers();
+		const bool saved = save( filename.c_str(), true, env_t::savegame_version_str, env_t::savegame_ex_version_str, env_t::savegame_ex_revision_str, true );
+		dr_exit_child(saved ? 0 : 1);
+	}
+	else if(  pid < 0  ) {
+		dbg->warning("karte_t::start_background_save()", "Cannot save in the background, saving '%s' now", filename.c_str());
+		save( filename.c_str(), true, env_t::savegame_version_str, env_t::savegame_ex_version_str, env_t::savegame_ex_revision_str, true );
+	}
+	else {
+		background_save_pid = pid;
+		background_save_start = dr_time();
+		dbg->message("karte_t::start_background_save()", "Saving '%s' in the background", filename.c_str());
+	}
+}
+
+
+void karte_t::check_background_save(bool wait)
+{
+	if(  background_save_pid <= 0  ) {
+		return;
+	}
+	int result = dr_await_child(background_save_pid, false);
+	while(  result < 0  &&  wait  &&  dr_time() - background_save_start < background_save_timeout  ) {
+		dr_sleep(10);
+		result = dr_await_child(background_save_pid, false);
+	}
+	if(  result < 0  ) {
+		if(  dr_time() - background_save_start < background_save_timeout  ) {
+			return;
+		}
+		// a copy which hangs would keep all later autosaves from starting, and the game from ending
+		dbg->warning("karte_t::check_background_save()", "Background save still running after %u s, ending it", background_save_timeout / 1000);
+		dr_kill_child(background_save_pid);
+		result = 0;
+	}
+	background_save_pid = 0;
+
+	if(  result > 0  ) {
+		dbg->message("karte_t::check_background_save()", "Background save finished after %u ms", dr_time() - background_save_start);
+		if(  !env_t::server  &&  !destroying  ) {
+			create_win( new news_img("Spielstand wurde\ngespeichert!\n"), w_time_delete, magic_none);
+		}
+	}
+	else {
+		dbg->error("karte_t::check_background_save()", "Background save failed");
+		if(  !env_t::server  &&  !destroying  ) {
+			create_win( new news_img("Kann Spielstand\nnicht speichern.\n"), w_info, magic_none);
+		}
+	}
 }
 
 
@@ -8933,6 +9163,11 @@ DBG_MESSAGE("karte_t::save(loadsave_t *file)", "motd filename %s", env_t::server
 		file->rdwr_long(cities_to_process);
 	}
 
+	if (file->is_version_ex_atleast(14, 46))
+	{
+		file->rdwr_long(monthly_update_row);
+	}
+
 	// MUST be at the end of the load/save routine.
 	// save all open windows (upon request)
 	file->rdwr_byte( active_player_nr );
@@ -9321,6 +9556,13 @@ void karte_t::plans_finish_rd( sint16 x_min, sint16 x_max, sint16 y_min, sint16
 #endif
 }
 
+checklist_t karte_t::calc_checklist()
+{
+	return checklist_t(sync_steps, (uint32)steps, network_frame_count, get_random_seed(), halthandle_t::get_next_check(), linehandle_t::get_next_check(), convoihandle_t::get_next_check(),
+		rands, debug_sums, get_state_hashes()
+	);
+}
+
 void karte_t::clear_checklist_history()
 {
 	// TODO: either explain or remove the use of pre-increment (++i)
@@ -9348,6 +9590,8 @@ void karte_t::clear_all_checklists()
 	clear_checklist_history();
 	clear_checklist_rands();
 	clear_checklist_debug_sums();
+	state_hash_logs[0].clear();
+	state_hash_logs[1].clear();
 }
 
 void karte_t::load(loadsave_t *file)
@@ -9634,6 +9878,8 @@ DBG_MESSAGE("karte_t::load()", "init player");
 		stadt_t *s = new stadt_t(file);
 		const sint32 population = s->get_einwohner();
 		stadt.append(s, population > 0 ? population : 1); // This has to be at least 1, or else the weighted vector will not add it. TODO: Remove this check once the population checking method is improved.
+		city_limits_index.add(s, s->get_linksoben(), s->get_rechtsunten());
+		city_centre_index.add(s, s->get_center());
 	}
 
 	DBG_MESSAGE("karte_t::load()","loading blocks");
@@ -9725,6 +9971,7 @@ DBG_MESSAGE("karte_t::load()", "init player");
 		fabrik_t *fab = new fabrik_t(file);
 		if(fab->get_desc()) {
 			fab_list.append(fab);
+			factory_index.add(fab, fab->get_pos().get_2d());
 		}
 		else {
 			dbg->error("karte_t::load()","Unknown factory skipped!");
@@ -10213,6 +10460,11 @@ DBG_MESSAGE("karte_t::load()", "%d factories loaded", fab_list.get_count());
 		file->rdwr_long(cities_to_process);
 	}
 
+	if (file->is_version_ex_atleast(14, 46))
+	{
+		file->rdwr_long(monthly_update_row);
+	}
+
 	// MUST be at the end of the load/save routine.
 	if(  file->is_version_atleast(102, 4)  ) {
 		if(  env_t::restore_UI  ) {
@@ -10232,6 +10484,11 @@ DBG_MESSAGE("karte_t::load()", "%d factories loaded", fab_list.get_count());
 		i->check_road_tiles(false);
 	}
 
+	weg_t::private_car_route_map::finish_loading();
+
+	// the private car route checks resume with the road network as loaded
+	road_graph_t::rebuild(this);
+
 	file->set_buffered(false);
 	clear_random_mode(LOAD_RANDOM);
 
@@ -11183,6 +11440,12 @@ void karte_t::do_network_world_command(network_world_command_t *nwc)
 		if(client_checklist != server_checklist)
 		{
 			dbg->warning("karte_t:::do_network_world_command", "disconnecting due to checklist mismatch:\n%s", buf );
+			const state_hashes_t &server_hashes = nwcheck->server_state_hashes;
+			if(  server_hashes.calculated  ) {
+				// the step of the check may be the one before the newest
+				const uint8 log = server_hashes.step == get_state_hashes().step ? current_state_hash_log : current_state_hash_log ^ 1;
+				state_hash_logs[log].report_mismatch(this, server_hashes);
+			}
 			network_disconnect();
 		} else {
 			dbg->message("karte_t:::do_network_world_command", "sync_step=%u  %s", server_sync_step, buf);
@@ -11386,9 +11649,7 @@ bool karte_t::interactive(uint32 quit_month)
 						network_frame_count = 0;
 					}
 					sync_steps = steps * settings.get_frames_per_step() + network_frame_count;
-					LCHKLST(sync_steps) = checklist_t(sync_steps, (uint32)steps, network_frame_count, get_random_seed(), halthandle_t::get_next_check(), linehandle_t::get_next_check(), convoihandle_t::get_next_check(),
-						rands, debug_sums
-					);
+					LCHKLST(sync_steps) = calc_checklist();
 
 #ifdef DEBUG_SIMRAND_CALLS
 					char buf[2048];
@@ -11407,7 +11668,7 @@ bool karte_t::interactive(uint32 quit_month)
 								dbg->warning("karte_t::interactive", "server lagging by %lli", timelag );
 							}
 
-							nwc_check_t* nwc = new nwc_check_t(sync_steps + 1, map_counter, LCHKLST(sync_steps), sync_steps);
+							nwc_check_t* nwc = new nwc_check_t(sync_steps + 1, map_counter, LCHKLST(sync_steps), get_state_hashes(), sync_steps);
 							network_send_all(nwc, true);
 						}
 						else {
@@ -18,11 +18,13 @@
 #include "tpl/vector_tpl.h"
 #include "tpl/slist_tpl.h"
 #include "tpl/koordhashtable_tpl.h"
+#include "tpl/spatial_index_tpl.h"
 
 #include "dataobj/settings.h"
 #include "network/pwd_hash.h"
 #include "dataobj/loadsave.h"
 #include "dataobj/rect.h"
+#include "dataobj/state_hashes.h"
 
 #include "simware.h"
 
@@ -109,8 +111,11 @@ struct checklist_t
 	uint32 rand[CHK_RANDS];
 	uint32 debug_sum[CHK_DEBUG_SUMS];
 
+	// 0 unless env_t::network_state_hashes is set
+	uint32 state_hash[state_hashes_t::MAX_SUBSYSTEMS];
 
-	checklist_t(uint32 _ss, uint32 _st, uint8 _nfc, uint32 _random_seed, uint16 _halt_entry, uint16 _line_entry, uint16 _convoy_entry, uint32 *_rands, uint32 *_debug_sums);
+
+	checklist_t(uint32 _ss, uint32 _st, uint8 _nfc, uint32 _random_seed, uint16 _halt_entry, uint16 _line_entry, uint16 _convoy_entry, uint32 *_rands, uint32 *_debug_sums, const state_hashes_t &_state_hashes);
 	checklist_t() : ss(0), st(0), nfc(0), random_seed(0), halt_entry(0), line_entry(0), convoy_entry(0)
 	{
 		for(  uint8 i = 0;  i < CHK_RANDS;  i++  ) {
@@ -119,6 +124,9 @@ struct checklist_t
 		for(  uint8 i = 0;  i < CHK_DEBUG_SUMS;  i++  ) {
 			debug_sum[i] = 0;
 		}
+		for(  uint8 i = 0;  i < state_hashes_t::MAX_SUBSYSTEMS;  i++  ) {
+			state_hash[i] = 0;
+		}
 	}
 
 	bool operator == (const checklist_t &other) const
@@ -133,8 +141,14 @@ struct checklist_t
 			// debugs_equal = debugs_equal  &&  (debug_sum[i] == 0  ||  other.debug_sum[i] == 0  ||  debug_sum[i] == other.debug_sum[i]);
 			debugs_equal = debugs_equal  &&  debug_sum[i] == other.debug_sum[i];
 		}
+		bool hashes_equal = true;
+		for(  uint8 i = 0;  i < state_hashes_t::MAX_SUBSYSTEMS  &&  hashes_equal;  i++  ) {
+			// either side may not calculate them
+			hashes_equal = state_hash[i] == 0  ||  other.state_hash[i] == 0  ||  state_hash[i] == other.state_hash[i];
+		}
 		return ( rands_equal &&
 			debugs_equal &&
+			hashes_equal &&
 			ss == other.ss &&
 			st == other.st &&
 			nfc == other.nfc &&
@@ -431,6 +445,18 @@ private:
 	 */
 	weighted_vector_tpl<stadt_t*> stadt;
 
+	/**
+	 * The cities by their city limits and by their centres, the tourist attractions
+	 * and the factories by their positions, to find them near a position.
+	 */
+	spatial_index_tpl<stadt_t*> city_limits_index;
+	spatial_index_tpl<stadt_t*> city_centre_index;
+	spatial_index_tpl<gebaeude_t*> attraction_index;
+	spatial_index_tpl<fabrik_t*> factory_index;
+
+	/// Fills the spatial indices from the lists, for the current size of the map
+	void rebuild_spatial_indices();
+
 	sint64 last_month_bev;
 
 	/**
@@ -625,6 +651,10 @@ private:
 	uint32 rands[CHK_RANDS];
 	uint32 debug_sums[CHK_DEBUG_SUMS];
 
+	// the state hashes of the last two steps, the newer one at current_state_hash_log
+	state_hash_log_t state_hash_logs[2];
+	uint8 current_state_hash_log;
+
 
 	/// @note variable used in interactive()
 	uint8  network_frame_count;
@@ -738,6 +768,13 @@ private:
 	 */
 	uint32 tile_counter;
 
+	/**
+	 * The next row of the map whose ways and stops start their new month, if
+	 * this is spread over several steps (see settings_t::monthly_update_steps).
+	 * At least the map height when all have.
+	 */
+	uint32 monthly_update_row;
+
 	/**
 	 * To identify different stages of the same game.
 	 */
@@ -764,6 +801,15 @@ private:
 	 */
 	void new_month();
 
+	/**
+	 * Monthly actions of the ways and stops in the rows from @p first_row up to
+	 * @p end_row of the map. Stops count as in the row of their base tile.
+	 */
+	void new_month_rows(uint32 first_row, uint32 end_row);
+
+	/// Continues the monthly actions of the ways and stops, if they are spread over several steps
+	void step_monthly_update();
+
 	/**
 	 * Yearly actions.
 	 */
@@ -774,6 +820,25 @@ private:
 	 */
 	void save(loadsave_t *file, bool silent);
 
+	/// Name of the autosave to write in the background at the end of this step, or empty
+	std::string background_save_name;
+
+	/// The copy of this process writing the background save, or 0
+	int background_save_pid;
+	uint32 background_save_start;
+
+	/// Whether this is the copy writing a background save, in which no other threads exist
+	bool is_background_save_copy;
+
+	/// Writes background_save_name in a copy of this process. Must be called while no other thread is working.
+	void start_background_save();
+
+	/// A background save still running after this many milliseconds is ended as failed
+	static const uint32 background_save_timeout = 10 * 60 * 1000;
+
+	/// Reports the end of the background save; if @p wait, waits for it, at most until background_save_timeout
+	void check_background_save(bool wait);
+
 	/**
 	 * Internal loading method.
 	 */
@@ -853,7 +918,7 @@ private:
 	};
 
 	void world_xy_loop(xy_loop_func func, uint8 flags);
-	static void *world_xy_loop_thread(void *);
+	static void world_xy_loop_task(void *data, uint32 band);
 
 	/**
 	 * Loops over plans after load.
@@ -947,13 +1012,10 @@ private:
 #ifdef MULTI_THREAD
 	bool passengers_and_mail_threads_working;
 	bool convoy_threads_working;
-	bool path_explorer_working;
 	bool private_car_threads_working;
 public:
-	static simthread_barrier_t step_convoys_barrier_external;
-	static simthread_barrier_t unreserve_route_barrier;
 	static simthread_barrier_t private_car_barrier;
-	static pthread_mutex_t unreserve_route_mutex;
+	// Only for what the passenger generation tasks cannot book for later, such as new private cars.
 	static pthread_mutex_t step_passengers_and_mail_mutex;
 	static bool private_car_route_mutex_initialised;
 	static pthread_mutex_t private_car_route_mutex;
@@ -961,6 +1023,13 @@ public:
 	void start_convoy_threads();
 	void start_path_explorer();
 	void start_private_car_threads(bool override_suspend = false);
+
+	/**
+	 * Generates @p packets packets of passengers with one task, then with two and so on
+	 * up to the number of passenger generation tasks, and prints the packets per second.
+	 * The passengers remain in the game.
+	 */
+	void benchmark_passenger_generation(uint32 packets);
 #else
 public:
 #endif
@@ -1001,11 +1070,10 @@ private:
 	static sint32 cities_to_process;
 #ifdef MULTI_THREAD
 	friend void *check_road_connexions_threaded(void* args);
-	friend void *unreserve_route_threaded(void* args);
-	friend void *step_passengers_and_mail_threaded(void* args);
-	friend void *step_convoys_threaded(void* args);
-	friend void *path_explorer_threaded(void* args);
-	friend void *step_individual_convoy_threaded(void* args);
+	friend void step_passengers_and_mail_task(void *data, uint32 task);
+	friend void passenger_benchmark_task(void *data, uint32 task);
+	friend void step_convoys_task(void *data, uint32 task);
+	friend void path_explorer_task(void *data, uint32 task);
 	static vector_tpl<convoihandle_t> convoys_next_step;
 	public:
 	static bool threads_initialised;
@@ -2322,11 +2390,23 @@ public:
 	 */
 	bool remove_city(stadt_t *s);
 
+	/// Called by a city whose city limits changed from @p old_lo, @p old_ur
+	void update_city_limits(stadt_t *s, koord old_lo, koord old_ur);
+
 	/* tourist attraction list */
 	void add_attraction(gebaeude_t *gb);
 	void remove_attraction(gebaeude_t *gb);
 	const weighted_vector_tpl<gebaeude_t*> &get_attractions() const {return world_attractions; }
 
+	/**
+	 * To find cities, tourist attractions and factories near a position.
+	 * The cities are indexed by their city limits and by the centres of these.
+	 */
+	const spatial_index_tpl<stadt_t*> &get_city_limits_index() const { return city_limits_index; }
+	const spatial_index_tpl<stadt_t*> &get_city_centre_index() const { return city_centre_index; }
+	const spatial_index_tpl<gebaeude_t*> &get_attraction_index() const { return attraction_index; }
+	const spatial_index_tpl<fabrik_t*> &get_factory_index() const { return factory_index; }
+
 	void add_label(koord k) { if (!labels.is_contained(k)) labels.append(k); }
 	void remove_label(koord k) { labels.remove(k); }
 	const slist_tpl<koord>& get_label_list() const { return labels; }
@@ -2557,8 +2637,9 @@ public:
 	/**
 	 * Saves the map to a file.
 	 * @param filename name of the file to write.
+	 * @returns false if the file could not be written
 	 */
-	void save(const char *filename, bool autosave, const char *version, const char *ex_version, const char* ex_revision, bool silent);
+	bool save(const char *filename, bool autosave, const char *version, const char *ex_version, const char* ex_revision, bool silent);
 
 	/**
 	 * Loads a map from a file.
@@ -2597,8 +2678,14 @@ public:
 	void set_checklist_at(const uint32 sync_step, const checklist_t &chklst) { LCHKLST(sync_step) = chklst; }
 
 	const checklist_t& get_last_checklist() const { return LCHKLST(sync_steps); }
+
+	/// The newest state hashes, as sent with nwc_check_t
+	const state_hashes_t &get_state_hashes() const { return state_hash_logs[current_state_hash_log].get_hashes(); }
 	uint32 get_last_checklist_sync_step() const { return sync_steps; }
 
+	/// The checklist of the current state, as recorded for each sync step of a network game
+	checklist_t calc_checklist();
+
 	void clear_checklist_history();
 	void clear_checklist_debug_sums();
 	void clear_checklist_rands();
@@ -2709,7 +2796,7 @@ private:
 
 	void refresh_private_car_routes();
 
-	static void clear_private_car_routes() ;
+	void clear_private_car_routes();
 };
 
 
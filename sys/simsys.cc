@@ -39,12 +39,16 @@
 #	else
 #		include <sys\unistd.h>
 #	endif
+#	include <psapi.h>
 #	include "../simdebug.h"
 #else
 #	include <limits.h>
 #	include <dirent.h>
 #	if !defined __AMIGA__ && !defined __BEOS__
 #		include <unistd.h>
+#		include <sys/resource.h>
+#		include <sys/wait.h>
+#		include <signal.h>
 #	endif
 #endif
 
@@ -299,6 +303,84 @@ char *dr_getcwd(char *buf, size_t size)
 #endif
 }
 
+uint64 dr_get_peak_memory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if(  K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))  ) {
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#elif defined __linux__  ||  defined __APPLE__  ||  defined __FreeBSD__  ||  defined __OpenBSD__  ||  defined __NetBSD__
+	struct rusage usage;
+	if(  getrusage(RUSAGE_SELF, &usage) == 0  ) {
+#ifdef __APPLE__
+		return (uint64)usage.ru_maxrss;
+#else
+		// in kilobytes
+		return (uint64)usage.ru_maxrss * 1024;
+#endif
+	}
+	return 0;
+#else
+	return 0;
+#endif
+}
+
+#if defined _WIN32  ||  defined __AMIGA__  ||  defined __BEOS__
+
+int dr_fork()
+{
+	return -1;
+}
+
+void dr_exit_child(int code)
+{
+	exit(code);
+}
+
+int dr_await_child(int, bool)
+{
+	return 0;
+}
+
+void dr_kill_child(int)
+{
+}
+
+#else
+
+int dr_fork()
+{
+	// or the copy would write out what is buffered again
+	fflush(NULL);
+	return fork();
+}
+
+void dr_exit_child(int code)
+{
+	_exit(code);
+}
+
+int dr_await_child(int pid, bool wait)
+{
+	int status;
+	const pid_t ret = waitpid(pid, &status, wait ? 0 : WNOHANG);
+	if(  ret == 0  ) {
+		return -1;
+	}
+	return ret == pid  &&  WIFEXITED(status)  &&  WEXITSTATUS(status) == 0;
+}
+
+void dr_kill_child(int pid)
+{
+	kill(pid, SIGKILL);
+	int status;
+	waitpid(pid, &status, 0);
+}
+
+#endif
+
 FILE *dr_fopen (const char *filename, const char *mode)
 {
 #ifdef _WIN32
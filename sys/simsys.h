@@ -117,6 +117,28 @@ int dr_chdir(const char *path);
 // Functions the same as getcwd except path must be UTF-8 encoded.
 char *dr_getcwd(char *buf, size_t size);
 
+// Returns the most memory this program has occupied so far in bytes, or 0 if unknown.
+uint64 dr_get_peak_memory();
+
+/**
+ * Starts a copy of this process, which goes on from here with a snapshot of its memory.
+ * Only the calling thread exists in the copy, which must end with dr_exit_child().
+ * @returns the id of the copy in the original, 0 in the copy, or -1 if this failed or is not supported
+ */
+int dr_fork();
+
+// Ends the copy made by dr_fork() at once, without flushing or cleaning up the state shared with the original.
+void dr_exit_child(int code);
+
+/**
+ * Checks whether the copy @p pid made by dr_fork() has ended; if @p wait, waits until it has.
+ * @returns 1 if it ended with code 0, 0 if it ended otherwise, -1 if it is still running
+ */
+int dr_await_child(int pid, bool wait);
+
+// Ends the copy @p pid made by dr_fork() at once, and waits until it has ended.
+void dr_kill_child(int pid);
+
 // Functions the same as fopen except filename must be UTF-8 encoded.
 FILE *dr_fopen(const char *filename, const char *mode);
 
@@ -0,0 +1,311 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef TPL_SPATIAL_INDEX_TPL_H
+#define TPL_SPATIAL_INDEX_TPL_H
+
+
+#include <algorithm>
+
+#include "vector_tpl.h"
+#include "../dataobj/koord.h"
+
+
+/**
+ * Finds the objects near a position on the map without looking at all of them.
+ *
+ * The map is divided into square cells of a fixed size. Each object covers a
+ * rectangle of tiles (a single tile for most objects), and is kept in every cell
+ * that its rectangle overlaps. A query only looks at the cells around its position.
+ *
+ * Distances are measured like koord_distance(), from the position to the nearest
+ * tile of the rectangle of an object. Objects at the same distance are ordered by
+ * the north-west corner of their rectangle, so that the order of the results does
+ * not depend on the order in which the objects were added, e.g. after loading a game.
+ *
+ * The index must not be changed while other threads query it.
+ */
+template<class T> class spatial_index_tpl
+{
+private:
+	struct entry_t
+	{
+		T obj;
+		koord lo, ur;
+	};
+
+	struct found_t
+	{
+		const entry_t *entry;
+		uint32 distance;
+	};
+
+	// orders by distance, then by position
+	struct found_order_t
+	{
+		bool operator()(const found_t &a, const found_t &b) const
+		{
+			if(  a.distance != b.distance  ) {
+				return a.distance < b.distance;
+			}
+			if(  a.entry->lo.y != b.entry->lo.y  ) {
+				return a.entry->lo.y < b.entry->lo.y;
+			}
+			return a.entry->lo.x < b.entry->lo.x;
+		}
+	};
+
+	sint32 cell_size;
+
+	// number of cells in x and y direction
+	sint32 width, height;
+
+	vector_tpl<entry_t> *cells;
+
+	uint32 count;
+
+	sint32 get_cell_x(sint32 x) const { return x < 0 ? 0 : min(x / cell_size, width - 1); }
+	sint32 get_cell_y(sint32 y) const { return y < 0 ? 0 : min(y / cell_size, height - 1); }
+
+	vector_tpl<entry_t> &get_cell(sint32 x, sint32 y) const { return cells[y * width + x]; }
+
+	static uint32 get_distance(koord pos, const entry_t &entry)
+	{
+		const sint32 dx = max(0, max(entry.lo.x - pos.x, pos.x - entry.ur.x));
+		const sint32 dy = max(0, max(entry.lo.y - pos.y, pos.y - entry.ur.y));
+		return (uint32)(dx + dy);
+	}
+
+	/**
+	 * An object lies in several cells, but is only reported from the one nearest
+	 * to the cell of the query at @p cx, @p cy.
+	 */
+	bool is_reported_in(const entry_t &entry, sint32 cx, sint32 cy, sint32 x, sint32 y) const
+	{
+		const sint32 report_x = max(get_cell_x(entry.lo.x), min(cx, get_cell_x(entry.ur.x)));
+		const sint32 report_y = max(get_cell_y(entry.lo.y), min(cy, get_cell_y(entry.ur.y)));
+		return report_x == x  &&  report_y == y;
+	}
+
+	// appends the objects reported in cell x, y to found
+	void collect(koord pos, sint32 cx, sint32 cy, sint32 x, sint32 y, vector_tpl<found_t> &found) const
+	{
+		const vector_tpl<entry_t> &cell = get_cell(x, y);
+		for(  uint32 i = 0;  i < cell.get_count();  i++  ) {
+			if(  is_reported_in(cell[i], cx, cy, x, y)  ) {
+				found_t f;
+				f.entry = &cell[i];
+				f.distance = get_distance(pos, cell[i]);
+				found.append(f);
+			}
+		}
+	}
+
+	// the cells of the index must not be shared
+	spatial_index_tpl(const spatial_index_tpl &);
+	spatial_index_tpl &operator=(const spatial_index_tpl &);
+
+public:
+	explicit spatial_index_tpl(sint16 cell_size) :
+		cell_size(cell_size),
+		width(0),
+		height(0),
+		cells(NULL),
+		count(0)
+	{
+	}
+
+	~spatial_index_tpl()
+	{
+		delete [] cells;
+	}
+
+	/// Removes all objects, and covers a map of @p size tiles from now on
+	void resize(koord size)
+	{
+		delete [] cells;
+		width = max(1, (size.x + cell_size - 1) / cell_size);
+		height = max(1, (size.y + cell_size - 1) / cell_size);
+		cells = new vector_tpl<entry_t>[width * height];
+		count = 0;
+	}
+
+	/// Removes all objects
+	void clear()
+	{
+		for(  sint32 i = 0;  i < width * height;  i++  ) {
+			cells[i].clear();
+		}
+		count = 0;
+	}
+
+	uint32 get_count() const { return count; }
+
+	/// Adds @p obj covering the tiles from @p lo to @p ur, both included. Ignored before the first resize().
+	void add(T obj, koord lo, koord ur)
+	{
+		if(  cells == NULL  ) {
+			return;
+		}
+		entry_t entry;
+		entry.obj = obj;
+		entry.lo = lo;
+		entry.ur = ur;
+		for(  sint32 y = get_cell_y(lo.y);  y <= get_cell_y(ur.y);  y++  ) {
+			for(  sint32 x = get_cell_x(lo.x);  x <= get_cell_x(ur.x);  x++  ) {
+				get_cell(x, y).append(entry);
+			}
+		}
+		count++;
+	}
+
+	void add(T obj, koord pos) { add(obj, pos, pos); }
+
+	/// Removes @p obj, which must have been added with the same rectangle. @returns false if it was not found.
+	bool remove(T obj, koord lo, koord ur)
+	{
+		if(  cells == NULL  ) {
+			return false;
+		}
+		bool found = false;
+		for(  sint32 y = get_cell_y(lo.y);  y <= get_cell_y(ur.y);  y++  ) {
+			for(  sint32 x = get_cell_x(lo.x);  x <= get_cell_x(ur.x);  x++  ) {
+				vector_tpl<entry_t> &cell = get_cell(x, y);
+				for(  uint32 i = 0;  i < cell.get_count();  i++  ) {
+					if(  cell[i].obj == obj  &&  cell[i].lo == lo  &&  cell[i].ur == ur  ) {
+						cell.remove_at(i);
+						found = true;
+						break;
+					}
+				}
+			}
+		}
+		if(  found  ) {
+			count--;
+		}
+		return found;
+	}
+
+	bool remove(T obj, koord pos) { return remove(obj, pos, pos); }
+
+	/// Appends the objects covering @p pos to @p result, in the order they were added
+	void get_at(koord pos, vector_tpl<T> &result) const
+	{
+		if(  cells == NULL  ) {
+			return;
+		}
+		const vector_tpl<entry_t> &cell = get_cell(get_cell_x(pos.x), get_cell_y(pos.y));
+		for(  uint32 i = 0;  i < cell.get_count();  i++  ) {
+			const entry_t &entry = cell[i];
+			if(  entry.lo.x <= pos.x  &&  pos.x <= entry.ur.x  &&  entry.lo.y <= pos.y  &&  pos.y <= entry.ur.y  ) {
+				result.append(entry.obj);
+			}
+		}
+	}
+
+	/// Appends the objects within @p radius of @p pos to @p result, the nearest first
+	void get_within(koord pos, uint32 radius, vector_tpl<T> &result) const
+	{
+		if(  cells == NULL  ) {
+			return;
+		}
+		// beyond this, all cells are searched anyway
+		const uint32 max_radius = (uint32)((width + height) * cell_size);
+		const sint32 r = (sint32)(radius < max_radius ? radius : max_radius);
+		const sint32 cx = get_cell_x(pos.x);
+		const sint32 cy = get_cell_y(pos.y);
+
+		vector_tpl<found_t> found;
+		for(  sint32 y = get_cell_y(pos.y - r);  y <= get_cell_y(pos.y + r);  y++  ) {
+			for(  sint32 x = get_cell_x(pos.x - r);  x <= get_cell_x(pos.x + r);  x++  ) {
+				const vector_tpl<entry_t> &cell = get_cell(x, y);
+				for(  uint32 i = 0;  i < cell.get_count();  i++  ) {
+					const uint32 distance = get_distance(pos, cell[i]);
+					if(  distance <= radius  &&  is_reported_in(cell[i], cx, cy, x, y)  ) {
+						found_t f;
+						f.entry = &cell[i];
+						f.distance = distance;
+						found.append(f);
+					}
+				}
+			}
+		}
+
+		std::stable_sort(found.begin(), found.end(), found_order_t());
+		for(  uint32 i = 0;  i < found.get_count();  i++  ) {
+			result.append(found[i].entry->obj);
+		}
+	}
+
+	/**
+	 * Appends the @p wanted objects nearest to @p pos to @p result, the nearest first,
+	 * or all objects if there are fewer.
+	 * The cells are searched in rings around @p pos, until no unsearched cell can hold a nearer object.
+	 */
+	void get_nearest(koord pos, uint32 wanted, vector_tpl<T> &result) const
+	{
+		if(  cells == NULL  ||  wanted == 0  ) {
+			return;
+		}
+		const sint32 cx = get_cell_x(pos.x);
+		const sint32 cy = get_cell_y(pos.y);
+
+		vector_tpl<found_t> found;
+		for(  sint32 r = 0;  ;  r++  ) {
+			// the cells at distance r from the cell of pos
+			for(  sint32 y = max(0, cy - r);  y <= min(height - 1, cy + r);  y++  ) {
+				if(  y == cy - r  ||  y == cy + r  ) {
+					for(  sint32 x = max(0, cx - r);  x <= min(width - 1, cx + r);  x++  ) {
+						collect(pos, cx, cy, x, y, found);
+					}
+				}
+				else {
+					if(  cx - r >= 0  ) {
+						collect(pos, cx, cy, cx - r, y, found);
+					}
+					if(  cx + r < width  ) {
+						collect(pos, cx, cy, cx + r, y, found);
+					}
+				}
+			}
+
+			// all objects not found yet are outside the searched cells
+			const bool searched_all = cx - r <= 0  &&  cx + r >= width - 1  &&  cy - r <= 0  &&  cy + r >= height - 1;
+			if(  searched_all  ) {
+				break;
+			}
+			// the least distance of a tile outside them
+			sint32 unsearched = SINT32_MAX_VALUE;
+			if(  cx - r > 0  ) {
+				unsearched = min(unsearched, pos.x - (cx - r) * cell_size + 1);
+			}
+			if(  cx + r < width - 1  ) {
+				unsearched = min(unsearched, (cx + r + 1) * cell_size - pos.x);
+			}
+			if(  cy - r > 0  ) {
+				unsearched = min(unsearched, pos.y - (cy - r) * cell_size + 1);
+			}
+			if(  cy + r < height - 1  ) {
+				unsearched = min(unsearched, (cy + r + 1) * cell_size - pos.y);
+			}
+			uint32 nearer = 0;
+			for(  uint32 i = 0;  i < found.get_count();  i++  ) {
+				if(  (sint32)found[i].distance < unsearched  ) {
+					nearer++;
+				}
+			}
+			if(  nearer >= wanted  ) {
+				break;
+			}
+		}
+
+		std::stable_sort(found.begin(), found.end(), found_order_t());
+		for(  uint32 i = 0;  i < found.get_count()  &&  i < wanted;  i++  ) {
+			result.append(found[i].entry->obj);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,359 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include "job_scheduler.h"
+
+#include "simthread.h"
+#include "../simdebug.h"
+#include "../tpl/vector_tpl.h"
+
+
+#ifdef MULTI_THREAD
+
+struct task_t
+{
+	job_scheduler_t::job_t *job;
+	uint32 number;
+};
+
+// the tasks waiting for a worker; the owner takes from the front, others steal from the back
+struct task_queue_t
+{
+	pthread_mutex_t mutex;
+	vector_tpl<task_t> tasks;
+	uint32 first;
+};
+
+static vector_tpl<task_queue_t *> queues;
+static vector_tpl<pthread_t> workers;
+static void (*worker_exit_function)(void *) = NULL;
+static bool stopping = false;
+
+// set in a copy of the process, in which no workers may be started
+static bool workers_forgotten = false;
+
+// guards the counters below and the unfinished tasks of all jobs
+static pthread_mutex_t scheduler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tasks_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t tasks_finished = PTHREAD_COND_INITIALIZER;
+
+// tasks in the queues; may drop below zero for a moment while a job is submitted
+static sint32 queued_count = 0;
+
+// tasks of all jobs submitted and not yet finished, and the workers waiting for new tasks
+static uint32 unfinished_count = 0;
+static uint32 waiting_workers = 0;
+static bool awaiting_idle = false;
+
+static thread_local uint32 worker_number = UINT32_MAX_VALUE;
+
+
+/**
+ * Takes a task from the queues, starting with queue @p first.
+ * If @p job is given, only tasks of this job are taken.
+ */
+static bool take_task(uint32 first, const job_scheduler_t::job_t *job, task_t &task)
+{
+	const uint32 queue_count = queues.get_count();
+	for(  uint32 i = 0;  i < queue_count;  i++  ) {
+		task_queue_t &queue = *queues[(first + i) % queue_count];
+		bool found = false;
+
+		pthread_mutex_lock(&queue.mutex);
+		if(  job  ) {
+			for(  uint32 j = queue.first;  j < queue.tasks.get_count();  j++  ) {
+				if(  queue.tasks[j].job == job  ) {
+					task = queue.tasks[j];
+					queue.tasks.remove_at(j);
+					found = true;
+					break;
+				}
+			}
+		}
+		else if(  queue.first < queue.tasks.get_count()  ) {
+			if(  i == 0  ) {
+				task = queue.tasks[queue.first++];
+			}
+			else {
+				task = queue.tasks.pop_back();
+			}
+			found = true;
+		}
+		if(  queue.first >= queue.tasks.get_count()  ) {
+			queue.tasks.clear();
+			queue.first = 0;
+		}
+		pthread_mutex_unlock(&queue.mutex);
+
+		if(  found  ) {
+			pthread_mutex_lock(&scheduler_mutex);
+			queued_count--;
+			pthread_mutex_unlock(&scheduler_mutex);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+static void run_task(const task_t &task)
+{
+	job_scheduler_t::job_t &job = *task.job;
+	(*job.function)(job.data, task.number);
+
+	// the job may be gone as soon as its last task is marked finished
+	pthread_mutex_lock(&scheduler_mutex);
+	unfinished_count--;
+	if(  --job.unfinished == 0  ||  (unfinished_count == 0  &&  awaiting_idle)  ) {
+		pthread_cond_broadcast(&tasks_finished);
+	}
+	pthread_mutex_unlock(&scheduler_mutex);
+}
+
+
+static void *worker_thread(void *args)
+{
+	worker_number = (uint32)(size_t)args;
+
+	while(  true  ) {
+		task_t task;
+		if(  take_task(worker_number, NULL, task)  ) {
+			run_task(task);
+			continue;
+		}
+
+		pthread_mutex_lock(&scheduler_mutex);
+		while(  queued_count <= 0  &&  !stopping  ) {
+			waiting_workers++;
+			if(  awaiting_idle  ) {
+				pthread_cond_broadcast(&tasks_finished);
+			}
+			pthread_cond_wait(&tasks_queued, &scheduler_mutex);
+			waiting_workers--;
+		}
+		const bool stop = stopping  &&  queued_count <= 0;
+		pthread_mutex_unlock(&scheduler_mutex);
+		if(  stop  ) {
+			break;
+		}
+	}
+
+	if(  worker_exit_function  ) {
+		worker_exit_function(NULL);
+	}
+	return NULL;
+}
+
+
+void job_scheduler_t::start(uint32 worker_count, void (*worker_exit)(void *))
+{
+	if(  !queues.empty()  ||  workers_forgotten  ) {
+		return;
+	}
+
+	worker_exit_function = worker_exit;
+
+	// without workers, the waiting threads run all tasks from a single queue
+	for(  uint32 i = 0;  i < (worker_count > (uint32)1 ? worker_count : (uint32)1);  i++  ) {
+		task_queue_t *queue = new task_queue_t;
+		pthread_mutex_init(&queue->mutex, NULL);
+		queue->first = 0;
+		queues.append(queue);
+	}
+
+	for(  uint32 i = 0;  i < worker_count;  i++  ) {
+		pthread_t thread;
+		const int rc = pthread_create(&thread, NULL, &worker_thread, (void *)(size_t)i);
+		if(  rc  ) {
+			dbg->fatal("job_scheduler_t::start()", "Failed to create worker thread, error %d", rc);
+		}
+		workers.append(thread);
+	}
+}
+
+
+void job_scheduler_t::stop()
+{
+	pthread_mutex_lock(&scheduler_mutex);
+	stopping = true;
+	pthread_cond_broadcast(&tasks_queued);
+	pthread_mutex_unlock(&scheduler_mutex);
+
+	FOR(vector_tpl<pthread_t>, worker, workers) {
+		pthread_join(worker, NULL);
+	}
+	workers.clear();
+
+	FOR(vector_tpl<task_queue_t *>, queue, queues) {
+		assert(queue->tasks.empty());
+		pthread_mutex_destroy(&queue->mutex);
+		delete queue;
+	}
+	queues.clear();
+
+	stopping = false;
+}
+
+
+void job_scheduler_t::await_idle()
+{
+	if(  queues.empty()  ) {
+		return;
+	}
+
+	// without workers, nobody else would run the queued tasks
+	task_t task;
+	while(  take_task(0, NULL, task)  ) {
+		run_task(task);
+	}
+
+	pthread_mutex_lock(&scheduler_mutex);
+	awaiting_idle = true;
+	while(  unfinished_count > 0  ||  waiting_workers < workers.get_count()  ) {
+		pthread_cond_wait(&tasks_finished, &scheduler_mutex);
+	}
+	awaiting_idle = false;
+	pthread_mutex_unlock(&scheduler_mutex);
+}
+
+
+void job_scheduler_t::forget_workers()
+{
+	workers.clear();
+	FOR(vector_tpl<task_queue_t *>, queue, queues) {
+		delete queue;
+	}
+	queues.clear();
+	workers_forgotten = true;
+
+	queued_count = 0;
+	unfinished_count = 0;
+	waiting_workers = 0;
+
+	// waiters which are not copied may be recorded in these
+	pthread_mutex_init(&scheduler_mutex, NULL);
+	pthread_cond_init(&tasks_queued, NULL);
+	pthread_cond_init(&tasks_finished, NULL);
+}
+
+
+uint32 job_scheduler_t::get_worker_count()
+{
+	return workers.get_count();
+}
+
+
+uint32 job_scheduler_t::get_worker_number()
+{
+	return worker_number;
+}
+
+
+void job_scheduler_t::submit(job_t &job, uint32 task_count)
+{
+	if(  queues.empty()  ) {
+		// no workers started, e.g. while a world is destroyed
+		for(  uint32 i = 0;  i < task_count;  i++  ) {
+			(*job.function)(job.data, i);
+		}
+		return;
+	}
+	if(  task_count == 0  ) {
+		return;
+	}
+
+	pthread_mutex_lock(&scheduler_mutex);
+	assert(job.unfinished == 0);
+	job.unfinished = task_count;
+	unfinished_count += task_count;
+	pthread_mutex_unlock(&scheduler_mutex);
+
+	// spread the tasks evenly, the workers balance the rest by stealing
+	const uint32 queue_count = queues.get_count();
+	for(  uint32 i = 0;  i < task_count;  i++  ) {
+		task_queue_t &queue = *queues[i % queue_count];
+		task_t task;
+		task.job = &job;
+		task.number = i;
+		pthread_mutex_lock(&queue.mutex);
+		queue.tasks.append(task);
+		pthread_mutex_unlock(&queue.mutex);
+	}
+
+	pthread_mutex_lock(&scheduler_mutex);
+	queued_count += task_count;
+	pthread_cond_broadcast(&tasks_queued);
+	pthread_cond_broadcast(&tasks_finished); // waiters may help now
+	pthread_mutex_unlock(&scheduler_mutex);
+}
+
+
+void job_scheduler_t::wait(job_t &job)
+{
+	const uint32 first = worker_number == UINT32_MAX_VALUE ? 0 : worker_number;
+	while(  true  ) {
+		task_t task;
+		while(  take_task(first, &job, task)  ) {
+			run_task(task);
+		}
+
+		pthread_mutex_lock(&scheduler_mutex);
+		if(  job.unfinished == 0  ) {
+			pthread_mutex_unlock(&scheduler_mutex);
+			return;
+		}
+		// the remaining tasks run on other threads
+		pthread_cond_wait(&tasks_finished, &scheduler_mutex);
+		pthread_mutex_unlock(&scheduler_mutex);
+	}
+}
+
+#else
+
+void job_scheduler_t::start(uint32, void (*)(void *))
+{
+}
+
+
+void job_scheduler_t::stop()
+{
+}
+
+
+void job_scheduler_t::await_idle()
+{
+}
+
+
+void job_scheduler_t::forget_workers()
+{
+}
+
+
+uint32 job_scheduler_t::get_worker_count()
+{
+	return 0;
+}
+
+
+uint32 job_scheduler_t::get_worker_number()
+{
+	return UINT32_MAX_VALUE;
+}
+
+
+void job_scheduler_t::submit(job_t &job, uint32 task_count)
+{
+	for(  uint32 i = 0;  i < task_count;  i++  ) {
+		(*job.function)(job.data, i);
+	}
+}
+
+
+void job_scheduler_t::wait(job_t &)
+{
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef UTILS_JOB_SCHEDULER_H
+#define UTILS_JOB_SCHEDULER_H
+
+
+#include "../simtypes.h"
+
+
+/**
+ * One pool of worker threads, to which all parallel work of the world is handed
+ * as jobs. A job consists of a fixed number of tasks, which are spread over the
+ * queues of the workers. A worker takes the tasks from its own queue first; when
+ * that is empty, it steals from the others, so no core idles while any task waits.
+ *
+ * Which thread runs a task, and in which order, varies from run to run. To give
+ * the same results on all clients of a network game, the work of a task must only
+ * depend on its number and on the number of tasks of its job.
+ *
+ * A thread waiting for a job runs the queued tasks of that job itself. This allows
+ * tasks to wait for other jobs without starving the pool.
+ */
+class job_scheduler_t
+{
+public:
+	typedef void (*task_function_t)(void *data, uint32 task);
+
+	struct job_t
+	{
+		task_function_t function;
+		void *data;
+
+		// tasks submitted and not yet finished, only changed by the scheduler
+		uint32 unfinished;
+
+		job_t(task_function_t function, void *data) : function(function), data(data), unfinished(0) {}
+	};
+
+	/**
+	 * Starts @p worker_count workers, unless they run already.
+	 * Each worker calls @p worker_exit, if given, before it ends.
+	 */
+	static void start(uint32 worker_count, void (*worker_exit)(void *) = NULL);
+
+	/// Ends the workers. No job may be running.
+	static void stop();
+
+	/**
+	 * Returns when all submitted tasks have finished and all workers wait for new ones,
+	 * so that no worker holds a lock of the scheduler. Must not be called by a task.
+	 */
+	static void await_idle();
+
+	/**
+	 * Forgets the workers in a copy of this process made by dr_fork(), in which they do not exist.
+	 * Afterwards, no workers are started any more, and the tasks run at once when submitted.
+	 * The original must have called await_idle() before the copy was made.
+	 */
+	static void forget_workers();
+
+	static uint32 get_worker_count();
+
+	/// @returns the number of the worker calling this, or UINT32_MAX_VALUE if it is no worker
+	static uint32 get_worker_number();
+
+	/// Queues @p task_count tasks of @p job, or runs them at once if no workers are started. The job must not be running.
+	static void submit(job_t &job, uint32 task_count);
+
+	/// Returns when all tasks of @p job have finished. May be called from any thread.
+	static void wait(job_t &job);
+
+	/// Runs @p task_count tasks of @p job, and returns when all have finished
+	static void run(job_t &job, uint32 task_count)
+	{
+		submit(job, task_count);
+		wait(job);
+	}
+};
+
+#endif
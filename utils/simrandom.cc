@@ -16,7 +16,6 @@
 /* This is the mersenne random generator: More random and faster! */
 
 /* Period parameters */
-#define MERSENNE_TWISTER_N 624
 #define M 397
 #define MATRIX_A 0x9908b0dfUL   /* constant vector a */
 #define UPPER_MASK 0x80000000UL /* most significant w-r bits */
@@ -279,6 +278,28 @@ uint32 setsimrand(uint32 seed,uint32 ns)
 	return old_noise_seed;
 }
 
+
+void get_simrand_state(simrand_state_t &state)
+{
+	for(  int i = 0;  i < MERSENNE_TWISTER_N;  i++  ) {
+		state.mersenne_twister[i] = mersenne_twister[i];
+	}
+	state.mersenne_twister_index = mersenne_twister_index;
+	state.noise_seed = noise_seed;
+	state.random_origin = random_origin;
+}
+
+
+void set_simrand_state(const simrand_state_t &state)
+{
+	for(  int i = 0;  i < MERSENNE_TWISTER_N;  i++  ) {
+		mersenne_twister[i] = state.mersenne_twister[i];
+	}
+	mersenne_twister_index = state.mersenne_twister_index;
+	noise_seed = state.noise_seed;
+	random_origin = state.random_origin;
+}
+
 static double int_noise(const sint32 x, const sint32 y)
 {
 	uint32 n = (uint32)x + (uint32)y*101U + noise_seed;
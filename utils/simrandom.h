@@ -14,6 +14,23 @@ uint32 get_random_seed();
 
 uint32 setsimrand(uint32 seed, uint32 noise_seed);
 
+#define MERSENNE_TWISTER_N 624
+
+/**
+ * The random number generator of a thread. Work which may run on any thread
+ * keeps its own state, so that it draws the same numbers wherever it runs.
+ */
+struct simrand_state_t
+{
+	uint32 mersenne_twister[MERSENNE_TWISTER_N];
+	sint32 mersenne_twister_index;
+	uint32 noise_seed;
+	uint8 random_origin;
+};
+
+void get_simrand_state(simrand_state_t &state);
+void set_simrand_state(const simrand_state_t &state);
+
 /* generates a random number on [0,max-1]-interval
  * without affecting the game state
  * Use this for UI etc.
@@ -0,0 +1,361 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#include <chrono>
+
+#include "step_profiler.h"
+
+#include "csv.h"
+#include "simthread.h"
+#include "../simdebug.h"
+#include "../sys/simsys.h"
+#include "../tpl/vector_tpl.h"
+
+
+uint32 step_profiler_t::shown = 0;
+FILE *step_profiler_t::csv_file = NULL;
+uint32 step_profiler_t::step = 0;
+uint32 step_profiler_t::history[MAX_PHASES][history_length];
+uint32 step_profiler_t::last_history = 0;
+uint32 step_profiler_t::history_count = 0;
+bool step_profiler_t::summing_totals = false;
+uint64 step_profiler_t::totals[MAX_PHASES];
+uint32 step_profiler_t::total_steps = 0;
+
+
+static const struct {
+	const char *name;
+	uint8 parent;
+} phases[step_profiler_t::MAX_PHASES] = {
+	{ "Step",                          step_profiler_t::MAX_PHASES },
+	{ "New month",                     step_profiler_t::STEP },
+	{ "Wait for path explorer",        step_profiler_t::STEP },
+	{ "Wait for convoy route searches", step_profiler_t::STEP },
+	{ "Convoys",                       step_profiler_t::STEP },
+	{ "Cities",                        step_profiler_t::STEP },
+	{ "Wait for private car routes",   step_profiler_t::STEP },
+	{ "Wait for passenger generation", step_profiler_t::STEP },
+	{ "Factories",                     step_profiler_t::STEP },
+	{ "Players",                       step_profiler_t::STEP },
+	{ "Stops",                         step_profiler_t::STEP },
+	{ "Transferring cargo",            step_profiler_t::STEP },
+	{ "Sync step",                     step_profiler_t::MAX_PHASES },
+	{ "Moving objects",                step_profiler_t::SYNC_STEP },
+	{ "Display",                       step_profiler_t::SYNC_STEP },
+	{ "Convoy route searches (all threads)", step_profiler_t::MAX_PHASES },
+	{ "Passenger generation (all threads)",  step_profiler_t::MAX_PHASES },
+	{ "Path explorer (all threads)",   step_profiler_t::MAX_PHASES },
+	{ "Private car routes (all threads)", step_profiler_t::MAX_PHASES },
+	{ "Factory production (all threads)", step_profiler_t::MAX_PHASES }
+};
+
+
+struct sample_t
+{
+	uint8 phase;
+	uint32 us;
+};
+
+// the measurements of one thread, not yet collected by end_step()
+struct thread_buffer_t
+{
+	static const uint32 size = 1024;
+
+	sample_t samples[size];
+	uint32 first;
+	uint32 count;
+	uint32 lost;   // samples dropped since the buffer was full
+	bool in_use;   // whether a thread owns this buffer
+#ifdef MULTI_THREAD
+	pthread_mutex_t mutex;
+#endif
+};
+
+static vector_tpl<thread_buffer_t *> buffers;
+#ifdef MULTI_THREAD
+static pthread_mutex_t buffers_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+// hands the buffer of a thread over to the next thread when it ends
+struct buffer_owner_t
+{
+	thread_buffer_t *buffer;
+
+	~buffer_owner_t()
+	{
+		if(  buffer  ) {
+#ifdef MULTI_THREAD
+			pthread_mutex_lock(&buffers_mutex);
+#endif
+			buffer->in_use = false;
+#ifdef MULTI_THREAD
+			pthread_mutex_unlock(&buffers_mutex);
+#endif
+		}
+	}
+};
+
+static thread_local buffer_owner_t owner;
+
+
+static thread_buffer_t *get_thread_buffer()
+{
+	if(  owner.buffer  ) {
+		return owner.buffer;
+	}
+
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&buffers_mutex);
+#endif
+	FOR(vector_tpl<thread_buffer_t *>, buffer, buffers) {
+		if(  !buffer->in_use  ) {
+			owner.buffer = buffer;
+			break;
+		}
+	}
+	if(  !owner.buffer  ) {
+		owner.buffer = new thread_buffer_t;
+		owner.buffer->first = 0;
+		owner.buffer->count = 0;
+		owner.buffer->lost = 0;
+#ifdef MULTI_THREAD
+		pthread_mutex_init(&owner.buffer->mutex, NULL);
+#endif
+		buffers.append(owner.buffer);
+	}
+	owner.buffer->in_use = true;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&buffers_mutex);
+#endif
+	return owner.buffer;
+}
+
+
+static uint64 get_time_us()
+{
+	return (uint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+step_profiler_t::scope_t::scope_t(phase_t phase) :
+	phase(phase),
+	start(is_enabled() ? get_time_us() : 0)
+{
+}
+
+
+step_profiler_t::scope_t::~scope_t()
+{
+	if(  start != 0  ) {
+		record(phase, (uint32)(get_time_us() - start));
+	}
+}
+
+
+step_profiler_t::step_scope_t::step_scope_t(uint32 step) :
+	start(is_enabled() ? get_time_us() : 0)
+{
+	step_profiler_t::step = step;
+}
+
+
+step_profiler_t::step_scope_t::~step_scope_t()
+{
+	if(  start != 0  ) {
+		record(STEP, (uint32)(get_time_us() - start));
+	}
+	end_step();
+}
+
+
+void step_profiler_t::record(uint8 phase, uint32 us)
+{
+	thread_buffer_t &buffer = *get_thread_buffer();
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&buffer.mutex);
+#endif
+	if(  buffer.count < thread_buffer_t::size  ) {
+		sample_t &sample = buffer.samples[(buffer.first + buffer.count) % thread_buffer_t::size];
+		sample.phase = phase;
+		sample.us = us;
+		buffer.count++;
+	}
+	else {
+		buffer.lost++;
+	}
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&buffer.mutex);
+#endif
+}
+
+
+void step_profiler_t::end_step()
+{
+	// collected also while disabled, so that no old measurements are left when enabled again
+	uint32 times[MAX_PHASES] = {};
+	uint32 lost = 0;
+
+#ifdef MULTI_THREAD
+	pthread_mutex_lock(&buffers_mutex);
+#endif
+	FOR(vector_tpl<thread_buffer_t *>, buffer, buffers) {
+#ifdef MULTI_THREAD
+		pthread_mutex_lock(&buffer->mutex);
+#endif
+		for(  uint32 i = 0;  i < buffer->count;  i++  ) {
+			const sample_t &sample = buffer->samples[(buffer->first + i) % thread_buffer_t::size];
+			times[sample.phase] += sample.us;
+		}
+		buffer->first = (buffer->first + buffer->count) % thread_buffer_t::size;
+		buffer->count = 0;
+		lost += buffer->lost;
+		buffer->lost = 0;
+#ifdef MULTI_THREAD
+		pthread_mutex_unlock(&buffer->mutex);
+#endif
+	}
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock(&buffers_mutex);
+#endif
+
+	if(  !is_enabled()  ) {
+		return;
+	}
+
+	if(  lost > 0  ) {
+		dbg->warning("step_profiler_t::end_step()", "%u measurements lost in step %u", lost, step);
+	}
+
+	last_history = (last_history + 1) % history_length;
+	history_count = min(history_count + 1, history_length);
+	for(  uint8 phase = 0;  phase < MAX_PHASES;  phase++  ) {
+		history[phase][last_history] = times[phase];
+	}
+
+	if(  csv_file  ) {
+		write_csv_line(times);
+	}
+
+	if(  summing_totals  ) {
+		for(  uint8 phase = 0;  phase < MAX_PHASES;  phase++  ) {
+			totals[phase] += times[phase];
+		}
+		total_steps++;
+	}
+}
+
+
+void step_profiler_t::write_csv_line(const uint32 *times)
+{
+	CSV_t csv;
+	char buf[32];
+	csv.add_field(step);
+	for(  uint8 phase = 0;  phase < MAX_PHASES;  phase++  ) {
+		sprintf(buf, "%.3f", times[phase] / 1000.0);
+		csv.add_field(buf);
+	}
+	csv.new_line();
+	fputs(csv.get_str(), csv_file);
+	fflush(csv_file);
+}
+
+
+void step_profiler_t::set_shown(bool yes)
+{
+	if(  yes  &&  !is_enabled()  ) {
+		// start with an empty history
+		history_count = 0;
+	}
+	if(  yes  ) {
+		shown++;
+	}
+	else {
+		shown--;
+	}
+}
+
+
+bool step_profiler_t::open_csv(const char *filename)
+{
+	close_csv();
+	csv_file = dr_fopen(filename, "w");
+	if(  !csv_file  ) {
+		dbg->warning("step_profiler_t::open_csv()", "Cannot write step times to '%s'", filename);
+		return false;
+	}
+
+	CSV_t csv;
+	csv.add_field("step");
+	for(  uint8 phase = 0;  phase < MAX_PHASES;  phase++  ) {
+		csv.add_field(phases[phase].name);
+	}
+	csv.new_line();
+	fputs(csv.get_str(), csv_file);
+	return true;
+}
+
+
+void step_profiler_t::close_csv()
+{
+	if(  csv_file  ) {
+		fclose(csv_file);
+		csv_file = NULL;
+	}
+}
+
+
+void step_profiler_t::start_totals()
+{
+	for(  uint8 phase = 0;  phase < MAX_PHASES;  phase++  ) {
+		totals[phase] = 0;
+	}
+	total_steps = 0;
+	summing_totals = true;
+}
+
+
+double step_profiler_t::get_total_ms(uint8 phase)
+{
+	return totals[phase] / 1000.0;
+}
+
+
+const char *step_profiler_t::get_name(uint8 phase)
+{
+	return phases[phase].name;
+}
+
+
+uint8 step_profiler_t::get_parent(uint8 phase)
+{
+	return phases[phase].parent;
+}
+
+
+double step_profiler_t::get_last_ms(uint8 phase)
+{
+	return history_count > 0 ? history[phase][last_history] / 1000.0 : 0.0;
+}
+
+
+double step_profiler_t::get_average_ms(uint8 phase)
+{
+	uint64 sum = 0;
+	for(  uint32 i = 0;  i < history_count;  i++  ) {
+		sum += history[phase][(last_history + history_length - i) % history_length];
+	}
+	return history_count > 0 ? sum / (history_count * 1000.0) : 0.0;
+}
+
+
+double step_profiler_t::get_max_ms(uint8 phase)
+{
+	uint32 max_us = 0;
+	for(  uint32 i = 0;  i < history_count;  i++  ) {
+		max_us = max(max_us, history[phase][(last_history + history_length - i) % history_length]);
+	}
+	return max_us / 1000.0;
+}
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the Simutrans-Extended project under the Artistic License.
+ * (see LICENSE.txt)
+ */
+
+#ifndef UTILS_STEP_PROFILER_H
+#define UTILS_STEP_PROFILER_H
+
+
+#include <stdio.h>
+
+#include "../simtypes.h"
+
+
+/**
+ * Measures how long the phases of karte_t::step() and karte_t::sync_step() take,
+ * to find out which one is responsible when a game falls behind real time.
+ *
+ * The phases nest: the time of a phase includes that of its sub-phases. Work done
+ * on other threads is counted in phases of its own, as the sum over all threads.
+ *
+ * karte_t::sync_step() also runs within the phases of a step while the screen is
+ * updated, so their times include that of the sync steps in between.
+ *
+ * Each thread keeps its measurements in a ring buffer of its own; at the end of
+ * each step, the main thread collects them into the totals of that step. Nothing
+ * is measured unless the profiler window is open, a CSV file is written or the
+ * totals of a benchmark are summed up.
+ */
+class step_profiler_t
+{
+public:
+	enum phase_t
+	{
+		STEP,
+		STEP_NEW_MONTH,
+		STEP_AWAIT_PATH_EXPLORER,
+		STEP_AWAIT_CONVOYS,
+		STEP_CONVOYS,
+		STEP_CITIES,
+		STEP_AWAIT_PRIVATE_CARS,
+		STEP_AWAIT_PASSENGERS,
+		STEP_FACTORIES,
+		STEP_PLAYERS,
+		STEP_HALTS,
+		STEP_TRANSFERS,
+		SYNC_STEP,
+		SYNC_STEP_OBJECTS,
+		SYNC_STEP_DISPLAY,
+		TASK_CONVOYS,
+		TASK_PASSENGERS,
+		TASK_PATH_EXPLORER,
+		TASK_PRIVATE_CARS,
+		TASK_FACTORIES,
+		MAX_PHASES
+	};
+
+	/// Measures the time from its construction to its destruction
+	class scope_t
+	{
+		uint8 phase;
+		uint64 start;
+	public:
+		scope_t(phase_t phase);
+		~scope_t();
+	};
+
+	/// Measures karte_t::step(), and ends the step in the profiler
+	class step_scope_t
+	{
+		uint64 start;
+	public:
+		step_scope_t(uint32 step);
+		~step_scope_t();
+	};
+
+	/// Number of steps over which the average and maximum times are kept
+	static const uint32 history_length = 64;
+
+private:
+	// number of open profiler windows
+	static uint32 shown;
+	static FILE *csv_file;
+
+	// number of the world step being measured
+	static uint32 step;
+
+	// times in microseconds of the last steps, the newest at last_history
+	static uint32 history[MAX_PHASES][history_length];
+	static uint32 last_history;
+	static uint32 history_count;
+
+	// times in microseconds of all steps since start_totals()
+	static bool summing_totals;
+	static uint64 totals[MAX_PHASES];
+	static uint32 total_steps;
+
+	static void record(uint8 phase, uint32 us);
+
+	/// Collects the measurements of all threads into the history, and writes them to the CSV file
+	static void end_step();
+
+	static void write_csv_line(const uint32 *times);
+
+public:
+	static bool is_enabled() { return shown > 0  ||  csv_file != NULL  ||  summing_totals; }
+
+	/// Called by the profiler windows when they open and close
+	static void set_shown(bool yes);
+
+	/// Writes the times of each step to @p filename from now on. @returns false if it could not be opened.
+	static bool open_csv(const char *filename);
+
+	static void close_csv();
+
+	/// Sums up the times of all steps from now on, e.g. for a benchmark
+	static void start_totals();
+
+	/// Time in milliseconds of @p phase, and number of steps, since start_totals()
+	static double get_total_ms(uint8 phase);
+	static uint32 get_total_steps() { return total_steps; }
+
+	static const char *get_name(uint8 phase);
+
+	/// @returns the phase containing @p phase, or MAX_PHASES for the top level
+	static uint8 get_parent(uint8 phase);
+
+	/// Times in milliseconds of the latest step, and the average and maximum over the history
+	static double get_last_ms(uint8 phase);
+	static double get_average_ms(uint8 phase);
+	static double get_max_ms(uint8 phase);
+};
+
+#endif
@@ -59,6 +59,7 @@
 #include "../dataobj/schedule.h"
 #include "../dataobj/translator.h"
 #include "../dataobj/loadsave.h"
+#include "../dataobj/route_cache.h"
 #include "../dataobj/environment.h"
 #include "../dataobj/way_constraints.h"
 
@@ -1524,7 +1525,44 @@ void vehicle_t::set_desc(const vehicle_desc_t* value)
 
 route_t::route_result_t vehicle_t::calc_route(koord3d start, koord3d ziel, sint32 max_speed, bool is_tall, route_t* route)
 {
-	return route->calc_route(welt, start, ziel, this, max_speed, cnv != NULL ? cnv->get_highest_axle_load() : ((get_sum_weight() + 499) / 1000), is_tall, 0, SINT64_MAX_VALUE, cnv != NULL ? cnv->get_weight_summary().weight / 1000 : get_total_weight());
+	return calc_route_cached(start, ziel, max_speed, cnv != NULL ? cnv->get_highest_axle_load() : ((get_sum_weight() + 499) / 1000), is_tall, 0, cnv != NULL ? cnv->get_weight_summary().weight / 1000 : get_total_weight(), route);
+}
+
+route_t::route_result_t vehicle_t::calc_route_cached(koord3d start, koord3d ziel, sint32 max_speed, uint32 axle_load, bool is_tall, sint32 tile_length, uint32 convoy_weight, route_t* route)
+{
+	// Waiting or choosing convoys also check the reservations, which change all the time.
+	const bool use_cache = cnv != NULL  &&  !cnv->is_waiting()  &&  !cnv->get_is_choosing();
+	route_cache_t::key_t key;
+	if(  use_cache  ) {
+		key.start = start;
+		key.ziel = ziel;
+		key.vehicle_pos = get_pos();
+		// FNV-1a hash of the names of the vehicle types, which are the same on all clients
+		key.composition = 14695981039346656037ull;
+		for(  uint32 i = 0;  i < cnv->get_vehicle_count();  i++  ) {
+			for(  const char *name = cnv->get_vehicle(i)->get_desc()->get_name();  *name;  name++  ) {
+				key.composition = (key.composition ^ (uint8)*name) * 1099511628211ull;
+			}
+			key.composition = (key.composition ^ 0xFF) * 1099511628211ull;
+		}
+		key.max_speed = max_speed;
+		key.tile_length = tile_length;
+		key.axle_load = axle_load;
+		key.convoy_weight = convoy_weight;
+		key.waytype = get_waytype();
+		key.player_nr = get_player_nr();
+		key.flags = (is_tall ? route_cache_t::is_tall : 0) | (speed_limit < INT_MAX ? route_cache_t::has_speed_limit : 0);
+		if(  route_cache_t::get(key, *route)  ) {
+			return route_t::valid_route;
+		}
+	}
+
+	const uint32 generation = route_cache_t::get_generation();
+	const route_t::route_result_t result = route->calc_route(welt, start, ziel, this, max_speed, axle_load, is_tall, tile_length, SINT64_MAX_VALUE, convoy_weight, koord3d::invalid, ribi_t::all, route_t::none, route_t::get_convoy_search_direction(welt, start, ziel));
+	if(  use_cache  &&  result == route_t::valid_route  ) {
+		route_cache_t::put(key, *route, generation);
+	}
+	return result;
 }
 
 route_t::route_result_t vehicle_t::reroute(const uint16 reroute_index, const koord3d &ziel)
@@ -3483,7 +3521,7 @@ route_t::route_result_t road_vehicle_t::calc_route(koord3d start, koord3d ziel,
 	}
 	target_halt = halthandle_t(); // no block reserved
 	const uint32 routing_weight = cnv != NULL ? cnv->get_highest_axle_load() : ((get_sum_weight() + 499) / 1000);
-	route_t::route_result_t r = route->calc_route(welt, start, ziel, this, max_speed, routing_weight, is_tall, cnv->get_tile_length(), SINT64_MAX_VALUE, cnv->get_weight_summary().weight / 1000 );
+	route_t::route_result_t r = calc_route_cached(start, ziel, max_speed, routing_weight, is_tall, cnv->get_tile_length(), cnv->get_weight_summary().weight / 1000, route);
 	if(  r == route_t::valid_route_halt_too_short  ) {
 		cbuffer_t buf;
 		buf.printf( translator::translate("Vehicle %s cannot choose because stop too short!"), cnv->get_name());
@@ -4717,7 +4755,7 @@ route_t::route_result_t rail_vehicle_t::calc_route(koord3d start, koord3d ziel,
 	target_halt = halthandle_t(); // no block reserved
 	// use length > 8888 tiles to advance to the end of terminus stations
 	const sint16 tile_length = (cnv->get_schedule()->get_current_entry().reverse == 1 ? 8888 : 0) + cnv->get_true_tile_length();
-	route_t::route_result_t r = route->calc_route(welt, start, ziel, this, max_speed, cnv != NULL ? cnv->get_highest_axle_load() : ((get_sum_weight() + 499) / 1000), is_tall, tile_length, SINT64_MAX_VALUE, cnv ? cnv->get_weight_summary().weight / 1000 : get_total_weight());
+	route_t::route_result_t r = calc_route_cached(start, ziel, max_speed, cnv != NULL ? cnv->get_highest_axle_load() : ((get_sum_weight() + 499) / 1000), is_tall, tile_length, cnv ? cnv->get_weight_summary().weight / 1000 : get_total_weight(), route);
 	cnv->set_next_stop_index(0);
  	if(r == route_t::valid_route_halt_too_short)
 	{
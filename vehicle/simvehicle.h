@@ -426,6 +426,13 @@ public:
 	void get_smoke(bool yesno ) { smoke = yesno;}
 
 	virtual route_t::route_result_t calc_route(koord3d start, koord3d ziel, sint32 max_speed_kmh, bool is_tall, route_t* route);
+
+	/**
+	 * Searches the route of the convoy like route_t::calc_route(), or takes it
+	 * from the route cache if the same search was made recently.
+	 */
+	route_t::route_result_t calc_route_cached(koord3d start, koord3d ziel, sint32 max_speed_kmh, uint32 axle_load, bool is_tall, sint32 tile_length, uint32 convoy_weight, route_t* route);
+
 	uint16 get_route_index() const {return route_index;}
 	void set_route_index(uint16 value) { route_index = value; }
 	const koord3d get_pos_prev() const {return pos_prev;}